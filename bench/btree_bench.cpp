@@ -0,0 +1,137 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <numeric>
+#include <random>
+
+#include "Btree.hpp"
+#include "BtreeNodePage.hpp"
+
+using namespace backend;
+
+namespace {
+
+// A B-tree of {key, double} tuples. A degree of 0 fits as many keys as a page holds.
+class TreeFixture {
+public:
+    explicit TreeFixture(const Vari &keyType, degree_t degree = 0) {
+        std::filesystem::remove(kBenchFile);
+        ioHandler = std::make_unique<IOHandler>(kBenchFile);
+        pageCache = std::make_unique<PageCache>(*ioHandler, cts::CACHE_SZ);
+        fsm = std::make_unique<FreeSpaceMap>(*pageCache);
+        pager = std::make_unique<Pager>(*fsm, *ioHandler, *pageCache);
+
+        if (degree == 0)
+            degree = calculateDegree(keyType, {keyType, 0.0});
+        pgid_t root = pager->createNewPage<BtreeNodePage<Vec<Vari>>>(
+            degree, cts::PGID_INVALID, true, true).getPageID();
+        tree = std::make_unique<Btree<Vec<Vari>>>(root, *pager, degree);
+    }
+
+    ~TreeFixture() {
+        tree.reset();
+        pager.reset();
+        fsm.reset();
+        pageCache.reset();
+        ioHandler.reset();
+        std::filesystem::remove(kBenchFile);
+    }
+
+    static constexpr const char *kBenchFile = "bench_btree.db";
+
+    std::unique_ptr<IOHandler> ioHandler;
+    std::unique_ptr<PageCache> pageCache;
+    std::unique_ptr<FreeSpaceMap> fsm;
+    std::unique_ptr<Pager> pager;
+    std::unique_ptr<Btree<Vec<Vari>>> tree;
+};
+
+std::unique_ptr<TreeFixture> fixture;
+
+template<typename Key>
+Vari keyOf(int i) {
+    if constexpr (std::is_same_v<Key, string>)
+        return "key " + std::to_string(i);
+    else
+        return i;
+}
+
+Vec<int> shuffledKeys(int n) {
+    Vec<int> keys(n);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(152));
+    return keys;
+}
+
+// inserts 'state.range(0)' keys in random order into an empty tree of degree 'state.range(1)'
+template<typename Key>
+void BM_Insert(benchmark::State &state) {
+    auto keys = shuffledKeys(state.range(0));
+    for (auto _: state) {
+        state.PauseTiming();
+        auto fx = std::make_unique<TreeFixture>(Key(), state.range(1));
+        state.ResumeTiming();
+
+        for (int key: keys)
+            fx->tree->insert({keyOf<Key>(key), key * 1.5}, keyOf<Key>(key));
+
+        state.PauseTiming();
+        fx.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// looks up random keys of a tree of 'state.range(0)' keys and degree 'state.range(1)'
+template<typename Key>
+void BM_Search(benchmark::State &state) {
+    TreeFixture fx(Key(), state.range(1));
+    auto keys = shuffledKeys(state.range(0));
+    for (int key: keys)
+        fx.tree->insert({keyOf<Key>(key), key * 1.5}, keyOf<Key>(key));
+
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(fx.tree->search(keyOf<Key>(keys[i])));
+        if (++i == keys.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 'state.range(1)' percent point lookups of existing keys, the rest inserts of new keys, on a tree
+// of 'state.range(0)' keys
+void BM_ConcurrentMixed(benchmark::State &state) {
+    const int numKeys = state.range(0);
+    if (state.thread_index() == 0) {
+        fixture = std::make_unique<TreeFixture>(0);
+        for (int key = 0; key < numKeys; key++)
+            fixture->tree->insert({key, key * 1.5}, key);
+    }
+
+    std::mt19937 rng(152 + state.thread_index());
+    int nextKey = numKeys + state.thread_index();
+    for (auto _: state) {
+        if (static_cast<int>(rng() % 100) < state.range(1)) {
+            benchmark::DoNotOptimize(fixture->tree->concurrentSearch(static_cast<int>(rng() % numKeys)));
+        } else {
+            fixture->tree->concurrentInsert({nextKey, 0.0}, nextKey);
+            nextKey += state.threads();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0)
+        fixture.reset();
+}
+
+} // namespace
+
+BENCHMARK(BM_ConcurrentMixed)->Args({100000, 100})->Args({100000, 90})
+        ->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_Insert<int>)->Args({100000, 0})->Args({100000, 8})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Insert<string>)->Args({100000, 0})->Args({100000, 8})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Search<int>)->Args({100000, 0})->Args({100000, 8});
+BENCHMARK(BM_Search<string>)->Args({100000, 0})->Args({100000, 8});
@@ -0,0 +1,74 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <benchmark/benchmark.h>
+#include <map>
+
+#include "VectorExecutor.hpp"
+
+using namespace backend;
+
+namespace {
+
+// key, category (key % 'numGroups'), amount
+Vec<Vec<Vari>> makeRows(int numRows, int numGroups) {
+    Vec<Vec<Vari>> rows;
+    rows.reserve(numRows);
+    for (int key = 0; key < numRows; key++)
+        rows.push_back({key, key % numGroups, (key % 1000) * 0.25});
+    return rows;
+}
+
+// SELECT category, COUNT(*), SUM(amount) WHERE amount > 50 AND key != 0 GROUP BY category
+// (without the GROUP BY unless 'grouped')
+Query makeQuery(bool grouped) {
+    return {{{2, CompareOp::GT, 50.0}, {0, CompareOp::NE, 0}}, {}, grouped ? Vec<u16>{1} : Vec<u16>{},
+            {{AggregateOp::COUNT, 0}, {AggregateOp::SUM, 2}}};
+}
+
+} // namespace
+
+// evaluates the query tuple by tuple, comparing and adding up Vari values
+void BM_RowAtATime(benchmark::State &state) {
+    auto rows = makeRows(state.range(0), std::max<int>(1, state.range(1)));
+    auto query = makeQuery(state.range(1) > 0);
+
+    for (auto _: state) {
+        std::map<Vec<Vari>, std::pair<u64, double>> groups;
+        for (const auto &row: rows) {
+            bool matches = true;
+            for (const auto &predicate: query.where)
+                matches = matches && predicate.matches(row);
+            if (!matches)
+                continue;
+
+            Vec<Vari> key;
+            for (u16 column: query.groupBy)
+                key.push_back(row[column]);
+            auto &group = groups[key];
+            group.first++;
+            group.second += std::get<double>(row[2]);
+        }
+        benchmark::DoNotOptimize(groups);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// evaluates the same query with a VectorExecutor, including decoding the tuples into columns
+void BM_Vectorized(benchmark::State &state) {
+    auto rows = makeRows(state.range(0), std::max<int>(1, state.range(1)));
+    auto query = makeQuery(state.range(1) > 0);
+    Vec<Vari> types = {0, 0, 0.0};
+
+    for (auto _: state) {
+        VectorExecutor executor(types, query);
+        for (const auto &row: rows)
+            executor.addRow(row);
+        benchmark::DoNotOptimize(executor.finish());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_RowAtATime)->Args({100000, 0})->Args({100000, 16});
+BENCHMARK(BM_Vectorized)->Args({100000, 0})->Args({100000, 16});
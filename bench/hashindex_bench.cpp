@@ -0,0 +1,262 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <numeric>
+#include <random>
+
+#include "StorageEngine.hpp"
+#include "SchemaPage.hpp"
+
+using namespace backend;
+
+namespace {
+
+// Compares the B-tree, hash table and LSM engines on point lookups and inserts of the same data.
+class EngineFixture {
+public:
+    explicit EngineFixture(TableEngine engine) {
+        removeFiles();
+        ioHandler = std::make_unique<IOHandler>(kBenchFile);
+        pageCache = std::make_unique<PageCache>(*ioHandler, cts::CACHE_SZ);
+        fsm = std::make_unique<FreeSpaceMap>(*pageCache);
+        pager = std::make_unique<Pager>(*fsm, *ioHandler, *pageCache);
+        pager->createNewPage<SchemaPage>();
+        storage = std::make_unique<StorageEngine>(*pager, cts::SCHEMA_ID);
+        storage->createTable("Bench", {int(), int(), double()}, engine);
+        table = *storage->openTable("Bench");
+    }
+
+    ~EngineFixture() {
+        storage.reset();
+        pager.reset();
+        fsm.reset();
+        pageCache.reset();
+        ioHandler.reset();
+        removeFiles();
+    }
+
+    // removes the database file and the files of LSM tables stored next to it
+    static void removeFiles() {
+        for (const auto &entry: std::filesystem::directory_iterator("."))
+            if (entry.path().filename().string().starts_with(kBenchFile))
+                std::filesystem::remove(entry.path());
+    }
+
+    static constexpr const char *kBenchFile = "bench.db";
+
+    std::unique_ptr<IOHandler> ioHandler;
+    std::unique_ptr<PageCache> pageCache;
+    std::unique_ptr<FreeSpaceMap> fsm;
+    std::unique_ptr<Pager> pager;
+    std::unique_ptr<StorageEngine> storage;
+    TableHandle table;
+};
+
+Vec<int> shuffledKeys(int n) {
+    Vec<int> keys(n);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(152));
+    return keys;
+}
+
+void BM_PointLookup(benchmark::State &state, TableEngine engine) {
+    EngineFixture fx(engine);
+    auto keys = shuffledKeys(state.range(0));
+    for (int key: keys)
+        fx.storage->insertTuple(fx.table, {key, key * 2, key * 1.5});
+
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(fx.storage->getTuple(fx.table, keys[i]));
+        if (++i == keys.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_PreparedPointLookup(benchmark::State &state, TableEngine engine) {
+    EngineFixture fx(engine);
+    auto keys = shuffledKeys(state.range(0));
+    auto insert = fx.storage->prepareInsert(fx.table);
+    for (int key: keys)
+        insert.execute({key, key * 2, key * 1.5});
+
+    auto lookup = fx.storage->prepareLookup(fx.table);
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(lookup.execute(keys[i]));
+        if (++i == keys.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_MissingLookup(benchmark::State &state, TableEngine engine, bool bloom) {
+    EngineFixture fx(engine);
+    auto keys = shuffledKeys(state.range(0));
+    for (int key: keys)
+        fx.storage->insertTuple(fx.table, {key * 2, key, key * 1.5});
+    if (bloom)
+        fx.storage->createBloomFilter("Bench", 0.01);
+
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(fx.storage->getTuple(fx.table, keys[i] * 2 + 1));
+        if (++i == keys.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// scans a table keeping 1 in 'state.range(1)' tuples, projecting a single column
+void BM_Scan(benchmark::State &state, TableEngine engine) {
+    EngineFixture fx(engine);
+    for (int key: shuffledKeys(state.range(0)))
+        fx.storage->insertTuple(fx.table, {key, key % static_cast<int>(state.range(1)), key * 1.5});
+
+    for (auto _: state) {
+        size_t matches = 0;
+        fx.storage->scan(fx.table, {{1, CompareOp::EQ, 0}}, {2}, [&](const Vec<Vari> &row) {
+            benchmark::DoNotOptimize(row);
+            matches++;
+        });
+        benchmark::DoNotOptimize(matches);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// scans a table keeping 1% of tuples, using 'state.range(1)' threads
+void BM_ParallelScan(benchmark::State &state, TableEngine engine) {
+    EngineFixture fx(engine);
+    for (int key: shuffledKeys(state.range(0)))
+        fx.storage->insertTuple(fx.table, {key, key % 100, key * 1.5});
+
+    for (auto _: state) {
+        size_t matches = 0;
+        fx.storage->parallelScan(fx.table, {{1, CompareOp::EQ, 0}}, {2}, [&](const Vec<Vari> &) {
+            matches++;
+        }, state.range(1));
+        benchmark::DoNotOptimize(matches);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// joins two B-tree tables of 'state.range(0)' tuples on their keys; hash joins get a memory
+// budget of 'state.range(1)' KiB
+void BM_Join(benchmark::State &state, bool merge) {
+    EngineFixture fx(TableEngine::BTREE);
+    fx.storage->createTable("Other", {int(), int()});
+    auto other = *fx.storage->openTable("Other");
+    for (int key: shuffledKeys(state.range(0))) {
+        fx.storage->insertTuple(fx.table, {key, key % 100, key * 1.5});
+        fx.storage->insertTuple(other, {key, key * 2});
+    }
+
+    for (auto _: state) {
+        size_t matches = 0;
+        auto count = [&](const Vec<Vari> &, const Vec<Vari> &) { matches++; };
+        if (merge)
+            fx.storage->mergeJoin(fx.table, 0, other, 0, count);
+        else
+            fx.storage->hashJoin(fx.table, 0, other, 0, count, state.range(1) * 1024);
+        benchmark::DoNotOptimize(matches);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_Insert(benchmark::State &state, TableEngine engine, bool prepared) {
+    auto keys = shuffledKeys(state.range(0));
+    for (auto _: state) {
+        state.PauseTiming();
+        auto fx = std::make_unique<EngineFixture>(engine);
+        state.ResumeTiming();
+
+        if (prepared) {
+            auto insert = fx->storage->prepareInsert(fx->table);
+            for (int key: keys)
+                insert.execute({key, key * 2, key * 1.5});
+        } else {
+            for (int key: keys)
+                fx->storage->insertTuple(fx->table, {key, key * 2, key * 1.5});
+        }
+
+        state.PauseTiming();
+        fx.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// one insert, lookup, update and remove per iteration, on a table of 'state.range(0)' tuples
+void BM_Crud(benchmark::State &state, TableEngine engine) {
+    EngineFixture fx(engine);
+    auto keys = shuffledKeys(state.range(0));
+    for (int key: keys)
+        fx.storage->insertTuple(fx.table, {key, key * 2, key * 1.5});
+
+    size_t i = 0;
+    int next = static_cast<int>(keys.size());
+    for (auto _: state) {
+        fx.storage->insertTuple(fx.table, {next, next * 2, next * 1.5});
+        benchmark::DoNotOptimize(fx.storage->getTuple(fx.table, keys[i]));
+        fx.storage->updateTuple(fx.table, {keys[i], -keys[i], 0.5});
+        fx.storage->removeTuple(fx.table, next++);
+        if (++i == keys.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations() * 4);
+}
+
+// inserts durably, committing a transaction every range(1) inserts, so each commit's log flush is
+// shared by that many inserts
+void BM_TransactionalInsert(benchmark::State &state) {
+    auto keys = shuffledKeys(state.range(0));
+    for (auto _: state) {
+        state.PauseTiming();
+        auto fx = std::make_unique<EngineFixture>(TableEngine::BTREE);
+        state.ResumeTiming();
+
+        for (size_t i = 0; i < keys.size(); i += state.range(1)) {
+            auto txn = fx->storage->begin();
+            for (size_t j = i; j < std::min<size_t>(i + state.range(1), keys.size()); j++)
+                fx->storage->insertTuple(txn, fx->table, {keys[j], keys[j] * 2, keys[j] * 1.5});
+            fx->storage->commit(txn);
+        }
+
+        state.PauseTiming();
+        fx.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_PointLookup, btree, TableEngine::BTREE)->Arg(10000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_PointLookup, hash, TableEngine::HASH)->Arg(10000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_PointLookup, lsm, TableEngine::LSM)->Arg(10000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_PreparedPointLookup, btree, TableEngine::BTREE)->Arg(10000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_PreparedPointLookup, hash, TableEngine::HASH)->Arg(10000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_MissingLookup, btree, TableEngine::BTREE, false)->Arg(100000);
+BENCHMARK_CAPTURE(BM_MissingLookup, btree_bloom, TableEngine::BTREE, true)->Arg(100000);
+BENCHMARK_CAPTURE(BM_MissingLookup, lsm, TableEngine::LSM, false)->Arg(100000);
+BENCHMARK_CAPTURE(BM_MissingLookup, lsm_bloom, TableEngine::LSM, true)->Arg(100000);
+BENCHMARK_CAPTURE(BM_Scan, btree, TableEngine::BTREE)->Args({100000, 1})->Args({100000, 100});
+BENCHMARK_CAPTURE(BM_Scan, lsm, TableEngine::LSM)->Args({100000, 1})->Args({100000, 100});
+BENCHMARK_CAPTURE(BM_ParallelScan, btree, TableEngine::BTREE)
+        ->Args({100000, 1})->Args({100000, 2})->Args({100000, 4})->UseRealTime();
+BENCHMARK_CAPTURE(BM_Join, hash, false)->Args({100000, 64 * 1024})->Args({100000, 1024})
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Join, merge, true)->Args({100000, 0})->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Insert, btree, TableEngine::BTREE, false)->Arg(10000)
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Insert, btree_prepared, TableEngine::BTREE, true)->Arg(10000)
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Insert, hash, TableEngine::HASH, false)->Arg(10000)
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Insert, lsm, TableEngine::LSM, false)->Arg(10000)
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Crud, btree, TableEngine::BTREE)->Arg(100000);
+BENCHMARK_CAPTURE(BM_Crud, hash, TableEngine::HASH)->Arg(100000);
+BENCHMARK_CAPTURE(BM_Crud, lsm, TableEngine::LSM)->Arg(100000);
+BENCHMARK(BM_TransactionalInsert)->Args({2000, 1})->Args({2000, 16})->Args({2000, 256})
+        ->Unit(benchmark::kMillisecond);
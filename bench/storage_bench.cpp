@@ -0,0 +1,189 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <numeric>
+#include <random>
+
+#include "BtreeNodePage.hpp"
+#include "FSMPage.hpp"
+#include "IOHandler.hpp"
+#include "PageCache.hpp"
+
+using namespace backend;
+
+namespace {
+
+constexpr const char *kBenchFile = "bench_storage.db";
+
+// A file of 'numBlocks' serialized FSMPages, so any block can be loaded into a PageCache.
+class FileFixture {
+public:
+    explicit FileFixture(blockid_t numBlocks) : numBlocks(numBlocks) {
+        std::filesystem::remove(kBenchFile);
+        ioHandler = std::make_unique<IOHandler>(kBenchFile);
+        ioHandler->createMultipleBlocks(static_cast<int>(numBlocks));
+
+        Vec<byte> blocks(static_cast<size_t>(numBlocks) * cts::PG_SZ);
+        for (blockid_t id = 0; id < numBlocks; id++)
+            FSMPage(id).toBytes(std::span<byte>(blocks.data() + static_cast<size_t>(id) * cts::PG_SZ, cts::PG_SZ));
+        ioHandler->writeBlocks(blocks.data(), 0, numBlocks);
+    }
+
+    ~FileFixture() {
+        ioHandler.reset();
+        std::filesystem::remove(kBenchFile);
+    }
+
+    // block IDs in random order, to defeat the OS's read-ahead
+    Vec<blockid_t> shuffledBlocks() const {
+        Vec<blockid_t> ids(numBlocks);
+        std::iota(ids.begin(), ids.end(), 0);
+        std::shuffle(ids.begin(), ids.end(), std::mt19937(152));
+        return ids;
+    }
+
+    blockid_t numBlocks;
+    std::unique_ptr<IOHandler> ioHandler;
+};
+
+void BM_IORead(benchmark::State &state) {
+    FileFixture fx(state.range(0));
+    auto ids = fx.shuffledBlocks();
+    PgArr<byte> buf;
+
+    size_t i = 0;
+    for (auto _: state) {
+        fx.ioHandler->readBlock(buf.data(), ids[i]);
+        if (++i == ids.size()) i = 0;
+    }
+    state.SetBytesProcessed(state.iterations() * cts::PG_SZ);
+}
+
+// every write is synced to disk
+void BM_IOWrite(benchmark::State &state) {
+    FileFixture fx(state.range(0));
+    auto ids = fx.shuffledBlocks();
+    PgArr<byte> buf{};
+
+    size_t i = 0;
+    for (auto _: state) {
+        fx.ioHandler->writeBlock(buf.data(), ids[i]);
+        if (++i == ids.size()) i = 0;
+    }
+    state.SetBytesProcessed(state.iterations() * cts::PG_SZ);
+}
+
+// 'state.range(1)' consecutive blocks per write, with a single sync
+void BM_IOWriteConsecutive(benchmark::State &state) {
+    FileFixture fx(state.range(0));
+    auto run = static_cast<blockid_t>(state.range(1));
+    Vec<byte> buf(static_cast<size_t>(run) * cts::PG_SZ);
+
+    blockid_t first = 0;
+    for (auto _: state) {
+        fx.ioHandler->writeBlocks(buf.data(), first, run);
+        first = first + 2 * run > fx.numBlocks ? 0 : first + run;
+    }
+    state.SetBytesProcessed(state.iterations() * run * cts::PG_SZ);
+}
+
+// every page is cached, so each retrieval only moves the page to the front of the LRU list
+void BM_PageCacheHit(benchmark::State &state) {
+    FileFixture fx(state.range(0));
+    PageCache cache(*fx.ioHandler, fx.numBlocks);
+    auto ids = fx.shuffledBlocks();
+    for (blockid_t id: ids)
+        cache.retrievePage<FSMPage>(id);
+
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(cache.retrievePage<FSMPage>(ids[i]));
+        if (++i == ids.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// the cache holds 'state.range(1)' of the pages, so most retrievals read a page and write back the
+// page they evict
+void BM_PageCacheMiss(benchmark::State &state) {
+    FileFixture fx(state.range(0));
+    PageCache cache(*fx.ioHandler, state.range(1));
+    auto ids = fx.shuffledBlocks();
+
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(cache.retrievePage<FSMPage>(ids[i]));
+        if (++i == ids.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// finds and allocates the next free bit, starting over with an empty page once it is full
+void BM_FSMPageAlloc(benchmark::State &state) {
+    auto page = std::make_unique<FSMPage>(0);
+    for (auto _: state) {
+        if (page->getSpaceLeft() == 0) {
+            state.PauseTiming();
+            page = std::make_unique<FSMPage>(0);
+            state.ResumeTiming();
+        }
+        page->allocBit(page->findNextFree());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// a full leaf of {key, int, double} tuples with int or string keys
+template<typename Key>
+Ptr<BtreeNodePage<Vec<Vari>>> fullLeaf() {
+    Key key{};
+    degree_t degree = calculateDegree(Vari(key), {key, 0, 0.0});
+    auto page = std::make_unique<BtreeNodePage<Vec<Vari>>>(degree, cts::PGID_INVALID, true, true, 0);
+    for (int i = 0; i < page->maxKeys(); i++) {
+        Vari k;
+        if constexpr (std::is_same_v<Key, string>)
+            k = "key " + std::to_string(i);
+        else
+            k = i;
+        page->cells().push_back({k, {k, i, i * 1.5}});
+    }
+    return page;
+}
+
+template<typename Key>
+void BM_BtreeNodeSerialize(benchmark::State &state) {
+    auto page = fullLeaf<Key>();
+    PgArr<byte> buf;
+    for (auto _: state) {
+        page->toBytes(buf);
+        benchmark::DoNotOptimize(buf.data());
+    }
+    state.counters["cells"] = static_cast<double>(page->cells().size());
+    state.SetBytesProcessed(state.iterations() * cts::PG_SZ);
+}
+
+template<typename Key>
+void BM_BtreeNodeDeserialize(benchmark::State &state) {
+    auto page = fullLeaf<Key>();
+    PgArr<byte> buf;
+    page->toBytes(buf);
+    for (auto _: state)
+        benchmark::DoNotOptimize(BtreeNodePage<Vec<Vari>>(buf, 0));
+    state.counters["cells"] = static_cast<double>(page->cells().size());
+    state.SetBytesProcessed(state.iterations() * cts::PG_SZ);
+}
+
+} // namespace
+
+BENCHMARK(BM_IORead)->Arg(4096);
+BENCHMARK(BM_IOWrite)->Arg(4096);
+BENCHMARK(BM_IOWriteConsecutive)->Args({4096, 16})->Args({4096, 256});
+BENCHMARK(BM_PageCacheHit)->Arg(4096);
+BENCHMARK(BM_PageCacheMiss)->Args({4096, 64});
+BENCHMARK(BM_FSMPageAlloc);
+BENCHMARK(BM_BtreeNodeSerialize<int>);
+BENCHMARK(BM_BtreeNodeSerialize<string>);
+BENCHMARK(BM_BtreeNodeDeserialize<int>);
+BENCHMARK(BM_BtreeNodeDeserialize<string>);
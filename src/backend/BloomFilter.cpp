@@ -0,0 +1,59 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <algorithm>
+#include <cmath>
+
+#include "BloomFilter.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+BloomFilter::BloomFilter(u64 expectedKeys, double bitsPerKey) {
+    ASSUME_S(bitsPerKey > 0, "Bloom filter needs a positive number of bits per key");
+
+    m_numHashes = numHashesFor(bitsPerKey);
+
+    u64 bits = std::max<u64>(64, static_cast<u64>(std::ceil(expectedKeys * bitsPerKey)));
+    m_words.resize((bits + 63) / 64);
+}
+
+BloomFilter::BloomFilter(Vec<u64> words, u8 numHashes) : m_words(std::move(words)), m_numHashes(numHashes) {
+    ASSUME_S(!m_words.empty(), "Bloom filter must have at least one word");
+    ASSUME_S(numHashes > 0, "Bloom filter must use at least one probe");
+}
+
+void BloomFilter::add(u64 hash) {
+    add(hash, [](size_t) {});
+}
+
+bool BloomFilter::mayContain(u64 hash) const {
+    u64 bits = m_words.size() * 64;
+    u64 delta = (hash >> 33) | (hash << 31) | 1;
+    for (u8 i = 0; i < m_numHashes; i++) {
+        u64 bit = hash % bits;
+        if (!(m_words[bit / 64] & (u64(1) << (bit % 64))))
+            return false;
+        hash += delta;
+    }
+    return true;
+}
+
+u8 BloomFilter::numHashesFor(double bitsPerKey) {
+    // optimal number of probes is ln(2) * bits per key
+    return static_cast<u8>(std::clamp(std::round(bitsPerKey * 0.69), 1.0, 30.0));
+}
+
+double BloomFilter::bitsPerKeyFor(double falsePositiveRate) {
+    ASSUME_S(falsePositiveRate > 0 && falsePositiveRate < 1, "False-positive rate must be between 0 and 1");
+
+    // bits per key = -ln(p) / ln(2)^2
+    return -std::log(falsePositiveRate) / (std::log(2.0) * std::log(2.0));
+}
+
+void BloomFilter::clear() {
+    std::fill(m_words.begin(), m_words.end(), 0);
+}
+
+} // namespace backend
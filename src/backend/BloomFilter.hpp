@@ -0,0 +1,110 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_BLOOMFILTER_HPP
+#define KNDB_BLOOMFILTER_HPP
+
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class BloomFilter
+ * @brief Probabilistic set of key hashes with no false negatives.
+ *
+ * mayContain() returning false guarantees the key was never added, so lookups of missing keys
+ * can be skipped. The false-positive rate is set by the number of bits spent per key:
+ * roughly 0.6185^bitsPerKey (about 1% at 10 bits per key).
+ *
+ * Keys are added and checked by their db_hash(), and each of the k probes is derived from that
+ * one hash using double hashing.
+ */
+class BloomFilter {
+public:
+    /**
+     * @brief Constructs an empty filter sized for a number of keys.
+     * @param expectedKeys Number of keys the filter is sized for. Adding more keys is allowed
+     * but raises the false-positive rate.
+     * @param bitsPerKey Number of filter bits per expected key.
+     */
+    BloomFilter(u64 expectedKeys, double bitsPerKey);
+
+    /**
+     * @brief Constructs a filter from previously stored words.
+     * @param words The filter's bit array, as returned by getWords().
+     * @param numHashes The number of probes per key, as returned by getNumHashes().
+     */
+    BloomFilter(Vec<u64> words, u8 numHashes);
+
+    /**
+     * @brief Adds a key to the filter.
+     * @param hash The db_hash() of the key.
+     */
+    void add(u64 hash);
+
+    /**
+     * @brief Adds a key to the filter, reporting every word that changed.
+     * @param hash The db_hash() of the key.
+     * @param onChanged Callable invoked as onChanged(size_t wordIdx) for each word that gained a
+     * bit, so callers keeping a copy of the words can update only those.
+     */
+    template<typename Fn>
+    void add(u64 hash, Fn &&onChanged) {
+        u64 bits = m_words.size() * 64;
+        u64 delta = (hash >> 33) | (hash << 31) | 1;
+        for (u8 i = 0; i < m_numHashes; i++) {
+            u64 bit = hash % bits;
+            u64 mask = u64(1) << (bit % 64);
+            if (!(m_words[bit / 64] & mask)) {
+                m_words[bit / 64] |= mask;
+                onChanged(static_cast<size_t>(bit / 64));
+            }
+            hash += delta;
+        }
+    }
+
+    /**
+     * @brief Checks whether a key may have been added.
+     * @param hash The db_hash() of the key.
+     * @return false if the key was definitely never added, true otherwise.
+     */
+    bool mayContain(u64 hash) const;
+
+    /**
+     * @brief Resets the filter to contain no keys.
+     */
+    void clear();
+
+    /**
+     * @return The filter's bit array.
+     */
+    const Vec<u64> &getWords() const { return m_words; }
+
+    /**
+     * @return The number of probes per key.
+     */
+    u8 getNumHashes() const { return m_numHashes; }
+
+    /**
+     * @brief Calculates the number of probes per key that minimizes the false-positive rate.
+     * @param bitsPerKey Number of filter bits per key.
+     * @return The number of probes per key.
+     */
+    static u8 numHashesFor(double bitsPerKey);
+
+    /**
+     * @brief Calculates the bits per key needed for a false-positive rate.
+     * @param falsePositiveRate The target rate, between 0 and 1 (exclusive).
+     * @return The number of bits per key.
+     */
+    static double bitsPerKeyFor(double falsePositiveRate);
+
+private:
+    Vec<u64> m_words;
+    u8 m_numHashes;
+};
+
+} // namespace backend
+
+#endif //KNDB_BLOOMFILTER_HPP
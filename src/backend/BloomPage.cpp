@@ -0,0 +1,67 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include "BloomPage.hpp"
+#include "utility.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+//    u8 pagetypeid
+//    pgid_t m_nextPageID
+//    u16 numWords
+//    u64 m_words[numWords]
+
+BloomPage::BloomPage(std::span<const byte> bytes, pgid_t pageID) : Page(pageID) {
+    ASSUME_S(bytes.size() == cts::PG_SZ, "Buffer is incorrectly sized");
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id;
+    u16 numWords;
+    db_deserialize(page_type_id, bytes, offset);
+    ASSUME_S(page_type_id == cts::pg_type_id::BLOOM_PAGE, "Page_type_id is incorrect type");
+
+    db_deserialize(m_nextPageID, bytes, offset);
+    db_deserialize(numWords, bytes, offset);
+    ASSUME_S(numWords <= getMaxWords(), "Page holds more words than fit");
+
+    m_words.resize(numWords);
+    for (auto &word: m_words)
+        db_deserialize(word, bytes, offset);
+
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+}
+
+BloomPage::BloomPage(Vec<u64> words, pgid_t nextPageID, pgid_t pageID) : Page(pageID),
+        m_nextPageID(nextPageID), m_words(std::move(words)) {
+    ASSUME_S(m_words.size() <= getMaxWords(), "Page cannot hold that many words");
+}
+
+void BloomPage::setWord(size_t idx, u64 word) {
+    ASSUME_S(idx < m_words.size(), "Word index is out of range");
+
+    m_words[idx] = word;
+}
+
+size_t BloomPage::getMaxWords() {
+    return (cts::PG_SZ - db_sizeof<pgtypeid_t>() - db_sizeof<pgid_t>() - db_sizeof<u16>()) / db_sizeof<u64>();
+}
+
+void BloomPage::toBytes(std::span<byte> buf) {
+    ASSUME_S(buf.size() == cts::PG_SZ, "Buffer is incorrectly sized");
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id = cts::pg_type_id::BLOOM_PAGE;
+    u16 numWords = m_words.size();
+    db_serialize(page_type_id, buf, offset);
+    db_serialize(m_nextPageID, buf, offset);
+    db_serialize(numWords, buf, offset);
+
+    for (auto word: m_words)
+        db_serialize(word, buf, offset);
+
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+}
+
+} // namespace backend
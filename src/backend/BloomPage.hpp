@@ -0,0 +1,69 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_BLOOMPAGE_HPP
+#define KNDB_BLOOMPAGE_HPP
+
+#include "Page.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class BloomPage
+ * @brief Stores a slice of a table's bloom filter.
+ *
+ * A bloom filter larger than one page is split across a chain of BloomPages, each holding up to
+ * getMaxWords() consecutive words of the filter's bit array.
+ */
+class BloomPage : public Page {
+public:
+    /**
+     * @brief Constructs a BloomPage from serialized data.
+     * @param bytes Serialized data.
+     * @param pageID The page ID.
+     */
+    BloomPage(std::span<const byte> bytes, pgid_t pageID);
+
+    /**
+     * @brief Constructs a new BloomPage.
+     * @param words The words of the filter stored in this page.
+     * @param nextPageID The page ID of the next page of the filter, or PGID_INVALID if last.
+     * @param pageID The page ID.
+     * @note Program terminates if there are more words than fit in a page.
+     */
+    BloomPage(Vec<u64> words, pgid_t nextPageID, pgid_t pageID);
+
+    /**
+     * @return The words of the filter stored in this page.
+     */
+    const Vec<u64> &getWords() const { return m_words; }
+
+    /**
+     * @brief Overwrites one word of this page.
+     * @param idx Index of the word within this page.
+     * @param word The new value.
+     */
+    void setWord(size_t idx, u64 word);
+
+    /**
+     * @return The page ID of the next page of the filter, or PGID_INVALID if this is the last.
+     */
+    pgid_t getNextPageID() const { return m_nextPageID; }
+
+    /**
+     * @return The max number of words a BloomPage can hold.
+     */
+    static size_t getMaxWords();
+
+    void toBytes(std::span<byte> buffer) override;
+
+private:
+    pgid_t m_nextPageID;
+    Vec<u64> m_words;
+};
+
+} // namespace backend
+
+#endif //KNDB_BLOOMPAGE_HPP
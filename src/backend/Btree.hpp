@@ -5,11 +5,16 @@
 #ifndef KNDB_BTREE_HPP
 #define KNDB_BTREE_HPP
 
+#include "Metrics.hpp"
 #include "Pager.hpp"
+#include <atomic>
 #include <optional>
 
 namespace backend {
 
+template<typename T>
+class BtreeNodePage;
+
 /**
  * @class Btree
  * @brief Represents a generic B-tree supporting insertion, deletion, update, and search operations.
@@ -17,8 +22,26 @@ namespace backend {
  * This class implements a B-tree with a specified degree. It operates on pages managed by a Pager,
  * storing key-value pairs persistently. Keys are of type 'variant' and values are of type 'T'.
  *
- * All keys must be unique within the B-tree. Duplicate insertions or operations on missing keys
- * will result in operation failures rather than exceptions.
+ * By default all keys must be unique within the B-tree. Duplicate insertions or operations on
+ * missing keys will result in operation failures rather than exceptions. A B-tree constructed as
+ * non-unique accepts duplicate keys instead, which is what secondary indexes use.
+ *
+ * Every non-leaf node keeps the number of cells under each of its children, maintained on insert,
+ * split, delete and rebalance. Counting and positional lookups therefore skip whole subtrees and
+ * only read the nodes on a single root-to-leaf path.
+ *
+ * The concurrent* operations may be called from many threads at once, using optimistic lock
+ * coupling. Every node is guarded by a version latch: readers descend without taking any lock and
+ * restart if a node they passed changed meanwhile, while writers lock only the nodes they change.
+ * Writers never change a node in place but publish a changed copy, so readers always see whole
+ * nodes, including while a node is being split. A concurrent insert locks its whole path, since it
+ * bumps the subtree count in every ancestor of its leaf, so the counts and parent pointers are
+ * always exact; inserts therefore take turns at the root, while searches never wait for them.
+ * The concurrent operations must not run alongside the other operations, and only concurrent
+ * operations on the same tree may run at once.
+ *
+ * The tree's own latches take no lock on the read path, and nodes found in the PageCache are
+ * fetched with its lock taken shared, so concurrent searches do not serialize on the cache either.
  *
  * @tparam T The type of values stored in the B-tree. This can be any standard type (e.g., int, double, std::string),
  * or a 'vector<variant>' representing a row of structured values. The supported variant types
@@ -32,8 +55,9 @@ public:
      * @param rootPageId The page ID of the root node in the tree.
      * @param pgr Reference to the Pager used for managing pages.
      * @param degree Degree of the B-tree (t). Each node will store between t-1 and 2t-1 keys.
+     * @param unique Whether keys must be unique within the tree.
      */
-    Btree(pgid_t rootPageId, Pager &pgr, degree_t degree);
+    Btree(pgid_t rootPageId, Pager &pgr, degree_t degree, bool unique = true);
 
     /**
      * @brief Searches for a key in the B-tree.
@@ -42,11 +66,19 @@ public:
      */
     std::optional<T> search(const Vari &key);
 
+    /**
+     * @brief Searches for every value stored under a key. May be called from several threads at
+     * once, as long as the tree is not modified meanwhile.
+     * @param key The key to search for.
+     * @return All values associated with the key, in tree order. Empty if not found.
+     */
+    Vec<T> searchAll(const Vari &key);
+
     /**
      * @brief Inserts a key-value pair into the B-tree.
      * @param values The value to associate with the key.
      * @param key The key to insert.
-     * @return true if insertion was successful, false if key already exists.
+     * @return true if insertion was successful, false if key already exists in a unique tree.
      */
     bool insert(T values, Vari key);
 
@@ -54,9 +86,19 @@ public:
      * @brief Removes a key-value pair from the B-tree.
      * @param key The key to remove.
      * @return true if removal was successful, false if key doesn't exist.
+     *
+     * If the tree is non-unique, only one of the entries stored under the key is removed.
      */
     bool remove(Vari key);
 
+    /**
+     * @brief Removes one specific key-value pair from the B-tree.
+     * @param key The key of the entry to remove.
+     * @param value The value of the entry to remove.
+     * @return true if removal was successful, false if no entry matches both key and value.
+     */
+    bool remove(const Vari &key, const T &value);
+
     /**
      * @brief Updates the value associated with an existing key.
      * @param values The new value to assign.
@@ -65,6 +107,58 @@ public:
      */
     bool update(T values, const Vari &key);
 
+    /**
+     * @brief Searches for a key, like search(), while other threads use the tree concurrently.
+     * @param key The key to search for.
+     * @return Optional value associated with the key, or std::nullopt if not found.
+     */
+    std::optional<T> concurrentSearch(const Vari &key);
+
+    /**
+     * @brief Inserts a key-value pair, like insert(), while other threads use the tree
+     * concurrently.
+     * @param values The value to associate with the key.
+     * @param key The key to insert.
+     * @return true if insertion was successful, false if key already exists in a unique tree.
+     */
+    bool concurrentInsert(T values, const Vari &key);
+
+    /**
+     * @brief Updates the value of a key, like update(), while other threads use the tree
+     * concurrently.
+     * @param values The new value to assign.
+     * @param key The key to update.
+     * @return true if update was successful, false if key doesn't exist.
+     */
+    bool concurrentUpdate(T values, const Vari &key);
+
+    /**
+     * @return The number of key-value pairs in the B-tree.
+     */
+    u64 size();
+
+    /**
+     * @brief Counts the pairs whose key is smaller than a key.
+     * @param key The key to rank. It does not need to be in the tree.
+     * @return The position the first pair with that key has (or would have) in key order.
+     */
+    u64 rank(const Vari &key);
+
+    /**
+     * @brief Counts the pairs whose key lies in a range.
+     * @param lo The smallest key to count.
+     * @param hi The largest key to count.
+     * @return The number of pairs with lo <= key <= hi, or 0 if hi < lo.
+     */
+    u64 countRange(const Vari &lo, const Vari &hi);
+
+    /**
+     * @brief Finds the pair at a position in key order.
+     * @param rank The position, starting from 0.
+     * @return The value of that pair, or std::nullopt if rank is not less than size().
+     */
+    std::optional<T> selectByRank(u64 rank);
+
     /**
      * @brief Returns the root page ID of the B-tree.
      * @return The page ID of the root node.
@@ -72,18 +166,222 @@ public:
     pgid_t getRootPage() const { return m_rootPageID; }
 
     /**
-     * Deletes the Btree and all its nodes.
+     * @brief Visits every key-value pair in the B-tree in ascending key order.
+     * @param fn Callable invoked as fn(const Vari &key, const T &value).
+     */
+    template<typename Fn>
+    void forEach(Fn &&fn);
+
+    /**
+     * @brief Splits the tree into disjoint subtrees that can be visited in parallel.
+     *
+     * Descends one level at a time from the root until a level holds at least minSubtrees nodes,
+     * or until reaching the leaves.
+     * @param minSubtrees The number of subtrees wanted.
+     * @return The depth of the chosen level (0 for the root) and the page IDs of its nodes, in key
+     * order. Pairs stored in nodes above that depth belong to no subtree; see forEachAbove().
+     */
+    std::pair<u32, Vec<pgid_t>> partition(size_t minSubtrees);
+
+    /**
+     * @brief Visits every key-value pair of a subtree in key order.
+     *
+     * May be called from several threads at once, as long as the tree is not modified meanwhile.
+     * @param subtreePageID The page ID of the subtree's root, as returned by partition().
+     * @param fn Callable invoked as fn(const Vari &key, const T &value).
+     */
+    template<typename Fn>
+    void forEachInSubtree(pgid_t subtreePageID, Fn &&fn);
+
+    /**
+     * @brief Visits every key-value pair stored in nodes above a depth, in no particular order.
+     *
+     * May be called from several threads at once, as long as the tree is not modified meanwhile.
+     * @param depth The depth returned by partition().
+     * @param fn Callable invoked as fn(const Vari &key, const T &value).
+     */
+    template<typename Fn>
+    void forEachAbove(u32 depth, Fn &&fn);
+
+    /**
+     * @class Cursor
+     * @brief Iterates the key-value pairs of a B-tree in ascending key order, one at a time.
+     *
+     * The cursor holds the nodes on the path to its current pair, so it stays usable while other
+     * pages are loaded and evicted. The tree must not be modified while a cursor is in use.
+     */
+    class Cursor {
+    public:
+        /**
+         * @return true if the cursor is on a pair, false once every pair was visited.
+         */
+        bool valid() const { return !m_path.empty(); }
+
+        /**
+         * @return The key of the current pair.
+         */
+        const Vari &key() const;
+
+        /**
+         * @return The value of the current pair.
+         */
+        const T &value() const;
+
+        /**
+         * @brief Moves to the next pair in key order.
+         */
+        void next();
+
+    private:
+        friend class Btree;
+
+        Cursor(Btree &tree);
+
+        // starts on the pair at a position in key order
+        Cursor(Btree &tree, u64 rank);
+
+        // descends to the leftmost leaf of a subtree, then skips past exhausted nodes
+        void descend(pgid_t pageID);
+
+        void settle();
+
+        struct Frame {
+            std::shared_ptr<BtreeNodePage<T>> node;
+            size_t idx; // current cell, or the child visited before it
+        };
+
+        Btree &m_tree;
+        Vec<Frame> m_path;
+    };
+
+    /**
+     * @return A cursor on the pair with the smallest key.
+     */
+    Cursor cursor();
+
+    /**
+     * @param rank A position in key order, starting from 0.
+     * @return A cursor on the pair at that position, which is past the last pair if rank is not
+     * less than size().
+     */
+    Cursor cursorAt(u64 rank);
+
+    /**
+     * Deletes the Btree and all its nodes, freeing their pages. The tree must not be used after.
      */
     void deleteTree();
 
 private:
     RowPos searchRowPtr(Vari targ_key, pgid_t currPageID);
 
-    void split(pgid_t currPageID);
+    // finds the leaf a duplicate key is inserted into (after all equal keys)
+    pgid_t searchLeafUpper(const Vari &targ_key, pgid_t currPageID);
+
+    void collect(const Vari &targ_key, pgid_t currPageID, Vec<T> &out);
+
+    RowPos searchEntry(const Vari &targ_key, const T &value, pgid_t currPageID);
+
+    template<typename Fn>
+    void forEach(pgid_t currPageID, Fn &fn);
+
+    template<typename Fn>
+    void forEachAbove(pgid_t currPageID, u32 depth, Fn &fn);
+
+    // counts the pairs whose key is smaller than (or, if inclusive, equal to) a key
+    u64 countBelow(const Vari &key, bool inclusive);
+
+    // adds delta to the subtree counts of every ancestor of a node
+    void adjustCounts(pgid_t currPageID, int delta);
+
+    // finds the position of a child in its parent's list of children
+    childid_t childIndex(BtreeNodePage<T> &parent, pgid_t childPageID);
+
+    // splits a node that is full, and then its ancestors as needed. Returns the number of nodes split
+    u32 split(pgid_t currPageID);
+
+    void removeAt(RowPos row);
+
+    void rebalance(pgid_t currPageID);
+
+    void deleteSubtree(pgid_t currPageID);
+
+    struct Metrics {
+        Counter &splits = MetricsRegistry::global().counter("btree.splits");
+        Counter &borrows = MetricsRegistry::global().counter("btree.borrows");
+        Counter &merges = MetricsRegistry::global().counter("btree.merges");
+        Counter &restarts = MetricsRegistry::global().counter("btree.restarts");
+        // nodes split by each insert, which shows how far split cascades reach
+        Histogram &insertSplits = MetricsRegistry::global().histogram("btree.insert_splits");
+    };
+
+    static Metrics &metrics() {
+        static Metrics m;
+        return m;
+    }
+
+    // version latch shared by the nodes whose page IDs map to it. The version is odd while a
+    // writer holds the latch, and every release after a change moves it on.
+    struct alignas(64) Latch {
+        std::atomic<u64> version{0};
+    };
+
+    static constexpr size_t NUM_LATCHES = 1024;
+
+    Latch &latch(pgid_t pageID) { return m_latches[pageID % NUM_LATCHES]; }
+
+    // waits until no writer holds a node's latch, and returns its version
+    u64 readVersion(pgid_t pageID);
+
+    // checks that a node's latch still has the version read before
+    bool validate(pgid_t pageID, u64 version);
+
+    // the latches held by one writer, released when it goes out of scope
+    class WriteLatches {
+    public:
+        explicit WriteLatches(Btree &tree) : m_tree(tree) {}
+
+        // locks a node's latch if it still has the version read before. false means the node
+        // changed, and the operation has to restart.
+        bool lock(pgid_t pageID, u64 version);
+
+        // locks a node's latch whatever its version, waiting for the writer holding it, if any
+        void acquire(pgid_t pageID);
+
+        // releases the latches after the locked nodes were changed, so readers restart
+        void publish();
+
+        ~WriteLatches();
+
+    private:
+        Btree &m_tree;
+        Vec<std::pair<Latch *, u64>> m_held;
+    };
+
+    struct PathEntry {
+        pgid_t pageID;
+        u64 version;
+        std::shared_ptr<BtreeNodePage<T>> node;
+    };
+
+    // descends towards a key without locking, recording the nodes passed and their versions. If
+    // stopAtKey, stops at the first node holding the key and sets match to its cell. Returns false
+    // if a writer changed a node on the way, in which case the caller restarts.
+    bool descendOptimistic(const Vari &key, bool stopAtKey, Vec<PathEntry> &path, cellid_t &match);
+
+    // allocates the page of a node created by a concurrent insert. The page holds an empty leaf,
+    // which can be written back if evicted, until the node is published over it.
+    pgid_t allocateNode();
+
+    // points a child moved by a concurrent split to its new parent. The child is changed in place
+    // if the insert already holds a copy of it, or else copied to moved.
+    void adopt(pgid_t childPageID, pgid_t parentPageID, WriteLatches &latches, Vec<Ptr<BtreeNodePage<T>>> &copies,
+               Vec<Ptr<BtreeNodePage<T>>> &created, Vec<Ptr<BtreeNodePage<T>>> &moved);
 
     Pager &m_pager;
-    pgid_t m_rootPageID;
+    std::atomic<pgid_t> m_rootPageID;
     degree_t m_degree;
+    bool m_unique;
+    Ptr<Latch[]> m_latches;
 };
 
 } // namespace backend
@@ -9,18 +9,29 @@
 #include "BtreeNodePage.hpp"
 #include "assume.hpp"
 
+#include <thread>
+
 #define B_NODE(id) m_pager.getPage<BtreeNodePage<T>>(id)
+#define B_VIEW(id) m_pager.viewPage<BtreeNodePage<T>>(id)
 #define B_NEW(deg, par, root, leaf) m_pager.createNewPage<BtreeNodePage<T>>(deg, par, root, leaf);
 
 namespace backend {
 template<typename T>
-Btree<T>::Btree(pgid_t rootPageId, Pager &pgr, degree_t degree) : m_rootPageID(rootPageId), m_pager
-                                                          (pgr), m_degree(degree) {
+Btree<T>::Btree(pgid_t rootPageId, Pager &pgr, degree_t degree, bool unique) : m_pager(pgr),
+        m_rootPageID(rootPageId), m_degree(degree), m_unique(unique), m_latches(std::make_unique<Latch[]>(NUM_LATCHES)) {
 }
 
 template<typename T>
 void Btree<T>::deleteTree() {
-    // implement
+    deleteSubtree(m_rootPageID);
+}
+
+template<typename T>
+void Btree<T>::deleteSubtree(pgid_t currPageID) {
+    Vec<childid_t> children = B_VIEW(currPageID).getChildren();
+    for (pgid_t child: children)
+        deleteSubtree(child);
+    m_pager.freePage(currPageID);
 }
 
 template<typename T>
@@ -31,7 +42,7 @@ RowPos Btree<T>::searchRowPtr(Vari targ_key, pgid_t currPageID) {
     //      - if reached end of node, search for rightmost child
     // how do we know if doesnt exist? if leaf, and not found
 
-    auto &node = B_NODE(currPageID);
+    auto &node = B_VIEW(currPageID);
     auto &cells = node.cells();
     auto &children = node.getChildren();
     bool isLeaf = node.leaf();
@@ -68,12 +79,319 @@ RowPos Btree<T>::searchRowPtr(Vari targ_key, pgid_t currPageID) {
     return searchRowPtr(targ_key, children[idx]);
 }
 
+template<typename T>
+pgid_t Btree<T>::searchLeafUpper(const Vari &targ_key, pgid_t currPageID) {
+    auto &node = B_VIEW(currPageID);
+    if (node.leaf())
+        return currPageID;
+
+    auto &cells = node.cells();
+    cellid_t idx = 0;
+    while (idx < cells.size() && !(targ_key < cells[idx].key))
+        idx++;
+
+    return searchLeafUpper(targ_key, node.getChildren()[idx]);
+}
+
+template<typename T>
+void Btree<T>::collect(const Vari &targ_key, pgid_t currPageID, Vec<T> &out) {
+    // with duplicates, equal keys may sit in the child on either side of an equal separator,
+    // so every child whose key range touches targ_key has to be visited. the node is held, since
+    // it may be evicted while its children are visited.
+    auto node = m_pager.getSharedPage<BtreeNodePage<T>>(currPageID);
+    auto &cells = node->cells();
+    bool isLeaf = node->leaf();
+
+    for (cellid_t idx = 0; idx < cells.size(); idx++) {
+        if (targ_key < cells[idx].key) {
+            if (!isLeaf)
+                collect(targ_key, node->getChildren()[idx], out);
+            return;
+        }
+
+        if (cells[idx].key == targ_key) {
+            if (!isLeaf)
+                collect(targ_key, node->getChildren()[idx], out);
+            out.push_back(cells[idx].value);
+        }
+    }
+
+    if (!isLeaf)
+        collect(targ_key, node->getChildren()[cells.size()], out);
+}
+
+template<typename T>
+RowPos Btree<T>::searchEntry(const Vari &targ_key, const T &value, pgid_t currPageID) {
+    auto &node = B_VIEW(currPageID);
+    auto &cells = node.cells();
+    bool isLeaf = node.leaf();
+
+    for (cellid_t idx = 0; idx < cells.size(); idx++) {
+        if (targ_key < cells[idx].key) {
+            if (!isLeaf)
+                return searchEntry(targ_key, value, node.getChildren()[idx]);
+            return {currPageID, cts::CELLID_INVALID};
+        }
+
+        if (cells[idx].key == targ_key) {
+            if (!isLeaf) {
+                RowPos row = searchEntry(targ_key, value, node.getChildren()[idx]);
+                if (row.cellID != cts::CELLID_INVALID)
+                    return row;
+            }
+            if (cells[idx].value == value)
+                return {currPageID, idx};
+        }
+    }
+
+    if (!isLeaf)
+        return searchEntry(targ_key, value, node.getChildren()[cells.size()]);
+    return {currPageID, cts::CELLID_INVALID};
+}
+
 template<typename T>
 std::optional<T> Btree<T>::search(const Vari &key) {
     RowPos row = searchRowPtr(key, m_rootPageID);
     if (row.cellID == cts::CELLID_INVALID)
         return std::nullopt;
-    return B_NODE(row.pageID).cells()[row.cellID].value;
+    return B_VIEW(row.pageID).cells()[row.cellID].value;
+}
+
+template<typename T>
+Vec<T> Btree<T>::searchAll(const Vari &key) {
+    Vec<T> res;
+    collect(key, m_rootPageID, res);
+    return res;
+}
+
+template<typename T>
+template<typename Fn>
+void Btree<T>::forEach(Fn &&fn) {
+    forEach(m_rootPageID, fn);
+}
+
+template<typename T>
+template<typename Fn>
+void Btree<T>::forEach(pgid_t currPageID, Fn &fn) {
+    // hold the node itself, since it may be evicted while its children are visited
+    auto node = m_pager.getSharedPage<BtreeNodePage<T>>(currPageID);
+    auto &cells = node->cells();
+    bool isLeaf = node->leaf();
+
+    for (cellid_t idx = 0; idx < cells.size(); idx++) {
+        if (!isLeaf)
+            forEach(node->getChildren()[idx], fn);
+        fn(cells[idx].key, cells[idx].value);
+    }
+
+    if (!isLeaf && !node->getChildren().empty())
+        forEach(node->getChildren()[cells.size()], fn);
+}
+
+template<typename T>
+typename Btree<T>::Cursor Btree<T>::cursor() {
+    return Cursor(*this);
+}
+
+template<typename T>
+Btree<T>::Cursor::Cursor(Btree &tree) : m_tree(tree) {
+    descend(m_tree.m_rootPageID);
+}
+
+template<typename T>
+Btree<T>::Cursor::Cursor(Btree &tree, u64 rank) : m_tree(tree) {
+    if (rank >= m_tree.size())
+        return;
+
+    // skip whole subtrees by their counts, keeping the path in the same shape descend() leaves it
+    pgid_t pageID = m_tree.m_rootPageID;
+    while (true) {
+        auto node = m_tree.m_pager.template getSharedPage<BtreeNodePage<T>>(pageID);
+        if (node->leaf()) {
+            m_path.push_back({node, static_cast<size_t>(rank)});
+            return;
+        }
+
+        size_t idx = 0;
+        while (rank >= node->getChildCounts()[idx]) {
+            rank -= node->getChildCounts()[idx];
+            if (rank == 0) {
+                m_path.push_back({node, idx});
+                return;
+            }
+            rank--;
+            idx++;
+        }
+        m_path.push_back({node, idx});
+        pageID = node->getChildren()[idx];
+    }
+}
+
+template<typename T>
+const Vari &Btree<T>::Cursor::key() const {
+    ASSUME_S(valid(), "Cursor is past the last pair");
+    const auto &frame = m_path.back();
+    return frame.node->cells()[frame.idx].key;
+}
+
+template<typename T>
+const T &Btree<T>::Cursor::value() const {
+    ASSUME_S(valid(), "Cursor is past the last pair");
+    const auto &frame = m_path.back();
+    return frame.node->cells()[frame.idx].value;
+}
+
+template<typename T>
+void Btree<T>::Cursor::next() {
+    ASSUME_S(valid(), "Cursor is past the last pair");
+    auto &frame = m_path.back();
+    frame.idx++;
+    if (frame.node->leaf())
+        settle();
+    else
+        descend(frame.node->getChildren()[frame.idx]);
+}
+
+template<typename T>
+void Btree<T>::Cursor::descend(pgid_t pageID) {
+    while (true) {
+        auto node = m_tree.m_pager.template getSharedPage<BtreeNodePage<T>>(pageID);
+        bool isLeaf = node->leaf() || node->getChildren().empty();
+        m_path.push_back({node, 0});
+        if (isLeaf)
+            break;
+        pageID = node->getChildren()[0];
+    }
+    settle();
+}
+
+template<typename T>
+void Btree<T>::Cursor::settle() {
+    // a node whose cells were all visited is done, as its last child was visited before
+    while (!m_path.empty() && m_path.back().idx >= m_path.back().node->cells().size())
+        m_path.pop_back();
+}
+
+template<typename T>
+std::pair<u32, Vec<pgid_t>> Btree<T>::partition(size_t minSubtrees) {
+    u32 depth = 0;
+    Vec<pgid_t> level{m_rootPageID};
+
+    while (level.size() < minSubtrees && !B_VIEW(level.front()).leaf()) {
+        Vec<pgid_t> next;
+        for (pgid_t pageID: level) {
+            const auto &children = B_VIEW(pageID).getChildren();
+            next.insert(next.end(), children.begin(), children.end());
+        }
+        level = std::move(next);
+        depth++;
+    }
+
+    return {depth, level};
+}
+
+template<typename T>
+template<typename Fn>
+void Btree<T>::forEachInSubtree(pgid_t subtreePageID, Fn &&fn) {
+    forEach(subtreePageID, fn);
+}
+
+template<typename T>
+template<typename Fn>
+void Btree<T>::forEachAbove(u32 depth, Fn &&fn) {
+    forEachAbove(m_rootPageID, depth, fn);
+}
+
+template<typename T>
+template<typename Fn>
+void Btree<T>::forEachAbove(pgid_t currPageID, u32 depth, Fn &fn) {
+    if (depth == 0)
+        return;
+
+    auto node = m_pager.getSharedPage<BtreeNodePage<T>>(currPageID);
+    for (const auto &cell: node->cells())
+        fn(cell.key, cell.value);
+
+    if (!node->leaf())
+        for (pgid_t child: node->getChildren())
+            forEachAbove(child, depth - 1, fn);
+}
+
+template<typename T>
+u64 Btree<T>::size() {
+    return B_VIEW(m_rootPageID).subtreeSize();
+}
+
+template<typename T>
+u64 Btree<T>::countBelow(const Vari &key, bool inclusive) {
+    // every cell passed on the way down counts, along with the whole subtree to its left
+    u64 count = 0;
+    pgid_t currPageID = m_rootPageID;
+    while (true) {
+        auto &node = B_VIEW(currPageID);
+        auto &cells = node.cells();
+        cellid_t idx = 0;
+        while (idx < cells.size() && (cells[idx].key < key || (inclusive && cells[idx].key == key))) {
+            if (!node.leaf())
+                count += node.getChildCounts()[idx];
+            count++;
+            idx++;
+        }
+
+        if (node.leaf() || node.getChildren().empty())
+            return count;
+        currPageID = node.getChildren()[idx];
+    }
+}
+
+template<typename T>
+u64 Btree<T>::rank(const Vari &key) {
+    return countBelow(key, false);
+}
+
+template<typename T>
+u64 Btree<T>::countRange(const Vari &lo, const Vari &hi) {
+    if (hi < lo)
+        return 0;
+    return countBelow(hi, true) - countBelow(lo, false);
+}
+
+template<typename T>
+std::optional<T> Btree<T>::selectByRank(u64 rank) {
+    Cursor cursor = cursorAt(rank);
+    if (!cursor.valid())
+        return std::nullopt;
+    return cursor.value();
+}
+
+template<typename T>
+typename Btree<T>::Cursor Btree<T>::cursorAt(u64 rank) {
+    return Cursor(*this, rank);
+}
+
+template<typename T>
+void Btree<T>::adjustCounts(pgid_t currPageID, int delta) {
+    while (!B_NODE(currPageID).root()) {
+        pgid_t parentID = B_NODE(currPageID).parent();
+        auto &parent = B_NODE(parentID);
+        parent.getChildCounts()[childIndex(parent, currPageID)] += delta;
+        currPageID = parentID;
+    }
+}
+
+template<typename T>
+childid_t Btree<T>::childIndex(BtreeNodePage<T> &parent, pgid_t childPageID) {
+    auto &p_children = parent.getChildren();
+    childid_t idx = cts::CHILDID_INVALID;
+    for (childid_t i = 0; i < p_children.size(); i++) {
+        if (p_children[i] == childPageID) {
+            idx = i;
+            break;
+        }
+    }
+
+    ASSUME_S(idx != cts::CHILDID_INVALID, "Node not found in parent's list of children");
+    return idx;
 }
 
 template<typename T>
@@ -88,10 +406,15 @@ bool Btree<T>::update(T values, const Vari &key) {
 template<typename T>
 bool Btree<T>::insert(T values, Vari key) {
     // 1. find node that cell belongs in
-    //      1b. if node already contains the key, return false
-    RowPos row = searchRowPtr(key, m_rootPageID);
-    if (row.cellID != cts::CELLID_INVALID)
-        return false;
+    //      1b. if node already contains the key, return false (unless duplicates are allowed)
+    RowPos row{};
+    if (m_unique) {
+        row = searchRowPtr(key, m_rootPageID);
+        if (row.cellID != cts::CELLID_INVALID)
+            return false;
+    } else {
+        row.pageID = searchLeafUpper(key, m_rootPageID);
+    }
 
     ASSUME_S(B_NODE(row.pageID).leaf(), "Attempting to insert into non-leaf node");
 
@@ -99,40 +422,35 @@ bool Btree<T>::insert(T values, Vari key) {
     //      2b. find position that cell belongs in
     auto &cells = B_NODE(row.pageID).cells();
     cellid_t idx = 0;
-    while (idx < cells.size() && cells[idx].key < key)
+    while (idx < cells.size() && !(key < cells[idx].key))
         idx++;
     cells.insert(cells.begin() + idx, {key, values});
+    adjustCounts(row.pageID, 1);
 
     // 3. call split on the leaf we inserted into
-    split(row.pageID);
+    metrics().insertSplits.record(split(row.pageID));
     return true;
 }
 
 template<typename T>
-void Btree<T>::split(pgid_t currPageID) {
+u32 Btree<T>::split(pgid_t currPageID) {
     //    1. if node is NOT full, return (doesn't need to be split)
     auto &node = B_NODE(currPageID);
     auto &cells = node.cells();
     auto &children = node.getChildren();
 
     if (cells.size() < node.maxKeys())
-        return;
+        return 0;
+    metrics().splits.add();
 
     //    2. if NOT root
     if (!node.root()) {
         //    2b. find the current node page id in the parent's children[], store as IDX
         auto &parent = B_NODE(node.parent());
         auto &p_children = parent.getChildren();
+        auto &p_counts = parent.getChildCounts();
         auto &p_cells = parent.cells();
-        childid_t idx = cts::CHILDID_INVALID;
-        for (childid_t i = 0; i < p_children.size(); i++) {
-            if (p_children[i] == currPageID) {
-                idx = i;
-                break;
-            }
-        }
-
-        ASSUME_S(idx != cts::CHILDID_INVALID, "Node not found in parent's list of children");
+        childid_t idx = childIndex(parent, currPageID);
 
         //    2c. move median cell of curr node to IDX position of parent node
         childid_t median = cells.size() / 2;
@@ -152,15 +470,19 @@ void Btree<T>::split(pgid_t currPageID) {
         if (!node.leaf()) {
             // if not leaf, we need to copy over children as well
             n_children.assign(children.begin() + median + 1, children.end());
+            newNode.getChildCounts().assign(node.getChildCounts().begin() + median + 1, node.getChildCounts().end());
             // update parent ptrs of children
             for (auto pg: n_children)
                 B_NODE(pg).setParent(newNode.getPageID());
             children.resize(median + 1);
+            node.getChildCounts().resize(median + 1);
         }
 
         //    2e. insert new pageID into parent node children[] (into the position
         //    where you deleted IDX originally (plus one for right node)
         p_children.insert(p_children.begin() + idx + 1, newNode.getPageID());
+        p_counts[idx] = node.subtreeSize();
+        p_counts.insert(p_counts.begin() + idx + 1, newNode.subtreeSize());
     } else {
         //    3. if IS root
         //        3b. create new node (new root) with middle cell of curr node as the single cell
@@ -190,28 +512,444 @@ void Btree<T>::split(pgid_t currPageID) {
         if (!node.leaf()) {
             // if not leaf, we need to copy over children as well
             n_children.assign(children.begin() + median + 1, children.end());
+            newNode.getChildCounts().assign(node.getChildCounts().begin() + median + 1, node.getChildCounts().end());
             // update parent ptrs of children
             for (auto pg: n_children)
                 B_NODE(pg).setParent(newNode.getPageID());
             children.resize(median + 1);
+            node.getChildCounts().resize(median + 1);
         }
 
         //    3d. insert new pageIDs into parent node children[]
         //             - (it should be empty so just insert anywhere)
         p_children.push_back(currPageID);
         p_children.push_back(newNode.getPageID());
+        newRoot.getChildCounts().push_back(node.subtreeSize());
+        newRoot.getChildCounts().push_back(newNode.subtreeSize());
     }
 
     //    4. call split on parent (if not root)
     if (!node.root())
-        split(node.parent());
+        return 1 + split(node.parent());
+    return 1;
 }
 
 template<typename T>
 bool Btree<T>::remove(Vari key) {
-    // TODO: Implement B-tree removal logic
-    // For now, return false as removal is not implemented
-    return false;
+    RowPos row = searchRowPtr(key, m_rootPageID);
+    if (row.cellID == cts::CELLID_INVALID)
+        return false;
+
+    removeAt(row);
+    return true;
+}
+
+template<typename T>
+bool Btree<T>::remove(const Vari &key, const T &value) {
+    RowPos row = searchEntry(key, value, m_rootPageID);
+    if (row.cellID == cts::CELLID_INVALID)
+        return false;
+
+    removeAt(row);
+    return true;
+}
+
+template<typename T>
+void Btree<T>::removeAt(RowPos row) {
+    auto &node = B_NODE(row.pageID);
+    auto &cells = node.cells();
+
+    //    1. if leaf, just erase the cell and fix the leaf
+    if (node.leaf()) {
+        cells.erase(cells.begin() + row.cellID);
+        adjustCounts(row.pageID, -1);
+        rebalance(row.pageID);
+        return;
+    }
+
+    //    2. otherwise, replace the cell with its predecessor (the largest cell of the left subtree),
+    //    which always lives in a leaf, and fix that leaf instead
+    pgid_t predID = node.getChildren()[row.cellID];
+    while (!B_NODE(predID).leaf())
+        predID = B_NODE(predID).getChildren().back();
+
+    auto &pred = B_NODE(predID);
+    cells[row.cellID] = pred.cells().back();
+    pred.cells().pop_back();
+    adjustCounts(predID, -1);
+    rebalance(predID);
+}
+
+template<typename T>
+void Btree<T>::rebalance(pgid_t currPageID) {
+    auto &node = B_NODE(currPageID);
+    auto &cells = node.cells();
+    auto &children = node.getChildren();
+
+    //    1. if root, only shrink the tree when an internal root has run out of cells
+    if (node.root()) {
+        if (cells.empty() && !node.leaf()) {
+            auto &child = B_NODE(children[0]);
+            child.setRoot(true);
+            child.setParent(cts::PGID_INVALID);
+            m_rootPageID = child.getPageID();
+            m_pager.freePage(currPageID);
+        }
+        return;
+    }
+
+    //    2. if node still has enough keys, nothing to fix
+    if (cells.size() >= node.minKeys())
+        return;
+
+    //    3. find the current node in the parent's children[], store as IDX
+    auto &parent = B_NODE(node.parent());
+    auto &p_children = parent.getChildren();
+    auto &p_counts = parent.getChildCounts();
+    auto &p_cells = parent.cells();
+    childid_t idx = childIndex(parent, currPageID);
+
+    //    4. borrow from left sibling through the parent separator
+    if (idx > 0) {
+        auto &left = B_NODE(p_children[idx - 1]);
+        if (left.cells().size() > left.minKeys()) {
+            cells.insert(cells.begin(), p_cells[idx - 1]);
+            p_cells[idx - 1] = left.cells().back();
+            left.cells().pop_back();
+
+            if (!node.leaf()) {
+                childid_t moved = left.getChildren().back();
+                left.getChildren().pop_back();
+                children.insert(children.begin(), moved);
+                node.getChildCounts().insert(node.getChildCounts().begin(), left.getChildCounts().back());
+                left.getChildCounts().pop_back();
+                B_NODE(moved).setParent(currPageID);
+            }
+            p_counts[idx - 1] = left.subtreeSize();
+            p_counts[idx] = node.subtreeSize();
+            metrics().borrows.add();
+            return;
+        }
+    }
+
+    //    5. borrow from right sibling through the parent separator
+    if (idx + 1 < p_children.size()) {
+        auto &right = B_NODE(p_children[idx + 1]);
+        if (right.cells().size() > right.minKeys()) {
+            cells.push_back(p_cells[idx]);
+            p_cells[idx] = right.cells().front();
+            right.cells().erase(right.cells().begin());
+
+            if (!node.leaf()) {
+                childid_t moved = right.getChildren().front();
+                right.getChildren().erase(right.getChildren().begin());
+                children.push_back(moved);
+                node.getChildCounts().push_back(right.getChildCounts().front());
+                right.getChildCounts().erase(right.getChildCounts().begin());
+                B_NODE(moved).setParent(currPageID);
+            }
+            p_counts[idx] = node.subtreeSize();
+            p_counts[idx + 1] = right.subtreeSize();
+            metrics().borrows.add();
+            return;
+        }
+    }
+
+    //    6. neither sibling can lend, so merge with one of them (right node into left node),
+    //    pulling the separator down from the parent
+    childid_t sep = idx > 0 ? idx - 1 : idx;
+    auto &left = B_NODE(p_children[sep]);
+    auto &right = B_NODE(p_children[sep + 1]);
+
+    left.cells().push_back(p_cells[sep]);
+    left.cells().insert(left.cells().end(), right.cells().begin(), right.cells().end());
+
+    if (!left.leaf()) {
+        for (auto pg: right.getChildren())
+            B_NODE(pg).setParent(left.getPageID());
+        left.getChildren().insert(left.getChildren().end(), right.getChildren().begin(),
+                                  right.getChildren().end());
+        left.getChildCounts().insert(left.getChildCounts().end(), right.getChildCounts().begin(),
+                                     right.getChildCounts().end());
+    }
+
+    m_pager.freePage(right.getPageID());
+    metrics().merges.add();
+    p_cells.erase(p_cells.begin() + sep);
+    p_children.erase(p_children.begin() + sep + 1);
+    p_counts.erase(p_counts.begin() + sep + 1);
+    p_counts[sep] = left.subtreeSize();
+
+    //    7. parent lost a cell, so it may need fixing as well
+    rebalance(parent.getPageID());
+}
+
+template<typename T>
+u64 Btree<T>::readVersion(pgid_t pageID) {
+    auto &version = latch(pageID).version;
+    u64 v = version.load(std::memory_order_acquire);
+    while (v & 1) {
+        std::this_thread::yield();
+        v = version.load(std::memory_order_acquire);
+    }
+    return v;
+}
+
+template<typename T>
+bool Btree<T>::validate(pgid_t pageID, u64 version) {
+    return latch(pageID).version.load(std::memory_order_acquire) == version;
+}
+
+template<typename T>
+bool Btree<T>::WriteLatches::lock(pgid_t pageID, u64 version) {
+    // nodes sharing a latch are covered by a single lock
+    Latch *l = &m_tree.latch(pageID);
+    for (const auto &[held, heldVersion]: m_held)
+        if (held == l)
+            return heldVersion == version;
+
+    if (!l->version.compare_exchange_strong(version, version + 1, std::memory_order_acquire))
+        return false;
+    m_held.emplace_back(l, version);
+    return true;
+}
+
+template<typename T>
+void Btree<T>::WriteLatches::acquire(pgid_t pageID) {
+    Latch *l = &m_tree.latch(pageID);
+    for (const auto &[held, heldVersion]: m_held)
+        if (held == l)
+            return;
+
+    while (true) {
+        u64 version = m_tree.readVersion(pageID);
+        if (l->version.compare_exchange_weak(version, version + 1, std::memory_order_acquire)) {
+            m_held.emplace_back(l, version);
+            return;
+        }
+    }
+}
+
+template<typename T>
+void Btree<T>::WriteLatches::publish() {
+    for (auto &[l, version]: m_held)
+        l->version.store(version + 2, std::memory_order_release);
+    m_held.clear();
+}
+
+template<typename T>
+Btree<T>::WriteLatches::~WriteLatches() {
+    // nothing was changed, so readers that passed these nodes need not restart
+    for (auto &[l, version]: m_held)
+        l->version.store(version, std::memory_order_release);
+}
+
+template<typename T>
+bool Btree<T>::descendOptimistic(const Vari &key, bool stopAtKey, Vec<PathEntry> &path,
+                                 cellid_t &match) {
+    path.clear();
+    match = cts::CELLID_INVALID;
+
+    // the root may have split between reading its page ID and its version
+    pgid_t pageID = m_rootPageID.load(std::memory_order_acquire);
+    u64 version = readVersion(pageID);
+    if (m_rootPageID.load(std::memory_order_acquire) != pageID)
+        return false;
+
+    while (true) {
+        auto node = m_pager.getSharedPage<BtreeNodePage<T>>(pageID);
+        path.push_back({pageID, version, node});
+        auto &cells = node->cells();
+
+        cellid_t idx = 0;
+        if (stopAtKey) {
+            while (idx < cells.size() && cells[idx].key < key)
+                idx++;
+            if (idx < cells.size() && cells[idx].key == key) {
+                match = idx;
+                return validate(pageID, version);
+            }
+        } else {
+            while (idx < cells.size() && !(key < cells[idx].key))
+                idx++;
+        }
+
+        if (node->leaf())
+            return validate(pageID, version);
+
+        // the child's version only counts if the parent still pointed to it when it was read
+        pgid_t childID = node->getChildren()[idx];
+        u64 childVersion = readVersion(childID);
+        if (!validate(pageID, version))
+            return false;
+        pageID = childID;
+        version = childVersion;
+    }
+}
+
+template<typename T>
+std::optional<T> Btree<T>::concurrentSearch(const Vari &key) {
+    Vec<PathEntry> path;
+    cellid_t match;
+    while (!descendOptimistic(key, true, path, match))
+        metrics().restarts.add();
+
+    if (match == cts::CELLID_INVALID)
+        return std::nullopt;
+    // the node is never changed in place, so it can be read after validating
+    return path.back().node->cells()[match].value;
+}
+
+template<typename T>
+bool Btree<T>::concurrentUpdate(T values, const Vari &key) {
+    Vec<PathEntry> path;
+    cellid_t match;
+    // every pass after the first is a restart
+    for (bool first = true;; first = false) {
+        if (!first)
+            metrics().restarts.add();
+        if (!descendOptimistic(key, true, path, match))
+            continue;
+        if (match == cts::CELLID_INVALID)
+            return false;
+
+        WriteLatches latches(*this);
+        if (!latches.lock(path.back().pageID, path.back().version))
+            continue;
+
+        auto copy = path.back().node->clone();
+        copy->cells()[match].value = std::move(values);
+        m_pager.replacePage(std::move(copy));
+        latches.publish();
+        return true;
+    }
+}
+
+template<typename T>
+bool Btree<T>::concurrentInsert(T values, const Vari &key) {
+    Vec<PathEntry> path;
+    cellid_t match;
+    // every pass after the first is a restart
+    for (bool first = true;; first = false) {
+        if (!first)
+            metrics().restarts.add();
+        if (!descendOptimistic(key, m_unique, path, match))
+            continue;
+        if (match != cts::CELLID_INVALID)
+            return false;
+
+        // every ancestor's count of the leaf's subtree grows, so the whole path is changed
+        WriteLatches latches(*this);
+        bool locked = true;
+        for (size_t i = 0; i < path.size() && locked; i++)
+            locked = latches.lock(path[i].pageID, path[i].version);
+        if (!locked)
+            continue;
+
+        // the locked nodes are unchanged since the descent, so their copies are up to date
+        Vec<Ptr<BtreeNodePage<T>>> copies;
+        for (const auto &entry: path)
+            copies.push_back(entry.node->clone());
+        for (size_t i = 0; i + 1 < copies.size(); i++)
+            copies[i]->getChildCounts()[childIndex(*copies[i], copies[i + 1]->getPageID())]++;
+
+        auto &leafCells = copies.back()->cells();
+        cellid_t pos = 0;
+        while (pos < leafCells.size() && !(key < leafCells[pos].key))
+            pos++;
+        leafCells.insert(leafCells.begin() + pos, {key, std::move(values)});
+
+        // split bottom-up like split(), giving the children moved to a new node their new parent
+        Vec<Ptr<BtreeNodePage<T>>> created;
+        Vec<Ptr<BtreeNodePage<T>>> moved;
+        pgid_t newRootID = cts::PGID_INVALID;
+        u32 splits = 0;
+        for (size_t i = copies.size() - 1; copies[i]->cells().size() >= copies[i]->maxKeys(); i--) {
+            splits++;
+            auto &node = *copies[i];
+            auto &cells = node.cells();
+            childid_t median = cells.size() / 2;
+            auto medianCell = cells[median];
+
+            pgid_t parentID = node.root() ? allocateNode() : copies[i - 1]->getPageID();
+            auto newNode = std::make_unique<BtreeNodePage<T>>(m_degree, parentID, false, node.leaf(),
+                                                              allocateNode());
+            newNode->cells().assign(cells.begin() + median + 1, cells.end());
+            cells.resize(median);
+            if (!node.leaf()) {
+                auto &children = node.getChildren();
+                auto &counts = node.getChildCounts();
+                newNode->getChildren().assign(children.begin() + median + 1, children.end());
+                newNode->getChildCounts().assign(counts.begin() + median + 1, counts.end());
+                children.resize(median + 1);
+                counts.resize(median + 1);
+                for (pgid_t child: newNode->getChildren())
+                    adopt(child, newNode->getPageID(), latches, copies, created, moved);
+            }
+
+            if (node.root()) {
+                auto newRoot = std::make_unique<BtreeNodePage<T>>(m_degree, cts::PGID_INVALID, true,
+                                                                  false, parentID);
+                newRoot->cells().push_back(std::move(medianCell));
+                newRoot->getChildren() = {node.getPageID(), newNode->getPageID()};
+                newRoot->getChildCounts() = {static_cast<u32>(node.subtreeSize()),
+                                             static_cast<u32>(newNode->subtreeSize())};
+                node.setRoot(false);
+                node.setParent(parentID);
+                newRootID = parentID;
+                created.push_back(std::move(newNode));
+                created.push_back(std::move(newRoot));
+                break;
+            }
+
+            auto &parent = *copies[i - 1];
+            childid_t idx = childIndex(parent, node.getPageID());
+            parent.cells().insert(parent.cells().begin() + idx, std::move(medianCell));
+            parent.getChildren().insert(parent.getChildren().begin() + idx + 1, newNode->getPageID());
+            parent.getChildCounts()[idx] = node.subtreeSize();
+            parent.getChildCounts().insert(parent.getChildCounts().begin() + idx + 1, newNode->subtreeSize());
+            created.push_back(std::move(newNode));
+        }
+
+        metrics().splits.add(splits);
+        metrics().insertSplits.record(splits);
+
+        // new nodes go first, so they are complete before any published node points to them
+        for (auto &node: created)
+            m_pager.replacePage(std::move(node));
+        for (auto &node: moved)
+            m_pager.replacePage(std::move(node));
+        for (auto it = copies.rbegin(); it != copies.rend(); ++it)
+            m_pager.replacePage(std::move(*it));
+        if (newRootID != cts::PGID_INVALID)
+            m_rootPageID.store(newRootID, std::memory_order_release);
+        latches.publish();
+        return true;
+    }
+}
+
+template<typename T>
+pgid_t Btree<T>::allocateNode() {
+    return m_pager.createNewPageID<BtreeNodePage<T>>(m_degree, cts::PGID_INVALID, false, true);
+}
+
+template<typename T>
+void Btree<T>::adopt(pgid_t childPageID, pgid_t parentPageID, WriteLatches &latches,
+                     Vec<Ptr<BtreeNodePage<T>>> &copies, Vec<Ptr<BtreeNodePage<T>>> &created,
+                     Vec<Ptr<BtreeNodePage<T>>> &moved) {
+    // the child may itself be a node changed or created by the same insert
+    for (auto *nodes: {&copies, &created})
+        for (auto &node: *nodes)
+            if (node->getPageID() == childPageID) {
+                node->setParent(parentPageID);
+                return;
+            }
+
+    // a concurrent update may be replacing the child, so it is locked before being copied
+    latches.acquire(childPageID);
+    auto child = m_pager.getSharedPage<BtreeNodePage<T>>(childPageID)->clone();
+    child->setParent(parentPageID);
+    moved.push_back(std::move(child));
 }
 } // namespace backend
 
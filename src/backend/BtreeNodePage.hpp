@@ -23,6 +23,7 @@ namespace backend {
  * 2. Non-leaf nodes have numCells + 1 children if numCells is nonzero, and 0 children otherwise.
  * 3. If the Btree Node stores tuples, each tuple has the same fixed number of attributes.
  * 4. The node has no more than 'getMaxKeys()' number of cells.
+ * 5. Non-leaf nodes store one subtree count per child.
  */
 template<typename T>
 class BtreeNodePage : public Page {
@@ -55,12 +56,28 @@ public:
      * @return A list of pageIDs to children nodes.
      */
     Vec<childid_t> &getChildren() { return m_children; }
+    const Vec<childid_t> &getChildren() const { return m_children; }
+
+    /**
+     * @brief Retrieves the number of cells in the subtree under each child, in the same order as
+     * getChildren().
+     * @return A list of subtree counts. Empty for leaf nodes.
+     */
+    Vec<u32> &getChildCounts() { return m_childCounts; }
+    const Vec<u32> &getChildCounts() const { return m_childCounts; }
+
+    /**
+     * @brief Counts the cells in the subtree rooted at this node.
+     * @return The node's own cells plus the counts of all its children.
+     */
+    u64 subtreeSize() const;
 
     /**
      * @brief Retrieves all the stored key-tuple cells in the node.
      * @return A list of key-tuple pairs that represent a row in the database.
      */
     Vec<cell> &cells() { return m_cells; }
+    const Vec<cell> &cells() const { return m_cells; }
 
     /**
      * @brief Retrieves the parent node ID.
@@ -110,6 +127,12 @@ public:
      */
     void setParent(uint32_t parent) { m_parentID = parent; }
 
+    /**
+     * @brief Copies the node, so the copy can be changed while others keep reading this one.
+     * @return A new node with the same page ID and contents.
+     */
+    Ptr<BtreeNodePage> clone() const;
+
     /**
      * @brief Serializes the B-tree node into a byte vector.
      * @param buffer The byte vector to store serialized data.
@@ -122,6 +145,7 @@ private:
     bool m_leaf;
     bool m_root;
     Vec<childid_t> m_children;
+    Vec<u32> m_childCounts;
     Vec<cell> m_cells;
 };
 
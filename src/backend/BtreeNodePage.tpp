@@ -18,6 +18,7 @@ namespace backend {
 //
 //    vector<variants> m_types;
 //    vector<size_t> m_children;
+//    vector<u32> m_childCounts;
 //    vector<cell> m_cells;
 
 //    cell {
@@ -28,7 +29,16 @@ namespace backend {
 template<typename T>
 BtreeNodePage<T>::BtreeNodePage(u16 deg, pgid_t parentID, bool is_root, bool is_leaf, pgid_t pageID)
         : Page(pageID), m_leaf(is_leaf), m_root(is_root), m_degree(deg), m_parentID(parentID),
-          m_children(0), m_cells(0) {
+          m_children(0), m_childCounts(0), m_cells(0) {
+}
+
+template<typename T>
+Ptr<BtreeNodePage<T>> BtreeNodePage<T>::clone() const {
+    auto copy = std::make_unique<BtreeNodePage<T>>(m_degree, m_parentID, m_root, m_leaf, m_pageID);
+    copy->m_children = m_children;
+    copy->m_childCounts = m_childCounts;
+    copy->m_cells = m_cells;
+    return copy;
 }
 
 template<typename T>
@@ -93,6 +103,13 @@ BtreeNodePage<T>::BtreeNodePage(std::span<const byte> bytes, pgid_t pageID) : Pa
             m_children.push_back(child_id);
         }
 
+    if (!m_leaf)
+        for (int i = 0; i < numCells + 1; i++) {
+            u32 count;
+            db_deserialize(count, bytes, offset);
+            m_childCounts.push_back(count);
+        }
+
     ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
 }
 
@@ -117,6 +134,8 @@ void BtreeNodePage<T>::toBytes(std::span<byte> buf) {
         return true;
     }, "Intermediate node has incorrect number of cells, or is empty (intermediate nodes cannot be empty)");
 
+    ASSUME_S(m_childCounts.size() == m_children.size(), "Node has incorrect number of subtree counts");
+
     offset_t offset = 0;
 
     pgtypeid_t page_type_id = cts::pg_type_id::BTREE_NODE_PAGE;
@@ -161,9 +180,21 @@ void BtreeNodePage<T>::toBytes(std::span<byte> buf) {
         for (int i = 0; i < numCells + 1; i++)
             db_serialize(m_children[i], buf, offset);
 
+    if (!m_leaf)
+        for (int i = 0; i < numCells + 1; i++)
+            db_serialize(m_childCounts[i], buf, offset);
+
     ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
 }
 
+template<typename T>
+u64 BtreeNodePage<T>::subtreeSize() const {
+    u64 size = m_cells.size();
+    for (u32 count: m_childCounts)
+        size += count;
+    return size;
+}
+
 } // namespace backend
 
 #endif //KNDB_BTREENODEPAGE_TPP
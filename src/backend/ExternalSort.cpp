@@ -0,0 +1,161 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "ExternalSort.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+namespace {
+
+// compares two tuples by the sort keys
+bool sortsBefore(const Vec<SortKey> &keys, const Vec<Vari> &a, const Vec<Vari> &b) {
+    for (const auto &key: keys) {
+        const Vari &lhs = a[key.column];
+        const Vari &rhs = b[key.column];
+        if (lhs == rhs)
+            continue;
+        return key.descending ? rhs < lhs : lhs < rhs;
+    }
+    return false;
+}
+
+// approximate number of bytes a buffered tuple occupies
+size_t footprint(const Vec<Vari> &tuple) {
+    size_t size = sizeof(Vari) * tuple.size() + sizeof(Vec<Vari>);
+    for (const auto &value: tuple)
+        if (auto str = std::get_if<string>(&value))
+            size += str->capacity();
+    return size;
+}
+
+/**
+ * Merges sorted runs through a loser tree. Each inner node of the tree holds the run that lost
+ * the comparison at that node, and node 0 holds the overall winner. After the winner's run
+ * advances, only the comparisons on the path from its leaf to the root are replayed.
+ */
+class MergeCursor : public TupleCursor {
+public:
+    MergeCursor(Vec<SortKey> keys, Vec<Ptr<SpillRun>> runs) : m_keys(std::move(keys)), m_runs(std::move(runs)) {
+        for (const auto &run: m_runs)
+            m_cursors.push_back(run->cursor());
+        m_tree.resize(m_runs.size());
+        m_tree[0] = build(1);
+    }
+
+    bool valid() const override { return m_cursors[m_tree[0]].valid(); }
+
+    const Vec<Vari> &tuple() const override { return m_cursors[m_tree[0]].tuple(); }
+
+    void next() override {
+        size_t winner = m_tree[0];
+        m_cursors[winner].next();
+
+        // leaves are numbered after the inner nodes, so leaf i is node i + k
+        for (size_t node = (winner + m_runs.size()) / 2; node > 0; node /= 2)
+            if (beats(m_tree[node], winner))
+                std::swap(m_tree[node], winner);
+        m_tree[0] = winner;
+    }
+
+private:
+    // plays the matches of a subtree, and returns its winner
+    size_t build(size_t node) {
+        if (node >= m_runs.size())
+            return node - m_runs.size();
+
+        size_t left = build(2 * node);
+        size_t right = build(2 * node + 1);
+        bool leftWins = beats(left, right);
+        m_tree[node] = leftWins ? right : left;
+        return leftWins ? left : right;
+    }
+
+    // exhausted runs lose to everything; ties go to the earlier run, keeping the merge stable
+    bool beats(size_t a, size_t b) const {
+        if (!m_cursors[a].valid())
+            return false;
+        if (!m_cursors[b].valid())
+            return true;
+        if (sortsBefore(m_keys, m_cursors[a].tuple(), m_cursors[b].tuple()))
+            return true;
+        if (sortsBefore(m_keys, m_cursors[b].tuple(), m_cursors[a].tuple()))
+            return false;
+        return a < b;
+    }
+
+    Vec<SortKey> m_keys;
+    Vec<Ptr<SpillRun>> m_runs;
+    Vec<SpillRun::Cursor> m_cursors;
+    Vec<size_t> m_tree;
+};
+
+} // namespace
+
+ExternalSort::ExternalSort(Pager &pager, Vec<Vari> types, Vec<SortKey> keys, size_t memoryBudget)
+        : m_pager(pager), m_types(std::move(types)), m_keys(std::move(keys)), m_memoryBudget(memoryBudget),
+          m_memoryUsed(0) {
+    for (const auto &key: m_keys)
+        if (key.column >= m_types.size())
+            throw std::invalid_argument("Sort column is out of range.");
+}
+
+void ExternalSort::add(Vec<Vari> tuple) {
+    m_memoryUsed += footprint(tuple);
+    m_buffer.push_back(std::move(tuple));
+    if (m_memoryUsed > m_memoryBudget)
+        writeRun();
+}
+
+Ptr<TupleCursor> ExternalSort::finish() {
+    if (m_runs.empty()) {
+        std::stable_sort(m_buffer.begin(), m_buffer.end(), [this](const Vec<Vari> &a, const Vec<Vari> &b) {
+            return sortsBefore(m_keys, a, b);
+        });
+        return std::make_unique<VectorCursor>(std::move(m_buffer));
+    }
+    if (!m_buffer.empty())
+        writeRun();
+
+    // merge the earliest runs into one until a single merge can read them all; merging runs in
+    // order of creation keeps the sort stable
+    size_t fanIn = getFanIn();
+    while (m_runs.size() > fanIn) {
+        Vec<Ptr<SpillRun>> group;
+        for (size_t i = 0; i < fanIn; i++)
+            group.push_back(std::move(m_runs[i]));
+
+        auto merged = std::make_unique<SpillRun>(m_pager, m_types);
+        for (MergeCursor merge(m_keys, std::move(group)); merge.valid(); merge.next())
+            merged->append(merge.tuple());
+
+        m_runs.erase(m_runs.begin(), m_runs.begin() + fanIn);
+        m_runs.insert(m_runs.begin(), std::move(merged));
+    }
+
+    return std::make_unique<MergeCursor>(m_keys, std::move(m_runs));
+}
+
+void ExternalSort::writeRun() {
+    std::stable_sort(m_buffer.begin(), m_buffer.end(), [this](const Vec<Vari> &a, const Vec<Vari> &b) {
+        return sortsBefore(m_keys, a, b);
+    });
+
+    auto run = std::make_unique<SpillRun>(m_pager, m_types);
+    for (auto &tuple: m_buffer)
+        run->append(std::move(tuple));
+    m_runs.push_back(std::move(run));
+
+    m_buffer.clear();
+    m_memoryUsed = 0;
+}
+
+size_t ExternalSort::getFanIn() const {
+    return std::max<size_t>(2, m_memoryBudget / (2 * cts::PG_SZ));
+}
+
+} // namespace backend
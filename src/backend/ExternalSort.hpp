@@ -0,0 +1,94 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_EXTERNALSORT_HPP
+#define KNDB_EXTERNALSORT_HPP
+
+#include "Pager.hpp"
+#include "SpillRun.hpp"
+#include "TupleCursor.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * A column to sort by, and its direction.
+ */
+struct SortKey {
+    u16 column;
+    bool descending = false;
+};
+
+/**
+ * @class ExternalSort
+ * @brief Sorts tuples that may not fit in memory.
+ *
+ * Tuples are buffered until they exceed the memory budget, then sorted and written out as a run
+ * of temporary SpillPages. Once all tuples were added, the runs are merged through a loser tree,
+ * which finds the next tuple out of k runs with about log2(k) comparisons. If there are more runs
+ * than the budget can hold a page of each for, groups of runs are first merged into longer ones.
+ * Every temporary page is freed once the sorted tuples have been read.
+ *
+ * The sort is stable: tuples comparing equal keep the order they were added in.
+ */
+class ExternalSort {
+public:
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+
+    /**
+     * @brief Prepares a sort.
+     * @param pager Pager to allocate temporary pages from.
+     * @param types The types of the tuples to sort.
+     * @param keys The columns to sort by, most significant first.
+     * @param memoryBudget Approximate number of bytes the buffered tuples may occupy in memory.
+     *
+     * @throws std::invalid_argument if a key column is out of range.
+     */
+    ExternalSort(Pager &pager, Vec<Vari> types, Vec<SortKey> keys, size_t memoryBudget = DEFAULT_MEMORY_BUDGET);
+
+    /**
+     * @brief Adds a tuple to sort.
+     * @param tuple The tuple. Must have the types given to the constructor.
+     */
+    void add(Vec<Vari> tuple);
+
+    /**
+     * @brief Ends the input and starts returning the tuples in sorted order. The sort must not be
+     * used afterwards.
+     * @return A cursor over the sorted tuples. It owns the remaining runs, and frees their pages
+     * when destroyed.
+     */
+    Ptr<TupleCursor> finish();
+
+    /**
+     * @return The number of runs written to temporary pages so far.
+     */
+    size_t getNumRuns() const { return m_runs.size(); }
+
+    ExternalSort &operator=(ExternalSort &&other) = delete;
+    ExternalSort &operator=(const ExternalSort &other) = delete;
+    ExternalSort(ExternalSort &&other) = delete;
+    ExternalSort(const ExternalSort &other) = delete;
+
+private:
+    // sorts the buffered tuples and writes them out as a run
+    void writeRun();
+
+    // max number of runs merged at once: the budget is split into one page per run, plus one
+    // read ahead
+    size_t getFanIn() const;
+
+    Pager &m_pager;
+    Vec<Vari> m_types;
+    Vec<SortKey> m_keys;
+    size_t m_memoryBudget;
+
+    Vec<Vec<Vari>> m_buffer;
+    size_t m_memoryUsed;
+    Vec<Ptr<SpillRun>> m_runs;
+};
+
+} // namespace backend
+
+#endif //KNDB_EXTERNALSORT_HPP
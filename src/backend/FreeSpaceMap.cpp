@@ -5,16 +5,32 @@
 #include "FreeSpaceMap.hpp"
 #include <FSMPage.hpp>
 #include "assume.hpp"
+#include "Metrics.hpp"
 
 namespace backend {
 
+struct FreeSpaceMap::Metrics {
+    Counter &allocs = MetricsRegistry::global().counter("fsm.allocs");
+    Counter &frees = MetricsRegistry::global().counter("fsm.frees");
+    Histogram &allocNs = MetricsRegistry::global().histogram("fsm.alloc_ns");
+};
+
+FreeSpaceMap::Metrics &FreeSpaceMap::metrics() {
+    static Metrics m;
+    return m;
+}
+
 FreeSpaceMap::FreeSpaceMap(PageCache& cache) : m_cache(cache) {
 
 }
 
 pgid_t FreeSpaceMap::allocBit() {
     ASSUME_S(!isFull(), "There is no bitmap with free space left");
+    metrics().allocs.add();
+    ScopedTimer timer(metrics().allocNs);
 
+    // the FSM pages are pinned, as other threads may be loading pages while they are changed
+    PageCache::Pin firstPin(m_cache, 0);
     auto& firstFSMPage = m_cache.retrievePage<FSMPage>(0);
     if (firstFSMPage.getSpaceLeft() != 0) {
         auto bit = firstFSMPage.findNextFree();
@@ -23,6 +39,7 @@ pgid_t FreeSpaceMap::allocBit() {
     }
 
     auto nextFSMPageID = firstFSMPage.getNextPageID();
+    PageCache::Pin nextPin(m_cache, nextFSMPageID);
     auto& nextFSMPage = m_cache.retrievePage<FSMPage>(nextFSMPageID);
     auto bit = nextFSMPage.findNextFree();
     nextFSMPage.allocBit(bit);
@@ -37,10 +54,13 @@ pgid_t FreeSpaceMap::allocBit() {
 
 void FreeSpaceMap::freeBit(pgid_t pageID) {
     ASSUME_S(!isFree(pageID), "That page is already freed");
+    metrics().frees.add();
 
     pgid_t fsm_pgid = pageID / FSMPage::getBlocksInPage();
     bitmapidx_t bit = pageID % FSMPage::getBlocksInPage();
 
+    PageCache::Pin currPin(m_cache, fsm_pgid * FSMPage::getBlocksInPage());
+    PageCache::Pin firstPin(m_cache, 0);
     auto& currFSMPage = m_cache.retrievePage<FSMPage>(fsm_pgid * FSMPage::getBlocksInPage());
     auto& firstFSMPage = m_cache.retrievePage<FSMPage>(0);
     currFSMPage.freeBit(bit);
@@ -60,16 +80,18 @@ void FreeSpaceMap::freeBit(pgid_t pageID) {
 bool FreeSpaceMap::isFree(pgid_t pageID) {
     pgid_t fsm_pgid = pageID / FSMPage::getBlocksInPage();
     bitmapidx_t bit = pageID % FSMPage::getBlocksInPage();
-    auto& fsm_page = m_cache.retrievePage<FSMPage>(fsm_pgid * FSMPage::getBlocksInPage());
+    auto& fsm_page = m_cache.viewPage<FSMPage>(fsm_pgid * FSMPage::getBlocksInPage());
     return fsm_page.isFree(bit);
 }
 
 bool FreeSpaceMap::isFull() {
-    auto& firstFSMPage = m_cache.retrievePage<FSMPage>(0);
+    auto& firstFSMPage = m_cache.viewPage<FSMPage>(0);
     return firstFSMPage.getSpaceLeft() == 0 && firstFSMPage.getNextPageID() == cts::PGID_INVALID;
 }
 
 void FreeSpaceMap::linkFSMPage(pgid_t newFSMPageID) {
+    PageCache::Pin firstPin(m_cache, 0);
+    PageCache::Pin newPin(m_cache, newFSMPageID);
     auto& firstFsmPage = m_cache.retrievePage<FSMPage>(0);
     auto& newFsmPage = m_cache.retrievePage<FSMPage>(newFSMPageID);
 
@@ -85,6 +85,10 @@ public:
     void linkFSMPage(pgid_t newFSMPageID);
 
 private:
+    struct Metrics;
+
+    static Metrics &metrics();
+
     PageCache& m_cache;
 };
 
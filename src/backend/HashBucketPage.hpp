@@ -0,0 +1,104 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_HASHBUCKETPAGE_HPP
+#define KNDB_HASHBUCKETPAGE_HPP
+
+#include "Page.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class HashBucketPage
+ * @brief Represents a bucket of an extendible hash index stored in a database.
+ * @tparam T Type stored by the bucket. Currently supported types include trivially copyable
+ * types and vector<variants> (representing tuples)
+ *
+ * A bucket holds up to 'capacity()' key-value cells in no particular order. When a bucket can no
+ * longer be split (its local depth has reached the directory's max depth), additional cells are
+ * stored in a chain of overflow pages linked through getNextPageID().
+ *
+ * Same serialization assumptions as BtreeNodePage apply: all cells have the same key type and,
+ * for tuples, the same fixed number of attributes.
+ */
+template<typename T>
+class HashBucketPage : public Page {
+public:
+    struct cell {
+        Vari key;
+        T value;
+    };
+
+public:
+    /**
+     * @brief Constructs a HashBucketPage from serialized data.
+     * @param bytes Serialized data.
+     * @param pageID The page ID.
+     */
+    HashBucketPage(std::span<const byte> bytes, pgid_t pageID);
+
+    /**
+     * @brief Constructs a new, empty bucket.
+     * @param capacity Max number of cells the bucket can hold.
+     * @param localDepth Number of hash bits shared by every key in the bucket.
+     * @param pageID Page ID of this bucket.
+     */
+    HashBucketPage(u16 capacity, u8 localDepth, pgid_t pageID);
+
+    /**
+     * @brief Retrieves all the stored key-value cells in the bucket.
+     * @return A list of key-value pairs.
+     */
+    Vec<cell> &cells() { return m_cells; }
+    const Vec<cell> &cells() const { return m_cells; }
+
+    /**
+     * @return The max number of cells the bucket can hold.
+     */
+    u16 capacity() const { return m_capacity; }
+
+    /**
+     * @return true if no more cells can be added to this page.
+     */
+    bool full() const { return m_cells.size() >= m_capacity; }
+
+    /**
+     * @return The number of hash bits shared by every key in the bucket.
+     */
+    u8 getLocalDepth() const { return m_localDepth; }
+
+    /**
+     * @param localDepth The new local depth.
+     */
+    void setLocalDepth(u8 localDepth) { m_localDepth = localDepth; }
+
+    /**
+     * @return The page ID of the next overflow page, or PGID_INVALID if there is none.
+     */
+    pgid_t getNextPageID() const { return m_nextPageID; }
+
+    /**
+     * @param pageID The page ID of the next overflow page.
+     */
+    void setNextPageID(pgid_t pageID) { m_nextPageID = pageID; }
+
+    /**
+     * @brief Serializes the bucket into a byte vector.
+     * @param buffer The byte vector to store serialized data.
+     */
+    void toBytes(std::span<byte> buffer) override;
+
+private:
+    u16 m_capacity;
+    u8 m_localDepth;
+    pgid_t m_nextPageID;
+    Vec<cell> m_cells;
+};
+
+} // namespace backend
+
+#include "HashBucketPage.tpp"
+
+#endif //KNDB_HASHBUCKETPAGE_HPP
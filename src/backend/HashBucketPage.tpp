@@ -0,0 +1,123 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_HASHBUCKETPAGE_TPP
+#define KNDB_HASHBUCKETPAGE_TPP
+
+#include "HashBucketPage.hpp"
+#include "utility.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+//    u8 pagetypeid
+//    u16 m_capacity
+//    u8 m_localDepth
+//    pgid_t m_nextPageID
+//    u32 numCells
+//    typeid_t key type          (only if numCells > 0)
+//    u8 numTypes, typeid_t[]    (only if numCells > 0 and T is a tuple)
+//    cell[numCells]
+
+template<typename T>
+HashBucketPage<T>::HashBucketPage(u16 capacity, u8 localDepth, pgid_t pageID)
+        : Page(pageID), m_capacity(capacity), m_localDepth(localDepth), m_nextPageID(cts::PGID_INVALID) {
+    ASSUME_S(capacity > 0, "Bucket must be able to hold at least one cell");
+}
+
+template<typename T>
+HashBucketPage<T>::HashBucketPage(std::span<const byte> bytes, pgid_t pageID) : Page(pageID) {
+    static_assert(std::is_trivially_copyable_v<T> || std::is_same_v<Vec<Vari>, T>);
+    ASSUME_S(bytes.size() == cts::PG_SZ, "Buffer is incorrectly sized");
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id;
+    db_deserialize(page_type_id, bytes, offset);
+    ASSUME_S(page_type_id == cts::pg_type_id::HASH_BUCKET_PAGE, "Page_type_id is incorrect type");
+
+    db_deserialize(m_capacity, bytes, offset);
+    db_deserialize(m_localDepth, bytes, offset);
+    db_deserialize(m_nextPageID, bytes, offset);
+
+    cellid_t numCells;
+    db_deserialize(numCells, bytes, offset);
+    ASSUME_S(numCells <= m_capacity, "Bucket has more cells than its capacity");
+    m_cells.resize(numCells);
+
+    if (numCells == 0) return;
+
+    typeid_t key_type_id;
+    db_deserialize(key_type_id, bytes, offset);
+    Vari key = type_id_to_variant(key_type_id);
+
+    u8 numTypes = 0;
+    Vec<Vari> types;
+    if constexpr (std::is_same_v<T, Vec<Vari>>) {
+        db_deserialize(numTypes, bytes, offset);
+        for (int i = 0; i < numTypes; ++i) {
+            typeid_t type_id;
+            db_deserialize(type_id, bytes, offset);
+            types.push_back(type_id_to_variant(type_id));
+        }
+    }
+
+    for (auto &cell: m_cells) {
+        db_deserialize(cell.key, bytes, offset, key);
+
+        if constexpr (std::is_same_v<T, Vec<Vari>>) {
+            cell.value.resize(numTypes);
+            for (int j = 0; j < numTypes; ++j)
+                db_deserialize(cell.value[j], bytes, offset, types[j]);
+        } else
+            db_deserialize(cell.value, bytes, offset);
+    }
+
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+}
+
+template<typename T>
+void HashBucketPage<T>::toBytes(std::span<byte> buf) {
+    ASSUME_S(buf.size() == cts::PG_SZ, "Buffer is incorrectly sized");
+    ASSUME_S(m_cells.size() <= m_capacity, "Bucket has more cells than its capacity");
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id = cts::pg_type_id::HASH_BUCKET_PAGE;
+    db_serialize(page_type_id, buf, offset);
+
+    db_serialize(m_capacity, buf, offset);
+    db_serialize(m_localDepth, buf, offset);
+    db_serialize(m_nextPageID, buf, offset);
+
+    cellid_t numCells = m_cells.size();
+    db_serialize(numCells, buf, offset);
+    if (numCells == 0) return;
+
+    typeid_t key_type_id = variant_to_type_id(m_cells[0].key);
+    db_serialize(key_type_id, buf, offset);
+
+    if constexpr (std::is_same_v<T, Vec<Vari>>) {
+        u8 numTypes = m_cells[0].value.size();
+        db_serialize(numTypes, buf, offset);
+        for (const auto &value: m_cells[0].value) {
+            typeid_t type_id = variant_to_type_id(value);
+            db_serialize(type_id, buf, offset);
+        }
+    }
+
+    for (const auto &cell: m_cells) {
+        db_serialize(cell.key, buf, offset);
+
+        if constexpr (std::is_same_v<T, Vec<Vari>>)
+            for (const auto &value: cell.value)
+                db_serialize(value, buf, offset);
+        else
+            db_serialize(cell.value, buf, offset);
+    }
+
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+}
+
+} // namespace backend
+
+#endif //KNDB_HASHBUCKETPAGE_TPP
@@ -0,0 +1,82 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <bit>
+
+#include "HashDirectoryPage.hpp"
+#include "utility.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+//    u8 pagetypeid
+//    u8 m_level
+//    u8 m_depth
+//    pgid_t m_slots[1 << m_depth]
+
+HashDirectoryPage::HashDirectoryPage(std::span<const byte> bytes, pgid_t pageID) : Page(pageID) {
+    ASSUME_S(bytes.size() == cts::PG_SZ, "Buffer is incorrectly sized");
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id;
+    db_deserialize(page_type_id, bytes, offset);
+    ASSUME_S(page_type_id == cts::pg_type_id::HASH_DIR_PAGE, "Page_type_id is incorrect type");
+
+    db_deserialize(m_level, bytes, offset);
+    db_deserialize(m_depth, bytes, offset);
+    ASSUME_S(m_depth <= getMaxPageDepth(), "Depth is larger than max");
+
+    m_slots.resize(1 << m_depth);
+    for (auto &slot: m_slots)
+        db_deserialize(slot, bytes, offset);
+
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+}
+
+HashDirectoryPage::HashDirectoryPage(pgid_t bucketPageID, pgid_t pageID) : Page(pageID),
+        m_level(0), m_depth(0), m_slots{bucketPageID} {
+}
+
+HashDirectoryPage::HashDirectoryPage(u8 level, Vec<pgid_t> slots, pgid_t pageID) : Page(pageID) {
+    assign(level, std::move(slots));
+}
+
+size_t HashDirectoryPage::getSlotIndex(u64 hash) const {
+    return (hash >> (m_level * getMaxPageDepth())) & ((u64(1) << m_depth) - 1);
+}
+
+void HashDirectoryPage::assign(u8 level, Vec<pgid_t> slots) {
+    ASSUME_S(std::has_single_bit(slots.size()), "Slot count is not a power of two");
+    m_level = level;
+    m_depth = std::countr_zero(slots.size());
+    ASSUME_S(m_depth <= getMaxPageDepth(), "Depth is larger than max");
+    m_slots = std::move(slots);
+}
+
+void HashDirectoryPage::grow() {
+    ASSUME_S(m_depth < getMaxPageDepth(), "Page is already at max depth");
+
+    size_t size = m_slots.size();
+    m_slots.resize(size * 2);
+    for (size_t i = 0; i < size; i++)
+        m_slots[size + i] = m_slots[i];
+    m_depth++;
+}
+
+void HashDirectoryPage::toBytes(std::span<byte> buf) {
+    ASSUME_S(buf.size() == cts::PG_SZ, "Buffer is incorrectly sized");
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id = cts::pg_type_id::HASH_DIR_PAGE;
+    db_serialize(page_type_id, buf, offset);
+    db_serialize(m_level, buf, offset);
+    db_serialize(m_depth, buf, offset);
+
+    for (auto slot: m_slots)
+        db_serialize(slot, buf, offset);
+
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+}
+
+} // namespace backend
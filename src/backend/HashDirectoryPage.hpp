@@ -0,0 +1,121 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_HASHDIRECTORYPAGE_HPP
+#define KNDB_HASHDIRECTORYPAGE_HPP
+
+#include "Page.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class HashDirectoryPage
+ * @brief Page of the directory of an extendible hash index.
+ *
+ * The directory maps the lowest 'global depth' bits of a key's hash to the page ID of the bucket
+ * that holds the key. Several directory slots may point to the same bucket when that bucket's
+ * local depth is smaller than the global depth.
+ *
+ * A page holds at most 2^getMaxPageDepth() slots, so a larger directory is a tree of pages. Pages
+ * at level 0 hold bucket IDs indexed by the lowest getMaxPageDepth() bits, and each level above
+ * points to pages of the level below, indexed by the next getMaxPageDepth() bits. Every page but
+ * the root is full, so the root's level and depth give the directory's global depth.
+ */
+class HashDirectoryPage : public Page {
+public:
+    /**
+     * @brief Constructs a HashDirectoryPage from serialized data.
+     * @param bytes Serialized data.
+     * @param pageID The page ID.
+     */
+    HashDirectoryPage(std::span<const byte> bytes, pgid_t pageID);
+
+    /**
+     * @brief Constructs a new directory of global depth 0 with a single bucket.
+     * @param bucketPageID The page ID of the first bucket.
+     * @param pageID The page ID.
+     */
+    HashDirectoryPage(pgid_t bucketPageID, pgid_t pageID);
+
+    /**
+     * @brief Constructs a directory page with the given slots.
+     * @param level The page's level, where level 0 holds bucket IDs.
+     * @param slots The slots, whose count must be a power of two.
+     * @param pageID The page ID.
+     */
+    HashDirectoryPage(u8 level, Vec<pgid_t> slots, pgid_t pageID);
+
+    /**
+     * @return The page's level. Slots of a level 0 page hold bucket IDs, and slots of other pages
+     * hold the IDs of directory pages one level down.
+     */
+    u8 getLevel() const { return m_level; }
+
+    /**
+     * @return The number of hash bits used to index this page's slots.
+     */
+    u8 getDepth() const { return m_depth; }
+
+    /**
+     * @return The number of hash bits resolved by this page and the pages below it. For the root,
+     * this is the directory's global depth.
+     */
+    u8 getGlobalDepth() const { return m_depth + m_level * getMaxPageDepth(); }
+
+    /**
+     * @brief Gets the slot that a hash maps to in this page.
+     * @param hash The hash of a key.
+     * @return The page ID of the bucket, or of the next directory page if the level is not 0.
+     */
+    pgid_t getSlot(u64 hash) const { return m_slots[getSlotIndex(hash)]; }
+
+    /**
+     * @brief Gets the index of the slot that a hash maps to in this page.
+     * @param hash The hash of a key.
+     * @return The index into getSlots().
+     */
+    size_t getSlotIndex(u64 hash) const;
+
+    /**
+     * @return All slots of the page, indexed by the hash bits of its level.
+     */
+    Vec<pgid_t> &getSlots() { return m_slots; }
+    const Vec<pgid_t> &getSlots() const { return m_slots; }
+
+    /**
+     * @brief Replaces the page's level and slots, keeping its page ID.
+     * @param level The new level.
+     * @param slots The new slots, whose count must be a power of two.
+     */
+    void assign(u8 level, Vec<pgid_t> slots);
+
+    /**
+     * @brief Doubles the page, incrementing its depth. Each new slot points to the same page as
+     * the slot it mirrors.
+     * @note Program terminates if the page is already at its max depth.
+     */
+    void grow();
+
+    /**
+     * @return The max number of hash bits a single directory page can index.
+     */
+    static u8 getMaxPageDepth() { return 9; }
+
+    /**
+     * @return The max global depth of a directory, after which full buckets grow overflow pages.
+     */
+    static u8 getMaxGlobalDepth() { return 3 * getMaxPageDepth(); }
+
+    void toBytes(std::span<byte> buffer) override;
+
+private:
+    u8 m_level;
+    u8 m_depth;
+    Vec<pgid_t> m_slots;
+};
+
+} // namespace backend
+
+#endif //KNDB_HASHDIRECTORYPAGE_HPP
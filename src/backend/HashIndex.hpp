@@ -0,0 +1,142 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_HASHINDEX_HPP
+#define KNDB_HASHINDEX_HPP
+
+#include "Pager.hpp"
+#include <optional>
+
+namespace backend {
+
+/**
+ * @class HashIndex
+ * @brief Represents a persistent extendible hash index supporting insertion, deletion, update,
+ * and exact-key search operations.
+ *
+ * A directory of HashDirectoryPages maps the low bits of each key's hash to a HashBucketPage.
+ * Full buckets are split (doubling the directory when needed) until the directory reaches its max
+ * depth, after which buckets grow chains of overflow pages instead. A directory of up to 512
+ * slots fits in one page, and each further 9 bits add a level of pages above it, so a lookup
+ * costs one access per directory level plus one bucket access in the common case.
+ *
+ * Like Btree, all keys must be unique, and duplicate insertions or operations on missing keys
+ * result in operation failures rather than exceptions. Keys are not kept in any order.
+ *
+ * @tparam T The type of values stored in the index. Same types as Btree are supported.
+ */
+template<typename T>
+class HashIndex {
+public:
+    /**
+     * @brief Constructs a hash index.
+     * @param directoryPageID The page ID of the index's directory.
+     * @param pgr Reference to the Pager used for managing pages.
+     * @param bucketCapacity Max number of cells stored in each bucket page.
+     */
+    HashIndex(pgid_t directoryPageID, Pager &pgr, u16 bucketCapacity);
+
+    /**
+     * @brief Searches for a key in the index.
+     * @param key The key to search for.
+     * @return Optional value associated with the key, or std::nullopt if not found.
+     */
+    std::optional<T> search(const Vari &key);
+
+    /**
+     * @brief Inserts a key-value pair into the index.
+     * @param values The value to associate with the key.
+     * @param key The key to insert.
+     * @return true if insertion was successful, false if key already exists.
+     */
+    bool insert(T values, Vari key);
+
+    /**
+     * @brief Removes a key-value pair from the index.
+     * @param key The key to remove.
+     * @return true if removal was successful, false if key doesn't exist.
+     */
+    bool remove(Vari key);
+
+    /**
+     * @brief Updates the value associated with an existing key.
+     * @param values The new value to assign.
+     * @param key The key to update.
+     * @return true if update was successful, false if key doesn't exist.
+     */
+    bool update(T values, const Vari &key);
+
+    /**
+     * @brief Returns the directory page ID of the index. The directory never moves, so this
+     * never changes.
+     * @return The page ID of the directory.
+     */
+    pgid_t getRootPage() const { return m_directoryPageID; }
+
+    /**
+     * @brief Visits every key-value pair in the index, in no particular order.
+     * @param fn Callable invoked as fn(const Vari &key, const T &value).
+     */
+    template<typename Fn>
+    void forEach(Fn &&fn);
+
+    /**
+     * @brief Lists every bucket of the index once, so buckets can be visited in parallel.
+     * @return The page IDs of the first page of each bucket's chain.
+     */
+    Vec<pgid_t> getBuckets();
+
+    /**
+     * @brief Visits every key-value pair of a bucket, including its overflow pages.
+     *
+     * May be called from several threads at once, as long as the index is not modified meanwhile.
+     * @param bucketPageID The first page of the bucket, as returned by getBuckets().
+     * @param fn Callable invoked as fn(const Vari &key, const T &value).
+     */
+    template<typename Fn>
+    void forEachInBucket(pgid_t bucketPageID, Fn &&fn);
+
+    /**
+     * Deletes the index, freeing its directory pages, buckets and overflow pages. The index must
+     * not be used after.
+     */
+    void deleteIndex();
+
+private:
+    // finds the page and cell of a key within its bucket's chain
+    RowPos searchRowPtr(const Vari &targ_key, u64 hash);
+
+    // finds the bucket that a hash maps to, walking down the directory's levels
+    pgid_t getBucket(u64 hash);
+
+    // splits a bucket, given the hash of a key in it
+    void split(pgid_t bucketPageID, u64 hash);
+
+    u8 getGlobalDepth();
+
+    // points the directory slot at an index (the low global depth bits of a hash) to a bucket
+    void setSlot(u64 index, pgid_t bucketPageID);
+
+    // doubles the directory, incrementing its global depth
+    void growDirectory();
+
+    // copies a directory page and every page below it, returning the copy's page ID
+    pgid_t copyDirectory(pgid_t pageID);
+
+    // appends every bucket slot below a directory page, in slot order
+    void collectSlots(pgid_t pageID, Vec<pgid_t> &out);
+
+    // frees a directory page and every directory page below it
+    void deleteDirectory(pgid_t pageID);
+
+    Pager &m_pager;
+    pgid_t m_directoryPageID;
+    u16 m_bucketCapacity;
+};
+
+} // namespace backend
+
+#include "HashIndex.tpp"
+
+#endif //KNDB_HASHINDEX_HPP
@@ -0,0 +1,302 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_HASHINDEX_TPP
+#define KNDB_HASHINDEX_TPP
+
+#include <algorithm>
+
+#include "HashIndex.hpp"
+#include "HashBucketPage.hpp"
+#include "HashDirectoryPage.hpp"
+#include "utility.hpp"
+#include "assume.hpp"
+
+#define H_DIR(id) m_pager.getPage<HashDirectoryPage>(id)
+#define H_BUCKET(id) m_pager.getPage<HashBucketPage<T>>(id)
+#define H_DIR_VIEW(id) m_pager.viewPage<HashDirectoryPage>(id)
+#define H_BUCKET_VIEW(id) m_pager.viewPage<HashBucketPage<T>>(id)
+#define H_NEW(cap, depth) m_pager.createNewPage<HashBucketPage<T>>(cap, depth)
+
+namespace backend {
+
+template<typename T>
+HashIndex<T>::HashIndex(pgid_t directoryPageID, Pager &pgr, u16 bucketCapacity)
+        : m_pager(pgr), m_directoryPageID(directoryPageID), m_bucketCapacity(bucketCapacity) {
+}
+
+template<typename T>
+pgid_t HashIndex<T>::getBucket(u64 hash) {
+    pgid_t curr = m_directoryPageID;
+    while (true) {
+        auto &page = H_DIR_VIEW(curr);
+        if (page.getLevel() == 0)
+            return page.getSlot(hash);
+        curr = page.getSlot(hash);
+    }
+}
+
+template<typename T>
+RowPos HashIndex<T>::searchRowPtr(const Vari &targ_key, u64 hash) {
+    pgid_t curr = getBucket(hash);
+    while (curr != cts::PGID_INVALID) {
+        auto &page = H_BUCKET_VIEW(curr);
+        auto &cells = page.cells();
+        for (cellid_t idx = 0; idx < cells.size(); idx++)
+            if (cells[idx].key == targ_key)
+                return {curr, idx};
+        curr = page.getNextPageID();
+    }
+
+    return {cts::PGID_INVALID, cts::CELLID_INVALID};
+}
+
+template<typename T>
+std::optional<T> HashIndex<T>::search(const Vari &key) {
+    RowPos row = searchRowPtr(key, db_hash(key));
+    if (row.cellID == cts::CELLID_INVALID)
+        return std::nullopt;
+    return H_BUCKET_VIEW(row.pageID).cells()[row.cellID].value;
+}
+
+template<typename T>
+bool HashIndex<T>::update(T values, const Vari &key) {
+    RowPos row = searchRowPtr(key, db_hash(key));
+    if (row.cellID == cts::CELLID_INVALID)
+        return false;
+    H_BUCKET(row.pageID).cells()[row.cellID].value = values;
+    return true;
+}
+
+template<typename T>
+bool HashIndex<T>::insert(T values, Vari key) {
+    u64 hash = db_hash(key);
+    if (searchRowPtr(key, hash).cellID != cts::CELLID_INVALID)
+        return false;
+
+    while (true) {
+        //    1. if the key's bucket has room, insert into it
+        pgid_t bucketID = getBucket(hash);
+        auto &bucket = H_BUCKET(bucketID);
+        if (!bucket.full()) {
+            bucket.cells().push_back({key, values});
+            return true;
+        }
+
+        //    2. if the bucket can still be split, split it and try again
+        if (bucket.getLocalDepth() < HashDirectoryPage::getMaxGlobalDepth()) {
+            split(bucketID, hash);
+            continue;
+        }
+
+        //    3. otherwise, insert into the first overflow page with room, creating one if needed
+        pgid_t curr = bucketID;
+        while (true) {
+            auto &page = H_BUCKET(curr);
+            if (!page.full()) {
+                page.cells().push_back({key, values});
+                return true;
+            }
+
+            if (page.getNextPageID() == cts::PGID_INVALID) {
+                auto &overflow = H_NEW(m_bucketCapacity, page.getLocalDepth());
+                page.setNextPageID(overflow.getPageID());
+                overflow.cells().push_back({key, values});
+                return true;
+            }
+            curr = page.getNextPageID();
+        }
+    }
+}
+
+template<typename T>
+void HashIndex<T>::split(pgid_t bucketPageID, u64 hash) {
+    u8 depth = H_BUCKET(bucketPageID).getLocalDepth();
+
+    ASSUME_S(H_BUCKET(bucketPageID).getNextPageID() == cts::PGID_INVALID,
+             "Only buckets without overflow pages can be split");
+
+    //    1. make sure the directory distinguishes one more bit than the bucket does
+    if (depth == getGlobalDepth())
+        growDirectory();
+
+    //    2. create the sibling bucket. the bucket is reachable from every slot sharing the low
+    //       'depth' bits of the hash, and the ones with the next bit set now point at the sibling
+    pgid_t siblingID = H_NEW(m_bucketCapacity, depth + 1).getPageID();
+    H_BUCKET(bucketPageID).setLocalDepth(depth + 1);
+
+    u64 low = (hash & ((u64(1) << depth) - 1)) | (u64(1) << depth);
+    u64 numSlots = u64(1) << (getGlobalDepth() - depth - 1);
+    for (u64 high = 0; high < numSlots; high++)
+        setSlot(low | (high << (depth + 1)), siblingID);
+
+    //    3. move cells with the new bit set into the sibling
+    auto &cells = H_BUCKET(bucketPageID).cells();
+    auto moved = std::partition(cells.begin(), cells.end(), [depth](const auto &cell) {
+        return !((db_hash(cell.key) >> depth) & 1);
+    });
+    H_BUCKET(siblingID).cells().assign(std::make_move_iterator(moved), std::make_move_iterator(cells.end()));
+    cells.erase(moved, cells.end());
+}
+
+template<typename T>
+u8 HashIndex<T>::getGlobalDepth() {
+    return H_DIR_VIEW(m_directoryPageID).getGlobalDepth();
+}
+
+template<typename T>
+void HashIndex<T>::setSlot(u64 index, pgid_t bucketPageID) {
+    pgid_t curr = m_directoryPageID;
+    while (true) {
+        auto &page = H_DIR(curr);
+        if (page.getLevel() == 0) {
+            page.getSlots()[page.getSlotIndex(index)] = bucketPageID;
+            return;
+        }
+        curr = page.getSlot(index);
+    }
+}
+
+template<typename T>
+void HashIndex<T>::growDirectory() {
+    auto &root = H_DIR(m_directoryPageID);
+    u8 level = root.getLevel();
+    if (level == 0 && root.getDepth() < HashDirectoryPage::getMaxPageDepth()) {
+        root.grow();
+        return;
+    }
+
+    //    1. if the root has room, double it. each new slot mirrors an old one, but needs its own
+    //       copy of the pages below, since their slots will diverge
+    Vec<pgid_t> slots = root.getSlots();
+    if (root.getDepth() < HashDirectoryPage::getMaxPageDepth()) {
+        size_t size = slots.size();
+        for (size_t i = 0; i < size; i++)
+            slots.push_back(copyDirectory(slots[i]));
+        H_DIR(m_directoryPageID).assign(level, std::move(slots));
+        return;
+    }
+
+    //    2. otherwise, move the root's slots into a new page and make the root the parent of that
+    //       page and its copy, so the root keeps its page ID
+    pgid_t lower = m_pager.createNewPage<HashDirectoryPage>(level, std::move(slots)).getPageID();
+    pgid_t copy = copyDirectory(lower);
+    H_DIR(m_directoryPageID).assign(level + 1, {lower, copy});
+}
+
+template<typename T>
+pgid_t HashIndex<T>::copyDirectory(pgid_t pageID) {
+    auto &page = H_DIR_VIEW(pageID);
+    u8 level = page.getLevel();
+    Vec<pgid_t> slots = page.getSlots();
+    if (level > 0)
+        for (auto &slot: slots)
+            slot = copyDirectory(slot);
+    return m_pager.createNewPage<HashDirectoryPage>(level, std::move(slots)).getPageID();
+}
+
+template<typename T>
+void HashIndex<T>::collectSlots(pgid_t pageID, Vec<pgid_t> &out) {
+    // copy the slots, since the directory page may be evicted while visiting the pages below
+    auto &page = H_DIR_VIEW(pageID);
+    Vec<pgid_t> slots = page.getSlots();
+    if (page.getLevel() == 0) {
+        out.insert(out.end(), slots.begin(), slots.end());
+        return;
+    }
+    for (pgid_t slot: slots)
+        collectSlots(slot, out);
+}
+
+template<typename T>
+void HashIndex<T>::deleteIndex() {
+    for (pgid_t bucket: getBuckets()) {
+        pgid_t curr = bucket;
+        while (curr != cts::PGID_INVALID) {
+            pgid_t next = H_BUCKET_VIEW(curr).getNextPageID();
+            m_pager.freePage(curr);
+            curr = next;
+        }
+    }
+    deleteDirectory(m_directoryPageID);
+}
+
+template<typename T>
+void HashIndex<T>::deleteDirectory(pgid_t pageID) {
+    auto &page = H_DIR_VIEW(pageID);
+    if (page.getLevel() > 0) {
+        Vec<pgid_t> slots = page.getSlots();
+        for (pgid_t slot: slots)
+            deleteDirectory(slot);
+    }
+    m_pager.freePage(pageID);
+}
+
+template<typename T>
+bool HashIndex<T>::remove(Vari key) {
+    u64 hash = db_hash(key);
+    pgid_t prev = cts::PGID_INVALID;
+    pgid_t curr = getBucket(hash);
+
+    while (curr != cts::PGID_INVALID) {
+        auto &page = H_BUCKET(curr);
+        auto &cells = page.cells();
+        for (cellid_t idx = 0; idx < cells.size(); idx++) {
+            if (cells[idx].key != key)
+                continue;
+
+            cells.erase(cells.begin() + idx);
+
+            // unlink overflow pages once they become empty (the primary bucket always stays)
+            if (cells.empty() && prev != cts::PGID_INVALID) {
+                H_BUCKET(prev).setNextPageID(page.getNextPageID());
+                m_pager.freePage(curr);
+            }
+            return true;
+        }
+        prev = curr;
+        curr = page.getNextPageID();
+    }
+
+    return false;
+}
+
+template<typename T>
+template<typename Fn>
+void HashIndex<T>::forEach(Fn &&fn) {
+    for (pgid_t bucket: getBuckets())
+        forEachInBucket(bucket, fn);
+}
+
+template<typename T>
+Vec<pgid_t> HashIndex<T>::getBuckets() {
+    // slots of the whole directory, in order of the low hash bits they stand for
+    Vec<pgid_t> slots;
+    collectSlots(m_directoryPageID, slots);
+
+    Vec<pgid_t> buckets;
+    for (size_t i = 0; i < slots.size(); i++) {
+        // a bucket of local depth d is reachable from every slot sharing its low d bits, so only
+        // count it for the lowest of those slots
+        if (i < (size_t(1) << H_BUCKET_VIEW(slots[i]).getLocalDepth()))
+            buckets.push_back(slots[i]);
+    }
+    return buckets;
+}
+
+template<typename T>
+template<typename Fn>
+void HashIndex<T>::forEachInBucket(pgid_t bucketPageID, Fn &&fn) {
+    pgid_t curr = bucketPageID;
+    while (curr != cts::PGID_INVALID) {
+        auto page = m_pager.getSharedPage<HashBucketPage<T>>(curr);
+        for (const auto &cell: page->cells())
+            fn(cell.key, cell.value);
+        curr = page->getNextPageID();
+    }
+}
+
+} // namespace backend
+
+#endif //KNDB_HASHINDEX_TPP
@@ -0,0 +1,58 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "HyperLogLog.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+HyperLogLog::HyperLogLog(u8 precision) : m_registers(size_t(1) << precision, 0), m_precision(precision) {
+    ASSUME_S(precision >= MIN_PRECISION && precision <= MAX_PRECISION, "Precision is out of range");
+}
+
+HyperLogLog::HyperLogLog(Vec<u8> registers) : m_registers(std::move(registers)) {
+    ASSUME_S(std::has_single_bit(m_registers.size()), "Number of registers must be a power of two");
+
+    m_precision = std::countr_zero(m_registers.size());
+    ASSUME_S(m_precision >= MIN_PRECISION && m_precision <= MAX_PRECISION, "Precision is out of range");
+}
+
+void HyperLogLog::add(u64 hash) {
+    // db_hash() of short values leaves the high bits poorly mixed, so finish it off first
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    size_t idx = hash >> (64 - m_precision);
+    u64 rest = hash << m_precision;
+    u8 rank = std::min<int>(std::countl_zero(rest), 64 - m_precision) + 1;
+    m_registers[idx] = std::max(m_registers[idx], rank);
+}
+
+u64 HyperLogLog::estimate() const {
+    double m = m_registers.size();
+    double sum = 0;
+    size_t zeros = 0;
+    for (u8 reg: m_registers) {
+        sum += std::ldexp(1.0, -reg);
+        if (reg == 0)
+            zeros++;
+    }
+
+    double alpha = m == 16 ? 0.673 : m == 32 ? 0.697 : m == 64 ? 0.709 : 0.7213 / (1 + 1.079 / m);
+    double est = alpha * m * m / sum;
+
+    // small counts leave registers empty, and linear counting over those is more accurate
+    if (est <= 2.5 * m && zeros > 0)
+        est = m * std::log(m / zeros);
+    return static_cast<u64>(std::llround(est));
+}
+
+} // namespace backend
@@ -0,0 +1,61 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_HYPERLOGLOG_HPP
+#define KNDB_HYPERLOGLOG_HPP
+
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class HyperLogLog
+ * @brief Estimates the number of distinct values added to it, in a fixed amount of memory.
+ *
+ * Each value's hash picks one of 2^precision registers, which remembers the longest run of
+ * leading zeros seen in the rest of the hash. The estimate's standard error is about
+ * 1.04 / sqrt(2^precision), e.g. 3% with 1024 registers. Values cannot be removed.
+ */
+class HyperLogLog {
+public:
+    static constexpr u8 MIN_PRECISION = 4;
+    static constexpr u8 MAX_PRECISION = 16;
+
+    /**
+     * @brief Constructs an empty sketch.
+     * @param precision Base-2 logarithm of the number of registers.
+     */
+    explicit HyperLogLog(u8 precision);
+
+    /**
+     * @brief Constructs a sketch from previously stored registers.
+     * @param registers The sketch's registers, as returned by getRegisters(). Their number must
+     * be a power of two.
+     */
+    explicit HyperLogLog(Vec<u8> registers);
+
+    /**
+     * @brief Adds a value to the sketch.
+     * @param hash The db_hash() of the value.
+     */
+    void add(u64 hash);
+
+    /**
+     * @return The estimated number of distinct values added so far.
+     */
+    u64 estimate() const;
+
+    /**
+     * @return The sketch's registers.
+     */
+    const Vec<u8> &getRegisters() const { return m_registers; }
+
+private:
+    Vec<u8> m_registers;
+    u8 m_precision;
+};
+
+} // namespace backend
+
+#endif //KNDB_HYPERLOGLOG_HPP
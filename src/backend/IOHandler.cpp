@@ -2,23 +2,80 @@
 // Created by Kylan Chen on 2/9/25.
 //
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include "assume.hpp"
 #include "utility.hpp"
 #include "IOHandler.hpp"
+#include "Metrics.hpp"
+#include "PageCodec.hpp"
+#include "SlotMap.hpp"
+#include "Tracer.hpp"
 
 namespace backend {
 
+namespace {
+
+// the smallest mapping of a file that can grow, in blocks
+constexpr size_t MIN_MAP_BLOCKS = 256;
+
+bool aligned(const void *arr) {
+    return reinterpret_cast<uintptr_t>(arr) % cts::PG_SZ == 0;
+}
+
+// checks the blocks of a batch, and sorts them
+template<typename Buffer>
+Vec<std::pair<blockid_t, Buffer>> sortBatch(std::span<const std::pair<blockid_t, Buffer>> blocks,
+                                            blockid_t numBlocks) {
+    Vec<std::pair<blockid_t, Buffer>> sorted(blocks.begin(), blocks.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    if (!sorted.empty() && sorted.back().first >= numBlocks)
+        throw std::runtime_error("BlockNo out of bounds");
+    for (size_t i = 1; i < sorted.size(); i++)
+        ASSUME_S(sorted[i].first != sorted[i - 1].first, "Block is listed twice in a batch");
+    return sorted;
+}
+
+} // namespace
+
+struct IOHandler::Metrics {
+    Counter &reads = MetricsRegistry::global().counter("io.reads");
+    Counter &writes = MetricsRegistry::global().counter("io.writes");
+    Counter &bytesRead = MetricsRegistry::global().counter("io.bytes_read");
+    Counter &bytesWritten = MetricsRegistry::global().counter("io.bytes_written");
+    Counter &syncs = MetricsRegistry::global().counter("io.syncs");
+    Counter &mappedReads = MetricsRegistry::global().counter("io.mapped_reads");
+    Counter &unalignedCopies = MetricsRegistry::global().counter("io.unaligned_copies");
+    Counter &incompressible = MetricsRegistry::global().counter("io.incompressible_blocks");
+    Histogram &readNs = MetricsRegistry::global().histogram("io.read_ns");
+    Histogram &writeNs = MetricsRegistry::global().histogram("io.write_ns");
+    Histogram &syncNs = MetricsRegistry::global().histogram("io.sync_ns");
+};
+
+IOHandler::Metrics &IOHandler::metrics() {
+    static Metrics m;
+    return m;
+}
+
 blockid_t IOHandler::getNumBlocks() const {
     return m_blocks;
 }
 
-IOHandler::IOHandler(std::string_view fileName) {
+std::string_view IOHandler::getFileName() const {
+    return m_fileName;
+}
+
+IOHandler::IOHandler(std::string_view fileName, IOMode mode) : m_fileName(fileName), m_mode(mode) {
 #ifdef _WIN32
     m_handle = CreateFile(
         string(fileName).c_str(),            // File name
-        GENERIC_READ | GENERIC_WRITE, // Access mode
-        0,                         // No sharing
+        readOnly() ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE, // Access mode
+        readOnly() ? FILE_SHARE_READ : 0, // Readers may share a read-only file
         nullptr,                      // Security attributes
-        OPEN_ALWAYS,             // Create new or overwrite
+        readOnly() ? OPEN_EXISTING : OPEN_ALWAYS, // Create new or overwrite
         FILE_ATTRIBUTE_NORMAL,      // Normal file
         nullptr        // No template
     );
@@ -35,11 +92,33 @@ IOHandler::IOHandler(std::string_view fileName) {
     }
 
     m_blocks = fileSize.QuadPart / cts::PG_SZ;
+    if (m_mode == IOMode::COMPRESSED) {
+        try {
+            m_slots = std::make_unique<SlotMap>(m_fileName + ".map", fileSize.QuadPart > 0);
+        } catch (...) {
+            CloseHandle(m_handle);
+            throw;
+        }
+    }
 #else //_WIN32
-    m_fd = open(string(fileName).c_str(), O_RDWR | O_CREAT, 0644);
+    int flags = readOnly() ? O_RDONLY : O_RDWR | O_CREAT;
+#ifdef O_DIRECT
+    if (m_mode == IOMode::DIRECT)
+        flags |= O_DIRECT;
+#endif //O_DIRECT
+    m_fd = open(string(fileName).c_str(), flags, 0644);
+#ifdef O_DIRECT
+    // some file systems, such as tmpfs, have no direct I/O
+    if (m_fd == -1 && errno == EINVAL && (flags & O_DIRECT))
+        m_fd = open(string(fileName).c_str(), flags & ~O_DIRECT, 0644);
+#endif //O_DIRECT
 
     if (m_fd == -1)
         throw std::runtime_error("Failed to open file");
+#ifdef F_NOCACHE
+    if (m_mode == IOMode::DIRECT)
+        fcntl(m_fd, F_NOCACHE, 1);
+#endif //F_NOCACHE
 
     struct stat f_stat;
     if (fstat(m_fd, &f_stat) == -1) {
@@ -48,10 +127,170 @@ IOHandler::IOHandler(std::string_view fileName) {
     }
 
     m_blocks = f_stat.st_size / cts::PG_SZ;
+    try {
+        if (m_mode == IOMode::MMAP || readOnly())
+            remap();
+        if (m_mode == IOMode::COMPRESSED)
+            m_slots = std::make_unique<SlotMap>(m_fileName + ".map", f_stat.st_size > 0);
+    } catch (...) {
+        close(m_fd);
+        throw;
+    }
+#endif //_WIN32
+    // the blocks of a compressed file are its map's, not its size's
+    if (m_slots)
+        m_blocks = m_slots->getNumBlocks();
+}
+
+#ifndef _WIN32
+void IOHandler::remap() {
+    size_t needed = static_cast<size_t>(m_blocks) * cts::PG_SZ;
+    if (needed == 0 || needed <= m_mapLen)
+        return;
+
+    // a growing file is mapped with room to spare, as blocks appended within the mapping become
+    // visible through it without remapping
+    size_t len = readOnly() ? needed : std::max({needed, 2 * m_mapLen, MIN_MAP_BLOCKS * cts::PG_SZ});
+    void *map = mmap(nullptr, len, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED)
+        throw std::runtime_error("Failed to map file");
+    // pages are looked up at random, so reading ahead of a fault would mostly bring in unused blocks
+    madvise(map, len, MADV_RANDOM);
+
+    if (m_map)
+        m_oldMaps.emplace_back(m_map, m_mapLen);
+    m_map = static_cast<byte *>(map);
+    m_mapLen = len;
+}
+
+void IOHandler::writeAt(const void *arr, size_t len, u64 pos) const {
+    if (m_mode == IOMode::DIRECT && !aligned(arr)) {
+        metrics().unalignedCopies.add();
+        AlignedBytes buf(len);
+        std::memcpy(buf.data(), arr, len);
+        writeAt(buf.data(), len, pos);
+        return;
+    }
+    if (pwrite(m_fd, arr, len, static_cast<off_t>(pos)) != static_cast<ssize_t>(len))
+        throw std::runtime_error("error while writing file");
+}
+
+void IOHandler::readAt(void *arr, size_t len, u64 pos) const {
+    if (m_mode == IOMode::DIRECT && !aligned(arr)) {
+        metrics().unalignedCopies.add();
+        AlignedBytes buf(len);
+        readAt(buf.data(), len, pos);
+        std::memcpy(arr, buf.data(), len);
+        return;
+    }
+    if (pread(m_fd, arr, len, static_cast<off_t>(pos)) != static_cast<ssize_t>(len))
+        throw std::runtime_error("error while reading file");
+}
+#else //_WIN32
+void IOHandler::writeAt(const void *arr, size_t len, u64 pos) const {
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(pos);
+    overlapped.OffsetHigh = static_cast<DWORD>(pos >> 32);
+    DWORD written;
+    if (!WriteFile(m_handle, arr, static_cast<DWORD>(len), &written, &overlapped) || written != len)
+        throw std::runtime_error("WriteFile failed, error code: " + std::to_string(GetLastError()));
+}
+
+void IOHandler::readAt(void *arr, size_t len, u64 pos) const {
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(pos);
+    overlapped.OffsetHigh = static_cast<DWORD>(pos >> 32);
+    DWORD bytesRead;
+    if (!ReadFile(m_handle, arr, static_cast<DWORD>(len), &bytesRead, &overlapped) || bytesRead != len)
+        throw std::runtime_error("ReadFile failed, error code: " + std::to_string(GetLastError()));
+}
+#endif //_WIN32
+
+void IOHandler::writeSlot(const void *arr, blockid_t blockNo) const {
+    auto &m = metrics();
+    ScopedTimer timer(m.writeNs);
+    Tracer::LayerTimer trace(&Tracer::Record::ioNs);
+
+    // a slot holds the compressed length, then the compressed block; a block that does not fit in
+    // fewer units than a whole one is stored as it is
+    PgArr<byte> slot;
+    constexpr size_t maxLen = cts::PG_SZ - SlotMap::SLOT_UNIT - sizeof(u16);
+    size_t len = PageCodec::compress({static_cast<const byte *>(arr), cts::PG_SZ},
+                                     std::span(slot).subspan(sizeof(u16), maxLen));
+    const void *data = arr;
+    u32 units = SlotMap::UNITS_PER_BLOCK;
+    if (len > 0) {
+        auto stored = static_cast<u16>(len);
+        std::memcpy(slot.data(), &stored, sizeof(stored));
+        units = static_cast<u32>((sizeof(u16) + len + SlotMap::SLOT_UNIT - 1) / SlotMap::SLOT_UNIT);
+        std::memset(slot.data() + sizeof(u16) + len, 0, units * SlotMap::SLOT_UNIT - sizeof(u16) - len);
+        data = slot.data();
+    } else {
+        m.incompressible.add();
+    }
+
+    u64 unit = m_slots->place(blockNo, units).unit;
+    size_t bytes = units * SlotMap::SLOT_UNIT;
+    m.writes.add();
+    m.bytesWritten.add(bytes);
+    Tracer::addBytes(&Tracer::Record::bytesWritten, bytes);
+    writeAt(data, bytes, unit * SlotMap::SLOT_UNIT);
+}
+
+void IOHandler::readSlot(void *arr, blockid_t blockNo) const {
+    auto [unit, units] = m_slots->get(blockNo);
+    // like a new block of an uncompressed file
+    if (units == 0) {
+        std::memset(arr, 0, cts::PG_SZ);
+        return;
+    }
+
+    auto &m = metrics();
+    size_t bytes = units * SlotMap::SLOT_UNIT;
+    m.reads.add();
+    m.bytesRead.add(bytes);
+    ScopedTimer timer(m.readNs);
+    Tracer::addBytes(&Tracer::Record::bytesRead, bytes);
+    Tracer::LayerTimer trace(&Tracer::Record::ioNs);
+    if (units == SlotMap::UNITS_PER_BLOCK) {
+        readAt(arr, cts::PG_SZ, unit * SlotMap::SLOT_UNIT);
+        return;
+    }
+
+    PgArr<byte> slot;
+    readAt(slot.data(), bytes, unit * SlotMap::SLOT_UNIT);
+    u16 len;
+    std::memcpy(&len, slot.data(), sizeof(len));
+    if (sizeof(u16) + len > bytes ||
+        !PageCodec::decompress({slot.data() + sizeof(u16), len}, {static_cast<byte *>(arr), cts::PG_SZ}))
+        throw std::runtime_error("Compressed block " + std::to_string(blockNo) + " is corrupt");
+}
+
+void IOHandler::checkWritable() const {
+    if (readOnly())
+        throw std::runtime_error("File is open read-only");
+}
+
+std::span<const byte> IOHandler::viewBlock(blockid_t BlockNo) const {
+    if (BlockNo >= m_blocks)
+        throw std::runtime_error("BlockNo out of bounds");
+#ifdef _WIN32
+    return {};
+#else
+    if (!m_map)
+        return {};
+    metrics().mappedReads.add();
+    Tracer::addBytes(&Tracer::Record::bytesRead, cts::PG_SZ);
+    return {m_map + static_cast<size_t>(BlockNo) * cts::PG_SZ, cts::PG_SZ};
 #endif //_WIN32
 }
 
 blockid_t IOHandler::createNewBlock() {
+    checkWritable();
+    if (m_slots) {
+        m_slots->addBlocks(1);
+        return m_blocks++;
+    }
 #ifdef _WIN32
     LARGE_INTEGER newPos;
     newPos.QuadPart = ++m_blocks * cts::PG_SZ;
@@ -61,9 +300,12 @@ blockid_t IOHandler::createNewBlock() {
     if (!SetEndOfFile(m_handle))
         throw std::runtime_error("Failed to truncate file");
 #else
-    blockid_t new_sz = ++m_blocks * cts::PG_SZ;
+    blockid_t new_sz = (m_blocks + 1) * cts::PG_SZ;
     if (ftruncate(m_fd, new_sz) == -1)
         throw std::runtime_error("Failed to increase file size");
+    m_blocks++;
+    if (m_mode == IOMode::MMAP)
+        remap();
 #endif //_WIN32
 
     return m_blocks - 1;
@@ -71,6 +313,12 @@ blockid_t IOHandler::createNewBlock() {
 
 blockid_t IOHandler::createMultipleBlocks(int numBlocks) {
     ASSUME_S(numBlocks > 0, "Cannot allocate non-positive number of blocks");
+    checkWritable();
+    if (m_slots) {
+        m_slots->addBlocks(numBlocks);
+        m_blocks += numBlocks;
+        return m_blocks - numBlocks;
+    }
 
 #ifdef _WIN32
     LARGE_INTEGER newPos;
@@ -86,6 +334,10 @@ blockid_t IOHandler::createMultipleBlocks(int numBlocks) {
         throw std::runtime_error("Failed to increase file size");
 #endif //_WIN32
     m_blocks += numBlocks;
+#ifndef _WIN32
+    if (m_mode == IOMode::MMAP)
+        remap();
+#endif //_WIN32
 
     return m_blocks - numBlocks;
 }
@@ -93,6 +345,18 @@ blockid_t IOHandler::createMultipleBlocks(int numBlocks) {
 void IOHandler::writeBlock(void *arr, blockid_t BlockNo) const {
     if (BlockNo >= m_blocks)
         throw std::runtime_error("BlockNo out of bounds");
+    checkWritable();
+    if (m_slots) {
+        writeSlot(arr, BlockNo);
+        sync();
+        return;
+    }
+    auto &m = metrics();
+    m.writes.add();
+    m.bytesWritten.add(cts::PG_SZ);
+    ScopedTimer timer(m.writeNs);
+    Tracer::addBytes(&Tracer::Record::bytesWritten, cts::PG_SZ);
+    Tracer::LayerTimer trace(&Tracer::Record::ioNs);
 #ifdef _WIN32
     LARGE_INTEGER fileOffset;
     fileOffset.QuadPart = static_cast<LONGLONG>(BlockNo) * cts::PG_SZ;
@@ -105,16 +369,19 @@ void IOHandler::writeBlock(void *arr, blockid_t BlockNo) const {
 
     //TODO: usually we should not flush after every write;
     // this is just for development/debugging purposes
+    m.syncs.add();
+    ScopedTimer syncTimer(m.syncNs);
     if (!FlushFileBuffers(m_handle))
         throw std::runtime_error("FlushFileBuffers failed, error code: " + std::to_string(GetLastError()));
 
 #else
 
-    if (pwrite(m_fd, arr, cts::PG_SZ, BlockNo * cts::PG_SZ) == -1)
-        throw std::runtime_error("error while writing file");
+    writeAt(arr, cts::PG_SZ, static_cast<off_t>(BlockNo) * cts::PG_SZ);
 
     //TODO: usually we should not flush after every write;
     // this is just for development/debugging purposes
+    m.syncs.add();
+    ScopedTimer syncTimer(m.syncNs);
     if (fsync(m_fd) == -1)
         throw std::runtime_error("Error while fsyncing file");
 #endif
@@ -123,31 +390,274 @@ void IOHandler::writeBlock(void *arr, blockid_t BlockNo) const {
 void IOHandler::readBlock(void *arr, blockid_t BlockNo) const {
     if (BlockNo >= m_blocks)
         throw std::runtime_error("BlockNo out of bounds");
+    if (m_slots) {
+        readSlot(arr, BlockNo);
+        return;
+    }
+    auto &m = metrics();
+    m.reads.add();
+    m.bytesRead.add(cts::PG_SZ);
+    ScopedTimer timer(m.readNs);
+    Tracer::addBytes(&Tracer::Record::bytesRead, cts::PG_SZ);
+    Tracer::LayerTimer trace(&Tracer::Record::ioNs);
+#ifdef _WIN32
+    // pass the offset with the read rather than moving the shared file pointer, so concurrent
+    // reads don't race
+    u64 fileOffset = static_cast<u64>(BlockNo) * cts::PG_SZ;
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(fileOffset);
+    overlapped.OffsetHigh = static_cast<DWORD>(fileOffset >> 32);
+
+    // Read file
+    DWORD bytesRead;
+    if (!ReadFile(m_handle, arr, cts::PG_SZ, &bytesRead, &overlapped) || bytesRead != cts::PG_SZ)
+        throw std::runtime_error("ReadFile failed, error code: " + std::to_string(GetLastError()));
+#else
+    // writes go through the same OS page cache as the mapping, so it never holds stale blocks
+    if (m_map) {
+        std::memcpy(arr, m_map + static_cast<size_t>(BlockNo) * cts::PG_SZ, cts::PG_SZ);
+        return;
+    }
+    readAt(arr, cts::PG_SZ, static_cast<off_t>(BlockNo) * cts::PG_SZ);
+#endif//_WIN32
+}
+
+void IOHandler::writeBlocks(const void *arr, blockid_t firstBlockNo, blockid_t numBlocks) const {
+    if (firstBlockNo + numBlocks > m_blocks || firstBlockNo + numBlocks < firstBlockNo)
+        throw std::runtime_error("BlockNo out of bounds");
+    checkWritable();
+    if (m_slots) {
+        for (blockid_t i = 0; i < numBlocks; i++)
+            writeSlot(static_cast<const byte *>(arr) + static_cast<size_t>(i) * cts::PG_SZ, firstBlockNo + i);
+        sync();
+        return;
+    }
+    auto &m = metrics();
+    m.writes.add();
+    m.bytesWritten.add(static_cast<u64>(numBlocks) * cts::PG_SZ);
+    ScopedTimer timer(m.writeNs);
+    Tracer::addBytes(&Tracer::Record::bytesWritten, static_cast<u64>(numBlocks) * cts::PG_SZ);
+    Tracer::LayerTimer trace(&Tracer::Record::ioNs);
 #ifdef _WIN32
-    // Move file pointer manually
     LARGE_INTEGER fileOffset;
-    fileOffset.QuadPart = static_cast<LONGLONG>(BlockNo) * cts::PG_SZ;
+    fileOffset.QuadPart = static_cast<LONGLONG>(firstBlockNo) * cts::PG_SZ;
+    if (!SetFilePointerEx(m_handle, fileOffset, nullptr, FILE_BEGIN))
+        throw std::runtime_error("SetFilePointerEx failed, error code: " + std::to_string(GetLastError()));
+
+    DWORD written;
+    if (!WriteFile(m_handle, arr, numBlocks * cts::PG_SZ, &written, nullptr))
+        throw std::runtime_error("WriteFile failed, error code: " + std::to_string(GetLastError()));
+
+    m.syncs.add();
+    ScopedTimer syncTimer(m.syncNs);
+    if (!FlushFileBuffers(m_handle))
+        throw std::runtime_error("FlushFileBuffers failed, error code: " + std::to_string(GetLastError()));
+#else
+    size_t len = static_cast<size_t>(numBlocks) * cts::PG_SZ;
+    off_t pos = static_cast<off_t>(firstBlockNo) * cts::PG_SZ;
+    writeAt(arr, len, pos);
+
+    m.syncs.add();
+    ScopedTimer syncTimer(m.syncNs);
+    if (fsync(m_fd) == -1)
+        throw std::runtime_error("Error while fsyncing file");
+#endif
+}
+
+void IOHandler::readBlocks(void *arr, blockid_t firstBlockNo, blockid_t numBlocks) const {
+    if (firstBlockNo + numBlocks > m_blocks || firstBlockNo + numBlocks < firstBlockNo)
+        throw std::runtime_error("BlockNo out of bounds");
+    if (m_slots) {
+        for (blockid_t i = 0; i < numBlocks; i++)
+            readSlot(static_cast<byte *>(arr) + static_cast<size_t>(i) * cts::PG_SZ, firstBlockNo + i);
+        return;
+    }
+    auto &m = metrics();
+    m.reads.add();
+    m.bytesRead.add(static_cast<u64>(numBlocks) * cts::PG_SZ);
+    ScopedTimer timer(m.readNs);
+    Tracer::addBytes(&Tracer::Record::bytesRead, static_cast<u64>(numBlocks) * cts::PG_SZ);
+    Tracer::LayerTimer trace(&Tracer::Record::ioNs);
+#ifdef _WIN32
+    LARGE_INTEGER fileOffset;
+    fileOffset.QuadPart = static_cast<LONGLONG>(firstBlockNo) * cts::PG_SZ;
     if (!SetFilePointerEx(m_handle, fileOffset, nullptr, FILE_BEGIN))
         throw std::runtime_error("SetFilePointerEx failed, error code: " + std::to_string(GetLastError()));
 
-    // Read file
     DWORD bytesRead;
-    if (!ReadFile(m_handle, arr, cts::PG_SZ, &bytesRead, nullptr) || bytesRead != cts::PG_SZ)
+    if (!ReadFile(m_handle, arr, numBlocks * cts::PG_SZ, &bytesRead, nullptr) ||
+        bytesRead != numBlocks * cts::PG_SZ)
         throw std::runtime_error("ReadFile failed, error code: " + std::to_string(GetLastError()));
 #else
-    if (pread(m_fd, arr, cts::PG_SZ, BlockNo * cts::PG_SZ) == -1)
-        throw std::runtime_error("error while reading file");
+    size_t len = static_cast<size_t>(numBlocks) * cts::PG_SZ;
+    off_t pos = static_cast<off_t>(firstBlockNo) * cts::PG_SZ;
+    if (m_map) {
+        std::memcpy(arr, m_map + pos, len);
+        return;
+    }
+    readAt(arr, len, pos);
 #endif//_WIN32
 }
 
+void IOHandler::writeBlocks(std::span<const std::pair<blockid_t, const void *>> blocks, bool sync) const {
+    auto sorted = sortBatch(blocks, m_blocks);
+    checkWritable();
+    auto &m = metrics();
+    if (m_slots) {
+        for (auto [blockNo, arr]: sorted)
+            writeSlot(arr, blockNo);
+    } else {
+        u64 bytes = static_cast<u64>(sorted.size()) * cts::PG_SZ;
+        m.bytesWritten.add(bytes);
+        ScopedTimer timer(m.writeNs);
+        Tracer::addBytes(&Tracer::Record::bytesWritten, bytes);
+        Tracer::LayerTimer trace(&Tracer::Record::ioNs);
+#ifdef _WIN32
+        for (auto [blockNo, arr]: sorted) {
+            m.writes.add();
+            u64 fileOffset = static_cast<u64>(blockNo) * cts::PG_SZ;
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(fileOffset);
+            overlapped.OffsetHigh = static_cast<DWORD>(fileOffset >> 32);
+            DWORD written;
+            if (!WriteFile(m_handle, arr, cts::PG_SZ, &written, &overlapped))
+                throw std::runtime_error("WriteFile failed, error code: " + std::to_string(GetLastError()));
+        }
+#else
+        // direct I/O needs aligned buffers, so unaligned ones are copied into aligned ones first
+        Vec<AlignedBytes> copies;
+        for (auto &[blockNo, arr]: sorted) {
+            if (m_mode == IOMode::DIRECT && !aligned(arr)) {
+                m.unalignedCopies.add();
+                copies.emplace_back(static_cast<const byte *>(arr), static_cast<const byte *>(arr) + cts::PG_SZ);
+                arr = copies.back().data();
+            }
+        }
+        transferRuns<const void *>(sorted, true);
+#endif //_WIN32
+    }
+    if (sync)
+        this->sync();
+}
+
+void IOHandler::readBlocks(std::span<const std::pair<blockid_t, void *>> blocks) const {
+    auto sorted = sortBatch(blocks, m_blocks);
+    if (m_slots) {
+        for (auto [blockNo, arr]: sorted)
+            readSlot(arr, blockNo);
+        return;
+    }
+    auto &m = metrics();
+    u64 bytes = static_cast<u64>(sorted.size()) * cts::PG_SZ;
+    m.bytesRead.add(bytes);
+    ScopedTimer timer(m.readNs);
+    Tracer::addBytes(&Tracer::Record::bytesRead, bytes);
+    Tracer::LayerTimer trace(&Tracer::Record::ioNs);
+#ifdef _WIN32
+    for (auto [blockNo, arr]: sorted) {
+        m.reads.add();
+        u64 fileOffset = static_cast<u64>(blockNo) * cts::PG_SZ;
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(fileOffset);
+        overlapped.OffsetHigh = static_cast<DWORD>(fileOffset >> 32);
+        DWORD bytesRead;
+        if (!ReadFile(m_handle, arr, cts::PG_SZ, &bytesRead, &overlapped) || bytesRead != cts::PG_SZ)
+            throw std::runtime_error("ReadFile failed, error code: " + std::to_string(GetLastError()));
+    }
+#else
+    if (m_map) {
+        m.reads.add();
+        for (auto [blockNo, arr]: sorted)
+            std::memcpy(arr, m_map + static_cast<size_t>(blockNo) * cts::PG_SZ, cts::PG_SZ);
+        return;
+    }
+
+    // direct I/O needs aligned buffers, so unaligned ones are read into aligned ones, then copied
+    Vec<std::pair<void *, AlignedBytes>> copies;
+    for (auto &[blockNo, arr]: sorted) {
+        if (m_mode == IOMode::DIRECT && !aligned(arr)) {
+            m.unalignedCopies.add();
+            copies.emplace_back(arr, AlignedBytes(cts::PG_SZ));
+            arr = copies.back().second.data();
+        }
+    }
+    transferRuns<void *>(sorted, false);
+    for (auto &[arr, copy]: copies)
+        std::memcpy(arr, copy.data(), cts::PG_SZ);
+#endif //_WIN32
+}
+
+void IOHandler::sync() const {
+    checkWritable();
+    auto &m = metrics();
+    m.syncs.add();
+    ScopedTimer timer(m.syncNs);
+    Tracer::LayerTimer trace(&Tracer::Record::ioNs);
+#ifdef _WIN32
+    if (!FlushFileBuffers(m_handle))
+        throw std::runtime_error("FlushFileBuffers failed, error code: " + std::to_string(GetLastError()));
+#else
+    if (fsync(m_fd) == -1)
+        throw std::runtime_error("Error while fsyncing file");
+#endif //_WIN32
+    // the map must only point at slots whose blocks are on disk
+    if (m_slots)
+        m_slots->sync();
+}
+
+#ifndef _WIN32
+template<typename Buffer>
+void IOHandler::transferRuns(std::span<const std::pair<blockid_t, Buffer>> blocks, bool write) const {
+    Vec<iovec> iov;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        iov.push_back({const_cast<void *>(static_cast<const void *>(blocks[i].second)), cts::PG_SZ});
+        if (i + 1 < blocks.size() && blocks[i + 1].first == blocks[i].first + 1)
+            continue;
+
+        (write ? metrics().writes : metrics().reads).add();
+        auto pos = static_cast<off_t>(blocks[i].first + 1 - iov.size()) * cts::PG_SZ;
+        // a run of more than IOV_MAX blocks, or a partial transfer, takes several calls
+        size_t next = 0;
+        while (next < iov.size()) {
+            int count = static_cast<int>(std::min<size_t>(iov.size() - next, IOV_MAX));
+            ssize_t done = write ? pwritev(m_fd, iov.data() + next, count, pos)
+                                 : preadv(m_fd, iov.data() + next, count, pos);
+            if (done <= 0)
+                throw std::runtime_error(write ? "error while writing file" : "error while reading file");
+            pos += done;
+            for (; next < iov.size() && static_cast<size_t>(done) >= iov[next].iov_len; next++)
+                done -= static_cast<ssize_t>(iov[next].iov_len);
+            if (done > 0) {
+                iov[next].iov_base = static_cast<byte *>(iov[next].iov_base) + done;
+                iov[next].iov_len -= done;
+            }
+        }
+        iov.clear();
+    }
+}
+#endif //_WIN32
+
 IOHandler::~IOHandler() {
 #ifdef _WIN32
-    FlushFileBuffers(m_handle);
+    if (!readOnly())
+        FlushFileBuffers(m_handle);
     CloseHandle(m_handle);
 #else
-    fsync(m_fd);
+    if (m_map)
+        munmap(m_map, m_mapLen);
+    for (auto [map, len]: m_oldMaps)
+        munmap(map, len);
+    if (!readOnly())
+        fsync(m_fd);
     close(m_fd);
 #endif//_WIN32
+    // the blocks are flushed, so the map may point at them; a failure leaves the map as of the last sync
+    if (m_slots) {
+        try {
+            m_slots->sync();
+        } catch (const std::exception &) {
+        }
+    }
 }
 
 } // namespace backend
\ No newline at end of file
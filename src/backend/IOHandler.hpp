@@ -5,7 +5,9 @@
 #ifndef KNDB_IOHANDLER_HPP
 #define KNDB_IOHANDLER_HPP
 
+#include <atomic>
 #include <cstddef>
+#include <span>
 #include <string>
 
 #include "kndb_types.hpp"
@@ -13,18 +15,52 @@
     #include <windows.h>
 #else // includes for posix
     #include <fcntl.h>
+    #include <sys/mman.h>
     #include <sys/stat.h>
+    #include <sys/uio.h>
     #include <unistd.h>
 #endif //_WIN32
 
 namespace backend {
 
+/**
+ * @brief How an IOHandler accesses its file.
+ */
+enum class IOMode : u8 {
+    READ_WRITE, ///< Reads and writes blocks with system calls.
+    MMAP,       ///< Reads blocks through a memory mapping of the file, and writes them with system calls.
+    READ_ONLY,  ///< Opens an existing file read-only, and reads blocks through a memory mapping.
+    DIRECT,     ///< Reads and writes blocks with direct I/O, bypassing the OS page cache.
+    COMPRESSED  ///< Stores each block compressed, in a slot of its own size.
+};
+
+class SlotMap;
+
 /**
  * @class IOHandler
  * @brief Provides an interface for low-level file I/O operations.
  *
  * Handles file interactions such as reading and writing, as well as
  * increasing the size of the file when needed.
+ *
+ * In the MMAP and READ_ONLY modes, the file is mapped into memory with a hint that it is accessed
+ * at random, so blocks are read from the OS page cache without a system call or a second copy,
+ * and viewBlock() lets pages be deserialized straight from the mapping. On Windows, the file is
+ * not mapped, and those modes read blocks with system calls like READ_WRITE.
+ *
+ * In DIRECT mode, blocks move straight between the disk and the caller's buffer, so they are not
+ * cached a second time by the OS and memory use is bounded by the PageCache's capacity. The OS
+ * no longer reads ahead either, so callers that read consecutive blocks should batch them with
+ * readBlocks(). Buffers should be aligned to cts::PG_SZ (see AlignedBytes); any other buffer is
+ * copied through an aligned one. If the file system or platform has no direct I/O, the file is
+ * accessed like READ_WRITE.
+ *
+ * In COMPRESSED mode, each block is compressed with PageCodec and stored in a slot of 1 to 8
+ * eighths of a block, which is written and read in place of the whole block. A SlotMap, kept in
+ * the file "<fileName>.map", tells where each block's slot is. A block that does not compress
+ * below 7 eighths is stored as it is. Blocks are created without taking space, and a block never
+ * written reads as zeros. A compressed file must always be opened in this mode, and opening an
+ * uncompressed file in it throws.
  */
 class IOHandler {
 public:
@@ -32,12 +68,14 @@ public:
      * @brief Constructs an IOHandler for a given file.
      *
      * @param fileName The name of the file to be used for storage.
+     * @param mode How the file is accessed.
      *
      * Opens or creates a file for managing database storage. If
-     * the file is created, default size is 0.
+     * the file is created, default size is 0. In READ_ONLY mode, the
+     * file must exist and is never changed.
      * @throws std::runtime_error if file operations fail.
      */
-    explicit IOHandler(std::string_view fileName);
+    explicit IOHandler(std::string_view fileName, IOMode mode = IOMode::READ_WRITE);
 
     /**
      * @brief Gets the total number of blocks in the database file.
@@ -50,7 +88,7 @@ public:
      * @brief Creates a new block in the file.
      *
      * @return The Block No of the newly created block (0-indexed).
-     * @throws std::runtime_error if file operations fail.
+     * @throws std::runtime_error if file operations fail or the file is read-only.
      */
     blockid_t createNewBlock();
 
@@ -60,7 +98,7 @@ public:
      * @param numBlocks Number of blocks to allocate. Must be positive number.
      *
      * @return The Block No of the first newly created block (0-indexed).
-     * @throws std::runtime_error if file operations fail.
+     * @throws std::runtime_error if file operations fail or the file is read-only.
      */
     blockid_t createMultipleBlocks(int numBlocks);
 
@@ -69,7 +107,8 @@ public:
      *
      * @param arr Pointer to the data to be written.
      * @param BlockNo The ID of the block to write to (0-indexed).
-     * @throws std::runtime_error if BlockNo is out of bounds or file operations fail.
+     * @throws std::runtime_error if BlockNo is out of bounds, file operations fail or the file is
+     * read-only.
      */
     void writeBlock(void *arr, blockid_t BlockNo) const;
 
@@ -79,9 +118,98 @@ public:
      * @param arr Pointer to the buffer where data will be read into.
      * @param BlockNo The ID of the block to read from (0-indexed).
      * @throws std::runtime_error if BlockNo is out of bounds or file operations fail.
+     *
+     * Safe to call from several threads at once.
      */
     void readBlock(void *arr, blockid_t BlockNo) const;
 
+    /**
+     * @brief Writes a range of consecutive blocks with a single write and a single flush.
+     *
+     * @param arr Pointer to numBlocks blocks of data to be written.
+     * @param firstBlockNo The ID of the first block to write to (0-indexed).
+     * @param numBlocks Number of blocks to write.
+     * @throws std::runtime_error if the range is out of bounds, file operations fail or the file
+     * is read-only.
+     */
+    void writeBlocks(const void *arr, blockid_t firstBlockNo, blockid_t numBlocks) const;
+
+    /**
+     * @brief Reads a range of consecutive blocks with a single read.
+     *
+     * @param arr Pointer to the buffer where numBlocks blocks will be read into.
+     * @param firstBlockNo The ID of the first block to read from (0-indexed).
+     * @param numBlocks Number of blocks to read.
+     * @throws std::runtime_error if the range is out of bounds or file operations fail.
+     */
+    void readBlocks(void *arr, blockid_t firstBlockNo, blockid_t numBlocks) const;
+
+    /**
+     * @brief Writes a batch of blocks, each from its own buffer.
+     *
+     * The blocks are sorted, and each run of consecutive blocks is written with a single
+     * vectored write, so a batch spread over the file is written mostly sequentially.
+     *
+     * @param blocks The blocks to write, as (block ID, buffer) pairs in any order. A block must not
+     * be listed twice.
+     * @param sync Whether to flush the file once the whole batch is written.
+     * @throws std::runtime_error if a block is out of bounds, file operations fail or the file is
+     * read-only.
+     */
+    void writeBlocks(std::span<const std::pair<blockid_t, const void *>> blocks, bool sync = true) const;
+
+    /**
+     * @brief Reads a batch of blocks, each into its own buffer.
+     *
+     * The blocks are sorted, and each run of consecutive blocks is read with a single vectored
+     * read.
+     *
+     * @param blocks The blocks to read, as (block ID, buffer) pairs in any order.
+     * @throws std::runtime_error if a block is out of bounds or file operations fail.
+     */
+    void readBlocks(std::span<const std::pair<blockid_t, void *>> blocks) const;
+
+    /**
+     * @brief Flushes every write made so far to disk.
+     * @throws std::runtime_error if the flush fails or the file is read-only.
+     */
+    void sync() const;
+
+    /**
+     * @brief Gives direct access to a block through the file's memory mapping.
+     *
+     * @param BlockNo The ID of the block (0-indexed).
+     * @return A view of the block, valid until the handler is destroyed, or an empty span if the
+     * file is not mapped, in which case readBlock() must be used instead.
+     * @throws std::runtime_error if BlockNo is out of bounds.
+     *
+     * Safe to call from several threads at once.
+     */
+    std::span<const byte> viewBlock(blockid_t BlockNo) const;
+
+    IOMode getMode() const { return m_mode; }
+
+    /**
+     * @return true if blocks are read through a memory mapping of the file, see viewBlock().
+     */
+#ifdef _WIN32
+    bool mapped() const { return false; }
+#else
+    bool mapped() const { return m_mode == IOMode::MMAP || readOnly(); }
+#endif //_WIN32
+
+    /**
+     * @return true if the file was opened in READ_ONLY mode, in which case every write throws.
+     */
+    bool readOnly() const { return m_mode == IOMode::READ_ONLY; }
+
+    /**
+     * @brief Gets the name of the file this handler operates on.
+     *
+     * @return The file name, as passed to the constructor.
+     */
+    std::string_view getFileName() const;
+
     ~IOHandler();
 
     IOHandler& operator=(IOHandler&& other) = delete;
@@ -90,12 +218,41 @@ public:
     IOHandler(IOHandler&&) = delete;
 
 private:
+    struct Metrics;
+
+    static Metrics &metrics();
+
 #ifdef _WIN32
     HANDLE m_handle;
 #else
     int m_fd;
+    byte *m_map = nullptr; ///< The mapping of the file's blocks, if mapped.
+    size_t m_mapLen = 0;   ///< Bytes mapped, which may run past the end of the file.
+    Vec<std::pair<byte *, size_t>> m_oldMaps; ///< Outgrown mappings, kept so views into them stay valid.
+
+    // maps at least the file's current blocks, replacing the mapping if it is too small
+    void remap();
+
+    // writes or reads the blocks of a sorted batch, one vectored call per run of consecutive blocks.
+    // Buffers must be aligned for direct I/O.
+    template<typename Buffer>
+    void transferRuns(std::span<const std::pair<blockid_t, Buffer>> blocks, bool write) const;
 #endif // _WIN32
-    pgid_t m_blocks;
+    std::atomic<blockid_t> m_blocks; ///< Read by any thread, while one thread may add blocks.
+    string m_fileName;
+    IOMode m_mode;
+    Ptr<SlotMap> m_slots; ///< Where each block is stored, in COMPRESSED mode.
+
+    // write or read len bytes at pos, through an aligned copy if direct I/O needs one
+    void writeAt(const void *arr, size_t len, u64 pos) const;
+    void readAt(void *arr, size_t len, u64 pos) const;
+
+    // compresses a block into its slot, or reads and decompresses it, in COMPRESSED mode
+    void writeSlot(const void *arr, blockid_t blockNo) const;
+    void readSlot(void *arr, blockid_t blockNo) const;
+
+    // throws if the file was opened read-only
+    void checkWritable() const;
 };
 
 } // namespace backend
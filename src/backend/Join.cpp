@@ -0,0 +1,128 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include "Join.hpp"
+#include "utility.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+HashJoin::HashJoin(Pager &pager, Vec<Vari> buildTypes, u16 buildColumn, Vec<Vari> probeTypes, u16 probeColumn,
+                   size_t memoryBudget)
+        : HashJoin(pager, std::move(buildTypes), buildColumn, std::move(probeTypes), probeColumn, memoryBudget, 0) {}
+
+HashJoin::HashJoin(Pager &pager, Vec<Vari> buildTypes, u16 buildColumn, Vec<Vari> probeTypes, u16 probeColumn,
+                   size_t memoryBudget, u32 level)
+        : m_pager(pager), m_buildTypes(std::move(buildTypes)), m_buildColumn(buildColumn),
+          m_probeTypes(std::move(probeTypes)), m_probeColumn(probeColumn), m_memoryBudget(memoryBudget),
+          m_level(level), m_memoryUsed(0), m_probing(false) {
+    ASSUME_S(m_buildColumn < m_buildTypes.size() && m_probeColumn < m_probeTypes.size(),
+             "Join column is out of range");
+    ASSUME_S(variant_to_type_id(m_buildTypes[m_buildColumn]) == variant_to_type_id(m_probeTypes[m_probeColumn]),
+             "Join columns have different types");
+}
+
+void HashJoin::build(const Vec<Vari> &tuple) {
+    ASSUME_S(!m_probing, "Build tuple added after probing");
+
+    if (hasSpilled()) {
+        m_buildPartitions[partitionOf(tuple[m_buildColumn])]->append(tuple);
+        return;
+    }
+
+    m_table.emplace(tuple[m_buildColumn], tuple);
+    m_memoryUsed += footprint(tuple);
+    if (m_memoryUsed > m_memoryBudget && m_level < MAX_LEVEL)
+        spill();
+}
+
+void HashJoin::probe(const Vec<Vari> &tuple, const JoinCallback &callback) {
+    m_probing = true;
+    const Vari &value = tuple[m_probeColumn];
+    if (hasSpilled()) {
+        m_probePartitions[partitionOf(value)]->append(tuple);
+        return;
+    }
+
+    auto [begin, end] = m_table.equal_range(value);
+    for (auto it = begin; it != end; ++it)
+        callback(it->second, tuple);
+}
+
+void HashJoin::finish(const JoinCallback &callback) {
+    for (size_t p = 0; p < m_buildPartitions.size(); p++) {
+        auto buildPartition = std::move(m_buildPartitions[p]);
+        auto probePartition = std::move(m_probePartitions[p]);
+        if (buildPartition->size() == 0 || probePartition->size() == 0)
+            continue;
+
+        HashJoin partition(m_pager, m_buildTypes, m_buildColumn, m_probeTypes, m_probeColumn, m_memoryBudget,
+                           m_level + 1);
+        buildPartition->forEach([&](const Vec<Vari> &tuple) { partition.build(tuple); });
+        buildPartition.reset();
+        probePartition->forEach([&](const Vec<Vari> &tuple) { partition.probe(tuple, callback); });
+        probePartition.reset();
+        partition.finish(callback);
+    }
+
+    m_buildPartitions.clear();
+    m_probePartitions.clear();
+    m_table.clear();
+    m_memoryUsed = 0;
+}
+
+void HashJoin::spill() {
+    for (size_t p = 0; p < NUM_PARTITIONS; p++) {
+        m_buildPartitions.push_back(std::make_unique<SpillRun>(m_pager, m_buildTypes));
+        m_probePartitions.push_back(std::make_unique<SpillRun>(m_pager, m_probeTypes));
+    }
+
+    for (auto &[value, tuple]: m_table)
+        m_buildPartitions[partitionOf(value)]->append(std::move(tuple));
+    m_table.clear();
+    m_memoryUsed = 0;
+}
+
+size_t HashJoin::partitionOf(const Vari &value) const {
+    // each level uses lower bits than the last, so a partition is split evenly at the next level
+    u32 shift = 64 - PARTITION_BITS * (m_level + 1);
+    return (db_hash(value) >> shift) & (NUM_PARTITIONS - 1);
+}
+
+size_t HashJoin::footprint(const Vec<Vari> &tuple) {
+    // the tuple, the copy of its join value, and the hash table node
+    size_t size = sizeof(Vari) * (tuple.size() + 1) + sizeof(Vec<Vari>) + 4 * sizeof(void *);
+    for (const auto &value: tuple)
+        if (auto str = std::get_if<string>(&value))
+            size += str->capacity();
+    return size;
+}
+
+void mergeJoin(TupleCursor &left, u16 leftColumn, TupleCursor &right, u16 rightColumn, const JoinCallback &callback) {
+    Vec<Vec<Vari>> group; // right tuples sharing the current join value
+
+    while (left.valid() && right.valid()) {
+        const Vari &leftValue = left.tuple()[leftColumn];
+        const Vari &rightValue = right.tuple()[rightColumn];
+        if (leftValue < rightValue) {
+            left.next();
+            continue;
+        }
+        if (rightValue < leftValue) {
+            right.next();
+            continue;
+        }
+
+        Vari value = rightValue;
+        group.clear();
+        for (; right.valid() && right.tuple()[rightColumn] == value; right.next())
+            group.push_back(right.tuple());
+
+        for (; left.valid() && left.tuple()[leftColumn] == value; left.next())
+            for (const auto &match: group)
+                callback(left.tuple(), match);
+    }
+}
+
+} // namespace backend
@@ -0,0 +1,130 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_JOIN_HPP
+#define KNDB_JOIN_HPP
+
+#include <functional>
+#include <unordered_map>
+
+#include "Pager.hpp"
+#include "SpillRun.hpp"
+#include "TupleCursor.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * Receives the pairs of tuples produced by a join. The tuples are only valid during the call.
+ */
+using JoinCallback = std::function<void(const Vec<Vari> &left, const Vec<Vari> &right)>;
+
+/**
+ * @class HashJoin
+ * @brief Joins two inputs on equal column values by hashing one of them (the build input) and
+ * looking up the tuples of the other (the probe input).
+ *
+ * Build tuples are kept in an in-memory hash table until they exceed the memory budget. The join
+ * then spills: every build tuple, and every probe tuple after it, is written to one of
+ * NUM_PARTITIONS SpillRuns chosen by the hash of its join value. Once the probe input ends, each
+ * pair of partitions is joined on its own, spilling again into finer partitions if the build
+ * partition still does not fit.
+ */
+class HashJoin {
+public:
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+    static constexpr u32 PARTITION_BITS = 4;
+    static constexpr size_t NUM_PARTITIONS = 1 << PARTITION_BITS;
+
+    /**
+     * @brief Prepares a join.
+     * @param pager Pager to allocate spill pages from.
+     * @param buildTypes The types of the build tuples.
+     * @param buildColumn The column of the build tuples to join on.
+     * @param probeTypes The types of the probe tuples.
+     * @param probeColumn The column of the probe tuples to join on. Must have the same type as
+     * the build column.
+     * @param memoryBudget Approximate number of bytes the build tuples may occupy in memory.
+     */
+    HashJoin(Pager &pager, Vec<Vari> buildTypes, u16 buildColumn, Vec<Vari> probeTypes, u16 probeColumn,
+             size_t memoryBudget = DEFAULT_MEMORY_BUDGET);
+
+    /**
+     * @brief Adds a tuple to the build input. Must be called before any probe.
+     * @param tuple The tuple.
+     */
+    void build(const Vec<Vari> &tuple);
+
+    /**
+     * @brief Joins a probe tuple with the matching build tuples, or spills it if the build input
+     * has spilled.
+     * @param tuple The tuple.
+     * @param callback Invoked as callback(build, probe) for every matching pair.
+     */
+    void probe(const Vec<Vari> &tuple, const JoinCallback &callback);
+
+    /**
+     * @brief Joins the spilled partitions, if any, and frees their pages.
+     * @param callback Invoked as callback(build, probe) for every matching pair.
+     */
+    void finish(const JoinCallback &callback);
+
+    /**
+     * @return true if the build input did not fit in the memory budget.
+     */
+    bool hasSpilled() const { return !m_buildPartitions.empty(); }
+
+    HashJoin &operator=(HashJoin &&other) = delete;
+    HashJoin &operator=(const HashJoin &other) = delete;
+    HashJoin(HashJoin &&other) = delete;
+    HashJoin(const HashJoin &other) = delete;
+
+private:
+    // levels of partitioning after which the build input is kept in memory regardless of size,
+    // since its tuples likely all share a few join values
+    static constexpr u32 MAX_LEVEL = 3;
+
+    HashJoin(Pager &pager, Vec<Vari> buildTypes, u16 buildColumn, Vec<Vari> probeTypes, u16 probeColumn,
+             size_t memoryBudget, u32 level);
+
+    // moves the in-memory build tuples to the partitions
+    void spill();
+
+    // picks a partition using the next PARTITION_BITS bits of the value's hash
+    size_t partitionOf(const Vari &value) const;
+
+    // approximate number of bytes a tuple occupies in the hash table
+    static size_t footprint(const Vec<Vari> &tuple);
+
+    Pager &m_pager;
+    Vec<Vari> m_buildTypes;
+    u16 m_buildColumn;
+    Vec<Vari> m_probeTypes;
+    u16 m_probeColumn;
+    size_t m_memoryBudget;
+    u32 m_level;
+
+    std::unordered_multimap<Vari, Vec<Vari>> m_table;
+    size_t m_memoryUsed;
+    bool m_probing;
+    Vec<Ptr<SpillRun>> m_buildPartitions;
+    Vec<Ptr<SpillRun>> m_probePartitions;
+};
+
+/**
+ * @brief Joins two inputs that are sorted on the columns they are joined on, by advancing through
+ * both at once. Only the tuples of the right input that share the current join value are held in
+ * memory.
+ * @param left Cursor over the left input, in ascending order of leftColumn.
+ * @param leftColumn The column of the left tuples to join on.
+ * @param right Cursor over the right input, in ascending order of rightColumn.
+ * @param rightColumn The column of the right tuples to join on.
+ * @param callback Invoked as callback(left, right) for every matching pair, in ascending order of
+ * the join value.
+ */
+void mergeJoin(TupleCursor &left, u16 leftColumn, TupleCursor &right, u16 rightColumn, const JoinCallback &callback);
+
+} // namespace backend
+
+#endif //KNDB_JOIN_HPP
@@ -0,0 +1,405 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+#include "LsmTree.hpp"
+#include "utility.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+//    manifest block:
+//    u8 pagetypeid
+//    u64 nextRunID
+//    u8 numLevels
+//    level {
+//        u16 numRuns
+//        u64 runIDs[numRuns]
+//    }[numLevels]
+
+LsmTree::LsmTree(string basePath, const Vec<Vari> &types)
+        : LsmTree(std::move(basePath), types, Options{}) {}
+
+LsmTree::LsmTree(string basePath, const Vec<Vari> &types, Options options)
+        : m_basePath(std::move(basePath)), m_types(types), m_options(options), m_nextRunID(0), m_busy(false),
+          m_stop(false) {
+    ASSUME_S(!types.empty(), "There cannot be 0 types in an LSM tree");
+    ASSUME_S(m_options.memtableEntries > 0, "Memtable must hold at least one entry");
+    ASSUME_S(m_options.level0Runs > 0, "Level 0 must hold at least one run");
+    ASSUME_S(m_options.levelRatio > 1, "Level ratio must be greater than 1");
+
+    loadManifest();
+    m_worker = std::thread(&LsmTree::backgroundLoop, this);
+}
+
+LsmTree::~LsmTree() {
+    if (!m_worker.joinable())
+        return;
+
+    {
+        std::unique_lock lock(m_mutex);
+        if (!m_memtable.empty())
+            rotateMemtable(lock);
+        m_stop = true;
+    }
+    m_workCv.notify_all();
+    m_worker.join();
+}
+
+void LsmTree::destroy() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_memtable.clear();
+        // a memtable the background thread has not picked up yet is never written
+        if (!m_busy)
+            m_immutable = nullptr;
+        m_stop = true;
+    }
+    m_workCv.notify_all();
+    m_worker.join();
+
+    // close the runs before deleting their files
+    auto empty = std::make_shared<Version>();
+    empty->levels.resize(1);
+    m_version = std::move(empty);
+    m_immutable = nullptr;
+
+    std::filesystem::path base(m_basePath);
+    std::filesystem::path dir = base.has_parent_path() ? base.parent_path() : std::filesystem::path(".");
+    string prefix = base.filename().string() + ".";
+    for (const auto &entry: std::filesystem::directory_iterator(dir)) {
+        string name = entry.path().filename().string();
+        if (name.size() <= prefix.size() + 4 || !name.starts_with(prefix) || !name.ends_with(".run"))
+            continue;
+
+        // only files named <base>.<runID>.run belong to the tree
+        string runID = name.substr(prefix.size(), name.size() - prefix.size() - 4);
+        if (std::all_of(runID.begin(), runID.end(), [](char c) { return c >= '0' && c <= '9'; }))
+            std::filesystem::remove(entry.path());
+    }
+    std::filesystem::remove(m_basePath + ".manifest");
+    std::filesystem::remove(m_basePath + ".manifest.tmp");
+}
+
+std::pair<std::shared_ptr<const LsmTree::Memtable>, std::shared_ptr<const LsmTree::Version>>
+LsmTree::snapshot() const {
+    std::lock_guard lock(m_mutex);
+    return {m_immutable, m_version};
+}
+
+Vec<Ptr<LsmCursor>> LsmTree::sources(const std::shared_ptr<const Memtable> &immutable,
+                                     const Version &version) const {
+    Vec<Ptr<LsmCursor>> sources;
+    sources.push_back(std::make_unique<MemtableCursor>(m_memtable));
+    if (immutable)
+        sources.push_back(std::make_unique<MemtableCursor>(*immutable));
+    for (const auto &level: version.levels)
+        for (const auto &run: level)
+            sources.push_back(run->cursor());
+    return sources;
+}
+
+std::optional<LsmEntry> LsmTree::lookup(const Vari &key) const {
+    if (auto it = m_memtable.find(key); it != m_memtable.end())
+        return LsmEntry{it->first, it->second};
+
+    auto [immutable, version] = snapshot();
+    if (immutable) {
+        if (auto it = immutable->find(key); it != immutable->end())
+            return LsmEntry{it->first, it->second};
+    }
+
+    u64 hash = db_hash(key);
+    for (const auto &level: version->levels) {
+        for (const auto &run: level) {
+            if (auto entry = run->get(key, hash))
+                return entry;
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::optional<Vec<Vari>> LsmTree::search(const Vari &key) {
+    ASSUME_S(key.index() == m_types[0].index(), "Key type is incorrect");
+
+    auto entry = lookup(key);
+    if (!entry)
+        return std::nullopt;
+    return std::move(entry->value);
+}
+
+bool LsmTree::insert(Vec<Vari> values, Vari key) {
+    ASSUME_S(key.index() == m_types[0].index(), "Key type is incorrect");
+
+    auto entry = lookup(key);
+    if (entry && entry->value)
+        return false;
+
+    put(std::move(key), std::move(values));
+    return true;
+}
+
+bool LsmTree::remove(Vari key) {
+    ASSUME_S(key.index() == m_types[0].index(), "Key type is incorrect");
+
+    auto entry = lookup(key);
+    if (!entry || !entry->value)
+        return false;
+
+    put(std::move(key), std::nullopt);
+    return true;
+}
+
+bool LsmTree::update(Vec<Vari> values, const Vari &key) {
+    ASSUME_S(key.index() == m_types[0].index(), "Key type is incorrect");
+
+    auto entry = lookup(key);
+    if (!entry || !entry->value)
+        return false;
+
+    put(key, std::move(values));
+    return true;
+}
+
+void LsmTree::put(Vari key, std::optional<Vec<Vari>> value) {
+    m_memtable.insert_or_assign(std::move(key), std::move(value));
+    if (m_memtable.size() < m_options.memtableEntries)
+        return;
+
+    std::unique_lock lock(m_mutex);
+    rotateMemtable(lock);
+}
+
+void LsmTree::rotateMemtable(std::unique_lock<std::mutex> &lock) {
+    // only one memtable can be waiting to be flushed; writers stall until it is
+    m_doneCv.wait(lock, [this] { return m_immutable == nullptr; });
+
+    m_immutable = std::make_shared<const Memtable>(std::move(m_memtable));
+    m_memtable.clear();
+    m_workCv.notify_all();
+}
+
+void LsmTree::flush() {
+    std::unique_lock lock(m_mutex);
+    if (!m_memtable.empty())
+        rotateMemtable(lock);
+
+    m_doneCv.wait(lock, [this] {
+        return !m_busy && m_immutable == nullptr && pickCompaction(*m_version) == cts::SIZE_T_INVALID;
+    });
+}
+
+Vec<size_t> LsmTree::getRunsPerLevel() const {
+    auto [_, version] = snapshot();
+
+    Vec<size_t> runs;
+    for (const auto &level: version->levels)
+        runs.push_back(level.size());
+    return runs;
+}
+
+size_t LsmTree::pickCompaction(const Version &version) const {
+    if (version.levels[0].size() >= m_options.level0Runs)
+        return 0;
+
+    u64 capacity = m_options.memtableEntries * m_options.level0Runs;
+    for (size_t i = 1; i < version.levels.size(); i++) {
+        capacity *= m_options.levelRatio;
+
+        u64 entries = 0;
+        for (const auto &run: version.levels[i])
+            entries += run->getNumEntries();
+        if (entries > capacity)
+            return i;
+    }
+
+    return cts::SIZE_T_INVALID;
+}
+
+void LsmTree::backgroundLoop() {
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        m_workCv.wait(lock, [this] {
+            return m_stop || m_immutable != nullptr || pickCompaction(*m_version) != cts::SIZE_T_INVALID;
+        });
+
+        auto immutable = m_immutable;
+        auto version = m_version;
+        size_t level = pickCompaction(*version);
+        if (!immutable && (m_stop || level == cts::SIZE_T_INVALID))
+            return;
+
+        m_busy = true;
+        lock.unlock();
+
+        if (immutable) {
+            // tombstones in the memtable only matter if older runs may still hold their keys
+            bool empty = std::all_of(version->levels.begin(), version->levels.end(),
+                                     [](const auto &runs) { return runs.empty(); });
+
+            MemtableCursor cursor(*immutable);
+            auto next = std::make_shared<Version>(*version);
+            if (auto run = writeRun(cursor, immutable->size(), empty))
+                next->levels[0].insert(next->levels[0].begin(), std::move(run));
+            installVersion(next);
+        } else {
+            compact(level);
+        }
+
+        lock.lock();
+        if (immutable)
+            m_immutable = nullptr;
+        m_busy = false;
+        m_doneCv.notify_all();
+    }
+}
+
+void LsmTree::compact(size_t level) {
+    std::shared_ptr<const Version> version;
+    {
+        std::lock_guard lock(m_mutex);
+        version = m_version;
+    }
+
+    auto next = std::make_shared<Version>(*version);
+    size_t target = level + 1;
+    if (next->levels.size() <= target)
+        next->levels.resize(target + 1);
+
+    // newest first: the compacted level, then the level it merges into
+    Vec<RunPtr> inputs = next->levels[level];
+    inputs.insert(inputs.end(), next->levels[target].begin(), next->levels[target].end());
+
+    Vec<Ptr<LsmCursor>> cursors;
+    u64 expected = 0;
+    for (const auto &run: inputs) {
+        cursors.push_back(run->cursor());
+        expected += run->getNumEntries();
+    }
+
+    // tombstones can be dropped once no deeper level may still hold the keys they delete
+    bool deepest = true;
+    for (size_t i = target + 1; i < next->levels.size(); i++)
+        deepest &= next->levels[i].empty();
+
+    MergeCursor cursor(std::move(cursors));
+    auto run = writeRun(cursor, expected, deepest);
+
+    next->levels[level].clear();
+    next->levels[target].clear();
+    if (run)
+        next->levels[target].push_back(std::move(run));
+    installVersion(next);
+
+    for (const auto &input: inputs)
+        input->markObsolete();
+}
+
+LsmTree::RunPtr LsmTree::writeRun(LsmCursor &source, u64 expectedEntries, bool dropTombstones) {
+    u64 runID = m_nextRunID++;
+    string fileName = runFileName(runID);
+
+    SortedRunWriter writer(fileName, m_types, expectedEntries, m_options.bloomBitsPerKey);
+    for (; source.valid(); source.next()) {
+        if (dropTombstones && !source.entry().value.has_value())
+            continue;
+        writer.add(source.entry());
+    }
+
+    if (writer.finish() == 0) {
+        std::remove(fileName.c_str());
+        return nullptr;
+    }
+
+    return std::make_shared<SortedRun>(runID, fileName);
+}
+
+void LsmTree::installVersion(std::shared_ptr<const Version> version) {
+    // the manifest is written first so that a crash never leaves it referring to deleted runs
+    writeManifest(*version);
+
+    std::lock_guard lock(m_mutex);
+    m_version = std::move(version);
+}
+
+string LsmTree::runFileName(u64 runID) const {
+    return m_basePath + "." + std::to_string(runID) + ".run";
+}
+
+void LsmTree::loadManifest() {
+    string fileName = m_basePath + ".manifest";
+    auto version = std::make_shared<Version>();
+    version->levels.resize(1);
+
+    if (!std::filesystem::exists(fileName)) {
+        m_version = std::move(version);
+        return;
+    }
+
+    IOHandler ioHandler(fileName);
+    ASSUME_S(ioHandler.getNumBlocks() == 1, "Manifest must be exactly one block");
+
+    PgArr<byte> buf;
+    ioHandler.readBlock(buf.data(), 0);
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id;
+    u8 numLevels;
+    db_deserialize(page_type_id, buf, offset);
+    ASSUME_S(page_type_id == cts::pg_type_id::LSM_MANIFEST_PAGE, "Page_type_id is incorrect type");
+    db_deserialize(m_nextRunID, buf, offset);
+    db_deserialize(numLevels, buf, offset);
+
+    version->levels.resize(std::max<u8>(numLevels, 1));
+    for (int i = 0; i < numLevels; i++) {
+        u16 numRuns;
+        db_deserialize(numRuns, buf, offset);
+        for (int j = 0; j < numRuns; j++) {
+            u64 runID;
+            db_deserialize(runID, buf, offset);
+            version->levels[i].push_back(std::make_shared<SortedRun>(runID, runFileName(runID)));
+        }
+    }
+
+    m_version = std::move(version);
+}
+
+void LsmTree::writeManifest(const Version &version) const {
+    string fileName = m_basePath + ".manifest";
+    string tmpName = fileName + ".tmp";
+
+    PgArr<byte> buf{};
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id = cts::pg_type_id::LSM_MANIFEST_PAGE;
+    u8 numLevels = version.levels.size();
+    db_serialize(page_type_id, buf, offset);
+    db_serialize(m_nextRunID, buf, offset);
+    db_serialize(numLevels, buf, offset);
+    for (const auto &level: version.levels) {
+        u16 numRuns = level.size();
+        db_serialize(numRuns, buf, offset);
+        for (const auto &run: level) {
+            u64 runID = run->getRunID();
+            db_serialize(runID, buf, offset);
+        }
+    }
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+
+    std::remove(tmpName.c_str());
+    {
+        IOHandler ioHandler(tmpName);
+        ioHandler.createNewBlock();
+        ioHandler.writeBlock(buf.data(), 0);
+    }
+
+    // rename is atomic, so readers see either the old or the new manifest
+    std::filesystem::rename(tmpName, fileName);
+}
+
+} // namespace backend
@@ -0,0 +1,199 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_LSMTREE_HPP
+#define KNDB_LSMTREE_HPP
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "SortedRun.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class LsmTree
+ * @brief Log-structured merge tree storing the tuples of a write-heavy table.
+ *
+ * Writes go to an in-memory sorted memtable. Once the memtable is full it becomes immutable and a
+ * background thread writes it out sequentially as a new SortedRun in level 0. The same thread
+ * performs leveled compaction:
+ * - once level 0 holds 'level0Runs' runs, they are merged together with level 1;
+ * - every deeper level holds a single run, which is merged into the next level once it grows
+ *   beyond 'levelRatio' times the size of the level above.
+ *
+ * Reads check the memtable, then the immutable memtable, then the runs from newest to oldest.
+ * Each run's bloom filter and fence pointers limit that to at most one block read per run that
+ * actually contains the key. Deletes write tombstones, which are dropped once they reach the
+ * deepest level.
+ *
+ * Runs live in their own files next to the database file, named after 'basePath'. The list of
+ * live runs is kept in a manifest file that is atomically replaced after every flush and
+ * compaction. The memtable itself is only persisted when it is flushed or the tree is destroyed.
+ *
+ * The interface mirrors Btree<Vec<Vari>>. Like Btree, all keys must be unique, and duplicate
+ * insertions or operations on missing keys result in operation failures rather than exceptions.
+ * Only one thread may use the public interface at a time.
+ */
+class LsmTree {
+public:
+    struct Options {
+        size_t memtableEntries = 8192; ///< Entries buffered in memory before a flush.
+        size_t level0Runs = 4;         ///< Level 0 runs that trigger a compaction into level 1.
+        size_t levelRatio = 10;        ///< Size ratio between consecutive levels.
+        double bloomBitsPerKey = 10;   ///< Bloom filter bits per entry of each run.
+    };
+
+    /**
+     * @brief Opens (or creates) an LSM tree.
+     * @param basePath Prefix of the names of the tree's files.
+     * @param types The types of the tuples stored; the first type is the key type.
+     * @param options Tuning parameters.
+     * @throws std::runtime_error if file operations fail.
+     */
+    LsmTree(string basePath, const Vec<Vari> &types, Options options);
+
+    /**
+     * @brief Opens (or creates) an LSM tree with default options.
+     */
+    LsmTree(string basePath, const Vec<Vari> &types);
+
+    /**
+     * @brief Flushes the memtable and stops the background thread, unless the tree was destroyed.
+     */
+    ~LsmTree();
+
+    /**
+     * @brief Stops the background thread without flushing and deletes the tree's manifest and
+     * every one of its run files, including runs a crash left behind. The tree must not be used
+     * after.
+     */
+    void destroy();
+
+    /**
+     * @brief Searches for a key.
+     * @param key The key to search for.
+     * @return Optional tuple associated with the key, or std::nullopt if not found.
+     */
+    std::optional<Vec<Vari>> search(const Vari &key);
+
+    /**
+     * @brief Inserts a key-tuple pair.
+     * @param values The tuple to associate with the key.
+     * @param key The key to insert.
+     * @return true if insertion was successful, false if key already exists.
+     */
+    bool insert(Vec<Vari> values, Vari key);
+
+    /**
+     * @brief Removes a key by writing a tombstone for it.
+     * @param key The key to remove.
+     * @return true if removal was successful, false if key doesn't exist.
+     */
+    bool remove(Vari key);
+
+    /**
+     * @brief Updates the tuple associated with an existing key.
+     * @param values The new tuple to assign.
+     * @param key The key to update.
+     * @return true if update was successful, false if key doesn't exist.
+     */
+    bool update(Vec<Vari> values, const Vari &key);
+
+    /**
+     * @brief LSM trees keep no data in the Pager's pages.
+     * @return PGID_INVALID.
+     */
+    pgid_t getRootPage() const { return cts::PGID_INVALID; }
+
+    /**
+     * @brief Visits every key-tuple pair in ascending key order.
+     * @param fn Callable invoked as fn(const Vari &key, const Vec<Vari> &value). It must not
+     * modify the tree.
+     */
+    template<typename Fn>
+    void forEach(Fn &&fn) {
+        auto [immutable, version] = snapshot();
+        MergeCursor cursor(sources(immutable, *version));
+        for (; cursor.valid(); cursor.next())
+            if (cursor.entry().value.has_value())
+                fn(cursor.entry().key, *cursor.entry().value);
+    }
+
+    /**
+     * @brief Writes the memtable out as a run and waits until all pending compactions are done.
+     */
+    void flush();
+
+    /**
+     * @return The number of runs in each level, starting with level 0.
+     */
+    Vec<size_t> getRunsPerLevel() const;
+
+    LsmTree &operator=(LsmTree &&other) = delete;
+    LsmTree &operator=(const LsmTree &other) = delete;
+    LsmTree(LsmTree &&other) = delete;
+    LsmTree(const LsmTree &other) = delete;
+
+private:
+    using Memtable = MemtableCursor::Memtable;
+    using RunPtr = std::shared_ptr<SortedRun>;
+
+    // immutable set of runs; replaced as a whole by the background thread
+    struct Version {
+        Vec<Vec<RunPtr>> levels; // level 0 is ordered newest first
+    };
+
+    std::pair<std::shared_ptr<const Memtable>, std::shared_ptr<const Version>> snapshot() const;
+
+    Vec<Ptr<LsmCursor>> sources(const std::shared_ptr<const Memtable> &immutable, const Version &version) const;
+
+    std::optional<LsmEntry> lookup(const Vari &key) const;
+
+    void put(Vari key, std::optional<Vec<Vari>> value);
+
+    // hands the memtable to the background thread. m_mutex must be held by lock.
+    void rotateMemtable(std::unique_lock<std::mutex> &lock);
+
+    // returns the level that should be compacted into the next one, or SIZE_T_INVALID
+    size_t pickCompaction(const Version &version) const;
+
+    void backgroundLoop();
+
+    void compact(size_t level);
+
+    RunPtr writeRun(LsmCursor &source, u64 expectedEntries, bool dropTombstones);
+
+    void installVersion(std::shared_ptr<const Version> version);
+
+    void loadManifest();
+
+    void writeManifest(const Version &version) const;
+
+    string runFileName(u64 runID) const;
+
+    string m_basePath;
+    Vec<Vari> m_types;
+    Options m_options;
+
+    Memtable m_memtable; // only touched by the caller's thread
+    std::shared_ptr<const Memtable> m_immutable;
+    std::shared_ptr<const Version> m_version;
+    u64 m_nextRunID;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCv;
+    std::condition_variable m_doneCv;
+    bool m_busy;
+    bool m_stop;
+    std::thread m_worker;
+};
+
+} // namespace backend
+
+#endif //KNDB_LSMTREE_HPP
@@ -0,0 +1,180 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include "Metrics.hpp"
+
+#include <bit>
+#include <cstdio>
+
+namespace backend {
+
+namespace {
+
+constexpr std::pair<const char *, double> PERCENTILES[] = {{"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99},
+                                                           {"p999", 0.999}};
+
+template<typename T>
+T &findOrCreate(std::map<string, Ptr<T>> &metrics, const string &name) {
+    auto &metric = metrics[name];
+    if (!metric)
+        metric = std::make_unique<T>();
+    return *metric;
+}
+
+void appendJsonString(string &out, const string &str) {
+    out += '"';
+    for (char c: str) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    out += '"';
+}
+
+string formatDouble(double value) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f", value);
+    return buf;
+}
+
+} // namespace
+
+size_t HistogramSnapshot::bucketOf(u64 value) {
+    if (value < (1u << SUB_BITS))
+        return value;
+    unsigned shift = std::bit_width(value) - SUB_BITS - 1;
+    return ((shift + 1) << SUB_BITS) + ((value >> shift) & ((1u << SUB_BITS) - 1));
+}
+
+u64 HistogramSnapshot::upperBound(size_t bucket) {
+    if (bucket < (1u << SUB_BITS))
+        return bucket;
+    unsigned shift = bucket / (1u << SUB_BITS) - 1;
+    u64 top = (1u << SUB_BITS) | (bucket % (1u << SUB_BITS));
+    return ((top + 1) << shift) - 1;
+}
+
+void HistogramSnapshot::merge(const HistogramSnapshot &other) {
+    for (size_t i = 0; i < NUM_BUCKETS; i++)
+        m_buckets[i] += other.m_buckets[i];
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_max = std::max(m_max, other.m_max);
+}
+
+u64 HistogramSnapshot::percentile(double quantile) const {
+    auto rank = static_cast<u64>(quantile * static_cast<double>(m_count));
+    u64 seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += m_buckets[i];
+        if (seen > rank || (seen == m_count && m_count > 0))
+            return std::min(upperBound(i), m_max);
+    }
+    return 0;
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    HistogramSnapshot snap;
+    for (size_t i = 0; i < HistogramSnapshot::NUM_BUCKETS; i++)
+        snap.m_buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    snap.m_count = m_count.load(std::memory_order_relaxed);
+    snap.m_sum = m_sum.load(std::memory_order_relaxed);
+    snap.m_max = m_max.load(std::memory_order_relaxed);
+    return snap;
+}
+
+void Histogram::reset() {
+    for (auto &bucket: m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+MetricsRegistry &MetricsRegistry::global() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+Counter &MetricsRegistry::counter(const string &name) {
+    std::lock_guard lock(m_mutex);
+    return findOrCreate(m_counters, name);
+}
+
+Gauge &MetricsRegistry::gauge(const string &name) {
+    std::lock_guard lock(m_mutex);
+    return findOrCreate(m_gauges, name);
+}
+
+Histogram &MetricsRegistry::histogram(const string &name) {
+    std::lock_guard lock(m_mutex);
+    return findOrCreate(m_histograms, name);
+}
+
+MetricsRegistry::Snapshot MetricsRegistry::snapshot() const {
+    std::lock_guard lock(m_mutex);
+    Snapshot snap;
+    for (const auto &[name, counter]: m_counters)
+        snap.counters.emplace_back(name, counter->value());
+    for (const auto &[name, gauge]: m_gauges)
+        snap.gauges.emplace_back(name, gauge->value());
+    for (const auto &[name, histogram]: m_histograms)
+        snap.histograms.emplace_back(name, histogram->snapshot());
+    return snap;
+}
+
+void MetricsRegistry::reset() {
+    std::lock_guard lock(m_mutex);
+    for (const auto &[name, counter]: m_counters)
+        counter->reset();
+    for (const auto &[name, histogram]: m_histograms)
+        histogram->reset();
+}
+
+string MetricsRegistry::Snapshot::toText() const {
+    string out;
+    for (const auto &[name, value]: counters)
+        out += name + " " + std::to_string(value) + "\n";
+    for (const auto &[name, value]: gauges)
+        out += name + " " + std::to_string(value) + "\n";
+    for (const auto &[name, histogram]: histograms) {
+        out += name + " count=" + std::to_string(histogram.count()) + " mean=" + formatDouble(histogram.mean());
+        for (const auto &[label, quantile]: PERCENTILES)
+            out += string(" ") + label + "=" + std::to_string(histogram.percentile(quantile));
+        out += " max=" + std::to_string(histogram.max()) + "\n";
+    }
+    return out;
+}
+
+string MetricsRegistry::Snapshot::toJson() const {
+    string out = "{\"counters\":{";
+    for (size_t i = 0; i < counters.size(); i++) {
+        if (i > 0) out += ',';
+        appendJsonString(out, counters[i].first);
+        out += ':' + std::to_string(counters[i].second);
+    }
+
+    out += "},\"gauges\":{";
+    for (size_t i = 0; i < gauges.size(); i++) {
+        if (i > 0) out += ',';
+        appendJsonString(out, gauges[i].first);
+        out += ':' + std::to_string(gauges[i].second);
+    }
+
+    out += "},\"histograms\":{";
+    for (size_t i = 0; i < histograms.size(); i++) {
+        const auto &[name, histogram] = histograms[i];
+        if (i > 0) out += ',';
+        appendJsonString(out, name);
+        out += ":{\"count\":" + std::to_string(histogram.count()) + ",\"sum\":" + std::to_string(histogram.sum()) +
+               ",\"mean\":" + formatDouble(histogram.mean()) + ",\"max\":" + std::to_string(histogram.max());
+        for (const auto &[label, quantile]: PERCENTILES)
+            out += string(",\"") + label + "\":" + std::to_string(histogram.percentile(quantile));
+        out += '}';
+    }
+    out += "}}";
+    return out;
+}
+
+} // namespace backend
@@ -0,0 +1,221 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_METRICS_HPP
+#define KNDB_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class Counter
+ * @brief A count that only goes up, e.g. the number of pages read. Lock-free.
+ */
+class Counter {
+public:
+    void add(u64 n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+
+    u64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+    void reset() { m_value.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<u64> m_value{0};
+};
+
+/**
+ * @class Gauge
+ * @brief A level that goes up and down, e.g. the number of cached pages. Lock-free.
+ */
+class Gauge {
+public:
+    void set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+
+    void add(int64_t delta) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+
+    int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> m_value{0};
+};
+
+/**
+ * @class HistogramSnapshot
+ * @brief The values recorded by a Histogram up to some moment, which can be queried and merged.
+ */
+class HistogramSnapshot {
+public:
+    /**
+     * Each power of two is split into 2^SUB_BITS equal buckets, so a value is reported with a
+     * relative error of at most 1/2^SUB_BITS (about 6%) whatever its magnitude.
+     */
+    static constexpr unsigned SUB_BITS = 4;
+    static constexpr size_t NUM_BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
+
+    /**
+     * @brief Adds every value recorded in another snapshot.
+     */
+    void merge(const HistogramSnapshot &other);
+
+    /**
+     * @param quantile The quantile, between 0 and 1.
+     * @return An upper bound of the value at the quantile, or 0 if nothing was recorded.
+     */
+    u64 percentile(double quantile) const;
+
+    u64 count() const { return m_count; }
+
+    u64 sum() const { return m_sum; }
+
+    u64 max() const { return m_max; }
+
+    double mean() const { return m_count == 0 ? 0 : static_cast<double>(m_sum) / static_cast<double>(m_count); }
+
+    // values below 2^SUB_BITS get a bucket each; larger ones share a bucket with values that agree
+    // in their top SUB_BITS + 1 bits
+    static size_t bucketOf(u64 value);
+
+    static u64 upperBound(size_t bucket);
+
+private:
+    friend class Histogram;
+
+    Arr<u64, NUM_BUCKETS> m_buckets{};
+    u64 m_count = 0;
+    u64 m_sum = 0;
+    u64 m_max = 0;
+};
+
+/**
+ * @class Histogram
+ * @brief Counts values, e.g. latencies in nanoseconds, in log-linear buckets like an HDR histogram.
+ *
+ * Recording is lock-free and takes a few relaxed atomic increments, so any number of threads can
+ * record into one histogram. Percentiles are read from a snapshot().
+ */
+class Histogram {
+public:
+    void record(u64 value) {
+        m_buckets[HistogramSnapshot::bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+        u64 max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+    }
+
+    /**
+     * @return The values recorded so far. Values recorded while the snapshot is taken may be
+     * partially included, e.g. in the count but not yet in a bucket.
+     */
+    HistogramSnapshot snapshot() const;
+
+    void reset();
+
+private:
+    Arr<std::atomic<u64>, HistogramSnapshot::NUM_BUCKETS> m_buckets{};
+    std::atomic<u64> m_count{0};
+    std::atomic<u64> m_sum{0};
+    std::atomic<u64> m_max{0};
+};
+
+/**
+ * @class ScopedTimer
+ * @brief Records the nanoseconds from its construction to its destruction into a Histogram.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram &histogram) : m_histogram(histogram), m_start(Clock::now()) {}
+
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start);
+        m_histogram.record(elapsed.count());
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Histogram &m_histogram;
+    Clock::time_point m_start;
+};
+
+/**
+ * @class MetricsRegistry
+ * @brief Owns named counters, gauges and histograms, and exports them as text or JSON.
+ *
+ * Looking a metric up by name takes a lock, so callers look it up once and keep the reference,
+ * which stays valid for the life of the registry. Updating a metric never takes a lock. Names are
+ * dotted paths starting with the layer that updates them, e.g. "pagecache.misses"; histograms of
+ * durations end in "_ns".
+ *
+ * The storage layers update the global() registry, which sums over every database in the process.
+ */
+class MetricsRegistry {
+public:
+    /**
+     * @class Snapshot
+     * @brief The value of every metric at some moment, ordered by name.
+     */
+    struct Snapshot {
+        Vec<std::pair<string, u64>> counters;
+        Vec<std::pair<string, int64_t>> gauges;
+        Vec<std::pair<string, HistogramSnapshot>> histograms;
+
+        /**
+         * @return One line per metric: "name value" for counters and gauges, and the count, mean,
+         * p50, p90, p99, p999 and max for histograms.
+         */
+        string toText() const;
+
+        /**
+         * @return A JSON object with "counters", "gauges" and "histograms" members, each mapping
+         * metric names to their values; histograms map to objects of count, sum, mean, max and
+         * percentiles.
+         */
+        string toJson() const;
+    };
+
+    static MetricsRegistry &global();
+
+    /**
+     * @return The counter with the given name, created at zero if it does not exist yet.
+     */
+    Counter &counter(const string &name);
+
+    /**
+     * @return The gauge with the given name, created at zero if it does not exist yet.
+     */
+    Gauge &gauge(const string &name);
+
+    /**
+     * @return The histogram with the given name, created empty if it does not exist yet.
+     */
+    Histogram &histogram(const string &name);
+
+    Snapshot snapshot() const;
+
+    /**
+     * @brief Sets every counter and histogram back to zero, e.g. between the phases of a
+     * benchmark. Gauges keep their level.
+     */
+    void reset();
+
+private:
+    mutable std::mutex m_mutex;
+    std::map<string, Ptr<Counter>> m_counters;
+    std::map<string, Ptr<Gauge>> m_gauges;
+    std::map<string, Ptr<Histogram>> m_histograms;
+};
+
+} // namespace backend
+
+#endif //KNDB_METRICS_HPP
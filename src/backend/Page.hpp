@@ -33,6 +33,18 @@ public:
      */
     pgid_t getPageID() const { return m_pageID; }
 
+    /**
+     * @brief Whether the page may differ from its copy on disk. New pages are dirty, and pages
+     * read from disk are clean until they are retrieved for writing.
+     */
+    bool isDirty() const { return m_dirty; }
+
+    /**
+     * @brief Sets whether the page may differ from its copy on disk.
+     * @param dirty The new state.
+     */
+    void setDirty(bool dirty) { m_dirty = dirty; }
+
     /**
      * @brief Serializes the page into a byte vector.
      * @param buffer The container that will be serialized to.
@@ -47,6 +59,7 @@ public:
 
 protected:
     pgid_t m_pageID;
+    bool m_dirty = true;
 
 };
 
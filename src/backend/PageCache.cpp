@@ -2,6 +2,8 @@
 // Created by kylan on 7/20/2025.
 //
 
+#include <algorithm>
+
 #include "PageCache.hpp"
 #include "assume.hpp"
 
@@ -10,52 +12,289 @@ namespace backend {
 PageCache::PageCache(IOHandler& ioHandler, size_t capacity): m_ioHandler(ioHandler), m_capacity(capacity) {
 }
 
-void PageCache::updateLRU(Ptr<Page> page) {
+PageCache::Metrics &PageCache::metrics() {
+    static Metrics m;
+    return m;
+}
+
+void PageCache::updateLRU(std::shared_ptr<Page> page) {
 
-    // 1. if key is in queue:
+    // 1. move the page's entry to the FRONT of the list, or add one
     pgid_t pageID = page->getPageID();
-    if (m_map.contains(pageID)) {
-        m_list.erase(m_map[pageID]);
+    if (auto it = m_map.find(pageID); it != m_map.end()) {
+        it->second->page = std::move(page);
+        it->second->referenced.store(false, std::memory_order_relaxed);
+        m_list.splice(m_list.begin(), m_list, it->second);
+    } else {
+        m_list.emplace_front(std::move(page));
+        m_map[pageID] = m_list.begin();
+        metrics().pages.add(1);
     }
 
-    // 2. add new node [key] to FRONT of list
-    m_list.push_front(std::move(page));
-
-    // 3. update map [key] -> new iterator
-    m_map[pageID] = m_list.begin();
+    // 2. if size > cap, remove the BACK-most page that is not pinned. A page referenced since it
+    // last moved gets a second chance at the front instead. The page just moved to the front is
+    // never evicted, so the cache briefly exceeds its capacity if all others are pinned.
+    if (m_list.size() <= m_capacity)
+        return;
 
-    // 4. if size > cap, remove BACK element
-    if (m_list.size() > m_capacity) {
-        pgid_t backPageID = m_list.back()->getPageID();
-        writePage(backPageID);
-        m_map.erase(backPageID);
-        m_list.pop_back();
+    // the walk wraps around to the back, so pages given a second chance are looked at again with
+    // their bit clear. Pages hit meanwhile may keep the walk from evicting any within its bound.
+    auto fresh = m_list.begin();
+    auto it = std::prev(m_list.end());
+    for (size_t steps = 2 * m_list.size(); steps > 0; steps--) {
+        auto next = it == m_list.begin() ? std::prev(m_list.end()) : std::prev(it);
+        pgid_t backPageID = it->page->getPageID();
+        if (it != fresh && !m_pins.contains(backPageID)) {
+            if (!it->referenced.exchange(false, std::memory_order_relaxed)) {
+                writePageLocked(backPageID);
+                m_map.erase(backPageID);
+                m_list.erase(it);
+                metrics().evictions.add();
+                metrics().pages.add(-1);
+                return;
+            }
+            m_list.splice(m_list.begin(), m_list, it);
+        }
+        it = next;
     }
 }
 
+std::shared_ptr<Page> PageCache::findCached(pgid_t pageID) {
+    std::shared_lock lock(m_mutex);
+    auto it = m_map.find(pageID);
+    if (it == m_map.end())
+        return nullptr;
+
+    metrics().hits.add();
+    Tracer::pageAccess(pageID, PageAccess::HIT);
+    it->second->referenced.store(true, std::memory_order_relaxed);
+    return it->second->page;
+}
+
+PageCache::Pin::Pin(PageCache &cache, pgid_t pageID) : m_cache(cache), m_pageID(pageID) {
+    std::lock_guard lock(m_cache.m_mutex);
+    m_cache.m_pins[pageID]++;
+}
+
+PageCache::Pin::~Pin() {
+    std::lock_guard lock(m_cache.m_mutex);
+    if (--m_cache.m_pins[m_pageID] == 0)
+        m_cache.m_pins.erase(m_pageID);
+}
+
 void PageCache::insertPage(Ptr<Page> page) {
+    Tracer::LayerTimer trace(&Tracer::Record::cacheNs);
+    Tracer::pageAccess(page->getPageID(), PageAccess::INSERT);
+    std::lock_guard lock(m_mutex);
+    // a read of the page that began before this is of an older version
+    if (m_loading.contains(page->getPageID()))
+        m_loadStale.insert(page->getPageID());
     updateLRU(std::move(page));
 }
 
 void PageCache::writePage(pgid_t pageID) {
-    Page& page = *(*m_map[pageID]);
-    if (m_map[pageID] == list_it()) {
-        return;
-    }
+    Tracer::LayerTimer trace(&Tracer::Record::cacheNs);
+    std::lock_guard lock(m_mutex);
+    writePageLocked(pageID);
+}
 
-    PgArr<byte> buf;
+void PageCache::serialize(Page &page, std::span<byte> buf) {
+    Tracer::LayerTimer trace(&Tracer::Record::codecNs);
+    Tracer::addBytes(&Tracer::Record::bytesSerialized, cts::PG_SZ);
     page.toBytes(buf);
+}
+
+void PageCache::writePageLocked(pgid_t pageID) {
+    auto it = m_map.find(pageID);
+    if (it == m_map.end() || m_ioHandler.readOnly() || !it->second->page->isDirty())
+        return;
+    Page &page = *it->second->page;
+    discardPrefetched({&pageID, 1});
+
+    if (m_writeHook)
+        m_writeHook();
+
+    Tracer::pageAccess(pageID, PageAccess::WRITE);
+    alignas(cts::PG_SZ) PgArr<byte> buf;
+    serialize(page, buf);
     m_ioHandler.writeBlock(buf.data(), pageID);
+    page.setDirty(false);
+    metrics().writes.add();
 }
 
-PageCache::~PageCache() {
-    PgArr<byte> buf;
-    for (const auto& [pageID, page_it]: m_map) {
-        auto& page = *(*page_it);
-        page.toBytes(buf);
-        m_ioHandler.writeBlock(buf.data(), pageID);
+void PageCache::flush() {
+    Tracer::LayerTimer trace(&Tracer::Record::cacheNs);
+    std::lock_guard lock(m_mutex);
+    if (m_ioHandler.readOnly())
+        return;
+    if (m_writeHook)
+        m_writeHook();
+
+    writeAll();
+}
+
+void PageCache::writeAll() {
+    Vec<pgid_t> pageIDs;
+    for (const auto &[pageID, page_it]: m_map)
+        if (page_it->page->isDirty())
+            pageIDs.push_back(pageID);
+    std::sort(pageIDs.begin(), pageIDs.end());
+    metrics().writes.add(pageIDs.size());
+    discardPrefetched(pageIDs);
+
+    // serialize the pages in batches of up to maxBatch pages, each written with one write per run
+    // of consecutive pages, and flush once at the end
+    static constexpr size_t maxBatch = 1024;
+    AlignedBytes buf(std::min(pageIDs.size(), maxBatch) * cts::PG_SZ);
+    Vec<std::pair<blockid_t, const void *>> batch;
+    for (size_t i = 0; i < pageIDs.size(); i++) {
+        byte *slot = buf.data() + batch.size() * cts::PG_SZ;
+        Tracer::pageAccess(pageIDs[i], PageAccess::WRITE);
+        Page &page = *m_map[pageIDs[i]]->page;
+        serialize(page, std::span<byte>(slot, cts::PG_SZ));
+        page.setDirty(false);
+        batch.emplace_back(pageIDs[i], slot);
+        if (batch.size() == maxBatch || i + 1 == pageIDs.size()) {
+            m_ioHandler.writeBlocks(batch, false);
+            batch.clear();
+        }
+    }
+    if (!pageIDs.empty())
+        m_ioHandler.sync();
+}
+
+void PageCache::prefetch(std::span<const pgid_t> pageIDs) {
+    Vec<pgid_t> missing;
+    {
+        std::lock_guard lock(m_mutex);
+        for (pgid_t pageID: pageIDs)
+            if (!m_map.contains(pageID))
+                missing.push_back(pageID);
+    }
+    std::lock_guard lock(m_prefetchMutex);
+    prefetchLocked(std::move(missing));
+}
+
+void PageCache::setReadAhead(size_t maxPages) {
+    std::lock_guard lock(m_prefetchMutex);
+    m_maxReadAhead = maxPages;
+    m_window = 0;
+}
+
+std::shared_ptr<const AlignedBytes> PageCache::takePrefetched(pgid_t pageID, size_t &offset) {
+    std::unique_lock lock(m_prefetchMutex);
+
+    // a scan reads ahead once it missed enough consecutive pages, and again each time it reaches
+    // the middle of the last window, so the next window is read while it works through this one
+    m_sequential = pageID == m_lastMiss + 1 ? m_sequential + 1 : 0;
+    m_lastMiss = pageID;
+    if (m_sequential < SEQUENTIAL_TRIGGER || m_maxReadAhead == 0) {
+        m_window = 0;
+        m_readAheadEnd = 0;
+    } else if (m_window == 0 || pageID + m_window / 2 >= m_readAheadEnd) {
+        m_window = std::min(std::max(2 * m_window, MIN_READ_AHEAD), m_maxReadAhead);
+        pgid_t first = std::max(m_readAheadEnd, pageID + 1);
+        pgid_t end = std::min<u64>(static_cast<u64>(first) + m_window, m_ioHandler.getNumBlocks());
+        Vec<pgid_t> pageIDs;
+        for (pgid_t id = first; id < end; id++)
+            pageIDs.push_back(id);
+        prefetchLocked(std::move(pageIDs));
+        m_readAheadEnd = std::max(first, end);
+    }
+
+    m_prefetchDone.wait(lock, [&] { return !m_inFlight.contains(pageID); });
+    auto it = m_prefetched.find(pageID);
+    if (it == m_prefetched.end())
+        return nullptr;
+    metrics().prefetchHits.add();
+    auto run = std::move(it->second.run);
+    offset = it->second.offset;
+    m_prefetchAges.erase(it->second.age);
+    m_prefetched.erase(it);
+    return run;
+}
+
+void PageCache::prefetchLocked(Vec<pgid_t> pageIDs) {
+    if (m_ioHandler.mapped())
+        return;
+    std::sort(pageIDs.begin(), pageIDs.end());
+    pageIDs.erase(std::unique(pageIDs.begin(), pageIDs.end()), pageIDs.end());
+    std::erase_if(pageIDs, [this](pgid_t pageID) {
+        return pageID >= m_ioHandler.getNumBlocks() || m_prefetched.contains(pageID) || m_inFlight.contains(pageID);
+    });
+    if (pageIDs.empty())
+        return;
+    if (!m_prefetchPool)
+        m_prefetchPool = std::make_unique<ThreadPool>(1);
+
+    // read each run of consecutive pages (of up to maxRun pages) with one read
+    static constexpr size_t maxRun = 64;
+    size_t start = 0;
+    for (size_t i = 0; i < pageIDs.size(); i++) {
+        m_inFlight.insert(pageIDs[i]);
+        if (i + 1 == pageIDs.size() || pageIDs[i + 1] != pageIDs[i] + 1 || i + 1 - start == maxRun) {
+            pgid_t first = pageIDs[start];
+            auto numPages = static_cast<blockid_t>(i + 1 - start);
+            m_prefetchPool->submit([this, first, numPages] { readRun(first, numPages); });
+            start = i + 1;
+        }
     }
 }
 
+void PageCache::readRun(pgid_t first, blockid_t numPages) {
+    auto run = std::make_shared<AlignedBytes>(static_cast<size_t>(numPages) * cts::PG_SZ);
+    bool read = true;
+    try {
+        m_ioHandler.readBlocks(run->data(), first, numPages);
+    } catch (const std::exception &) {
+        // the pages are read again when retrieved, which reports the error
+        read = false;
+    }
+
+    std::lock_guard lock(m_prefetchMutex);
+    for (blockid_t i = 0; i < numPages; i++) {
+        pgid_t pageID = first + i;
+        m_inFlight.erase(pageID);
+        if (m_stale.erase(pageID) || !read)
+            continue;
+        if (m_prefetched.size() == MAX_PREFETCHED) {
+            m_prefetched.erase(m_prefetchAges.front());
+            m_prefetchAges.pop_front();
+        }
+        m_prefetchAges.push_back(pageID);
+        m_prefetched[pageID] = {run, static_cast<size_t>(i) * cts::PG_SZ, std::prev(m_prefetchAges.end())};
+    }
+    if (read)
+        metrics().prefetched.add(numPages);
+    m_prefetchDone.notify_all();
+}
+
+void PageCache::discardPrefetched(std::span<const pgid_t> pageIDs) {
+    std::lock_guard lock(m_prefetchMutex);
+    if (m_prefetched.empty() && m_inFlight.empty())
+        return;
+    for (pgid_t pageID: pageIDs) {
+        if (auto it = m_prefetched.find(pageID); it != m_prefetched.end()) {
+            m_prefetchAges.erase(it->second.age);
+            m_prefetched.erase(it);
+        }
+        if (m_inFlight.contains(pageID))
+            m_stale.insert(pageID);
+    }
+}
+
+void PageCache::setWriteHook(std::function<void()> hook) {
+    std::lock_guard lock(m_mutex);
+    m_writeHook = std::move(hook);
+}
+
+PageCache::~PageCache() {
+    // let the reads in flight finish before the pages are written
+    m_prefetchPool.reset();
+    if (!m_ioHandler.readOnly())
+        writeAll();
+    metrics().pages.add(-static_cast<int64_t>(m_map.size()));
+}
+
 
 }
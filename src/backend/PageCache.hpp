@@ -7,9 +7,20 @@
 
 #include "IOHandler.hpp"
 #include "kndb_types.hpp"
+#include "Metrics.hpp"
 #include "Page.hpp"
+#include "ThreadPool.hpp"
+#include "Tracer.hpp"
+#include "atomic"
+#include "condition_variable"
+#include "functional"
 #include "list"
+#include "memory"
+#include "mutex"
+#include "shared_mutex"
+#include "span"
 #include "unordered_map"
+#include "unordered_set"
 
 namespace backend {
 
@@ -18,10 +29,49 @@ namespace backend {
  *
  * PageCache handles retrieval, insertion, eviction, and writing of pages.
  * It interacts directly with the IOHandler to read/write pages to disk when
- * necessary.
+ * necessary. Pages of a read-only file are never written back. Only dirty pages are written, i.e.
+ * pages created or inserted, or retrieved with retrievePage() since they were last written.
+ *
+ * Pages can be read ahead of their retrieval, either explicitly with prefetch() or automatically
+ * when pages missing from the cache are retrieved in consecutive order, as a scan does. Read-ahead
+ * happens on a background thread, one read per run of consecutive pages, and the blocks read are
+ * kept aside (not cached) until retrieved. A retrieval that needs a block still being read waits
+ * for it rather than reading it again. A mapped file is never read ahead, as its pages are read
+ * from the mapping.
+ *
+ * Eviction follows the LRU list with a second chance. Pages retrieved for reading that are cached
+ * (the common case of viewPage() and retrieveSharedPage()) only take the cache's lock shared, so
+ * such hits never wait for each other: rather than moving the page to the front of the list, they
+ * set its reference bit, and a page found with the bit set at the back of the list is moved to
+ * the front instead of being evicted.
+ *
+ * All member functions may be called from several threads at once. References returned by
+ * retrievePage() are only valid until the page is evicted, so threads that read pages while
+ * others may be loading pages should use retrieveSharedPage() instead, which keeps the page alive
+ * even after it is evicted, or hold a Pin on the page.
  */
 class PageCache {
 public:
+    /**
+     * @class Pin
+     * @brief Keeps a page from being evicted from its construction to its destruction, so a
+     * reference to it from retrievePage() stays valid, and it is not written back half-changed,
+     * while other threads load pages. The page may be pinned before it is cached.
+     */
+    class Pin {
+    public:
+        Pin(PageCache &cache, pgid_t pageID);
+
+        ~Pin();
+
+        Pin(const Pin &) = delete;
+        Pin &operator=(const Pin &) = delete;
+
+    private:
+        PageCache &m_cache;
+        pgid_t m_pageID;
+    };
+
     /**
      * @brief Constructs a PageCache with a reference to the underlying IOHandler.
      *
@@ -32,6 +82,7 @@ public:
 
     /**
      * @brief Retrieves a typed reference to a cached page, or loads it from disk if not cached.
+     * The page is marked dirty, as the caller may change it.
      *
      * @tparam T Derived type of Page expected by the caller.
      * @param pageID ID of the page to retrieve.
@@ -40,6 +91,31 @@ public:
     template <typename T>
     T& retrievePage(pgid_t pageID);
 
+    /**
+     * @brief Retrieves a page like retrievePage(), but for reading only, so the page is not
+     * marked dirty.
+     *
+     * @tparam T Derived type of Page expected by the caller.
+     * @param pageID ID of the page to retrieve.
+     * @return Const reference to the loaded or cached page of type T.
+     */
+    template <typename T>
+    const T& viewPage(pgid_t pageID);
+
+    /**
+     * @brief Retrieves a shared pointer to a cached page, or loads it from disk if not cached.
+     *
+     * The page stays alive as long as the pointer does, even if it is evicted from the cache in
+     * the meantime. Pages are read from disk without holding the cache's lock, so several threads
+     * can load pages in parallel.
+     *
+     * @tparam T Derived type of Page expected by the caller.
+     * @param pageID ID of the page to retrieve.
+     * @return Shared pointer to the loaded or cached page of type T.
+     */
+    template <typename T>
+    std::shared_ptr<T> retrieveSharedPage(pgid_t pageID);
+
     /**
      * @brief Inserts a newly created page into the cache.
      *
@@ -57,20 +133,143 @@ public:
      */
     void writePage(pgid_t pageID);
 
+    /**
+     * @brief Writes every dirty page to disk, keeping them cached. Pages are written in order,
+     * with a single write per run of consecutive pages and a single flush at the end.
+     */
+    void flush();
+
+    /**
+     * @brief Starts reading pages from disk in the background, so that retrieving them later does
+     * not wait for a read. Consecutive pages are read together with a single read.
+     *
+     * Pages that are cached, already read ahead, or out of the file's bounds are skipped. At most
+     * MAX_PREFETCHED pages are kept aside; past that, the oldest are dropped.
+     *
+     * @param pageIDs IDs of the pages, in any order.
+     */
+    void prefetch(std::span<const pgid_t> pageIDs);
+
+    /**
+     * @brief Sets how far ahead of a sequential scan pages are read.
+     *
+     * Once SEQUENTIAL_TRIGGER consecutive pages missed the cache, the pages after them are read
+     * ahead in a window that starts at MIN_READ_AHEAD pages and doubles every time the scan
+     * catches up to its middle, up to maxPages.
+     *
+     * @param maxPages The largest window, or 0 to disable read-ahead. DEFAULT_READ_AHEAD by default.
+     */
+    void setReadAhead(size_t maxPages);
+
+    /**
+     * @brief Sets a function to call before any page is written to disk, e.g. to flush a log that
+     * must reach the disk before the pages it describes.
+     *
+     * @param hook The function, or an empty function to remove it.
+     */
+    void setWriteHook(std::function<void()> hook);
+
     /**
      * @brief Flushes all cached pages to disk.
      */
     ~PageCache();
 
+    static constexpr size_t DEFAULT_READ_AHEAD = 64;
+    static constexpr size_t MIN_READ_AHEAD = 4;
+    static constexpr u32 SEQUENTIAL_TRIGGER = 3;
+    static constexpr size_t MAX_PREFETCHED = 1024;
+
 private:
-    using list_it = std::list<Ptr<Page>>::iterator;
+    struct Entry {
+        explicit Entry(std::shared_ptr<Page> page) : page(std::move(page)) {}
+
+        std::shared_ptr<Page> page;
+        std::atomic<bool> referenced{false}; // hit under the shared lock since it last moved
+    };
+
+    using list_it = std::list<Entry>::iterator;
+
+    struct Metrics {
+        Counter &hits = MetricsRegistry::global().counter("pagecache.hits");
+        Counter &misses = MetricsRegistry::global().counter("pagecache.misses");
+        Counter &evictions = MetricsRegistry::global().counter("pagecache.evictions");
+        Counter &writes = MetricsRegistry::global().counter("pagecache.page_writes");
+        Gauge &pages = MetricsRegistry::global().gauge("pagecache.pages");
+        Counter &prefetched = MetricsRegistry::global().counter("pagecache.prefetched");
+        Counter &prefetchHits = MetricsRegistry::global().counter("pagecache.prefetch_hits");
+    };
+
+    // a block read ahead: a page-sized slice of the buffer of the run it was read with
+    struct Prefetched {
+        std::shared_ptr<const AlignedBytes> run;
+        size_t offset;
+        std::list<pgid_t>::iterator age;
+    };
+
+    static Metrics &metrics();
 
     IOHandler& m_ioHandler;
     size_t m_capacity;
-    std::list<Ptr<Page>> m_list;
+    std::list<Entry> m_list;
     std::unordered_map<pgid_t, list_it> m_map;
+    std::shared_mutex m_mutex; // taken shared only to look up cached pages for reading
+    std::function<void()> m_writeHook;
+    std::unordered_map<pgid_t, u32> m_pins;    // pinned pages and how many pins each has
+    std::unordered_map<pgid_t, u32> m_loading; // pages being read by retrieveSharedPage(), and by how many threads
+    std::unordered_set<pgid_t> m_loadStale;    // pages being read that were inserted since their reads began
+
+    // guards the read-ahead state below. Taken after m_mutex when both are held.
+    std::mutex m_prefetchMutex;
+    std::condition_variable m_prefetchDone;
+    std::unordered_map<pgid_t, Prefetched> m_prefetched; // blocks read ahead, waiting to be retrieved
+    std::list<pgid_t> m_prefetchAges;       // pages in m_prefetched, oldest first
+    std::unordered_set<pgid_t> m_inFlight;  // pages being read ahead
+    std::unordered_set<pgid_t> m_stale;     // pages in flight that were written since their read began
+    size_t m_maxReadAhead = DEFAULT_READ_AHEAD;
+    pgid_t m_lastMiss = 0;     // the last page that missed the cache
+    u32 m_sequential = 0;      // consecutive pages that missed the cache before it
+    size_t m_window = 0;       // the current read-ahead window, 0 if not reading ahead
+    pgid_t m_readAheadEnd = 0; // the page after the last one read ahead
+    Ptr<ThreadPool> m_prefetchPool; // runs the reads, created on first use
+
+    // moves a page to the front of the LRU list, evicting the least recently used page that is not
+    // pinned if the cache is over capacity. m_mutex must be held exclusively.
+    void updateLRU(std::shared_ptr<Page> page);
+
+    // returns a cached page and sets its reference bit, or nullptr if it is not cached. Takes
+    // m_mutex shared.
+    std::shared_ptr<Page> findCached(pgid_t pageID);
+
+    // retrieves a page, marking it dirty if it is retrieved for writing
+    template <typename T>
+    T& retrievePage(pgid_t pageID, bool write);
+
+    // writes a page if it is dirty. m_mutex must be held.
+    void writePageLocked(pgid_t pageID);
+
+    // writes every dirty page, in batches. m_mutex must be held.
+    void writeAll();
+
+    // reads a page that is not cached from disk, without caching it
+    template <typename T>
+    std::shared_ptr<Page> readPage(pgid_t pageID);
+
+    // serializes a page into a buffer of cts::PG_SZ bytes
+    static void serialize(Page &page, std::span<byte> buf);
+
+    // notes a miss for read-ahead, then takes the page's block if it was read ahead, waiting for
+    // it if it is being read. Returns nullptr if it was not read ahead, or the block's run and
+    // sets offset to where the block starts in it.
+    std::shared_ptr<const AlignedBytes> takePrefetched(pgid_t pageID, size_t &offset);
+
+    // queues background reads of the pages that are not read ahead yet. m_prefetchMutex must be held.
+    void prefetchLocked(Vec<pgid_t> pageIDs);
+
+    // reads a run of consecutive pages and keeps them aside; runs on m_prefetchPool
+    void readRun(pgid_t first, blockid_t numPages);
 
-    void updateLRU(Ptr<Page> page);
+    // drops the blocks read ahead for pages about to be written, which they would be stale copies of
+    void discardPrefetched(std::span<const pgid_t> pageIDs);
 };
 
 }
@@ -7,18 +7,110 @@
 
 namespace backend {
 
+template <typename T>
+std::shared_ptr<Page> PageCache::readPage(pgid_t pageID) {
+    metrics().misses.add();
+    Tracer::pageAccess(pageID, PageAccess::MISS);
+
+    // a block read ahead or in a mapped file is deserialized in place, without copying it first
+    size_t offset;
+    std::shared_ptr<const AlignedBytes> run = takePrefetched(pageID, offset);
+    std::span<const byte> view;
+    alignas(cts::PG_SZ) PgArr<byte> buf;
+    if (run) {
+        view = std::span(*run).subspan(offset, cts::PG_SZ);
+    } else if (view = m_ioHandler.viewBlock(pageID); view.empty()) {
+        m_ioHandler.readBlock(buf.data(), pageID);
+        view = buf;
+    }
+
+    Tracer::LayerTimer trace(&Tracer::Record::codecNs);
+    Tracer::addBytes(&Tracer::Record::bytesSerialized, cts::PG_SZ);
+    auto page = std::make_shared<T>(view, pageID);
+    page->setDirty(false);
+    return page;
+}
+
 template <typename T>
 T& PageCache::retrievePage(pgid_t pageID) {
-    if (m_map.contains(pageID)) {
-        updateLRU(std::move(*m_map[pageID]));
+    return retrievePage<T>(pageID, true);
+}
+
+template <typename T>
+const T& PageCache::viewPage(pgid_t pageID) {
+    {
+        Tracer::LayerTimer trace(&Tracer::Record::cacheNs);
+        if (auto page = findCached(pageID))
+            return dynamic_cast<const T &>(*page);
+    }
+    return retrievePage<T>(pageID, false);
+}
+
+template <typename T>
+T& PageCache::retrievePage(pgid_t pageID, bool write) {
+    Tracer::LayerTimer trace(&Tracer::Record::cacheNs);
+    std::lock_guard lock(m_mutex);
+    if (auto it = m_map.find(pageID); it != m_map.end()) {
+        metrics().hits.add();
+        Tracer::pageAccess(pageID, PageAccess::HIT);
+        updateLRU(it->second->page);
     } else {
-        PgArr<byte> buf;
-        m_ioHandler.readBlock(buf.data(), pageID);
-        Ptr<Page> page = std::make_unique<T>(buf, pageID);
-        updateLRU(std::move(page));
+        updateLRU(readPage<T>(pageID));
     }
 
-    return dynamic_cast<T &>(**m_map[pageID]);
+    auto &page = dynamic_cast<T &>(*m_map[pageID]->page);
+    if (write)
+        page.setDirty(true);
+    return page;
+}
+
+template <typename T>
+std::shared_ptr<T> PageCache::retrieveSharedPage(pgid_t pageID) {
+    Tracer::LayerTimer trace(&Tracer::Record::cacheNs);
+    if (auto page = findCached(pageID))
+        return std::dynamic_pointer_cast<T>(page);
+
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        if (auto it = m_map.find(pageID); it != m_map.end()) {
+            metrics().hits.add();
+            Tracer::pageAccess(pageID, PageAccess::HIT);
+            std::shared_ptr<Page> page = it->second->page;
+            updateLRU(page);
+            return std::dynamic_pointer_cast<T>(page);
+        }
+
+        m_loading[pageID]++;
+        lock.unlock();
+        std::shared_ptr<Page> page;
+        try {
+            page = readPage<T>(pageID);
+        } catch (...) {
+            lock.lock();
+            if (--m_loading[pageID] == 0) {
+                m_loading.erase(pageID);
+                m_loadStale.erase(pageID);
+            }
+            throw;
+        }
+        lock.lock();
+
+        // a newer version inserted during the read may have been evicted already, in which case
+        // the read is retried, as it may have returned the block from before that version was written
+        bool stale = m_loadStale.contains(pageID);
+        if (--m_loading[pageID] == 0) {
+            m_loading.erase(pageID);
+            m_loadStale.erase(pageID);
+        }
+        if (stale)
+            continue;
+
+        // another thread may have loaded the page in the meantime; keep its copy
+        if (auto it = m_map.find(pageID); it != m_map.end())
+            page = it->second->page;
+        updateLRU(page);
+        return std::dynamic_pointer_cast<T>(page);
+    }
 }
 
 }
@@ -0,0 +1,150 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include "PageCodec.hpp"
+
+#include <array>
+#include <cstring>
+
+#include "assume.hpp"
+
+namespace backend {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+constexpr unsigned HASH_BITS = 12;
+constexpr u8 MAX_NIBBLE = 15;
+
+u32 load32(const byte *p) {
+    u32 val;
+    std::memcpy(&val, p, sizeof(val));
+    return val;
+}
+
+u32 hash(u32 seq) { return (seq * 2654435761u) >> (32 - HASH_BITS); }
+
+// writes to a bounded output, remembering whether anything did not fit
+struct Writer {
+    std::span<byte> out;
+    size_t pos = 0;
+    bool overflow = false;
+
+    void put(u8 b) {
+        if (pos < out.size())
+            out[pos++] = static_cast<byte>(b);
+        else
+            overflow = true;
+    }
+
+    void put(const byte *src, size_t len) {
+        if (len > out.size() - pos) {
+            overflow = true;
+            return;
+        }
+        std::memcpy(out.data() + pos, src, len);
+        pos += len;
+    }
+
+    // the part of a length that did not fit in its token nibble
+    void putLength(size_t len) {
+        for (; len >= 255; len -= 255)
+            put(255);
+        put(static_cast<u8>(len));
+    }
+};
+
+// reads the continuation of a length whose nibble was 15; returns false if it runs past the input
+bool getLength(std::span<const byte> in, size_t &pos, size_t &len) {
+    u8 b;
+    do {
+        if (pos >= in.size())
+            return false;
+        b = std::to_integer<u8>(in[pos++]);
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+void putSequence(Writer &w, const byte *literals, size_t numLiterals, size_t offset, size_t matchLen) {
+    size_t extra = matchLen == 0 ? 0 : matchLen - MIN_MATCH;
+    w.put(static_cast<u8>(std::min<size_t>(numLiterals, MAX_NIBBLE) << 4 | std::min<size_t>(extra, MAX_NIBBLE)));
+    if (numLiterals >= MAX_NIBBLE)
+        w.putLength(numLiterals - MAX_NIBBLE);
+    w.put(literals, numLiterals);
+    if (matchLen == 0)
+        return;
+    w.put(static_cast<u8>(offset));
+    w.put(static_cast<u8>(offset >> 8));
+    if (extra >= MAX_NIBBLE)
+        w.putLength(extra - MAX_NIBBLE);
+}
+
+} // namespace
+
+size_t PageCodec::compress(std::span<const byte> in, std::span<byte> out) {
+    ASSUME_S(in.size() < MAX_INPUT_SIZE, "Input is too large to compress");
+    // positions of the last 4-byte prefix with each hash; MAX_INPUT_SIZE - 1 is past any input
+    std::array<u16, 1 << HASH_BITS> table;
+    table.fill(static_cast<u16>(MAX_INPUT_SIZE - 1));
+
+    Writer w{out};
+    const byte *src = in.data();
+    size_t n = in.size(), pos = 0, anchor = 0;
+    while (pos + MIN_MATCH <= n && !w.overflow) {
+        u32 seq = load32(src + pos);
+        u32 h = hash(seq);
+        size_t candidate = table[h];
+        table[h] = static_cast<u16>(pos);
+        if (candidate >= pos || load32(src + candidate) != seq) {
+            pos++;
+            continue;
+        }
+
+        size_t len = MIN_MATCH;
+        while (pos + len < n && src[candidate + len] == src[pos + len])
+            len++;
+        putSequence(w, src + anchor, pos - anchor, pos - candidate, len);
+        pos += len;
+        anchor = pos;
+    }
+    putSequence(w, src + anchor, n - anchor, 0, 0);
+    return w.overflow ? 0 : w.pos;
+}
+
+bool PageCodec::decompress(std::span<const byte> in, std::span<byte> out) {
+    size_t ip = 0, op = 0;
+    while (ip < in.size()) {
+        auto token = std::to_integer<u8>(in[ip++]);
+        size_t numLiterals = token >> 4;
+        if (numLiterals == MAX_NIBBLE && !getLength(in, ip, numLiterals))
+            return false;
+        if (numLiterals > in.size() - ip || numLiterals > out.size() - op)
+            return false;
+        std::memcpy(out.data() + op, in.data() + ip, numLiterals);
+        ip += numLiterals;
+        op += numLiterals;
+
+        // the last sequence ends with its literals
+        if (ip == in.size())
+            break;
+
+        if (in.size() - ip < 2)
+            return false;
+        size_t offset = std::to_integer<size_t>(in[ip]) | std::to_integer<size_t>(in[ip + 1]) << 8;
+        ip += 2;
+        size_t matchLen = token & MAX_NIBBLE;
+        if (matchLen == MAX_NIBBLE && !getLength(in, ip, matchLen))
+            return false;
+        matchLen += MIN_MATCH;
+        if (offset == 0 || offset > op || matchLen > out.size() - op)
+            return false;
+        // a copy may overlap its own output, which repeats the bytes before it, so copy bytewise
+        for (size_t i = 0; i < matchLen; i++, op++)
+            out[op] = out[op - offset];
+    }
+    return op == out.size();
+}
+
+} // namespace backend
@@ -0,0 +1,48 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_PAGECODEC_HPP
+#define KNDB_PAGECODEC_HPP
+
+#include <span>
+
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class PageCodec
+ * @brief A fast LZ77 codec for serialized pages, in the style of LZ4.
+ *
+ * The input is encoded as sequences, each a run of literal bytes followed by a copy of earlier
+ * output, found with a single-entry hash table of 4-byte prefixes. A sequence starts with a token
+ * byte holding both lengths in 4 bits each, with 255-byte continuation bytes for longer ones; a
+ * copy is given by a 2-byte offset. The last sequence has no copy. Pages are mostly zeros, fixed
+ * padded strings and repeated headers, which this shrinks severalfold at little CPU cost.
+ */
+class PageCodec {
+public:
+    /// Inputs must be shorter than this, as copy offsets are 16 bits.
+    static constexpr size_t MAX_INPUT_SIZE = 1 << 16;
+
+    /**
+     * @brief Compresses a block of bytes.
+     * @param in The bytes to compress, fewer than MAX_INPUT_SIZE.
+     * @param out Where to write the compressed bytes.
+     * @return The number of bytes written to out, or 0 if they did not fit.
+     */
+    static size_t compress(std::span<const byte> in, std::span<byte> out);
+
+    /**
+     * @brief Decompresses bytes written by compress().
+     * @param in The compressed bytes.
+     * @param out Where to write the original bytes. Must be exactly their size.
+     * @return false if the input is malformed or does not decompress to exactly out's size.
+     */
+    static bool decompress(std::span<const byte> in, std::span<byte> out);
+};
+
+} // namespace backend
+
+#endif //KNDB_PAGECODEC_HPP
@@ -18,8 +18,30 @@ bool Pager::isFree(pgid_t pageID) const {
     return m_freeSpaceMap.isFree(pageID);
 }
 
+std::string_view Pager::getFileName() const {
+    return m_ioHandler.getFileName();
+}
+
+bool Pager::readOnly() const {
+    return m_ioHandler.readOnly();
+}
+
+void Pager::replacePage(Ptr<Page> page) {
+    ASSUME_S(page->getPageID() < m_ioHandler.getNumBlocks(), "PageID is out of bounds");
+    m_pageCache.insertPage(std::move(page));
+}
+
+void Pager::flush() {
+    m_pageCache.flush();
+}
+
+void Pager::setWriteHook(std::function<void()> hook) {
+    m_pageCache.setWriteHook(std::move(hook));
+}
+
 void Pager::freePage(pgid_t pageID) const {
     ASSUME_S(pageID < m_ioHandler.getNumBlocks(), "PageID is out of bounds");
+    std::lock_guard lock(m_allocMutex);
     ASSUME_S(!m_freeSpaceMap.isFree(pageID), "That page is freed already");
 
     m_freeSpaceMap.freeBit(pageID);
@@ -5,6 +5,7 @@
 #ifndef KNDB_PAGER_HPP
 #define KNDB_PAGER_HPP
 
+#include <mutex>
 #include <unordered_map>
 
 #include "kndb_types.hpp"
@@ -55,6 +56,38 @@ public:
     template<typename T>
     T &getPage(pgid_t pageID);
 
+    /**
+     * @brief Retrieves a page for reading.
+     *
+     * @tparam T type of page that is expected to be returned.
+     *
+     * @param pageID the requested page's id.
+     *
+     * @return a const reference to the requested page.
+     *
+     * Note: The same lifetime rules as getPage() apply. Unlike getPage(), the
+     * page is not marked dirty, so a page that is only viewed is never written
+     * back to disk.
+     */
+    template<typename T>
+    const T &viewPage(pgid_t pageID);
+
+    /**
+     * @brief Retrieves a page that stays alive for as long as the returned pointer.
+     *
+     * @tparam T type of page that is expected to be returned.
+     *
+     * @param pageID the requested page's id.
+     *
+     * @return a shared pointer to the requested page.
+     *
+     * Note: Unlike getPage(), this function may be called from several threads at once, as long
+     * as no thread creates, frees or modifies pages at the same time. Changes made through the
+     * pointer after the page was evicted are lost, so it is meant for reading.
+     */
+    template<typename T>
+    std::shared_ptr<T> getSharedPage(pgid_t pageID);
+
     /**
      * @brief Creates a new page
      *
@@ -73,6 +106,42 @@ public:
     template<typename T, typename ...Args>
     T &createNewPage(Args &&... args);
 
+    /**
+     * @brief Creates a new page like createNewPage(), but returns its ID.
+     *
+     * @return the new page's id.
+     *
+     * Note: Unlike createNewPage(), this function may be called from several
+     * threads at once, and while others call getSharedPage() and replacePage().
+     * Pages are allocated one at a time, with the free space map's pages pinned
+     * in the cache while they change.
+     */
+    template<typename T, typename ...Args>
+    pgid_t createNewPageID(Args &&... args);
+
+    /**
+     * @brief Replaces the cached copy of a page with a new version of it.
+     *
+     * @param page the new version of the page, with the same page ID.
+     *
+     * Note: Threads holding the previous version through getSharedPage()
+     * keep seeing it unchanged, so a page can be rewritten while others read
+     * it by replacing it with a changed copy.
+     */
+    void replacePage(Ptr<Page> page);
+
+    /**
+     * @brief Writes every cached page to disk, so that the file holds every change made so far.
+     */
+    void flush();
+
+    /**
+     * @brief Sets a function to call before any page is written to disk.
+     *
+     * @param hook The function, or an empty function to remove it.
+     */
+    void setWriteHook(std::function<void()> hook);
+
     /**
      * @brief Frees a page
      * @param pageID the page id to be freed.
@@ -90,6 +159,19 @@ public:
      */
     bool isFree(pgid_t pageID) const;
 
+    /**
+     * Gets the name of the database file. Structures that keep their data in separate files
+     * (such as LSM tables) derive their file names from it.
+     *
+     * @return The database file name.
+     */
+    std::string_view getFileName() const;
+
+    /**
+     * @return true if the database file was opened read-only, so no page can be created or written.
+     */
+    bool readOnly() const;
+
     /**
      * All pages are guaranteed to be written
      */
@@ -104,6 +186,7 @@ private:
     PageCache& m_pageCache;
     FreeSpaceMap& m_freeSpaceMap;
     IOHandler& m_ioHandler;
+    mutable std::mutex m_allocMutex; // serializes changes to the free space map
 };
 
 } // namespace backend
@@ -21,9 +21,32 @@ T &Pager::getPage(pgid_t pageID) {
     return m_pageCache.retrievePage<T>(pageID);
 }
 
+template <typename T>
+const T &Pager::viewPage(pgid_t pageID) {
+    static_assert(std::is_base_of<Page, T>::value, "T must be a derived class of Page");
+    ASSUME_S(pageID < m_ioHandler.getNumBlocks(), "PageID is out of bounds");
+    ASSUME_S(!m_freeSpaceMap.isFree(pageID), "That page is freed");
+
+    return m_pageCache.viewPage<T>(pageID);
+}
+
+template <typename T>
+std::shared_ptr<T> Pager::getSharedPage(pgid_t pageID) {
+    static_assert(std::is_base_of<Page, T>::value, "T must be a derived class of Page");
+    ASSUME_S(pageID < m_ioHandler.getNumBlocks(), "PageID is out of bounds");
+
+    return m_pageCache.retrieveSharedPage<T>(pageID);
+}
+
 template<typename T, typename ...Args>
 T &Pager::createNewPage(Args&&... args) {
+    return getPage<T>(createNewPageID<T>(std::forward<Args>(args)...));
+}
+
+template<typename T, typename ...Args>
+pgid_t Pager::createNewPageID(Args&&... args) {
     static_assert(std::is_base_of<Page, T>::value, "T must be a derived class of Page");
+    std::lock_guard lock(m_allocMutex);
 
     // new FSMPage needed
     if (m_ioHandler.getNumBlocks() == 0 || m_freeSpaceMap.isFull()) {
@@ -42,7 +65,7 @@ T &Pager::createNewPage(Args&&... args) {
     auto newPage = std::make_unique<T>(std::forward<Args>(args)..., newPageNo);
     m_pageCache.insertPage(std::move(newPage));
 
-    return getPage<T>(newPageNo);
+    return newPageNo;
 }
 
 } // namespace backend
@@ -0,0 +1,31 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include "Predicate.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+bool Predicate::matches(const Vec<Vari> &tuple) const {
+    const Vari &lhs = tuple[column];
+    switch (op) {
+        case CompareOp::EQ:
+            return lhs == value;
+        case CompareOp::NE:
+            return lhs != value;
+        case CompareOp::LT:
+            return lhs < value;
+        case CompareOp::LE:
+            return lhs <= value;
+        case CompareOp::GT:
+            return lhs > value;
+        case CompareOp::GE:
+            return lhs >= value;
+    }
+
+    ASSUME_S(false, "Unknown comparison operator");
+    return false;
+}
+
+} // namespace backend
@@ -0,0 +1,40 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_PREDICATE_HPP
+#define KNDB_PREDICATE_HPP
+
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * Comparison applied by a Predicate.
+ */
+enum class CompareOp : u8 {
+    EQ, NE, LT, LE, GT, GE
+};
+
+/**
+ * @struct Predicate
+ * @brief A comparison between one column of a tuple and a constant, e.g. "column 2 >= 10".
+ *
+ * Used by table scans to filter tuples before they are copied out of their pages.
+ */
+struct Predicate {
+    u16 column;
+    CompareOp op;
+    Vari value;
+
+    /**
+     * @brief Evaluates the predicate on a tuple.
+     * @param tuple The tuple to check. Its value in the column must have the same type as value.
+     * @return true if the tuple satisfies the predicate.
+     */
+    bool matches(const Vec<Vari> &tuple) const;
+};
+
+} // namespace backend
+
+#endif //KNDB_PREDICATE_HPP
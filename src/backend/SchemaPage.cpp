@@ -57,7 +57,7 @@ u8 SchemaPage::getNumTables() const {
     return m_tables.size();
 }
 
-const std::unordered_map<string, pgid_t>& SchemaPage::getTables() {
+const std::unordered_map<string, pgid_t>& SchemaPage::getTables() const {
     return m_tables;
 }
 
@@ -44,7 +44,7 @@ public:
      * @brief Gets list of all tables in schema.
      * @return Map of table names to pageID of table metadata page.
      */
-    const std::unordered_map<string, pgid_t>& getTables();
+    const std::unordered_map<string, pgid_t>& getTables() const;
 
     /**
      * @brief Creates a new table in the schema.
@@ -0,0 +1,167 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include "SlotMap.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include "assume.hpp"
+
+namespace backend {
+
+namespace {
+
+constexpr char MAGIC[8] = {'K', 'N', 'D', 'B', 'S', 'L', 'T', '1'};
+
+// the name of a map file, after checking that it exists if it must
+const string &checked(const string &fileName, bool mustExist) {
+    if (mustExist && !std::filesystem::exists(fileName))
+        throw std::runtime_error("Missing slot map " + fileName + " of a compressed file");
+    return fileName;
+}
+
+} // namespace
+
+SlotMap::SlotMap(const string &fileName, bool mustExist) : m_file(checked(fileName, mustExist)) {
+    if (m_file.getNumBlocks() == 0) {
+        if (mustExist)
+            throw std::runtime_error(fileName + " is not a slot map");
+        // the header is written at once, so a map file always has one
+        m_file.createNewBlock();
+        m_dirty.insert(0);
+        sync();
+        return;
+    }
+
+    PgArr<byte> header;
+    m_file.readBlock(header.data(), 0);
+    u32 numBlocks;
+    std::memcpy(&numBlocks, header.data() + sizeof(MAGIC), sizeof(numBlocks));
+    blockid_t mapBlocks = (numBlocks + ENTRIES_PER_BLOCK - 1) / ENTRIES_PER_BLOCK;
+    if (std::memcmp(header.data(), MAGIC, sizeof(MAGIC)) != 0 || 1 + mapBlocks > m_file.getNumBlocks())
+        throw std::runtime_error(fileName + " is not a slot map");
+
+    Vec<byte> entries(static_cast<size_t>(mapBlocks) * cts::PG_SZ);
+    if (mapBlocks > 0)
+        m_file.readBlocks(entries.data(), 1, mapBlocks);
+    m_slots.resize(numBlocks);
+    for (blockid_t i = 0; i < numBlocks; i++) {
+        u64 entry;
+        std::memcpy(&entry, entries.data() + i * sizeof(u64), sizeof(u64));
+        m_slots[i] = {entry >> 4, static_cast<u32>(entry & 0xf)};
+        if (m_slots[i].units > UNITS_PER_BLOCK)
+            throw std::runtime_error(fileName + " is corrupt");
+    }
+
+    // everything between the slots is free
+    Vec<Slot> used;
+    std::copy_if(m_slots.begin(), m_slots.end(), std::back_inserter(used), [](auto &s) { return s.units > 0; });
+    std::sort(used.begin(), used.end(), [](auto &a, auto &b) { return a.unit < b.unit; });
+    for (const auto &slot: used) {
+        if (slot.unit < m_numUnits)
+            throw std::runtime_error(fileName + " is corrupt");
+        for (u64 unit = m_numUnits; unit < slot.unit;) {
+            auto units = static_cast<u32>(std::min<u64>(slot.unit - unit, UNITS_PER_BLOCK));
+            m_free[units].push_back(unit);
+            unit += units;
+        }
+        m_numUnits = slot.unit + slot.units;
+    }
+}
+
+blockid_t SlotMap::getNumBlocks() const {
+    std::lock_guard lock(m_mutex);
+    return static_cast<blockid_t>(m_slots.size());
+}
+
+void SlotMap::addBlocks(blockid_t numBlocks) {
+    std::lock_guard lock(m_mutex);
+    // the new entries are zero, which the map file's new blocks already are
+    m_slots.resize(m_slots.size() + numBlocks);
+    m_dirty.insert(0);
+}
+
+SlotMap::Slot SlotMap::get(blockid_t blockNo) const {
+    std::lock_guard lock(m_mutex);
+    ASSUME_S(blockNo < m_slots.size(), "Block has no entry in the slot map");
+    return m_slots[blockNo];
+}
+
+SlotMap::Slot SlotMap::place(blockid_t blockNo, u32 units) {
+    ASSUME_S(units > 0 && units <= UNITS_PER_BLOCK, "Slot size out of range");
+    std::lock_guard lock(m_mutex);
+    ASSUME_S(blockNo < m_slots.size(), "Block has no entry in the slot map");
+    Slot &slot = m_slots[blockNo];
+    if (slot.units >= units && (slot.units == UNITS_PER_BLOCK) == (units == UNITS_PER_BLOCK))
+        return slot;
+
+    if (slot.units > 0)
+        m_released.push_back(slot);
+    slot = {allocate(units), units};
+    touch(blockNo);
+    return slot;
+}
+
+u64 SlotMap::getNumUnits() const {
+    std::lock_guard lock(m_mutex);
+    return m_numUnits;
+}
+
+u64 SlotMap::allocate(u32 units) {
+    for (u32 size = units; size <= UNITS_PER_BLOCK; size++) {
+        if (m_free[size].empty())
+            continue;
+        u64 unit = m_free[size].back();
+        m_free[size].pop_back();
+        if (size > units)
+            m_free[size - units].push_back(unit + units);
+        return unit;
+    }
+    m_numUnits += units;
+    return m_numUnits - units;
+}
+
+void SlotMap::touch(blockid_t blockNo) {
+    m_dirty.insert(1 + blockNo / ENTRIES_PER_BLOCK);
+}
+
+void SlotMap::sync() {
+    std::lock_guard lock(m_mutex);
+    if (m_dirty.empty())
+        return;
+
+    auto numBlocks = static_cast<blockid_t>(m_slots.size());
+    blockid_t needed = 1 + (numBlocks + ENTRIES_PER_BLOCK - 1) / ENTRIES_PER_BLOCK;
+    if (needed > m_file.getNumBlocks())
+        m_file.createMultipleBlocks(static_cast<int>(needed - m_file.getNumBlocks()));
+
+    Vec<PgArr<byte>> buffers(m_dirty.size());
+    Vec<std::pair<blockid_t, const void *>> batch;
+    for (auto it = m_dirty.begin(); it != m_dirty.end(); ++it) {
+        auto &buf = buffers[batch.size()];
+        buf.fill(byte{0});
+        if (*it == 0) {
+            std::memcpy(buf.data(), MAGIC, sizeof(MAGIC));
+            std::memcpy(buf.data() + sizeof(MAGIC), &numBlocks, sizeof(numBlocks));
+        } else {
+            size_t first = (*it - 1) * ENTRIES_PER_BLOCK;
+            for (size_t i = first; i < std::min<size_t>(first + ENTRIES_PER_BLOCK, numBlocks); i++) {
+                u64 entry = m_slots[i].unit << 4 | m_slots[i].units;
+                std::memcpy(buf.data() + (i - first) * sizeof(u64), &entry, sizeof(u64));
+            }
+        }
+        batch.emplace_back(*it, buf.data());
+    }
+    m_file.writeBlocks(batch, true);
+    m_dirty.clear();
+
+    // the map on disk no longer points at the released slots
+    for (const auto &slot: m_released)
+        m_free[slot.units].push_back(slot.unit);
+    m_released.clear();
+}
+
+} // namespace backend
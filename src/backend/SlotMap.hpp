@@ -0,0 +1,105 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_SLOTMAP_HPP
+#define KNDB_SLOTMAP_HPP
+
+#include <mutex>
+#include <set>
+
+#include "IOHandler.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class SlotMap
+ * @brief The indirection map of a compressed file: where each block's slot is, and which space is
+ * free.
+ *
+ * A slot is a run of 1 to UNITS_PER_BLOCK units of SLOT_UNIT bytes in the data file. The map is
+ * kept in memory and persisted to its own file by sync(), as:
+ * - block 0: magic, u32 number of blocks
+ * - blocks 1..: a u64 per block, its slot's first unit shifted left by 4 and or'ed with its units
+ *
+ * Free space is tracked per slot size and rebuilt from the gaps between slots when the map is
+ * opened. A slot freed by moving its block is only reused after the next sync(), so the map on
+ * disk never points at reused space: after a crash, each block reads as of the last sync, or as
+ * since rewritten in place, like an uncompressed file.
+ *
+ * All member functions may be called from several threads at once.
+ */
+class SlotMap {
+public:
+    static constexpr size_t SLOT_UNIT = cts::PG_SZ / 8;
+    static constexpr u32 UNITS_PER_BLOCK = cts::PG_SZ / SLOT_UNIT;
+
+    /**
+     * @brief Where a block is stored. A block that was never written has no units.
+     */
+    struct Slot {
+        u64 unit = 0;
+        u32 units = 0;
+    };
+
+    /**
+     * @brief Opens or creates a map.
+     * @param fileName The name of the map file.
+     * @param mustExist Whether the map file must already exist, as its data file is not empty.
+     * @throws std::runtime_error if file operations fail, or the file is missing or not a map.
+     */
+    SlotMap(const string &fileName, bool mustExist);
+
+    blockid_t getNumBlocks() const;
+
+    /**
+     * @brief Adds blocks without slots to the end of the map.
+     */
+    void addBlocks(blockid_t numBlocks);
+
+    Slot get(blockid_t blockNo) const;
+
+    /**
+     * @brief Gives a block a slot of at least 'units' units.
+     *
+     * The block keeps its slot if large enough, unless the slot is a whole block while 'units' is
+     * not, or the other way around, as whole-block slots are stored uncompressed. Otherwise it is
+     * given a new slot, reusing free space before growing the data file.
+     * @return The block's slot.
+     */
+    Slot place(blockid_t blockNo, u32 units);
+
+    /**
+     * @return The size of the data file, in units.
+     */
+    u64 getNumUnits() const;
+
+    /**
+     * @brief Writes the map's changes to its file and flushes it, then frees the slots given up
+     * since the last sync. The data file must be flushed first.
+     * @throws std::runtime_error if file operations fail.
+     */
+    void sync();
+
+private:
+    static constexpr size_t ENTRIES_PER_BLOCK = cts::PG_SZ / sizeof(u64);
+
+    // gives out a free run of 'units' units, splitting a larger one or growing the data file
+    u64 allocate(u32 units);
+
+    // marks the map block holding a block's entry as changed
+    void touch(blockid_t blockNo);
+
+    mutable std::mutex m_mutex;
+    IOHandler m_file;
+    Vec<Slot> m_slots;
+    u64 m_numUnits = 0;
+    Arr<Vec<u64>, UNITS_PER_BLOCK + 1> m_free; ///< Free runs by size, as their first units.
+    Vec<Slot> m_released;                      ///< Slots given up since the last sync.
+    std::set<blockid_t> m_dirty;               ///< Map blocks changed since the last sync.
+};
+
+} // namespace backend
+
+#endif //KNDB_SLOTMAP_HPP
@@ -0,0 +1,86 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_SNAPSHOTMANAGER_HPP
+#define KNDB_SNAPSHOTMANAGER_HPP
+
+#include <mutex>
+#include <optional>
+#include <set>
+
+#include "assume.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class SnapshotManager
+ * @brief Hands out commit timestamps to changes and tracks the snapshots that are still open.
+ *
+ * Every change made outside of a transaction gets the next commit timestamp, and every change of
+ * a transaction the one the transaction gets when it commits. A snapshot taken at timestamp S sees
+ * exactly the changes with timestamps up to S, so the version of a tuple that a later change
+ * replaced has to be kept for as long as a snapshot older than the change is open.
+ *
+ * All member functions may be called from several threads at once.
+ */
+class SnapshotManager {
+public:
+    /**
+     * @return The commit timestamp of a new change.
+     */
+    u64 commit() {
+        std::lock_guard lock(m_mutex);
+        return ++m_lastCommit;
+    }
+
+    /**
+     * @return true if any snapshot is open, in which case changes must keep the versions they replace.
+     */
+    bool active() const {
+        std::lock_guard lock(m_mutex);
+        return !m_open.empty();
+    }
+
+    /**
+     * @return The timestamp of the oldest open snapshot, or std::nullopt if none is open. Versions
+     * replaced by changes up to it are seen by no open snapshot.
+     */
+    std::optional<u64> oldest() const {
+        std::lock_guard lock(m_mutex);
+        if (m_open.empty())
+            return std::nullopt;
+        return *m_open.begin();
+    }
+
+    /**
+     * @brief Opens a snapshot of every change committed so far.
+     * @return The snapshot's timestamp.
+     */
+    u64 open() {
+        std::lock_guard lock(m_mutex);
+        m_open.insert(m_lastCommit);
+        return m_lastCommit;
+    }
+
+    /**
+     * @brief Closes a snapshot opened by open().
+     * @param timestamp The snapshot's timestamp.
+     */
+    void close(u64 timestamp) {
+        std::lock_guard lock(m_mutex);
+        auto it = m_open.find(timestamp);
+        ASSUME_S(it != m_open.end(), "Snapshot is not open");
+        m_open.erase(it);
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    u64 m_lastCommit = 0;
+    std::multiset<u64> m_open;
+};
+
+} // namespace backend
+
+#endif //KNDB_SNAPSHOTMANAGER_HPP
@@ -0,0 +1,383 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <algorithm>
+#include <cstdio>
+
+#include "SortedRun.hpp"
+#include "utility.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+//    header block:
+//    u8 pagetypeid
+//    u64 numEntries
+//    u32 numDataBlocks
+//    u32 numFenceBlocks
+//    u32 numBloomWords
+//    u8 numHashes
+//    u16 numTypes
+//    typeid_t types[numTypes]
+//
+//    data block:
+//    u8 pagetypeid
+//    u16 numCells
+//    cell { key, bool tombstone, values[numTypes] }[numCells]
+//
+//    fence block:
+//    u8 pagetypeid
+//    u16 numKeys
+//    key[numKeys]
+//
+//    bloom block:
+//    u64 words[PG_SZ / 8]
+
+namespace {
+
+constexpr u32 WORDS_PER_BLOCK = cts::PG_SZ / sizeof(u64);
+
+u16 keysPerFenceBlock(const Vari &keyType) {
+    return (cts::PG_SZ - db_sizeof<pgtypeid_t>() - db_sizeof<u16>()) / db_sizeof(keyType);
+}
+
+}
+
+/**
+ * Iterates a run one data block at a time.
+ */
+class RunCursor : public LsmCursor {
+public:
+    explicit RunCursor(const SortedRun &run) : m_run(run), m_block(0), m_pos(0) {
+        if (m_run.m_numDataBlocks > 0)
+            m_run.readDataBlock(0, m_cells);
+    }
+
+    bool valid() const override {
+        return m_pos < m_cells.size();
+    }
+
+    const LsmEntry &entry() const override {
+        return m_cells[m_pos];
+    }
+
+    void next() override {
+        if (++m_pos < m_cells.size())
+            return;
+
+        m_pos = 0;
+        m_cells.clear();
+        if (++m_block < m_run.m_numDataBlocks)
+            m_run.readDataBlock(m_block, m_cells);
+    }
+
+private:
+    const SortedRun &m_run;
+    u32 m_block;
+    size_t m_pos;
+    Vec<LsmEntry> m_cells;
+};
+
+u16 SortedRun::entriesPerBlock(const Vec<Vari> &types) {
+    size_t cell_size = db_sizeof(types[0]) + db_sizeof<bool>();
+    for (const auto &type: types)
+        cell_size += db_sizeof(type);
+
+    return (cts::PG_SZ - db_sizeof<pgtypeid_t>() - db_sizeof<u16>()) / cell_size;
+}
+
+SortedRun::SortedRun(u64 runID, string fileName) : m_runID(runID), m_fileName(std::move(fileName)),
+                                                   m_obsolete(false) {
+    m_ioHandler = std::make_unique<IOHandler>(m_fileName);
+    if (m_ioHandler->getNumBlocks() == 0)
+        throw std::runtime_error("Run file is empty");
+
+    // header
+    PgArr<byte> buf;
+    m_ioHandler->readBlock(buf.data(), 0);
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id;
+    u32 numFenceBlocks, numBloomWords;
+    u8 numHashes;
+    u16 numTypes;
+    db_deserialize(page_type_id, buf, offset);
+    ASSUME_S(page_type_id == cts::pg_type_id::LSM_RUN_PAGE, "Page_type_id is incorrect type");
+
+    db_deserialize(m_numEntries, buf, offset);
+    db_deserialize(m_numDataBlocks, buf, offset);
+    db_deserialize(numFenceBlocks, buf, offset);
+    db_deserialize(numBloomWords, buf, offset);
+    db_deserialize(numHashes, buf, offset);
+    db_deserialize(numTypes, buf, offset);
+    for (int i = 0; i < numTypes; i++) {
+        typeid_t type_id;
+        db_deserialize(type_id, buf, offset);
+        m_types.push_back(type_id_to_variant(type_id));
+    }
+
+    // fence pointers
+    blockid_t block = 1 + m_numDataBlocks;
+    for (u32 i = 0; i < numFenceBlocks; i++, block++) {
+        m_ioHandler->readBlock(buf.data(), block);
+        offset = 0;
+
+        u16 numKeys;
+        db_deserialize(page_type_id, buf, offset);
+        ASSUME_S(page_type_id == cts::pg_type_id::LSM_RUN_PAGE, "Page_type_id is incorrect type");
+        db_deserialize(numKeys, buf, offset);
+        for (int j = 0; j < numKeys; j++) {
+            Vari key;
+            db_deserialize(key, buf, offset, m_types[0]);
+            m_fences.push_back(std::move(key));
+        }
+    }
+    ASSUME_S(m_fences.size() == m_numDataBlocks, "Run has a different number of fences than data blocks");
+
+    // bloom filter
+    u32 numBloomBlocks = (numBloomWords + WORDS_PER_BLOCK - 1) / WORDS_PER_BLOCK;
+    Vec<u64> words(numBloomBlocks * WORDS_PER_BLOCK);
+    m_ioHandler->readBlocks(words.data(), block, numBloomBlocks);
+    words.resize(numBloomWords);
+    m_bloom = std::make_unique<BloomFilter>(std::move(words), numHashes);
+}
+
+SortedRun::~SortedRun() {
+    m_ioHandler.reset();
+    if (m_obsolete)
+        std::remove(m_fileName.c_str());
+}
+
+void SortedRun::readDataBlock(u32 blockIdx, Vec<LsmEntry> &out) const {
+    ASSUME_S(blockIdx < m_numDataBlocks, "Data block is out of range");
+
+    PgArr<byte> buf;
+    m_ioHandler->readBlock(buf.data(), 1 + blockIdx);
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id;
+    u16 numCells;
+    db_deserialize(page_type_id, buf, offset);
+    ASSUME_S(page_type_id == cts::pg_type_id::LSM_RUN_PAGE, "Page_type_id is incorrect type");
+    db_deserialize(numCells, buf, offset);
+
+    out.resize(numCells);
+    for (auto &cell: out) {
+        bool tombstone;
+        db_deserialize(cell.key, buf, offset, m_types[0]);
+        db_deserialize(tombstone, buf, offset);
+
+        Vec<Vari> values(m_types.size());
+        for (size_t j = 0; j < m_types.size(); j++)
+            db_deserialize(values[j], buf, offset, m_types[j]);
+
+        if (tombstone)
+            cell.value = std::nullopt;
+        else
+            cell.value = std::move(values);
+    }
+
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+}
+
+std::optional<LsmEntry> SortedRun::get(const Vari &key, u64 hash) const {
+    if (!m_bloom->mayContain(hash))
+        return std::nullopt;
+
+    // the only block that may hold the key is the last one whose first key is <= key
+    auto fence = std::upper_bound(m_fences.begin(), m_fences.end(), key);
+    if (fence == m_fences.begin())
+        return std::nullopt;
+
+    Vec<LsmEntry> cells;
+    readDataBlock(fence - m_fences.begin() - 1, cells);
+
+    auto it = std::lower_bound(cells.begin(), cells.end(), key, [](const LsmEntry &cell, const Vari &k) {
+        return cell.key < k;
+    });
+    if (it == cells.end() || it->key != key)
+        return std::nullopt;
+    return std::move(*it);
+}
+
+Ptr<LsmCursor> SortedRun::cursor() const {
+    return std::make_unique<RunCursor>(*this);
+}
+
+SortedRunWriter::SortedRunWriter(string fileName, const Vec<Vari> &types, u64 expectedEntries,
+                                 double bloomBitsPerKey)
+        : m_fileName(std::move(fileName)), m_types(types), m_entriesPerBlock(SortedRun::entriesPerBlock(types)),
+          m_bloom(std::max<u64>(expectedEntries, 1), bloomBitsPerKey), m_numEntries(0), m_numDataBlocks(0) {
+    ASSUME_S(!types.empty(), "There cannot be 0 types in a run");
+    ASSUME_S(m_entriesPerBlock > 0, "Tuples are too large to be stored in a run");
+
+    std::remove(m_fileName.c_str());
+    m_ioHandler = std::make_unique<IOHandler>(m_fileName);
+    m_ioHandler->createNewBlock(); // header, written last
+}
+
+void SortedRunWriter::add(const LsmEntry &entry) {
+    ASSUME_S(m_block.empty() || m_block.back().key < entry.key, "Entries must be added in ascending key order");
+
+    if (m_block.size() == m_entriesPerBlock)
+        sealBlock();
+    if (m_block.empty())
+        m_fences.push_back(entry.key);
+
+    m_block.push_back(entry);
+    m_bloom.add(db_hash(entry.key));
+    m_numEntries++;
+}
+
+void SortedRunWriter::sealBlock() {
+    if (m_block.empty())
+        return;
+
+    size_t start = m_buffer.size();
+    m_buffer.resize(start + cts::PG_SZ);
+    std::span<byte> buf(m_buffer.data() + start, cts::PG_SZ);
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id = cts::pg_type_id::LSM_RUN_PAGE;
+    u16 numCells = m_block.size();
+    db_serialize(page_type_id, buf, offset);
+    db_serialize(numCells, buf, offset);
+
+    for (const auto &cell: m_block) {
+        bool tombstone = !cell.value.has_value();
+        db_serialize(cell.key, buf, offset);
+        db_serialize(tombstone, buf, offset);
+
+        // tombstones still take a full cell, filled with the types' default values
+        const auto &values = tombstone ? m_types : *cell.value;
+        for (const auto &value: values)
+            db_serialize(value, buf, offset);
+    }
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+
+    m_block.clear();
+    m_numDataBlocks++;
+    if (m_buffer.size() >= BATCH_BLOCKS * cts::PG_SZ)
+        flushBuffer();
+}
+
+void SortedRunWriter::flushBuffer() {
+    if (m_buffer.empty())
+        return;
+
+    blockid_t numBlocks = m_buffer.size() / cts::PG_SZ;
+    blockid_t first = m_ioHandler->createMultipleBlocks(numBlocks);
+    m_ioHandler->writeBlocks(m_buffer.data(), first, numBlocks);
+    m_buffer.clear();
+}
+
+u64 SortedRunWriter::finish() {
+    sealBlock();
+    flushBuffer();
+
+    // fence pointers
+    u16 perBlock = keysPerFenceBlock(m_types[0]);
+    u32 numFenceBlocks = 0;
+    for (size_t i = 0; i < m_fences.size(); i += perBlock, numFenceBlocks++) {
+        size_t start = m_buffer.size();
+        m_buffer.resize(start + cts::PG_SZ);
+        std::span<byte> buf(m_buffer.data() + start, cts::PG_SZ);
+        offset_t offset = 0;
+
+        pgtypeid_t page_type_id = cts::pg_type_id::LSM_RUN_PAGE;
+        u16 numKeys = std::min<size_t>(perBlock, m_fences.size() - i);
+        db_serialize(page_type_id, buf, offset);
+        db_serialize(numKeys, buf, offset);
+        for (size_t j = i; j < i + numKeys; j++)
+            db_serialize(m_fences[j], buf, offset);
+    }
+
+    // bloom filter
+    const auto &words = m_bloom.getWords();
+    u32 numBloomBlocks = (words.size() + WORDS_PER_BLOCK - 1) / WORDS_PER_BLOCK;
+    size_t start = m_buffer.size();
+    m_buffer.resize(start + numBloomBlocks * cts::PG_SZ);
+    memcpy(m_buffer.data() + start, words.data(), words.size() * sizeof(u64));
+    flushBuffer();
+
+    // header
+    PgArr<byte> buf{};
+    offset_t offset = 0;
+    pgtypeid_t page_type_id = cts::pg_type_id::LSM_RUN_PAGE;
+    u32 numBloomWords = words.size();
+    u8 numHashes = m_bloom.getNumHashes();
+    u16 numTypes = m_types.size();
+    db_serialize(page_type_id, buf, offset);
+    db_serialize(m_numEntries, buf, offset);
+    db_serialize(m_numDataBlocks, buf, offset);
+    db_serialize(numFenceBlocks, buf, offset);
+    db_serialize(numBloomWords, buf, offset);
+    db_serialize(numHashes, buf, offset);
+    db_serialize(numTypes, buf, offset);
+    for (const auto &type: m_types) {
+        typeid_t type_id = variant_to_type_id(type);
+        db_serialize(type_id, buf, offset);
+    }
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+    m_ioHandler->writeBlock(buf.data(), 0);
+
+    m_ioHandler.reset();
+    return m_numEntries;
+}
+
+MemtableCursor::MemtableCursor(const Memtable &memtable) : m_it(memtable.begin()), m_end(memtable.end()) {
+    load();
+}
+
+bool MemtableCursor::valid() const {
+    return m_it != m_end;
+}
+
+const LsmEntry &MemtableCursor::entry() const {
+    return m_entry;
+}
+
+void MemtableCursor::next() {
+    ++m_it;
+    load();
+}
+
+void MemtableCursor::load() {
+    if (m_it != m_end)
+        m_entry = {m_it->first, m_it->second};
+}
+
+MergeCursor::MergeCursor(Vec<Ptr<LsmCursor>> sources) : m_sources(std::move(sources)) {
+    select();
+}
+
+bool MergeCursor::valid() const {
+    return m_current != cts::SIZE_T_INVALID;
+}
+
+const LsmEntry &MergeCursor::entry() const {
+    return m_sources[m_current]->entry();
+}
+
+void MergeCursor::next() {
+    // skip the current key in every source, so older versions of it are never returned
+    Vari key = entry().key;
+    for (auto &source: m_sources)
+        if (source->valid() && source->entry().key == key)
+            source->next();
+    select();
+}
+
+void MergeCursor::select() {
+    m_current = cts::SIZE_T_INVALID;
+    for (size_t i = 0; i < m_sources.size(); i++) {
+        if (!m_sources[i]->valid())
+            continue;
+        // strict comparison keeps the newest source on equal keys
+        if (m_current == cts::SIZE_T_INVALID || m_sources[i]->entry().key < m_sources[m_current]->entry().key)
+            m_current = i;
+    }
+}
+
+} // namespace backend
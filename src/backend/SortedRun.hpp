@@ -0,0 +1,239 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_SORTEDRUN_HPP
+#define KNDB_SORTEDRUN_HPP
+
+#include <atomic>
+#include <map>
+#include <optional>
+
+#include "BloomFilter.hpp"
+#include "IOHandler.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @brief An entry of an LSM tree: a key and either its tuple or, for a deleted key, a tombstone
+ * (std::nullopt).
+ */
+struct LsmEntry {
+    Vari key;
+    std::optional<Vec<Vari>> value;
+};
+
+/**
+ * @class LsmCursor
+ * @brief Iterates the entries of a sorted source in ascending key order.
+ */
+class LsmCursor {
+public:
+    /**
+     * @return true if the cursor points at an entry, false once it is exhausted.
+     */
+    virtual bool valid() const = 0;
+
+    /**
+     * @return The current entry. Only valid while valid() is true.
+     */
+    virtual const LsmEntry &entry() const = 0;
+
+    /**
+     * @brief Advances to the next entry.
+     */
+    virtual void next() = 0;
+
+    virtual ~LsmCursor() = default;
+};
+
+/**
+ * @class SortedRun
+ * @brief An immutable, sorted file of LSM entries.
+ *
+ * A run is written once by a SortedRunWriter and never modified. Its file consists of:
+ * - block 0: header (entry count, block counts, bloom filter parameters and tuple types)
+ * - data blocks: fixed-size cells in ascending key order
+ * - fence blocks: the first key of every data block
+ * - bloom blocks: the bloom filter of every key in the run
+ *
+ * Fence pointers and the bloom filter are kept in memory, so a point lookup of a missing key
+ * usually costs no I/O, and a lookup of a present key costs exactly one block read.
+ *
+ * Runs are shared between readers and the compaction thread. Once compacted away, a run is
+ * marked obsolete and its file is removed when the last reference to it is released.
+ */
+class SortedRun {
+public:
+    /**
+     * @brief Opens an existing run file.
+     * @param runID The ID of the run.
+     * @param fileName The name of the run's file.
+     * @throws std::runtime_error if file operations fail.
+     */
+    SortedRun(u64 runID, string fileName);
+
+    /**
+     * @brief Looks up a key in the run.
+     * @param key The key to look up.
+     * @param hash The db_hash() of the key.
+     * @return The key's entry (which may be a tombstone), or std::nullopt if the run does not
+     * contain the key.
+     */
+    std::optional<LsmEntry> get(const Vari &key, u64 hash) const;
+
+    /**
+     * @return A cursor over every entry of the run.
+     */
+    Ptr<LsmCursor> cursor() const;
+
+    /**
+     * @return The number of entries (including tombstones) in the run.
+     */
+    u64 getNumEntries() const { return m_numEntries; }
+
+    /**
+     * @return The ID of the run.
+     */
+    u64 getRunID() const { return m_runID; }
+
+    /**
+     * @brief Marks the run as no longer needed. Its file is deleted once the run is destroyed.
+     */
+    void markObsolete() { m_obsolete = true; }
+
+    /**
+     * @brief Calculates how many entries fit into one data block.
+     * @param types The tuple types stored in the run; the first type is the key type.
+     * @return The number of entries per block.
+     */
+    static u16 entriesPerBlock(const Vec<Vari> &types);
+
+    ~SortedRun();
+
+    SortedRun &operator=(SortedRun &&other) = delete;
+    SortedRun &operator=(const SortedRun &other) = delete;
+    SortedRun(SortedRun &&other) = delete;
+    SortedRun(const SortedRun &other) = delete;
+
+private:
+    friend class RunCursor;
+
+    // reads every entry of a data block (0-indexed, excluding the header block)
+    void readDataBlock(u32 blockIdx, Vec<LsmEntry> &out) const;
+
+    u64 m_runID;
+    string m_fileName;
+    Ptr<IOHandler> m_ioHandler;
+    Vec<Vari> m_types;
+    u64 m_numEntries;
+    u32 m_numDataBlocks;
+    Vec<Vari> m_fences;
+    Ptr<BloomFilter> m_bloom;
+    std::atomic<bool> m_obsolete;
+};
+
+/**
+ * @class SortedRunWriter
+ * @brief Writes a SortedRun file sequentially.
+ *
+ * Entries are packed into data blocks, which are buffered and written in large batches so a run
+ * costs a handful of sequential writes.
+ */
+class SortedRunWriter {
+public:
+    /**
+     * @brief Creates (or truncates) a run file for writing.
+     * @param fileName The name of the run's file.
+     * @param types The tuple types stored in the run; the first type is the key type.
+     * @param expectedEntries Number of entries the bloom filter is sized for.
+     * @param bloomBitsPerKey Number of bloom filter bits per entry.
+     */
+    SortedRunWriter(string fileName, const Vec<Vari> &types, u64 expectedEntries, double bloomBitsPerKey);
+
+    /**
+     * @brief Appends an entry. Entries must be added in strictly ascending key order.
+     * @param entry The entry to append.
+     */
+    void add(const LsmEntry &entry);
+
+    /**
+     * @brief Writes the remaining data blocks, the fence pointers, the bloom filter and the
+     * header, then closes the file.
+     * @return The number of entries written.
+     */
+    u64 finish();
+
+private:
+    void sealBlock();
+    void flushBuffer();
+
+    static constexpr u32 BATCH_BLOCKS = 64;
+
+    string m_fileName;
+    Ptr<IOHandler> m_ioHandler;
+    Vec<Vari> m_types;
+    u16 m_entriesPerBlock;
+    BloomFilter m_bloom;
+    Vec<Vari> m_fences;
+    Vec<LsmEntry> m_block;
+    Vec<byte> m_buffer;
+    u64 m_numEntries;
+    u32 m_numDataBlocks;
+};
+
+/**
+ * @class MemtableCursor
+ * @brief Iterates the entries of an in-memory table of LSM entries.
+ */
+class MemtableCursor : public LsmCursor {
+public:
+    using Memtable = std::map<Vari, std::optional<Vec<Vari>>>;
+
+    explicit MemtableCursor(const Memtable &memtable);
+
+    bool valid() const override;
+
+    const LsmEntry &entry() const override;
+
+    void next() override;
+
+private:
+    void load();
+
+    Memtable::const_iterator m_it;
+    Memtable::const_iterator m_end;
+    LsmEntry m_entry;
+};
+
+/**
+ * @class MergeCursor
+ * @brief Merges several sorted sources into one, resolving duplicate keys by recency.
+ *
+ * When several sources contain the same key, only the entry of the source that comes first in
+ * the list (the newest) is returned.
+ */
+class MergeCursor : public LsmCursor {
+public:
+    /**
+     * @param sources Sources ordered from newest to oldest.
+     */
+    explicit MergeCursor(Vec<Ptr<LsmCursor>> sources);
+
+    bool valid() const override;
+
+    const LsmEntry &entry() const override;
+
+    void next() override;
+
+private:
+    void select();
+
+    Vec<Ptr<LsmCursor>> m_sources;
+    size_t m_current;
+};
+
+} // namespace backend
+
+#endif //KNDB_SORTEDRUN_HPP
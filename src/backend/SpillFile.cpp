@@ -0,0 +1,33 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <cstdio>
+
+#include "SpillFile.hpp"
+
+namespace backend {
+
+SpillFile::SpillFile(string fileName) : m_fileName(std::move(fileName)) {
+    std::remove(m_fileName.c_str());
+}
+
+SpillFile::~SpillFile() {
+    m_pager.reset();
+    m_freeSpaceMap.reset();
+    m_pageCache.reset();
+    m_ioHandler.reset();
+    std::remove(m_fileName.c_str());
+}
+
+Pager &SpillFile::getPager() {
+    std::call_once(m_open, [this] {
+        m_ioHandler = std::make_unique<IOHandler>(m_fileName);
+        m_pageCache = std::make_unique<PageCache>(*m_ioHandler, CACHE_PAGES);
+        m_freeSpaceMap = std::make_unique<FreeSpaceMap>(*m_pageCache);
+        m_pager = std::make_unique<Pager>(*m_freeSpaceMap, *m_ioHandler, *m_pageCache);
+    });
+    return *m_pager;
+}
+
+} // namespace backend
@@ -0,0 +1,68 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_SPILLFILE_HPP
+#define KNDB_SPILLFILE_HPP
+
+#include <mutex>
+
+#include "FreeSpaceMap.hpp"
+#include "IOHandler.hpp"
+#include "PageCache.hpp"
+#include "Pager.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class SpillFile
+ * @brief A temporary file that query operators spill their SpillRuns to, apart from the database.
+ *
+ * Spilled pages only live as long as the query that made them, so keeping them out of the
+ * database file means a crash mid-query cannot leave them allocated there. The file is only
+ * created by the first spill, and deleted when the SpillFile is destroyed. A file that a crash
+ * left behind is deleted when the next SpillFile of the same name is constructed.
+ */
+class SpillFile {
+public:
+    /**
+     * Number of spilled pages kept in memory. Spilled tuples are read back once, in order, so a
+     * small cache suffices.
+     */
+    static constexpr size_t CACHE_PAGES = 1024;
+
+    /**
+     * @brief Deletes a spill file left behind by a crash.
+     * @param fileName The name of the spill file.
+     */
+    explicit SpillFile(string fileName);
+
+    /**
+     * @brief Deletes the spill file. No SpillRun of it may outlive it.
+     */
+    ~SpillFile();
+
+    /**
+     * @brief Creates the file on the first call. May be called from several threads at once.
+     * @return The Pager to allocate spill pages from.
+     */
+    Pager &getPager();
+
+    SpillFile &operator=(SpillFile &&other) = delete;
+    SpillFile &operator=(const SpillFile &other) = delete;
+    SpillFile(SpillFile &&other) = delete;
+    SpillFile(const SpillFile &other) = delete;
+
+private:
+    string m_fileName;
+    std::once_flag m_open;
+    Ptr<IOHandler> m_ioHandler;
+    Ptr<PageCache> m_pageCache;
+    Ptr<FreeSpaceMap> m_freeSpaceMap;
+    Ptr<Pager> m_pager;
+};
+
+} // namespace backend
+
+#endif //KNDB_SPILLFILE_HPP
@@ -0,0 +1,88 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include "SpillPage.hpp"
+#include "utility.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+//    u8 pagetypeid
+//    u16 numTuples
+//    u8 numTypes
+//    u8 typeIDs[numTypes]
+//    Vari tuples[numTuples][numTypes]
+
+SpillPage::SpillPage(std::span<const byte> bytes, pgid_t pageID) : Page(pageID) {
+    ASSUME_S(bytes.size() == cts::PG_SZ, "Buffer is incorrectly sized");
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id;
+    u16 numTuples;
+    u8 numTypes;
+    db_deserialize(page_type_id, bytes, offset);
+    ASSUME_S(page_type_id == cts::pg_type_id::SPILL_PAGE, "Page_type_id is incorrect type");
+
+    db_deserialize(numTuples, bytes, offset);
+    db_deserialize(numTypes, bytes, offset);
+    for (int i = 0; i < numTypes; i++) {
+        pgtypeid_t type_id;
+        db_deserialize(type_id, bytes, offset);
+        m_types.push_back(type_id_to_variant(type_id));
+    }
+    ASSUME_S(numTuples <= getMaxTuples(m_types), "Page holds more tuples than fit");
+
+    m_tuples.resize(numTuples);
+    for (auto &tuple: m_tuples) {
+        tuple.resize(numTypes);
+        for (int i = 0; i < numTypes; i++)
+            db_deserialize(tuple[i], bytes, offset, m_types[i]);
+    }
+
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+}
+
+SpillPage::SpillPage(Vec<Vari> types, pgid_t pageID) : Page(pageID), m_types(std::move(types)) {
+    ASSUME_S(getMaxTuples(m_types) > 0, "Tuple does not fit in a page");
+}
+
+void SpillPage::addTuple(Vec<Vari> tuple) {
+    ASSUME_S(!isFull(), "Page is full");
+    ASSUME_S(sameTypes(tuple, m_types), "Tuple has incorrect types");
+
+    m_tuples.push_back(std::move(tuple));
+}
+
+u16 SpillPage::getMaxTuples(const Vec<Vari> &types) {
+    size_t header = db_sizeof<pgtypeid_t>() + db_sizeof<u16>() + db_sizeof<u8>() + types.size() * db_sizeof<pgtypeid_t>();
+    size_t tupleSize = 0;
+    for (const auto &type: types)
+        tupleSize += db_sizeof(type);
+
+    if (tupleSize == 0 || header + tupleSize > cts::PG_SZ)
+        return 0;
+    return (cts::PG_SZ - header) / tupleSize;
+}
+
+void SpillPage::toBytes(std::span<byte> buf) {
+    ASSUME_S(buf.size() == cts::PG_SZ, "Buffer is incorrectly sized");
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id = cts::pg_type_id::SPILL_PAGE;
+    u16 numTuples = m_tuples.size();
+    u8 numTypes = m_types.size();
+    db_serialize(page_type_id, buf, offset);
+    db_serialize(numTuples, buf, offset);
+    db_serialize(numTypes, buf, offset);
+    for (const auto &type: m_types)
+        db_serialize(variant_to_type_id(type), buf, offset);
+
+    for (const auto &tuple: m_tuples)
+        for (const auto &value: tuple)
+            db_serialize(value, buf, offset);
+
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+}
+
+} // namespace backend
@@ -0,0 +1,69 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_SPILLPAGE_HPP
+#define KNDB_SPILLPAGE_HPP
+
+#include "Page.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class SpillPage
+ * @brief Holds tuples that a query operator moved out of memory.
+ *
+ * Spill pages are temporary: they are allocated while an operator runs and freed once it is done
+ * with them, so no other page refers to them.
+ */
+class SpillPage : public Page {
+public:
+    /**
+     * @brief Constructs a SpillPage from serialized data.
+     * @param bytes Serialized data.
+     * @param pageID The page ID.
+     */
+    SpillPage(std::span<const byte> bytes, pgid_t pageID);
+
+    /**
+     * @brief Constructs an empty SpillPage.
+     * @param types The types of the tuples the page will hold.
+     * @param pageID The page ID.
+     * @note Program terminates if not even one tuple of these types fits in a page.
+     */
+    SpillPage(Vec<Vari> types, pgid_t pageID);
+
+    /**
+     * @return The tuples stored in this page, in the order they were added.
+     */
+    const Vec<Vec<Vari>> &getTuples() const { return m_tuples; }
+
+    /**
+     * @brief Adds a tuple to this page.
+     * @param tuple The tuple. Must have the page's types.
+     * @note Program terminates if the page is full.
+     */
+    void addTuple(Vec<Vari> tuple);
+
+    /**
+     * @return true if no more tuples fit in this page.
+     */
+    bool isFull() const { return m_tuples.size() == getMaxTuples(m_types); }
+
+    /**
+     * @param types The types of the tuples.
+     * @return The max number of tuples of these types a SpillPage can hold.
+     */
+    static u16 getMaxTuples(const Vec<Vari> &types);
+
+    void toBytes(std::span<byte> buffer) override;
+
+private:
+    Vec<Vari> m_types;
+    Vec<Vec<Vari>> m_tuples;
+};
+
+} // namespace backend
+
+#endif //KNDB_SPILLPAGE_HPP
@@ -0,0 +1,45 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include "SpillRun.hpp"
+
+namespace backend {
+
+SpillRun::SpillRun(Pager &pager, Vec<Vari> types) : m_pager(pager), m_types(std::move(types)), m_numTuples(0) {}
+
+SpillRun::~SpillRun() {
+    for (pgid_t pageID: m_pageIDs)
+        m_pager.freePage(pageID);
+}
+
+void SpillRun::append(Vec<Vari> tuple) {
+    if (m_pageIDs.empty() || m_pager.getPage<SpillPage>(m_pageIDs.back()).isFull())
+        m_pageIDs.push_back(m_pager.createNewPage<SpillPage>(m_types).getPageID());
+
+    m_pager.getPage<SpillPage>(m_pageIDs.back()).addTuple(std::move(tuple));
+    m_numTuples++;
+}
+
+SpillRun::Cursor::Cursor(const SpillRun &run) : m_run(run), m_pageIdx(0), m_idx(0) {
+    if (!m_run.m_pageIDs.empty())
+        m_nextPage = m_run.m_pager.getSharedPage<SpillPage>(m_run.m_pageIDs[0]);
+    advancePage();
+}
+
+void SpillRun::Cursor::next() {
+    if (++m_idx == m_page->getTuples().size())
+        advancePage();
+}
+
+void SpillRun::Cursor::advancePage() {
+    m_page = std::move(m_nextPage);
+    m_idx = 0;
+    if (m_page && m_page->getTuples().empty())
+        m_page = nullptr;
+
+    if (m_page && ++m_pageIdx < m_run.m_pageIDs.size())
+        m_nextPage = m_run.m_pager.getSharedPage<SpillPage>(m_run.m_pageIDs[m_pageIdx]);
+}
+
+} // namespace backend
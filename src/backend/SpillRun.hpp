@@ -0,0 +1,117 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_SPILLRUN_HPP
+#define KNDB_SPILLRUN_HPP
+
+#include "Pager.hpp"
+#include "SpillPage.hpp"
+#include "TupleCursor.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class SpillRun
+ * @brief A sequence of tuples that a query operator moved out of memory.
+ *
+ * The tuples are appended to temporary SpillPages allocated through the Pager, which writes them
+ * to disk as the page cache evicts them. The pages are freed when the run is destroyed.
+ */
+class SpillRun {
+public:
+    /**
+     * @brief Creates an empty run.
+     * @param pager Pager to allocate pages from.
+     * @param types The types of the tuples of the run.
+     */
+    SpillRun(Pager &pager, Vec<Vari> types);
+
+    /**
+     * @brief Frees the run's pages.
+     */
+    ~SpillRun();
+
+    /**
+     * @brief Appends a tuple to the run.
+     * @param tuple The tuple. Must have the run's types.
+     */
+    void append(Vec<Vari> tuple);
+
+    /**
+     * @brief Visits every tuple of the run in the order they were appended.
+     * @param fn Callable invoked as fn(const Vec<Vari> &tuple). It may allocate pages itself, e.g.
+     * to append to other runs, but must not append to this one.
+     */
+    template<typename Fn>
+    void forEach(Fn &&fn) const {
+        for (pgid_t pageID: m_pageIDs) {
+            // hold the page, since fn may evict it
+            auto page = m_pager.getSharedPage<SpillPage>(pageID);
+            for (const auto &tuple: page->getTuples())
+                fn(tuple);
+        }
+    }
+
+    /**
+     * @class Cursor
+     * @brief Iterates the tuples of a run in the order they were appended.
+     *
+     * Besides the page it is on, the cursor holds the run's next page, which is read as soon as
+     * the cursor moves onto the current one.
+     */
+    class Cursor : public TupleCursor {
+    public:
+        bool valid() const override { return m_page != nullptr; }
+
+        const Vec<Vari> &tuple() const override { return m_page->getTuples()[m_idx]; }
+
+        void next() override;
+
+    private:
+        friend class SpillRun;
+
+        explicit Cursor(const SpillRun &run);
+
+        // moves onto the next page and reads the one after it
+        void advancePage();
+
+        const SpillRun &m_run;
+        size_t m_pageIdx;
+        size_t m_idx;
+        std::shared_ptr<SpillPage> m_page;
+        std::shared_ptr<SpillPage> m_nextPage;
+    };
+
+    /**
+     * @return A cursor on the first tuple of the run. The run must not be appended to or
+     * destroyed while the cursor is in use.
+     */
+    Cursor cursor() const { return Cursor(*this); }
+
+    /**
+     * @return The number of tuples in the run.
+     */
+    u64 size() const { return m_numTuples; }
+
+    /**
+     * @return The number of pages the run occupies.
+     */
+    size_t getNumPages() const { return m_pageIDs.size(); }
+
+    SpillRun &operator=(SpillRun &&other) = delete;
+    SpillRun &operator=(const SpillRun &other) = delete;
+    SpillRun(SpillRun &&other) = delete;
+    SpillRun(const SpillRun &other) = delete;
+
+private:
+    Pager &m_pager;
+    Vec<Vari> m_types;
+    Vec<pgid_t> m_pageIDs;
+    u64 m_numTuples;
+};
+
+} // namespace backend
+
+#endif //KNDB_SPILLRUN_HPP
@@ -0,0 +1,215 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <cmath>
+
+#include "StatsPage.hpp"
+#include "utility.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+//    u8 pagetypeid
+//    u16 numTypes
+//    u8 types[numTypes]
+//    u8 precision
+//    bool hasBounds
+//    bool boundsStale
+//    Vari minKey, maxKey (if hasBounds)
+//    {
+//        i64 exact
+//        double sum
+//        double compensation
+//    } sums[numTypes]
+//    u8 registers[numTypes - 1][2^precision]
+
+void StatsPage::ColumnSum::add(const Vari &value, bool negate) {
+    std::visit([&](auto &&arg) {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_floating_point_v<T>) {
+            // Neumaier's variant of Kahan summation, which also holds when the value outweighs the sum
+            double x = negate ? -static_cast<double>(arg) : static_cast<double>(arg);
+            double t = sum + x;
+            if (std::abs(sum) >= std::abs(x))
+                compensation += (sum - t) + x;
+            else
+                compensation += (x - t) + sum;
+            sum = t;
+        } else if constexpr (!std::is_same_v<T, string>) {
+            exact += negate ? -static_cast<int64_t>(arg) : static_cast<int64_t>(arg);
+        }
+    }, value);
+}
+
+StatsPage::StatsPage(std::span<const byte> bytes, pgid_t pageID) : Page(pageID) {
+    ASSUME_S(bytes.size() == cts::PG_SZ, "Buffer is incorrectly sized");
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id;
+    db_deserialize(page_type_id, bytes, offset);
+    ASSUME_S(page_type_id == cts::pg_type_id::STATS_PAGE, "Page_type_id is incorrect type");
+
+    u16 numTypes;
+    db_deserialize(numTypes, bytes, offset);
+    for (int i = 0; i < numTypes; i++) {
+        typeid_t type_id;
+        db_deserialize(type_id, bytes, offset);
+        m_types.push_back(type_id_to_variant(type_id));
+    }
+
+    u8 precision;
+    bool hasBounds;
+    db_deserialize(precision, bytes, offset);
+    db_deserialize(hasBounds, bytes, offset);
+    db_deserialize(m_boundsStale, bytes, offset);
+
+    if (hasBounds) {
+        Vari key;
+        db_deserialize(key, bytes, offset, m_types[0]);
+        m_minKey = key;
+        db_deserialize(key, bytes, offset, m_types[0]);
+        m_maxKey = key;
+    }
+
+    m_sums.resize(numTypes);
+    for (auto &sum: m_sums) {
+        db_deserialize(sum.exact, bytes, offset);
+        db_deserialize(sum.sum, bytes, offset);
+        db_deserialize(sum.compensation, bytes, offset);
+    }
+
+    for (int i = 1; i < numTypes; i++) {
+        Vec<u8> registers(size_t(1) << precision);
+        for (auto &reg: registers)
+            db_deserialize(reg, bytes, offset);
+        m_sketches.emplace_back(std::move(registers));
+    }
+
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+}
+
+StatsPage::StatsPage(const Vec<Vari> &types, pgid_t pageID) : Page(pageID), m_types(types),
+        m_boundsStale(false), m_sums(types.size()) {
+    ASSUME_S(!types.empty(), "There cannot be 0 types in a StatsPage");
+
+    u8 precision = precisionFor(types);
+    for (size_t i = 1; i < types.size(); i++)
+        m_sketches.emplace_back(precision);
+}
+
+void StatsPage::addTuple(const Vec<Vari> &tuple) {
+    const Vari &key = tuple[0];
+    if (!m_boundsStale) {
+        if (!m_minKey || key < *m_minKey)
+            m_minKey = key;
+        if (!m_maxKey || *m_maxKey < key)
+            m_maxKey = key;
+    }
+
+    for (size_t i = 0; i < tuple.size(); i++)
+        m_sums[i].add(tuple[i]);
+    for (size_t i = 1; i < tuple.size(); i++)
+        m_sketches[i - 1].add(db_hash(tuple[i]));
+}
+
+void StatsPage::removeTuple(const Vec<Vari> &tuple) {
+    const Vari &key = tuple[0];
+    if (key == m_minKey || key == m_maxKey)
+        m_boundsStale = true;
+
+    for (size_t i = 0; i < tuple.size(); i++)
+        m_sums[i].add(tuple[i], true);
+}
+
+void StatsPage::updateTuple(const Vec<Vari> &old, const Vec<Vari> &values) {
+    ASSUME_S(old[0] == values[0], "Updated tuple has a different key");
+
+    for (size_t i = 1; i < values.size(); i++) {
+        m_sums[i].add(values[i]);
+        m_sums[i].add(old[i], true);
+        m_sketches[i - 1].add(db_hash(values[i]));
+    }
+}
+
+void StatsPage::setKeyBounds(std::optional<Vari> minKey, std::optional<Vari> maxKey) {
+    m_minKey = std::move(minKey);
+    m_maxKey = std::move(maxKey);
+    m_boundsStale = false;
+}
+
+Vec<double> StatsPage::getSums() const {
+    Vec<double> sums;
+    for (const auto &sum: m_sums)
+        sums.push_back(sum.value());
+    return sums;
+}
+
+u64 StatsPage::estimateDistinct(u16 column) const {
+    ASSUME_S(column > 0 && column < m_types.size(), "Column has no sketch");
+
+    return m_sketches[column - 1].estimate();
+}
+
+size_t StatsPage::headerSize(const Vec<Vari> &types) {
+    return db_sizeof<pgtypeid_t>() + db_sizeof<u16>() + types.size() * db_sizeof<typeid_t>() +
+           db_sizeof<u8>() + 2 * db_sizeof<bool>() + 2 * db_sizeof(types[0]) +
+           types.size() * (db_sizeof<int64_t>() + 2 * db_sizeof<double>());
+}
+
+u8 StatsPage::precisionFor(const Vec<Vari> &types) {
+    // 1024 registers give about 3% error, which is plenty for statistics
+    static constexpr u8 max_precision = 10;
+
+    size_t header = headerSize(types);
+    ASSUME_S(header <= cts::PG_SZ, "StatsPage cannot support that many columns");
+    if (types.size() == 1)
+        return max_precision;
+
+    size_t per_sketch = (cts::PG_SZ - header) / (types.size() - 1);
+    u8 precision = HyperLogLog::MIN_PRECISION;
+    while (precision < max_precision && (size_t(1) << (precision + 1)) <= per_sketch)
+        precision++;
+    ASSUME_S((size_t(1) << precision) <= per_sketch, "StatsPage cannot support that many columns");
+    return precision;
+}
+
+void StatsPage::toBytes(std::span<byte> buf) {
+    ASSUME_S(buf.size() == cts::PG_SZ, "Buffer is incorrectly sized");
+    offset_t offset = 0;
+
+    pgtypeid_t page_type_id = cts::pg_type_id::STATS_PAGE;
+    db_serialize(page_type_id, buf, offset);
+
+    u16 numTypes = m_types.size();
+    db_serialize(numTypes, buf, offset);
+    for (const auto &type: m_types) {
+        typeid_t type_id = variant_to_type_id(type);
+        db_serialize(type_id, buf, offset);
+    }
+
+    u8 precision = precisionFor(m_types);
+    bool hasBounds = m_minKey.has_value();
+    db_serialize(precision, buf, offset);
+    db_serialize(hasBounds, buf, offset);
+    db_serialize(m_boundsStale, buf, offset);
+
+    if (hasBounds) {
+        db_serialize(*m_minKey, buf, offset);
+        db_serialize(*m_maxKey, buf, offset);
+    }
+
+    for (const auto &sum: m_sums) {
+        db_serialize(sum.exact, buf, offset);
+        db_serialize(sum.sum, buf, offset);
+        db_serialize(sum.compensation, buf, offset);
+    }
+
+    for (const auto &sketch: m_sketches)
+        for (u8 reg: sketch.getRegisters())
+            db_serialize(reg, buf, offset);
+
+    ASSUME_S(offset <= cts::PG_SZ, "Offset out of bounds");
+}
+
+} // namespace backend
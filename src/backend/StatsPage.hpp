@@ -0,0 +1,132 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_STATSPAGE_HPP
+#define KNDB_STATSPAGE_HPP
+
+#include <cstdint>
+#include <optional>
+
+#include "HyperLogLog.hpp"
+#include "Page.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class StatsPage
+ * @brief Stores aggregate statistics of a table, maintained as its tuples change.
+ *
+ * Holds the smallest and largest primary key, the sum of every numeric column, and a
+ * HyperLogLog sketch of the distinct values of every non-key column.
+ *
+ * Deleting the smallest or largest key leaves the other bound unknown without a search, so the
+ * bounds are then only marked stale and left for the table to recompute. Sketches only ever grow,
+ * so deleted values still count as distinct.
+ *
+ * Integer, char and bool columns are summed exactly in 64 bits. Float and double columns use
+ * compensated summation, so that rounding errors do not pile up as values are added and removed.
+ */
+class StatsPage : public Page {
+public:
+    /**
+     * @brief Constructs a StatsPage from serialized data.
+     * @param bytes Serialized data.
+     * @param pageID The page ID.
+     */
+    StatsPage(std::span<const byte> bytes, pgid_t pageID);
+
+    /**
+     * @brief Constructs the StatsPage of an empty table.
+     * @param types The column types of the table.
+     * @param pageID The page ID.
+     * @note Program terminates if the table has more columns than fit in a page.
+     */
+    StatsPage(const Vec<Vari> &types, pgid_t pageID);
+
+    /**
+     * @brief Accounts for a tuple inserted into the table.
+     * @param tuple The inserted tuple.
+     */
+    void addTuple(const Vec<Vari> &tuple);
+
+    /**
+     * @brief Accounts for a tuple deleted from the table.
+     * @param tuple The deleted tuple.
+     */
+    void removeTuple(const Vec<Vari> &tuple);
+
+    /**
+     * @brief Accounts for a tuple whose non-key values were updated.
+     * @param old The tuple before the update.
+     * @param values The tuple after the update. Must have the same key.
+     */
+    void updateTuple(const Vec<Vari> &old, const Vec<Vari> &values);
+
+    /**
+     * @return true if the key bounds have to be recomputed with setKeyBounds() before use.
+     */
+    bool keyBoundsStale() const { return m_boundsStale; }
+
+    /**
+     * @return The smallest key in the table, or std::nullopt if it is empty.
+     */
+    const std::optional<Vari> &getMinKey() const { return m_minKey; }
+
+    /**
+     * @return The largest key in the table, or std::nullopt if it is empty.
+     */
+    const std::optional<Vari> &getMaxKey() const { return m_maxKey; }
+
+    /**
+     * @brief Records freshly computed key bounds.
+     * @param minKey The smallest key in the table, or std::nullopt if it is empty.
+     * @param maxKey The largest key in the table, or std::nullopt if it is empty.
+     */
+    void setKeyBounds(std::optional<Vari> minKey, std::optional<Vari> maxKey);
+
+    /**
+     * @return The sum of each column, converted to double. 0 for string columns.
+     */
+    Vec<double> getSums() const;
+
+    /**
+     * @param column A non-key column.
+     * @return The estimated number of distinct values ever stored in the column.
+     */
+    u64 estimateDistinct(u16 column) const;
+
+    void toBytes(std::span<byte> buffer) override;
+
+private:
+    // running sum of a column. exact holds the sum of integral columns, sum and compensation
+    // (the rounding error lost by sum) that of floating point ones.
+    struct ColumnSum {
+        int64_t exact = 0;
+        double sum = 0;
+        double compensation = 0;
+
+        // adds a value to the sum, or subtracts it if negate
+        void add(const Vari &value, bool negate = false);
+
+        double value() const { return static_cast<double>(exact) + (sum + compensation); }
+    };
+
+    // largest sketch precision such that a sketch of each non-key column fits in a page
+    static u8 precisionFor(const Vec<Vari> &types);
+
+    // number of bytes taken by everything but the sketches
+    static size_t headerSize(const Vec<Vari> &types);
+
+    Vec<Vari> m_types;
+    std::optional<Vari> m_minKey;
+    std::optional<Vari> m_maxKey;
+    bool m_boundsStale;
+    Vec<ColumnSum> m_sums;
+    Vec<HyperLogLog> m_sketches; // one per non-key column
+};
+
+} // namespace backend
+
+#endif //KNDB_STATSPAGE_HPP
@@ -5,97 +5,597 @@
 #include "StorageEngine.hpp"
 
 #include "Btree.hpp"
+#include "Metrics.hpp"
+#include "Tracer.hpp"
 #include "utility.hpp"
 #include "SchemaPage.hpp"
 
+#include <utility>
+
 #define S_PAGE m_pager.getPage<SchemaPage>(m_schemaPageID)
+#define S_VIEW m_pager.viewPage<SchemaPage>(m_schemaPageID)
 
 namespace backend {
-StorageEngine::StorageEngine(Pager &pgr, pgid_t schemaPageID) : m_pager(pgr),
-                                                                m_schemaPageID(schemaPageID) {
+struct StorageEngine::Metrics {
+    Histogram &insertNs = MetricsRegistry::global().histogram("engine.insert_ns");
+    Histogram &updateNs = MetricsRegistry::global().histogram("engine.update_ns");
+    Histogram &removeNs = MetricsRegistry::global().histogram("engine.remove_ns");
+    Histogram &getNs = MetricsRegistry::global().histogram("engine.get_ns");
+    Histogram &rangeNs = MetricsRegistry::global().histogram("engine.range_ns");
+    Histogram &commitNs = MetricsRegistry::global().histogram("engine.commit_ns");
+    Histogram &abortNs = MetricsRegistry::global().histogram("engine.abort_ns");
+    Histogram &checkpointNs = MetricsRegistry::global().histogram("engine.checkpoint_ns");
+};
+
+StorageEngine::Metrics &StorageEngine::metrics() {
+    static Metrics m;
+    return m;
+}
+
+StorageEngine::StorageEngine(Pager &pgr, pgid_t schemaPageID) : m_pager(pgr), m_readOnly(pgr.readOnly()),
+        m_transactions(string(pgr.getFileName()) + ".wal", m_snapshots, pgr.readOnly()),
+        m_spill(string(pgr.getFileName()) + ".tmp"), m_schemaPageID(schemaPageID) {
+    // recovery would have to change the file
+    if (m_readOnly && m_transactions.logSize() > 0)
+        throw std::runtime_error("Database needs recovery; open it read-write first.");
+
     // add existing tables
-    for (const auto &[name, pageID]: S_PAGE.getTables())
-        m_tables.emplace_back(std::make_unique<Table>(name, m_pager, pageID));
+    for (const auto &[name, pageID]: S_VIEW.getTables())
+        addTable(std::make_unique<Table>(name, m_pager, m_snapshots, m_transactions, m_spill, pageID));
+
+    // the log must reach the disk before the pages it describes
+    m_pager.setWriteHook([this] { m_transactions.flushLog(); });
+    m_transactions.setCheckpoint([this] { checkpoint(); });
+
+    if (m_readOnly)
+        return;
+    bool recovered = m_transactions.recover([this](const string &name, const Vari &key, const auto &tuple) {
+        if (auto tab = findTable(name)) tab->restoreTuple(key, tuple);
+    });
+    if (recovered)
+        checkpoint();
+}
+
+StorageEngine::~StorageEngine() {
+    if (m_readOnly)
+        return;
+    // an open transaction is rolled back by recovery instead
+    if (m_transactions.active())
+        m_transactions.flushLog();
+    else if (m_transactions.logSize() > 0)
+        checkpoint();
+    m_pager.setWriteHook({});
+}
+
+void StorageEngine::checkWritable() const {
+    if (m_readOnly)
+        throw std::runtime_error("Database is open read-only.");
 }
 
-void StorageEngine::createTable(const string &tableName, const Vec<Vari> &types) {
+Table *StorageEngine::findTable(const string &tableName) const {
+    auto it = m_tables.find(tableName);
+    if (it == m_tables.end())
+        return nullptr;
+    return it->second.get();
+}
+
+Table &StorageEngine::addTable(Ptr<Table> table) {
+    m_handles[table->getTablePageID()] = {m_nextGeneration++, table.get()};
+    string name = table->getName();
+    return *m_tables.emplace(std::move(name), std::move(table)).first->second;
+}
+
+Table &StorageEngine::resolve(TableHandle table) const {
+    auto it = m_handles.find(table.m_tableID);
+    if (it == m_handles.end() || it->second.first != table.m_generation)
+        throw std::invalid_argument("Table handle is invalid.");
+    return *it->second.second;
+}
+
+void StorageEngine::createTable(const string &tableName, const Vec<Vari> &types, TableEngine engine) {
+    checkWritable();
     if (tableName.length() + 1 > db_sizeof<string>())
         throw std::invalid_argument("Name is too long");
 
     if (tableName.empty())
         throw std::invalid_argument("Name cannot be empty");
 
-    for (const auto &table: m_tables)
-        if (table->getName() == tableName)
-            throw std::invalid_argument("Table with that name already exists");
+    if (m_tables.contains(tableName))
+        throw std::invalid_argument("Table with that name already exists");
+
+    if (m_transactions.active())
+        throw std::runtime_error("Cannot create a table while a transaction is open.");
 
-    m_tables.emplace_back(std::make_unique<Table>(tableName, m_pager, types));
+    auto &table = addTable(std::make_unique<Table>(tableName, m_pager, m_snapshots, m_transactions, m_spill, types,
+                                                   engine));
 
-    S_PAGE.addTable(m_tables.back()->getName(), m_tables.back()->getTablePageID());
+    S_PAGE.addTable(table.getName(), table.getTablePageID());
+    // tables are not logged, so changes to them could not be recovered until the table is written
+    checkpoint();
 }
 
 std::optional<Vec<Vari>> StorageEngine::getTableTypes(const string &tableName) const {
-    for (const auto &tab: m_tables)
-        if (tab->getName() == tableName) return tab->getTypes();
+    if (auto tab = findTable(tableName)) return tab->getTypes();
 
     return std::nullopt;
 }
 
 void StorageEngine::dropTable(const string &tableName) {
-    int idx = -1;
-    for (int i = 0; i < m_tables.size(); i++)
-        if (m_tables[i]->getName() == tableName) idx = i;
-
-    if (idx == -1)
+    checkWritable();
+    auto it = m_tables.find(tableName);
+    if (it == m_tables.end())
         throw std::invalid_argument("Table name not found in schema.");
 
+    if (m_transactions.active())
+        throw std::runtime_error("Cannot drop a table while a transaction is open.");
+
     S_PAGE.removeTable(tableName);
 
-    m_tables[idx]->drop();
-    m_tables.erase(m_tables.begin() + idx);
+    it->second->drop();
+    m_handles.erase(it->second->getTablePageID());
+    m_tables.erase(it);
+    // the log must not replay the dropped table's changes into a new table of the same name
+    checkpoint();
 }
 
 Vec<string> StorageEngine::getTableNames() const {
     Vec<string> res;
-    for (auto &table: S_PAGE.getTables())
+    for (auto &table: S_VIEW.getTables())
         res.push_back(table.first);
     return std::move(res);
 }
 
 bool StorageEngine::removeTuple(const string &tableName, const Vari &key) const {
-    for (auto &tab: m_tables)
-        if (tab->getName() == tableName) return tab->deleteTuple(key);
+    ScopedTimer timer(metrics().removeNs);
+    Tracer::Scope trace(TraceOp::REMOVE);
+    checkWritable();
+    if (auto tab = findTable(tableName)) return tab->deleteTuple(key);
 
     return false;
 }
 
 bool StorageEngine::updateTuple(const string &tableName, const Vec<Vari> &values) const {
-    for (const auto &tab: m_tables)
-        if (tab->getName() == tableName)
-            return tab->updateTuple(values);
+    ScopedTimer timer(metrics().updateNs);
+    Tracer::Scope trace(TraceOp::UPDATE);
+    checkWritable();
+    if (auto tab = findTable(tableName)) return tab->updateTuple(values);
 
     return false;
 }
 
 bool StorageEngine::insertTuple(const string &tableName, const Vec<Vari> &values) const {
-    for (auto &tab: m_tables)
-        if (tab->getName() == tableName)
-            return tab->insertTuple(values);
+    ScopedTimer timer(metrics().insertNs);
+    Tracer::Scope trace(TraceOp::INSERT);
+    checkWritable();
+    if (auto tab = findTable(tableName)) return tab->insertTuple(values);
 
     return false;
 }
 
 std::optional<Vec<Vari>> StorageEngine::getTuple(const string &tableName, const Vari &key) const {
-    for (auto &tab: m_tables)
-        if (tab->getName() == tableName) return tab->readTuple(key);
+    ScopedTimer timer(metrics().getNs);
+    Tracer::Scope trace(TraceOp::GET);
+    if (auto tab = findTable(tableName)) return tab->readTuple(key);
 
     return std::nullopt;
 }
 
 std::optional<u64> StorageEngine::getNumTuples(const string &tableName) const {
-    for (const auto &tab: m_tables)
-        if (tab->getName() == tableName) return tab->getNumTuples();
+    if (auto tab = findTable(tableName)) return tab->getNumTuples();
+
+    return std::nullopt;
+}
+
+std::optional<Table::Stats> StorageEngine::getTableStats(const string &tableName) const {
+    if (auto tab = findTable(tableName)) return tab->getStats();
+
+    return std::nullopt;
+}
+
+std::optional<u64> StorageEngine::countRange(const string &tableName, const Vari &lo, const Vari &hi) const {
+    if (auto tab = findTable(tableName)) return tab->countRange(lo, hi);
+
+    return std::nullopt;
+}
+
+std::optional<u64> StorageEngine::getRank(const string &tableName, const Vari &key) const {
+    if (auto tab = findTable(tableName)) return tab->rank(key);
+
+    return std::nullopt;
+}
+
+std::optional<Vec<Vari>> StorageEngine::getTupleAtRank(const string &tableName, u64 rank) const {
+    if (auto tab = findTable(tableName)) return tab->selectByRank(rank);
+
+    return std::nullopt;
+}
+
+std::optional<Vec<Vec<Vari>>> StorageEngine::getTuplesFrom(const string &tableName, u64 rank, u64 limit) const {
+    ScopedTimer timer(metrics().rangeNs);
+    Tracer::Scope trace(TraceOp::RANGE);
+    if (auto tab = findTable(tableName)) return tab->readTuplesFrom(rank, limit);
+
+    return std::nullopt;
+}
+
+void StorageEngine::createIndex(const string &tableName, u16 column, bool unique) {
+    checkWritable();
+    auto tab = findTable(tableName);
+    if (!tab)
+        throw std::invalid_argument("Table name not found in schema.");
+
+    tab->createIndex(column, unique);
+}
+
+void StorageEngine::createBloomFilter(const string &tableName, double falsePositiveRate, u64 expectedTuples) {
+    checkWritable();
+    auto tab = findTable(tableName);
+    if (!tab)
+        throw std::invalid_argument("Table name not found in schema.");
+
+    tab->createBloomFilter(falsePositiveRate, expectedTuples);
+}
+
+std::optional<Vec<Vec<Vari>>> StorageEngine::getTuplesBy(const string &tableName, u16 column,
+                                                         const Vari &value) const {
+    if (auto tab = findTable(tableName)) return tab->readTuplesBy(column, value);
+
+    return std::nullopt;
+}
+
+bool StorageEngine::scan(const string &tableName, const Vec<Predicate> &predicates, const Vec<u16> &projection,
+                         const Table::ScanCallback &callback) const {
+    auto tab = findTable(tableName);
+    if (!tab)
+        return false;
+
+    tab->scan(predicates, projection, callback);
+    return true;
+}
+
+bool StorageEngine::scanSorted(const string &tableName, const Vec<SortKey> &orderBy,
+                               const Table::ScanCallback &callback, size_t memoryBudget) const {
+    auto tab = findTable(tableName);
+    if (!tab)
+        return false;
+
+    tab->scanSorted(orderBy, callback, memoryBudget);
+    return true;
+}
+
+bool StorageEngine::parallelScan(const string &tableName, const Vec<Predicate> &predicates,
+                                 const Vec<u16> &projection, const Table::ScanCallback &callback,
+                                 size_t numThreads) {
+    auto tab = findTable(tableName);
+    if (!tab)
+        return false;
+
+    tab->parallelScan(predicates, projection, callback, scanPool(numThreads));
+    return true;
+}
+
+std::optional<Vec<Vec<Vari>>> StorageEngine::query(const string &tableName, const Query &query) const {
+    auto tab = findTable(tableName);
+    if (!tab)
+        return std::nullopt;
+
+    return tab->query(query);
+}
+
+bool StorageEngine::hashJoin(const string &leftName, u16 leftColumn, const string &rightName, u16 rightColumn,
+                             const JoinCallback &callback, size_t memoryBudget) const {
+    auto left = openTable(leftName);
+    auto right = openTable(rightName);
+    if (!left || !right)
+        return false;
+
+    hashJoin(*left, leftColumn, *right, rightColumn, callback, memoryBudget);
+    return true;
+}
+
+bool StorageEngine::mergeJoin(const string &leftName, u16 leftColumn, const string &rightName, u16 rightColumn,
+                              const JoinCallback &callback) const {
+    auto left = openTable(leftName);
+    auto right = openTable(rightName);
+    if (!left || !right)
+        return false;
+
+    mergeJoin(*left, leftColumn, *right, rightColumn, callback);
+    return true;
+}
+
+void StorageEngine::checkJoin(const Table &left, u16 leftColumn, const Table &right, u16 rightColumn) {
+    auto leftTypes = left.getTypes();
+    auto rightTypes = right.getTypes();
+    if (leftColumn >= leftTypes.size() || rightColumn >= rightTypes.size())
+        throw std::invalid_argument("Join column is out of range.");
+    if (variant_to_type_id(leftTypes[leftColumn]) != variant_to_type_id(rightTypes[rightColumn]))
+        throw std::runtime_error("Join columns have different types.");
+}
+
+ThreadPool &StorageEngine::scanPool(size_t numThreads) {
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    if (!m_scanPool || m_scanPool->getNumThreads() != numThreads)
+        m_scanPool = std::make_unique<ThreadPool>(numThreads);
+    return *m_scanPool;
+}
+
+std::optional<TableHandle> StorageEngine::openTable(const string &tableName) const {
+    if (auto tab = findTable(tableName)) {
+        pgid_t id = tab->getTablePageID();
+        return TableHandle(id, m_handles.at(id).first);
+    }
 
     return std::nullopt;
 }
+
+Vec<Vari> StorageEngine::getTableTypes(TableHandle table) const {
+    return resolve(table).getTypes();
+}
+
+u64 StorageEngine::getNumTuples(TableHandle table) const {
+    return resolve(table).getNumTuples();
+}
+
+bool StorageEngine::removeTuple(TableHandle table, const Vari &key) const {
+    ScopedTimer timer(metrics().removeNs);
+    Tracer::Scope trace(TraceOp::REMOVE);
+    checkWritable();
+    return resolve(table).deleteTuple(key);
+}
+
+bool StorageEngine::updateTuple(TableHandle table, const Vec<Vari> &values) const {
+    ScopedTimer timer(metrics().updateNs);
+    Tracer::Scope trace(TraceOp::UPDATE);
+    checkWritable();
+    return resolve(table).updateTuple(values);
+}
+
+bool StorageEngine::insertTuple(TableHandle table, const Vec<Vari> &values) const {
+    ScopedTimer timer(metrics().insertNs);
+    Tracer::Scope trace(TraceOp::INSERT);
+    checkWritable();
+    return resolve(table).insertTuple(values);
+}
+
+std::optional<Vec<Vari>> StorageEngine::getTuple(TableHandle table, const Vari &key) const {
+    ScopedTimer timer(metrics().getNs);
+    Tracer::Scope trace(TraceOp::GET);
+    return resolve(table).readTuple(key);
+}
+
+bool StorageEngine::concurrentInsertTuple(TableHandle table, const Vec<Vari> &values) const {
+    ScopedTimer timer(metrics().insertNs);
+    Tracer::Scope trace(TraceOp::INSERT);
+    checkWritable();
+    return resolve(table).concurrentInsertTuple(values);
+}
+
+std::optional<Vec<Vari>> StorageEngine::concurrentGetTuple(TableHandle table, const Vari &key) const {
+    ScopedTimer timer(metrics().getNs);
+    Tracer::Scope trace(TraceOp::GET);
+    return resolve(table).concurrentReadTuple(key);
+}
+
+Table::Stats StorageEngine::getTableStats(TableHandle table) const {
+    return resolve(table).getStats();
+}
+
+u64 StorageEngine::countRange(TableHandle table, const Vari &lo, const Vari &hi) const {
+    return resolve(table).countRange(lo, hi);
+}
+
+u64 StorageEngine::getRank(TableHandle table, const Vari &key) const {
+    return resolve(table).rank(key);
+}
+
+std::optional<Vec<Vari>> StorageEngine::getTupleAtRank(TableHandle table, u64 rank) const {
+    return resolve(table).selectByRank(rank);
+}
+
+Vec<Vec<Vari>> StorageEngine::getTuplesFrom(TableHandle table, u64 rank, u64 limit) const {
+    ScopedTimer timer(metrics().rangeNs);
+    Tracer::Scope trace(TraceOp::RANGE);
+    return resolve(table).readTuplesFrom(rank, limit);
+}
+
+Snapshot::Snapshot(Snapshot &&other) noexcept : m_engine(other.m_engine), m_timestamp(other.m_timestamp) {
+    other.m_engine = nullptr;
+}
+
+Snapshot &Snapshot::operator=(Snapshot &&other) noexcept {
+    if (this != &other) {
+        close();
+        m_engine = std::exchange(other.m_engine, nullptr);
+        m_timestamp = other.m_timestamp;
+    }
+    return *this;
+}
+
+Snapshot::~Snapshot() {
+    close();
+}
+
+void Snapshot::close() {
+    if (m_engine)
+        std::exchange(m_engine, nullptr)->endSnapshot(m_timestamp);
+}
+
+Snapshot StorageEngine::beginSnapshot() {
+    return {this, m_snapshots.open()};
+}
+
+void StorageEngine::endSnapshot(u64 timestamp) {
+    m_snapshots.close(timestamp);
+    vacuum();
+}
+
+void StorageEngine::vacuum() {
+    for (const auto &[name, table]: m_tables)
+        table->vacuum();
+}
+
+Transaction::Transaction(Transaction &&other) noexcept : m_engine(other.m_engine), m_id(other.m_id) {
+    other.m_engine = nullptr;
+}
+
+Transaction &Transaction::operator=(Transaction &&other) {
+    if (this != &other) {
+        if (m_engine)
+            m_engine->abort(*this);
+        m_engine = std::exchange(other.m_engine, nullptr);
+        m_id = other.m_id;
+    }
+    return *this;
+}
+
+Transaction::~Transaction() {
+    if (m_engine)
+        m_engine->abort(*this);
+}
+
+Transaction StorageEngine::begin() {
+    checkWritable();
+    return {this, m_transactions.begin()};
+}
+
+void StorageEngine::commit(Transaction &txn) {
+    ScopedTimer timer(metrics().commitNs);
+    Tracer::Scope trace(TraceOp::COMMIT);
+    ASSUME_S(txn.valid(), "Transaction is not open");
+    m_transactions.commit(txn.m_id);
+    txn.m_engine = nullptr;
+}
+
+void StorageEngine::abort(Transaction &txn) {
+    ScopedTimer timer(metrics().abortNs);
+    Tracer::Scope trace(TraceOp::ABORT);
+    ASSUME_S(txn.valid(), "Transaction is not open");
+    m_transactions.abort(txn.m_id);
+    txn.m_engine = nullptr;
+}
+
+bool StorageEngine::insertTuple(Transaction &txn, TableHandle table, const Vec<Vari> &values) {
+    ScopedTimer timer(metrics().insertNs);
+    Tracer::Scope trace(TraceOp::INSERT);
+    checkWritable();
+    ASSUME_S(txn.valid(), "Transaction is not open");
+    TransactionManager::Scope scope(m_transactions, txn.m_id);
+    return resolve(table).insertTuple(values);
+}
+
+bool StorageEngine::updateTuple(Transaction &txn, TableHandle table, const Vec<Vari> &values) {
+    ScopedTimer timer(metrics().updateNs);
+    Tracer::Scope trace(TraceOp::UPDATE);
+    checkWritable();
+    ASSUME_S(txn.valid(), "Transaction is not open");
+    TransactionManager::Scope scope(m_transactions, txn.m_id);
+    return resolve(table).updateTuple(values);
+}
+
+bool StorageEngine::removeTuple(Transaction &txn, TableHandle table, const Vari &key) {
+    ScopedTimer timer(metrics().removeNs);
+    Tracer::Scope trace(TraceOp::REMOVE);
+    checkWritable();
+    ASSUME_S(txn.valid(), "Transaction is not open");
+    TransactionManager::Scope scope(m_transactions, txn.m_id);
+    return resolve(table).deleteTuple(key);
+}
+
+void StorageEngine::checkpoint() {
+    ScopedTimer timer(metrics().checkpointNs);
+    Tracer::Scope trace(TraceOp::CHECKPOINT);
+    if (m_transactions.active())
+        throw std::runtime_error("Cannot checkpoint while a transaction is open.");
+    if (m_readOnly)
+        return;
+
+    for (const auto &[name, table]: m_tables)
+        table->flush();
+    m_pager.flush();
+    m_transactions.truncateLog();
+}
+
+std::optional<Vec<Vari>> StorageEngine::getTuple(const Snapshot &snapshot, TableHandle table,
+                                                 const Vari &key) const {
+    ASSUME_S(snapshot.valid(), "Snapshot is closed");
+    return resolve(table).readTupleAt(key, snapshot.m_timestamp);
+}
+
+void StorageEngine::scan(const Snapshot &snapshot, TableHandle table, const Vec<Predicate> &predicates,
+                         const Vec<u16> &projection, const Table::ScanCallback &callback) const {
+    ASSUME_S(snapshot.valid(), "Snapshot is closed");
+    resolve(table).scanAt(snapshot.m_timestamp, predicates, projection, callback);
+}
+
+PreparedInsert StorageEngine::prepareInsert(TableHandle table) const {
+    checkWritable();
+    return resolve(table).prepareInsert();
+}
+
+PreparedLookup StorageEngine::prepareLookup(TableHandle table) const {
+    return resolve(table).prepareLookup();
+}
+
+Vec<Vec<Vari>> StorageEngine::getTuplesBy(TableHandle table, u16 column, const Vari &value) const {
+    return resolve(table).readTuplesBy(column, value);
+}
+
+void StorageEngine::scan(TableHandle table, const Vec<Predicate> &predicates, const Vec<u16> &projection,
+                         const Table::ScanCallback &callback) const {
+    resolve(table).scan(predicates, projection, callback);
+}
+
+void StorageEngine::scanSorted(TableHandle table, const Vec<SortKey> &orderBy, const Table::ScanCallback &callback,
+                               size_t memoryBudget) const {
+    resolve(table).scanSorted(orderBy, callback, memoryBudget);
+}
+
+void StorageEngine::parallelScan(TableHandle table, const Vec<Predicate> &predicates, const Vec<u16> &projection,
+                                 const Table::ScanCallback &callback, size_t numThreads) {
+    resolve(table).parallelScan(predicates, projection, callback, scanPool(numThreads));
+}
+
+Vec<Vec<Vari>> StorageEngine::query(TableHandle table, const Query &query) const {
+    return resolve(table).query(query);
+}
+
+void StorageEngine::hashJoin(TableHandle left, u16 leftColumn, TableHandle right, u16 rightColumn,
+                             const JoinCallback &callback, size_t memoryBudget) const {
+    const Table &leftTable = resolve(left);
+    const Table &rightTable = resolve(right);
+    checkJoin(leftTable, leftColumn, rightTable, rightColumn);
+
+    // build on the smaller table, so that it is the one that has to fit in memory
+    bool buildLeft = leftTable.getNumTuples() <= rightTable.getNumTuples();
+    const Table &build = buildLeft ? leftTable : rightTable;
+    const Table &probe = buildLeft ? rightTable : leftTable;
+    HashJoin join(m_spill.getPager(), build.getTypes(), buildLeft ? leftColumn : rightColumn,
+                  probe.getTypes(), buildLeft ? rightColumn : leftColumn, memoryBudget);
+
+    JoinCallback emit = [&](const Vec<Vari> &buildTuple, const Vec<Vari> &probeTuple) {
+        if (buildLeft)
+            callback(buildTuple, probeTuple);
+        else
+            callback(probeTuple, buildTuple);
+    };
+
+    build.scan({}, {}, [&](const Vec<Vari> &tuple) { join.build(tuple); });
+    probe.scan({}, {}, [&](const Vec<Vari> &tuple) { join.probe(tuple, emit); });
+    join.finish(emit);
+}
+
+void StorageEngine::mergeJoin(TableHandle left, u16 leftColumn, TableHandle right, u16 rightColumn,
+                              const JoinCallback &callback) const {
+    const Table &leftTable = resolve(left);
+    const Table &rightTable = resolve(right);
+    checkJoin(leftTable, leftColumn, rightTable, rightColumn);
+
+    auto leftCursor = leftTable.sortedCursor(leftColumn);
+    auto rightCursor = rightTable.sortedCursor(rightColumn);
+    backend::mergeJoin(*leftCursor, leftColumn, *rightCursor, rightColumn, callback);
+}
+
 } // namespace backend
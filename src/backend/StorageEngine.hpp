@@ -7,11 +7,124 @@
 
 #include "Pager.hpp"
 #include "Table.hpp"
+#include "TransactionManager.hpp"
 #include "kndb_types.hpp"
 #include <optional>
+#include <unordered_map>
 
 namespace backend {
 
+/**
+ * @class TableHandle
+ * @brief A resolved reference to a table in the Storage Engine.
+ *
+ * Obtained once through StorageEngine::openTable() and then reused for any number of operations,
+ * which skips the table name lookup that the name-based API performs on every call. A handle is
+ * invalidated when the table it refers to is dropped, even if a table of the same name is created
+ * again.
+ */
+class TableHandle {
+public:
+    TableHandle() = default;
+
+    /**
+     * @return true if the handle was obtained from openTable(), false if it was default
+     * constructed. A valid handle may still refer to a table that has since been dropped.
+     */
+    bool valid() const { return m_tableID != cts::PGID_INVALID; }
+
+private:
+    friend class StorageEngine;
+
+    TableHandle(pgid_t tableID, u64 generation) : m_tableID(tableID), m_generation(generation) {}
+
+    pgid_t m_tableID = cts::PGID_INVALID; // the table's TablePage, which a later table may reuse
+    u64 m_generation = 0;                 // tells the tables that used the same TablePage apart
+};
+
+class StorageEngine;
+
+/**
+ * @class Snapshot
+ * @brief A consistent, read-only view of every table as of the moment it was taken.
+ *
+ * Obtained through StorageEngine::beginSnapshot(). Reads through a snapshot see the tuples as they
+ * were when it was taken, while changes made in the meantime go ahead without waiting for it. The
+ * tuples those changes replace are kept until no open snapshot can see them. A snapshot closes
+ * when destroyed, and must be closed before the StorageEngine is destroyed.
+ */
+class Snapshot {
+public:
+    Snapshot() = default;
+
+    Snapshot(Snapshot &&other) noexcept;
+
+    Snapshot &operator=(Snapshot &&other) noexcept;
+
+    Snapshot(const Snapshot &) = delete;
+
+    Snapshot &operator=(const Snapshot &) = delete;
+
+    ~Snapshot();
+
+    /**
+     * @return true if the snapshot is open, false if it was closed or default constructed.
+     */
+    bool valid() const { return m_engine != nullptr; }
+
+    /**
+     * @brief Closes the snapshot, so the versions kept only for it can be vacuumed.
+     */
+    void close();
+
+private:
+    friend class StorageEngine;
+
+    Snapshot(StorageEngine *engine, u64 timestamp) : m_engine(engine), m_timestamp(timestamp) {}
+
+    StorageEngine *m_engine = nullptr;
+    u64 m_timestamp = 0;
+};
+
+/**
+ * @class Transaction
+ * @brief A group of changes that become durable together when committed, or are all undone when
+ * aborted.
+ *
+ * Obtained through StorageEngine::begin() and passed to the inserts, updates and removes that
+ * belong to it. A transaction locks every row it changes until it ends, and changing a row locked
+ * by another transaction throws rather than waits. Reads see uncommitted changes. A transaction
+ * still open when destroyed is aborted, and every transaction must end before the StorageEngine is
+ * destroyed.
+ */
+class Transaction {
+public:
+    Transaction() = default;
+
+    Transaction(Transaction &&other) noexcept;
+
+    Transaction &operator=(Transaction &&other);
+
+    Transaction(const Transaction &) = delete;
+
+    Transaction &operator=(const Transaction &) = delete;
+
+    ~Transaction();
+
+    /**
+     * @return true if the transaction is open, false if it ended or was default constructed.
+     */
+    bool valid() const { return m_engine != nullptr; }
+
+private:
+    friend class StorageEngine;
+
+    Transaction(StorageEngine *engine, u64 id) : m_engine(engine), m_id(id) {}
+
+    StorageEngine *m_engine = nullptr;
+    u64 m_id = 0;
+};
+
 /**
  * @class StorageEngine
  *
@@ -19,31 +132,60 @@ namespace backend {
  * It acts as the interface to the backend, handling table creation, deletion, and data operations:
  * - Creating and dropping tables.
  * - Inserting, updating, removing, and reading tuples from tables.
- * - Retrieving table metadata, including column types and tuple counts.
+ * - Creating secondary indexes and looking tuples up by indexed columns.
+ * - Retrieving table metadata, including column types, tuple counts and aggregate statistics.
+ * - Reading consistent snapshots while tables keep changing, with multi-version concurrency control.
+ * - Grouping changes into transactions, with a write-ahead log that recovers them after a crash.
+ *
+ * If the database file was opened read-only, every call that would change it throws
+ * std::runtime_error, and checkpoints write nothing.
  */
 class StorageEngine {
 public:
     /**
      * Constructs the Storage Engine from a given SchemaPage.
      *
+     * Every change is logged to a file next to the database file, which is flushed before any page
+     * is written. If the log holds changes when the engine is constructed (after a crash), they are
+     * recovered: changes of committed transactions and changes made outside of transactions are
+     * redone, and changes of transactions that never finished are undone.
+     *
+     * A read-only database is not recovered, and its log is not created.
+     *
+     * Sorts and joins that outgrow their memory budget spill to a temporary file next to the
+     * database file, which is deleted when the engine is destroyed, or constructed after a crash.
+     *
      * @param schemaPageID The page ID containing the metadata for the Storage Engine.
      * @param pgr The Pager responsible for managing disk I/O.
+     * @throws std::runtime_error if the database is read-only and its log holds changes to recover.
      */
     StorageEngine(Pager& pgr, pgid_t schemaPageID);
 
+    /**
+     * Checkpoints, unless a transaction is still open.
+     */
+    ~StorageEngine();
+
     /**
      * Creates a new table in the Storage Engine.
      *
      * @throws std::invalid_argument if the name is empty, too long, or already exists.
+     * @throws std::runtime_error if a transaction is open, since tables are not logged.
      * @param tableName The name of the table (case-sensitive).
      * @param types The list of column types for the table.
+     * @param engine The structure used to store the table's tuples. Hash tables answer exact key
+     * lookups faster, but cannot return tuples in key order. LSM tables make inserts, updates and
+     * deletes cheaper at the cost of slower lookups, and keep their tuples in files next to the
+     * database file.
      */
-    void createTable(const string &tableName, const Vec<Vari>& types);
+    void createTable(const string &tableName, const Vec<Vari>& types,
+                     TableEngine engine = TableEngine::BTREE);
 
     /**
      * Drops an existing table from the Storage Engine.
      *
      * @throws std::invalid_argument if the table does not exist.
+     * @throws std::runtime_error if a transaction is open.
      * @param tableName The name of the table to drop (case-sensitive).
      */
     void dropTable(const string& tableName);
@@ -107,7 +249,601 @@ public:
      */
     std::optional<Vec<Vari>> getTuple(const string &tableName, const Vari& key) const;
 
+    /**
+     * Retrieves the aggregates of a table (key bounds, column sums and distinct counts), which are
+     * kept up to date on every change rather than computed from the tuples.
+     *
+     * @param tableName The name of the table.
+     * @return The aggregates, or std::nullopt if table doesn't exist.
+     */
+    std::optional<Table::Stats> getTableStats(const string &tableName) const;
+
+    /**
+     * Counts the tuples of a table whose primary key lies in a range. B-tree tables answer in a
+     * number of page reads proportional to the height of the tree.
+     *
+     * @throws std::runtime_error if a key has incorrect type.
+     * @param tableName The name of the table.
+     * @param lo The smallest key to count.
+     * @param hi The largest key to count.
+     * @return Number of tuples with lo <= key <= hi, or std::nullopt if table doesn't exist.
+     */
+    std::optional<u64> countRange(const string &tableName, const Vari &lo, const Vari &hi) const;
+
+    /**
+     * Counts the tuples of a table whose primary key is smaller than a key.
+     *
+     * @throws std::runtime_error if key has incorrect type.
+     * @param tableName The name of the table.
+     * @param key The key to rank. It does not need to be in the table.
+     * @return The position of the key in key order, or std::nullopt if table doesn't exist.
+     */
+    std::optional<u64> getRank(const string &tableName, const Vari &key) const;
+
+    /**
+     * Retrieves the tuple at a position in primary key order.
+     *
+     * @param tableName The name of the table.
+     * @param rank The position, starting from 0.
+     * @return Optional tuple values, or std::nullopt if table doesn't exist or has no more than
+     * rank tuples.
+     */
+    std::optional<Vec<Vari>> getTupleAtRank(const string &tableName, u64 rank) const;
+
+    /**
+     * Retrieves consecutive tuples in primary key order, such as one page of a paginated result.
+     * B-tree tables skip to the first tuple without visiting the tuples before it.
+     *
+     * @param tableName The name of the table.
+     * @param rank The position of the first tuple, starting from 0.
+     * @param limit The maximum number of tuples to retrieve.
+     * @return The tuples, or std::nullopt if table doesn't exist.
+     */
+    std::optional<Vec<Vec<Vari>>> getTuplesFrom(const string &tableName, u64 rank, u64 limit) const;
+
+    /**
+     * Creates a secondary index on a column of a table. Existing tuples are indexed immediately and
+     * the index is maintained on every subsequent insert, update and delete.
+     *
+     * @throws std::invalid_argument if the table does not exist, the column is the primary key, out
+     * of range or already indexed, or if unique is requested and the column has duplicate values.
+     * @param tableName The name of the table.
+     * @param column The index of the column to build the index on.
+     * @param unique Whether the index should reject tuples with duplicate values in the column.
+     */
+    void createIndex(const string &tableName, u16 column, bool unique = false);
+
+    /**
+     * Creates a bloom filter over the primary keys of a table. Lookups, updates and deletes of keys
+     * that are not in the table are then answered without searching the table, except for a
+     * fraction of them given by the false-positive rate. The filter is stored in the database file
+     * and grows with the table.
+     *
+     * @throws std::invalid_argument if the table does not exist or already has a bloom filter, or
+     * if the rate is not between 0 and 1 (exclusive).
+     * @param tableName The name of the table.
+     * @param falsePositiveRate Target false-positive rate. Memory use is about 1.44 * log2(1 / rate)
+     * bits per key, e.g. 10 bits per key for 1%.
+     * @param expectedTuples Number of tuples to size the filter for up front.
+     */
+    void createBloomFilter(const string &tableName, double falsePositiveRate = 0.01, u64 expectedTuples = 0);
+
+    /**
+     * Retrieves every tuple of a table whose value in a column equals the given value.
+     *
+     * @throws std::invalid_argument if the column is not the primary key and has no index.
+     * @param tableName The name of the table.
+     * @param column The index of the column to look up by.
+     * @param value The value to look up.
+     * @return Matching tuples, or std::nullopt if table doesn't exist.
+     */
+    std::optional<Vec<Vec<Vari>>> getTuplesBy(const string &tableName, u16 column, const Vari& value) const;
+
+    /**
+     * Visits every tuple of a table that satisfies all predicates, passing only the projected
+     * columns to the callback. Tuples that fail a predicate are never copied out of the table.
+     *
+     * @throws std::invalid_argument if a predicate or projected column is out of range.
+     * @throws std::runtime_error if a predicate's value has incorrect type.
+     * @param tableName The name of the table.
+     * @param predicates Conditions that a tuple must all satisfy.
+     * @param projection The columns to return, in order. If empty, every column is returned.
+     * @param callback Invoked once per matching tuple, in key order (except for hash tables). It
+     * must not modify the table.
+     * @return false if the table doesn't exist.
+     */
+    bool scan(const string &tableName, const Vec<Predicate> &predicates, const Vec<u16> &projection,
+              const Table::ScanCallback &callback) const;
+
+    /**
+     * Visits every tuple of a table in the order of some of its columns, e.g. for an ORDER BY on
+     * columns other than the key. Tuples that don't fit in the memory budget are sorted in runs
+     * on temporary pages, which are merged and freed afterwards.
+     *
+     * @throws std::invalid_argument if an orderBy column is out of range.
+     * @param tableName The name of the table.
+     * @param orderBy The columns to order by, most significant first.
+     * @param callback Invoked once per tuple, in order. It must not modify the table.
+     * @param memoryBudget Approximate number of bytes the sort may hold in memory.
+     * @return false if the table doesn't exist.
+     */
+    bool scanSorted(const string &tableName, const Vec<SortKey> &orderBy, const Table::ScanCallback &callback,
+                    size_t memoryBudget = ExternalSort::DEFAULT_MEMORY_BUDGET) const;
+
+    /**
+     * Same as scan(), but splits the table into parts that are filtered and projected on several
+     * threads at once. Matching tuples are passed to the callback in no particular order, one at a
+     * time.
+     *
+     * @throws std::invalid_argument if a predicate or projected column is out of range.
+     * @throws std::runtime_error if a predicate's value has incorrect type.
+     * @param tableName The name of the table.
+     * @param predicates Conditions that a tuple must all satisfy.
+     * @param projection The columns to return, in order. If empty, every column is returned.
+     * @param callback Invoked once per matching tuple. It must not modify the table.
+     * @param numThreads Number of threads to scan with, or 0 for one per hardware thread.
+     * @return false if the table doesn't exist.
+     */
+    bool parallelScan(const string &tableName, const Vec<Predicate> &predicates, const Vec<u16> &projection,
+                      const Table::ScanCallback &callback, size_t numThreads = 0);
+
+    /**
+     * Evaluates a query over a table, a batch of tuples at a time: predicates, projections,
+     * aggregates and groupings are computed over whole typed columns rather than tuple by tuple.
+     *
+     * @throws std::invalid_argument if a column is out of range, if select is combined with
+     * aggregates or groupBy, or if SUM or AVG is applied to a string column.
+     * @throws std::runtime_error if a predicate's value has incorrect type.
+     * @param tableName The name of the table.
+     * @param query The query to evaluate.
+     * @return The result rows, or std::nullopt if the table doesn't exist.
+     */
+    std::optional<Vec<Vec<Vari>>> query(const string &tableName, const Query &query) const;
+
+    /**
+     * Joins two tables on equal column values by hashing the smaller one and looking up the
+     * tuples of the other. If the hashed tuples exceed the memory budget, both tables are split
+     * into partitions by the hash of their join value, which are spilled to temporary pages and
+     * then joined one at a time.
+     *
+     * @throws std::invalid_argument if a join column is out of range.
+     * @throws std::runtime_error if the join columns have different types.
+     * @param leftName The name of the left table.
+     * @param leftColumn The column of the left table to join on.
+     * @param rightName The name of the right table.
+     * @param rightColumn The column of the right table to join on.
+     * @param callback Invoked as callback(left, right) for every pair of matching tuples, in no
+     * particular order. It must not modify either table.
+     * @param memoryBudget Approximate number of bytes the hashed tuples may occupy in memory.
+     * @return false if either table doesn't exist.
+     */
+    bool hashJoin(const string &leftName, u16 leftColumn, const string &rightName, u16 rightColumn,
+                  const JoinCallback &callback, size_t memoryBudget = HashJoin::DEFAULT_MEMORY_BUDGET) const;
+
+    /**
+     * Joins two tables on equal column values by advancing through both in order of those values.
+     * B-tree tables joined on their key are read in order straight from their nodes, without any
+     * sorting; other tables or columns are sorted in memory first.
+     *
+     * @throws std::invalid_argument if a join column is out of range.
+     * @throws std::runtime_error if the join columns have different types.
+     * @param leftName The name of the left table.
+     * @param leftColumn The column of the left table to join on.
+     * @param rightName The name of the right table.
+     * @param rightColumn The column of the right table to join on.
+     * @param callback Invoked as callback(left, right) for every pair of matching tuples, in
+     * ascending order of the join value. It must not modify either table.
+     * @return false if either table doesn't exist.
+     */
+    bool mergeJoin(const string &leftName, u16 leftColumn, const string &rightName, u16 rightColumn,
+                   const JoinCallback &callback) const;
+
+    /**
+     * Resolves a table name into a handle that can be reused for subsequent operations.
+     *
+     * Every operation taking a handle throws std::invalid_argument if the handle was default
+     * constructed or its table was dropped.
+     *
+     * @param tableName The name of the table.
+     * @return Handle to the table, or std::nullopt if table doesn't exist.
+     */
+    std::optional<TableHandle> openTable(const string &tableName) const;
+
+    /**
+     * Retrieves the column types of the table referred to by a handle.
+     *
+     * @param table Handle to the table.
+     * @return List of column types.
+     */
+    Vec<Vari> getTableTypes(TableHandle table) const;
+
+    /**
+     * Retrieves the number of tuples stored in the table referred to by a handle.
+     *
+     * @param table Handle to the table.
+     * @return The tuple count.
+     */
+    u64 getNumTuples(TableHandle table) const;
+
+    /**
+     * Removes a tuple from the table referred to by a handle.
+     *
+     * @param table Handle to the table.
+     * @param key The primary key value of the tuple to remove.
+     * @return true if removal was successful, false if tuple not found.
+     */
+    bool removeTuple(TableHandle table, const Vari& key) const;
+
+    /**
+     * Updates an existing tuple in the table referred to by a handle.
+     *
+     * @param table Handle to the table.
+     * @param values The new values for the tuple.
+     * @return true if update was successful, false if tuple not found.
+     */
+    bool updateTuple(TableHandle table, const Vec<Vari>& values) const;
+
+    /**
+     * Inserts a new tuple into the table referred to by a handle.
+     *
+     * @param table Handle to the table.
+     * @param values The values for the new tuple.
+     * @return true if insertion was successful, false if key already exists.
+     */
+    bool insertTuple(TableHandle table, const Vec<Vari>& values) const;
+
+    /**
+     * Retrieves a tuple from the table referred to by a handle.
+     *
+     * @param table Handle to the table.
+     * @param key The primary key value of the tuple to retrieve.
+     * @return Optional tuple values, or std::nullopt if tuple not found.
+     */
+    std::optional<Vec<Vari>> getTuple(TableHandle table, const Vari& key) const;
+
+    /**
+     * Inserts a new tuple into the B-tree table referred to by a handle, while other threads
+     * insert or retrieve tuples of the same table with the concurrent operations. No other
+     * operation may run on the engine meanwhile.
+     *
+     * @throws std::runtime_error if the table is not a B-tree table, has secondary indexes or a
+     * bloom filter, if a transaction is open, or if the tuple has incorrect types.
+     * @param table Handle to the table.
+     * @param values The values for the new tuple.
+     * @return true if insertion was successful, false if key already exists.
+     */
+    bool concurrentInsertTuple(TableHandle table, const Vec<Vari>& values) const;
+
+    /**
+     * Retrieves a tuple from the B-tree table referred to by a handle, while other threads insert
+     * or retrieve tuples of the same table with the concurrent operations.
+     *
+     * @throws std::runtime_error if the table is not a B-tree table, or if key has incorrect type.
+     * @param table Handle to the table.
+     * @param key The primary key value of the tuple to retrieve.
+     * @return Optional tuple values, or std::nullopt if tuple not found.
+     */
+    std::optional<Vec<Vari>> concurrentGetTuple(TableHandle table, const Vari& key) const;
+
+    /**
+     * Retrieves the aggregates of the table referred to by a handle.
+     *
+     * @param table Handle to the table.
+     * @return The aggregates.
+     */
+    Table::Stats getTableStats(TableHandle table) const;
+
+    /**
+     * Counts the tuples of the table referred to by a handle whose primary key lies in a range.
+     *
+     * @throws std::runtime_error if a key has incorrect type.
+     * @param table Handle to the table.
+     * @param lo The smallest key to count.
+     * @param hi The largest key to count.
+     * @return Number of tuples with lo <= key <= hi.
+     */
+    u64 countRange(TableHandle table, const Vari &lo, const Vari &hi) const;
+
+    /**
+     * Counts the tuples of the table referred to by a handle whose primary key is smaller than a key.
+     *
+     * @throws std::runtime_error if key has incorrect type.
+     * @param table Handle to the table.
+     * @param key The key to rank.
+     * @return The position of the key in key order.
+     */
+    u64 getRank(TableHandle table, const Vari &key) const;
+
+    /**
+     * Retrieves the tuple at a position in primary key order from the table referred to by a handle.
+     *
+     * @param table Handle to the table.
+     * @param rank The position, starting from 0.
+     * @return Optional tuple values, or std::nullopt if the table has no more than rank tuples.
+     */
+    std::optional<Vec<Vari>> getTupleAtRank(TableHandle table, u64 rank) const;
+
+    /**
+     * Retrieves consecutive tuples in primary key order from the table referred to by a handle.
+     *
+     * @param table Handle to the table.
+     * @param rank The position of the first tuple, starting from 0.
+     * @param limit The maximum number of tuples to retrieve.
+     * @return The tuples.
+     */
+    Vec<Vec<Vari>> getTuplesFrom(TableHandle table, u64 rank, u64 limit) const;
+
+    /**
+     * Opens a snapshot of every table. Until it is closed, changes keep the tuples they replace in
+     * a per-table version store, which reads through the snapshot consult before the table.
+     *
+     * @return The snapshot.
+     */
+    Snapshot beginSnapshot();
+
+    /**
+     * Retrieves a tuple from the table referred to by a handle, as it was when a snapshot was taken.
+     *
+     * @param snapshot An open snapshot.
+     * @param table Handle to the table.
+     * @param key The primary key value of the tuple to retrieve.
+     * @return Optional tuple values, or std::nullopt if the tuple did not exist at the time.
+     */
+    std::optional<Vec<Vari>> getTuple(const Snapshot &snapshot, TableHandle table, const Vari &key) const;
+
+    /**
+     * Same as scan(), but visits the tuples of the table referred to by a handle as they were when
+     * a snapshot was taken. The table may be changed between (but not during) calls to the callback
+     * without affecting the tuples visited.
+     *
+     * @param snapshot An open snapshot.
+     * @param table Handle to the table.
+     * @param predicates Conditions that a tuple must all satisfy.
+     * @param projection The columns to return, in order. If empty, every column is returned.
+     * @param callback Invoked once per matching tuple, in key order (except for hash tables).
+     */
+    void scan(const Snapshot &snapshot, TableHandle table, const Vec<Predicate> &predicates,
+              const Vec<u16> &projection, const Table::ScanCallback &callback) const;
+
+    /**
+     * Removes the versions of tuples that no open snapshot can see, freeing their pages. Runs
+     * whenever a snapshot closes.
+     */
+    void vacuum();
+
+    /**
+     * Starts a transaction. Its changes are logged as they are made, and made durable together by
+     * a single flush of the log when it commits.
+     *
+     * @return The transaction.
+     */
+    Transaction begin();
+
+    /**
+     * Commits a transaction, making its changes durable and releasing its locks.
+     *
+     * @param txn An open transaction. It is closed afterwards.
+     */
+    void commit(Transaction &txn);
+
+    /**
+     * Aborts a transaction, restoring every tuple it changed and releasing its locks.
+     *
+     * @param txn An open transaction. It is closed afterwards.
+     */
+    void abort(Transaction &txn);
+
+    /**
+     * Inserts a tuple into the table referred to by a handle, as part of a transaction.
+     *
+     * @throws std::runtime_error if the tuple has incorrect types, or if another transaction has
+     * locked its key. The transaction stays open either way.
+     * @param txn An open transaction.
+     * @param table Handle to the table.
+     * @param values The tuple values to insert.
+     * @return True if insertion succeeded, false otherwise.
+     */
+    bool insertTuple(Transaction &txn, TableHandle table, const Vec<Vari>& values);
+
+    /**
+     * Updates a tuple in the table referred to by a handle, as part of a transaction.
+     *
+     * @throws std::runtime_error if the tuple has incorrect types, or if another transaction has
+     * locked its key. The transaction stays open either way.
+     * @param txn An open transaction.
+     * @param table Handle to the table.
+     * @param values The new tuple values. The first value must be the primary key.
+     * @return True if the update succeeded, false otherwise.
+     */
+    bool updateTuple(Transaction &txn, TableHandle table, const Vec<Vari>& values);
+
+    /**
+     * Removes a tuple from the table referred to by a handle, as part of a transaction.
+     *
+     * @throws std::runtime_error if the key has incorrect type, or if another transaction has
+     * locked it. The transaction stays open either way.
+     * @param txn An open transaction.
+     * @param table Handle to the table.
+     * @param key The primary key value of the tuple to remove.
+     * @return True if the tuple was removed, false otherwise.
+     */
+    bool removeTuple(Transaction &txn, TableHandle table, const Vari& key);
+
+    /**
+     * Writes every change made so far to the database file (and the files of LSM tables), then
+     * truncates the log. Runs on its own when the log grows large, when a table is created or
+     * dropped, and when the engine is destroyed.
+     *
+     * @throws std::runtime_error if a transaction is open.
+     */
+    void checkpoint();
+
+    /**
+     * Prepares an insert into the table referred to by a handle. Repeated inserts through it skip
+     * resolving the table's schema and checking types against the stored column types.
+     *
+     * @param table Handle to the table.
+     * @return The prepared insert, valid until the table is dropped.
+     */
+    PreparedInsert prepareInsert(TableHandle table) const;
+
+    /**
+     * Prepares a primary key lookup on the table referred to by a handle.
+     *
+     * @param table Handle to the table.
+     * @return The prepared lookup, valid until the table is dropped.
+     */
+    PreparedLookup prepareLookup(TableHandle table) const;
+
+    /**
+     * Retrieves every tuple of the table referred to by a handle whose value in a column equals
+     * the given value.
+     *
+     * @throws std::invalid_argument if the column is not the primary key and has no index.
+     * @param table Handle to the table.
+     * @param column The index of the column to look up by.
+     * @param value The value to look up.
+     * @return Matching tuples.
+     */
+    Vec<Vec<Vari>> getTuplesBy(TableHandle table, u16 column, const Vari& value) const;
+
+    /**
+     * Visits every tuple of the table referred to by a handle that satisfies all predicates,
+     * passing only the projected columns to the callback.
+     *
+     * @throws std::invalid_argument if a predicate or projected column is out of range.
+     * @throws std::runtime_error if a predicate's value has incorrect type.
+     * @param table Handle to the table.
+     * @param predicates Conditions that a tuple must all satisfy.
+     * @param projection The columns to return, in order. If empty, every column is returned.
+     * @param callback Invoked once per matching tuple. It must not modify the table.
+     */
+    void scan(TableHandle table, const Vec<Predicate> &predicates, const Vec<u16> &projection,
+              const Table::ScanCallback &callback) const;
+
+    /**
+     * Visits every tuple of the table referred to by a handle in the order of some of its columns.
+     *
+     * @throws std::invalid_argument if an orderBy column is out of range.
+     * @param table Handle to the table.
+     * @param orderBy The columns to order by, most significant first.
+     * @param callback Invoked once per tuple, in order. It must not modify the table.
+     * @param memoryBudget Approximate number of bytes the sort may hold in memory.
+     */
+    void scanSorted(TableHandle table, const Vec<SortKey> &orderBy, const Table::ScanCallback &callback,
+                    size_t memoryBudget = ExternalSort::DEFAULT_MEMORY_BUDGET) const;
+
+    /**
+     * Same as scan(), but splits the table referred to by a handle into parts that are filtered and
+     * projected on several threads at once.
+     *
+     * @throws std::invalid_argument if a predicate or projected column is out of range.
+     * @throws std::runtime_error if a predicate's value has incorrect type.
+     * @param table Handle to the table.
+     * @param predicates Conditions that a tuple must all satisfy.
+     * @param projection The columns to return, in order. If empty, every column is returned.
+     * @param callback Invoked once per matching tuple, one at a time. It must not modify the table.
+     * @param numThreads Number of threads to scan with, or 0 for one per hardware thread.
+     */
+    void parallelScan(TableHandle table, const Vec<Predicate> &predicates, const Vec<u16> &projection,
+                      const Table::ScanCallback &callback, size_t numThreads = 0);
+
+    /**
+     * Evaluates a query over the table referred to by a handle, a batch of tuples at a time.
+     *
+     * @throws std::invalid_argument if a column is out of range, if select is combined with
+     * aggregates or groupBy, or if SUM or AVG is applied to a string column.
+     * @throws std::runtime_error if a predicate's value has incorrect type.
+     * @param table Handle to the table.
+     * @param query The query to evaluate.
+     * @return The result rows.
+     */
+    Vec<Vec<Vari>> query(TableHandle table, const Query &query) const;
+
+    /**
+     * Same as hashJoin(), for the tables referred to by two handles.
+     *
+     * @throws std::invalid_argument if a join column is out of range.
+     * @throws std::runtime_error if the join columns have different types.
+     * @param left Handle to the left table.
+     * @param leftColumn The column of the left table to join on.
+     * @param right Handle to the right table.
+     * @param rightColumn The column of the right table to join on.
+     * @param callback Invoked as callback(left, right) for every pair of matching tuples.
+     * @param memoryBudget Approximate number of bytes the hashed tuples may occupy in memory.
+     */
+    void hashJoin(TableHandle left, u16 leftColumn, TableHandle right, u16 rightColumn,
+                  const JoinCallback &callback, size_t memoryBudget = HashJoin::DEFAULT_MEMORY_BUDGET) const;
+
+    /**
+     * Same as mergeJoin(), for the tables referred to by two handles.
+     *
+     * @throws std::invalid_argument if a join column is out of range.
+     * @throws std::runtime_error if the join columns have different types.
+     * @param left Handle to the left table.
+     * @param leftColumn The column of the left table to join on.
+     * @param right Handle to the right table.
+     * @param rightColumn The column of the right table to join on.
+     * @param callback Invoked as callback(left, right) for every pair of matching tuples, in
+     * ascending order of the join value.
+     */
+    void mergeJoin(TableHandle left, u16 leftColumn, TableHandle right, u16 rightColumn,
+                   const JoinCallback &callback) const;
+
 private:
+    friend class Snapshot;
+
+    /**
+     * Closes a snapshot and vacuums the versions only it could see.
+     *
+     * @param timestamp The snapshot's timestamp.
+     */
+    void endSnapshot(u64 timestamp);
+
+    /**
+     * Throws if two tables cannot be joined on the given columns.
+     */
+    static void checkJoin(const Table &left, u16 leftColumn, const Table &right, u16 rightColumn);
+
+    /**
+     * Gets the thread pool used by parallel scans, creating it if needed.
+     *
+     * @param numThreads The number of threads wanted, or 0 for one per hardware thread.
+     * @return The pool, reused between scans asking for the same number of threads.
+     */
+    ThreadPool &scanPool(size_t numThreads);
+
+    /**
+     * Looks up a table by name.
+     *
+     * @param tableName The name of the table.
+     * @return Pointer to the table, or nullptr if table doesn't exist.
+     */
+    Table *findTable(const string &tableName) const;
+
+    /**
+     * Adds a table, giving it the next generation so that handles to a dropped table with the same
+     * TablePage ID do not resolve to it.
+     *
+     * @param table The table.
+     * @return The table, now owned by the engine.
+     */
+    Table &addTable(Ptr<Table> table);
+
+    /**
+     * Looks up the table a handle refers to.
+     *
+     * @param table Handle to the table.
+     * @return The table.
+     * @throws std::invalid_argument if the handle was default constructed or its table was dropped.
+     */
+    Table &resolve(TableHandle table) const;
+
+    /**
+     * Throws std::runtime_error if the database is open read-only.
+     */
+    void checkWritable() const;
+
     /**
      * Checks if two lists of column types match.
      *
@@ -117,9 +853,23 @@ private:
      */
     bool sameTypes(Vec<Vari> vec1, Vec<Vari> vec2);
 
+    /**
+     * Latency histograms of the tuple operations, transactions and checkpoints.
+     */
+    struct Metrics;
+
+    static Metrics &metrics();
+
     Pager& m_pager;  ///< Reference to the Pager handling disk operations.
-    Vec<std::unique_ptr<Table>> m_tables;  ///< List of tables managed by the Storage Engine.
+    bool m_readOnly;  ///< Whether the database file was opened read-only.
+    SnapshotManager m_snapshots;  ///< Commit timestamps and open snapshots, shared by every table.
+    TransactionManager m_transactions;  ///< Open transactions, their locks and the write-ahead log.
+    mutable SpillFile m_spill;  ///< The temporary file that sorts and joins spill to.
+    std::unordered_map<string, Ptr<Table>> m_tables;  ///< Tables managed by the Storage Engine, keyed by name.
+    std::unordered_map<pgid_t, std::pair<u64, Table *>> m_handles;  ///< Generation and table of each TablePage ID.
+    u64 m_nextGeneration = 0;  ///< Generation given to the next table added.
     pgid_t m_schemaPageID;  ///< The hardcoded page ID where Storage Engine metadata is stored.
+    Ptr<ThreadPool> m_scanPool;  ///< Threads used by parallel scans, created on first use.
 };
 
 } // namespace backend
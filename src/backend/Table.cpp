@@ -2,105 +2,820 @@
 // Created by Kylan Chen on 10/13/24.
 //
 
+#include <algorithm>
+#include <mutex>
+#include <type_traits>
 #include <utility>
 
 #include "Table.hpp"
 
 #include <Btree.hpp>
 
+#include "BloomPage.hpp"
 #include "BtreeNodePage.hpp"
+#include "HashBucketPage.hpp"
+#include "HashDirectoryPage.hpp"
 #include "Pager.hpp"
+#include "StatsPage.hpp"
 #include "TablePage.hpp"
 
 #define T_PAGE m_pager.getPage<TablePage>(m_tablePageID)
+#define T_STATS m_pager.getPage<StatsPage>(m_statsPageID)
+#define T_VIEW m_pager.viewPage<TablePage>(m_tablePageID)
+#define T_STATS_VIEW m_pager.viewPage<StatsPage>(m_statsPageID)
 
 namespace backend {
 
-Table::Table(string name, Pager &pgr, const pgid_t tablePageId) : m_pager(pgr), m_tablePageID
-        (tablePageId), m_name(std::move(name)) {
-    degree_t deg = calculateDegree(T_PAGE.getTypes()[0], T_PAGE.getTypes());
-    m_btree = std::make_unique<Btree<Vec<Vari>>>(T_PAGE.getBtreePageID(), pgr, deg);
+namespace {
+
+// streams the tuples of a B-tree table in key order
+class BtreeCursor : public TupleCursor {
+public:
+    explicit BtreeCursor(Btree<Vec<Vari>>::Cursor cursor) : m_cursor(std::move(cursor)) {}
+
+    bool valid() const override { return m_cursor.valid(); }
+
+    const Vec<Vari> &tuple() const override { return m_cursor.value(); }
+
+    void next() override { m_cursor.next(); }
+
+private:
+    Btree<Vec<Vari>>::Cursor m_cursor;
+};
+
+} // namespace
+
+Table::Table(string name, Pager &pgr, SnapshotManager &snapshots, TransactionManager &transactions, SpillFile &spill,
+             const pgid_t tablePageId) : m_pager(pgr), m_snapshots(snapshots), m_transactions(transactions), m_spill(spill), m_tablePageID(tablePageId), m_statsPageID(T_VIEW.getStatsPageID()),
+        m_name(std::move(name)) {
+    if (T_VIEW.getEngine() == TableEngine::HASH) {
+        u16 cap = calculateBucketCapacity(T_VIEW.getTypes()[0], T_VIEW.getTypes());
+        m_store = std::make_unique<HashIndex<Vec<Vari>>>(T_VIEW.getBtreePageID(), pgr, cap);
+    } else if (T_VIEW.getEngine() == TableEngine::LSM) {
+        m_store = std::make_unique<LsmTree>(lsmBasePath(), T_VIEW.getTypes());
+    } else {
+        degree_t deg = calculateDegree(T_VIEW.getTypes()[0], T_VIEW.getTypes());
+        m_store = std::make_unique<Btree<Vec<Vari>>>(T_VIEW.getBtreePageID(), pgr, deg);
+    }
+
+    for (const auto &index: T_VIEW.getIndexes()) {
+        const auto &types = T_VIEW.getTypes();
+        degree_t idx_deg = calculateDegree(types[index.column], Vec<Vari>{types[0]});
+        m_indexes.push_back({index.column, index.unique, std::make_unique<Btree<Vec<Vari>>>(
+                index.btreePageID, pgr, idx_deg, false), index.btreePageID});
+    }
+
+    const auto &bloom = T_VIEW.getBloom();
+    if (bloom.pageID != cts::PGID_INVALID) {
+        Vec<u64> words;
+        Vec<pgid_t> pageIDs;
+        for (pgid_t pg = bloom.pageID; pg != cts::PGID_INVALID; pg = m_pager.viewPage<BloomPage>(pg).getNextPageID()) {
+            const auto &page_words = m_pager.viewPage<BloomPage>(pg).getWords();
+            words.insert(words.end(), page_words.begin(), page_words.end());
+            pageIDs.push_back(pg);
+        }
+        m_bloom = std::make_unique<Bloom>(Bloom{
+                BloomFilter(std::move(words), BloomFilter::numHashesFor(bloom.bitsPerKey)), std::move(pageIDs),
+                bloom.capacity, bloom.bitsPerKey});
+    }
+    m_numTuples = T_VIEW.getNumTuples();
+    m_rootPageID = T_VIEW.getBtreePageID();
+
+    // no snapshot survives a crash, so neither does the version store one left behind
+    if (pgid_t leftover = T_VIEW.getVersionsPageID(); leftover != cts::PGID_INVALID && !m_pager.readOnly()) {
+        m_versions = std::make_unique<VersionStore>(m_pager, T_VIEW.getTypes(), leftover);
+        m_versionsPageID = leftover;
+        dropVersions();
+    }
 }
 
-Table::Table(string name, Pager &pgr, const Vec<Vari> &types) : m_pager(pgr),
-                                                                m_name(std::move(name)) {
-    m_tablePageID = m_pager.createNewPage<TablePage>(types, cts::PGID_INVALID).getPageID();
-    degree_t deg = calculateDegree(T_PAGE.getTypes()[0], T_PAGE.getTypes());
-    pgid_t btree_pg = m_pager.createNewPage<BtreeNodePage<Vec<Vari>>>(
-            deg, cts::PGID_INVALID, true, true
-    ).getPageID();
-    T_PAGE.setBtreePageID(btree_pg);
-    m_btree = std::make_unique<Btree<Vec<Vari>>>(T_PAGE.getBtreePageID(), m_pager, deg);
+Table::Table(string name, Pager &pgr, SnapshotManager &snapshots, TransactionManager &transactions, SpillFile &spill,
+             const Vec<Vari> &types, TableEngine engine) : m_pager(pgr), m_snapshots(snapshots),
+        m_transactions(transactions), m_spill(spill), m_name(std::move(name)) {
+    m_tablePageID = m_pager.createNewPage<TablePage>(types, cts::PGID_INVALID, engine).getPageID();
+    m_statsPageID = m_pager.createNewPage<StatsPage>(types).getPageID();
+    T_PAGE.setStatsPageID(m_statsPageID);
+
+    if (engine == TableEngine::HASH) {
+        u16 cap = calculateBucketCapacity(T_VIEW.getTypes()[0], T_VIEW.getTypes());
+        pgid_t bucket_pg = m_pager.createNewPage<HashBucketPage<Vec<Vari>>>(cap, 0).getPageID();
+        pgid_t dir_pg = m_pager.createNewPage<HashDirectoryPage>(bucket_pg).getPageID();
+        T_PAGE.setBtreePageID(dir_pg);
+        m_store = std::make_unique<HashIndex<Vec<Vari>>>(T_VIEW.getBtreePageID(), m_pager, cap);
+    } else if (engine == TableEngine::LSM) {
+        // the tuples live in the LSM tree's own files, so the TablePage has no root page
+        m_store = std::make_unique<LsmTree>(lsmBasePath(), T_VIEW.getTypes());
+    } else {
+        degree_t deg = calculateDegree(T_VIEW.getTypes()[0], T_VIEW.getTypes());
+        pgid_t btree_pg = m_pager.createNewPage<BtreeNodePage<Vec<Vari>>>(
+                deg, cts::PGID_INVALID, true, true
+        ).getPageID();
+        T_PAGE.setBtreePageID(btree_pg);
+        m_store = std::make_unique<Btree<Vec<Vari>>>(T_VIEW.getBtreePageID(), m_pager, deg);
+    }
+    m_rootPageID = T_VIEW.getBtreePageID();
+}
+
+Table::~Table() {
+    dropVersions();
 }
 
 u64 Table::getNumTuples() const {
-    return T_PAGE.getNumTuples();
+    return m_numTuples;
+}
+
+Table::Stats Table::getStats() const {
+    if (T_STATS_VIEW.keyBoundsStale()) {
+        std::optional<Vari> minKey, maxKey;
+        visitStore([&](auto &store) {
+            using Store = std::decay_t<decltype(store)>;
+            if constexpr (std::is_same_v<Store, Btree<Vec<Vari>>>) {
+                if (u64 size = store.size(); size > 0) {
+                    minKey = (*store.selectByRank(0))[0];
+                    maxKey = (*store.selectByRank(size - 1))[0];
+                }
+            } else {
+                store.forEach([&](const Vari &key, const Vec<Vari> &) {
+                    if (!minKey || key < *minKey)
+                        minKey = key;
+                    if (!maxKey || *maxKey < key)
+                        maxKey = key;
+                });
+            }
+        });
+        T_STATS.setKeyBounds(std::move(minKey), std::move(maxKey));
+    }
+
+    const auto &stats = T_STATS_VIEW;
+    u64 numTuples = m_numTuples;
+    Stats res{numTuples, stats.getMinKey(), stats.getMaxKey(), stats.getSums(), {numTuples}};
+    for (u16 column = 1; column < res.sums.size(); column++)
+        res.distinct.push_back(std::min(stats.estimateDistinct(column), numTuples));
+    return res;
+}
+
+u64 Table::countRange(const Vari &lo, const Vari &hi) const {
+    if (variant_to_type_id(T_VIEW.getTypes()[0]) != variant_to_type_id(lo) ||
+        variant_to_type_id(T_VIEW.getTypes()[0]) != variant_to_type_id(hi))
+        throw std::runtime_error("Key is incorrect type.");
+
+    return visitStore([&](auto &store) -> u64 {
+        using Store = std::decay_t<decltype(store)>;
+        if constexpr (std::is_same_v<Store, Btree<Vec<Vari>>>) {
+            return store.countRange(lo, hi);
+        } else {
+            u64 count = 0;
+            store.forEach([&](const Vari &key, const Vec<Vari> &) {
+                if (!(key < lo) && !(hi < key))
+                    count++;
+            });
+            return count;
+        }
+    });
+}
+
+u64 Table::rank(const Vari &key) const {
+    if (variant_to_type_id(T_VIEW.getTypes()[0]) != variant_to_type_id(key))
+        throw std::runtime_error("Key is incorrect type.");
+
+    return visitStore([&](auto &store) -> u64 {
+        using Store = std::decay_t<decltype(store)>;
+        if constexpr (std::is_same_v<Store, Btree<Vec<Vari>>>) {
+            return store.rank(key);
+        } else {
+            u64 count = 0;
+            store.forEach([&](const Vari &other, const Vec<Vari> &) {
+                if (other < key)
+                    count++;
+            });
+            return count;
+        }
+    });
+}
+
+std::optional<Vec<Vari>> Table::selectByRank(u64 rank) const {
+    auto cursor = cursorAtRank(rank);
+    if (!cursor->valid())
+        return std::nullopt;
+    return cursor->tuple();
+}
+
+Vec<Vec<Vari>> Table::readTuplesFrom(u64 rank, u64 limit) const {
+    Vec<Vec<Vari>> res;
+    for (auto cursor = cursorAtRank(rank); cursor->valid() && res.size() < limit; cursor->next())
+        res.push_back(cursor->tuple());
+    return res;
+}
+
+Ptr<TupleCursor> Table::cursorAtRank(u64 rank) const {
+    if (auto btree = std::get_if<std::unique_ptr<Btree<Vec<Vari>>>>(&m_store))
+        return std::make_unique<BtreeCursor>((*btree)->cursorAt(rank));
+
+    auto cursor = sortedCursor(0);
+    for (; cursor->valid() && rank > 0; rank--)
+        cursor->next();
+    return cursor;
 }
 
 Vec<Vari> Table::getTypes() const {
-    return T_PAGE.getTypes();
+    return T_VIEW.getTypes();
 }
 
 pgid_t Table::getTablePageID() const {
     return m_tablePageID;
 }
 
-string Table::getName() const {
+TableEngine Table::getEngine() const {
+    return T_VIEW.getEngine();
+}
+
+const string &Table::getName() const {
     return m_name;
 }
 
 bool Table::insertTuple(const Vec<Vari> &values) const {
-    if (values.size() != T_PAGE.getTypes().size())
+    if (values.size() != T_VIEW.getTypes().size())
         throw std::runtime_error("Tuple has incorrect number of values.");
 
     for (int i = 0; i < values.size(); i++)
-        if (variant_to_type_id(values[i]) != variant_to_type_id(T_PAGE.getTypes()[i]))
+        if (variant_to_type_id(values[i]) != variant_to_type_id(T_VIEW.getTypes()[i]))
             throw std::runtime_error("Tuple has one or more incorrect types.");
 
-    pgid_t og_root = m_btree->getRootPage();
-    bool success = m_btree->insert(values, values[0]);
+    return insertChecked(values);
+}
+
+bool Table::insertChecked(const Vec<Vari> &values) const {
+    m_transactions.beginChange(*this, values[0]);
+    for (const auto &index: m_indexes)
+        if (index.unique && index.btree->search(values[index.column]).has_value())
+            return false;
+
+    bool success = visitStore([&](auto &store) { return store.insert(values, values[0]); });
     if (success) {
         T_PAGE.addTuple();
-        if (m_btree->getRootPage() != og_root)
-            T_PAGE.setBtreePageID(m_btree->getRootPage());
+        m_numTuples++;
+        T_STATS.addTuple(values);
+        recordChange(values[0], std::nullopt, values);
+        addToBloom(values[0]);
+        for (const auto &index: m_indexes)
+            index.btree->insert({values[0]}, values[index.column]);
+        syncRootPages();
     }
     return success;
 }
 
 std::optional<Vec<Vari>> Table::readTuple(const Vari &key) const {
-    if (variant_to_type_id(T_PAGE.getTypes()[0]) != variant_to_type_id(key))
+    if (variant_to_type_id(T_VIEW.getTypes()[0]) != variant_to_type_id(key))
         throw std::runtime_error("Key is incorrect type.");
 
-    return m_btree->search(key);
+    return readChecked(key);
+}
+
+std::optional<Vec<Vari>> Table::readChecked(const Vari &key) const {
+    if (!mayContain(key))
+        return std::nullopt;
+
+    return visitStore([&](auto &store) { return store.search(key); });
+}
+
+bool Table::concurrentInsertTuple(const Vec<Vari> &values) const {
+    auto &btree = concurrentStore();
+    if (!m_indexes.empty() || m_bloom)
+        throw std::runtime_error("Tables with indexes or a bloom filter can't be changed concurrently.");
+    if (m_transactions.active())
+        throw std::runtime_error("Tables can't be changed concurrently while a transaction is open.");
+
+    // other threads load pages meanwhile, which may evict the TablePage
+    auto page = m_pager.getSharedPage<TablePage>(m_tablePageID);
+    const auto &types = page->getTypes();
+    if (values.size() != types.size())
+        throw std::runtime_error("Tuple has incorrect number of values.");
+    for (size_t i = 0; i < values.size(); i++)
+        if (variant_to_type_id(values[i]) != variant_to_type_id(types[i]))
+            throw std::runtime_error("Tuple has one or more incorrect types.");
+
+    if (!btree.concurrentInsert(values, values[0]))
+        return false;
+
+    std::lock_guard lock(m_concurrentMutex);
+    T_PAGE.addTuple();
+    m_numTuples++;
+    T_STATS.addTuple(values);
+    recordChange(values[0], std::nullopt, values);
+    syncRootPages();
+    return true;
+}
+
+std::optional<Vec<Vari>> Table::concurrentReadTuple(const Vari &key) const {
+    auto &btree = concurrentStore();
+    auto page = m_pager.getSharedPage<TablePage>(m_tablePageID);
+    if (variant_to_type_id(page->getTypes()[0]) != variant_to_type_id(key))
+        throw std::runtime_error("Key is incorrect type.");
+
+    return btree.concurrentSearch(key);
+}
+
+Btree<Vec<Vari>> &Table::concurrentStore() const {
+    auto *btree = std::get_if<std::unique_ptr<Btree<Vec<Vari>>>>(&m_store);
+    if (!btree)
+        throw std::runtime_error("Only B-tree tables support concurrent operations.");
+    return **btree;
+}
+
+PreparedInsert Table::prepareInsert() const {
+    Vec<size_t> plan;
+    for (const auto &type: T_VIEW.getTypes())
+        plan.push_back(type.index());
+    return {*this, std::move(plan)};
+}
+
+PreparedLookup Table::prepareLookup() const {
+    return {*this, T_VIEW.getTypes()[0].index()};
+}
+
+bool PreparedInsert::execute(const Vec<Vari> &values) const {
+    if (values.size() != m_plan.size())
+        throw std::runtime_error("Tuple has incorrect number of values.");
+
+    for (size_t i = 0; i < values.size(); i++)
+        if (values[i].index() != m_plan[i])
+            throw std::runtime_error("Tuple has one or more incorrect types.");
+
+    return m_table->insertChecked(values);
+}
+
+std::optional<Vec<Vari>> PreparedLookup::execute(const Vari &key) const {
+    if (key.index() != m_keyIndex)
+        throw std::runtime_error("Key is incorrect type.");
+
+    return m_table->readChecked(key);
 }
 
 void Table::drop() {
-    // ???
+    dropVersions();
+
+    visitStore([](auto &store) {
+        using Store = std::decay_t<decltype(store)>;
+        if constexpr (std::is_same_v<Store, Btree<Vec<Vari>>>)
+            store.deleteTree();
+        else if constexpr (std::is_same_v<Store, HashIndex<Vec<Vari>>>)
+            store.deleteIndex();
+        else
+            store.destroy();
+    });
+
+    for (const auto &index: m_indexes)
+        index.btree->deleteTree();
+
+    if (m_bloom)
+        for (pgid_t pg: m_bloom->pageIDs)
+            m_pager.freePage(pg);
+
+    m_pager.freePage(m_statsPageID);
+    m_pager.freePage(m_tablePageID);
 }
 
 bool Table::updateTuple(const Vec<Vari> &values) const {
-    if (values.size() != T_PAGE.getTypes().size())
+    if (values.size() != T_VIEW.getTypes().size())
         throw std::runtime_error("Tuple has incorrect number of values.");
 
     for (int i = 0; i < values.size(); i++)
-        if (variant_to_type_id(values[i]) != variant_to_type_id(T_PAGE.getTypes()[i]))
+        if (variant_to_type_id(values[i]) != variant_to_type_id(T_VIEW.getTypes()[i]))
             throw std::runtime_error("Tuple has one or more incorrect types.");
 
-    return m_btree->update(values, values[0]);
+    m_transactions.beginChange(*this, values[0]);
+    if (!mayContain(values[0]))
+        return false;
+
+    auto old = visitStore([&](auto &store) { return store.search(values[0]); });
+    if (!old.has_value())
+        return false;
+
+    for (const auto &index: m_indexes)
+        if (index.unique && (*old)[index.column] != values[index.column] &&
+            index.btree->search(values[index.column]).has_value())
+            return false;
+
+    visitStore([&](auto &store) { return store.update(values, values[0]); });
+    T_STATS.updateTuple(*old, values);
+    recordChange(values[0], old, values);
+    for (const auto &index: m_indexes) {
+        if ((*old)[index.column] == values[index.column])
+            continue;
+        index.btree->remove((*old)[index.column], {values[0]});
+        index.btree->insert({values[0]}, values[index.column]);
+    }
+    syncRootPages();
+    return true;
 }
 
 bool Table::deleteTuple(const Vari &key) const {
-    if (variant_to_type_id(T_PAGE.getTypes()[0]) != variant_to_type_id(key))
+    if (variant_to_type_id(T_VIEW.getTypes()[0]) != variant_to_type_id(key))
         throw std::runtime_error("Key is incorrect type.");
 
-    pgid_t og_root = m_btree->getRootPage();
-    bool success = m_btree->remove(key);
+    m_transactions.beginChange(*this, key);
+    if (!mayContain(key))
+        return false;
+
+    // the old tuple is needed to take its values out of the indexes and statistics
+    auto old = visitStore([&](auto &store) { return store.search(key); });
+    if (!old.has_value())
+        return false;
+
+    bool success = visitStore([&](auto &store) { return store.remove(key); });
     if (success) {
         T_PAGE.removeTuple();
-        if (m_btree->getRootPage() != og_root)
-            T_PAGE.setBtreePageID(m_btree->getRootPage());
+        m_numTuples--;
+        T_STATS.removeTuple(*old);
+        recordChange(key, old, std::nullopt);
+        for (const auto &index: m_indexes)
+            index.btree->remove((*old)[index.column], {key});
+        syncRootPages();
     }
     return success;
 }
 
+void Table::createIndex(u16 column, bool unique) {
+    const auto &types = T_VIEW.getTypes();
+    if (column == 0)
+        throw std::invalid_argument("Primary key is already indexed.");
+    if (column >= types.size())
+        throw std::invalid_argument("Column is out of range.");
+    if (hasIndex(column))
+        throw std::invalid_argument("Column is already indexed.");
+
+    // sorts the (value, key) pairs of the column, so the index is built by inserting in order
+    auto sortEntries = [&] {
+        ExternalSort sort(m_spill.getPager(), {types[column], types[0]}, {{0}});
+        visitStore([&](auto &store) {
+            store.forEach([&](const Vari &key, const Vec<Vari> &tuple) {
+                sort.add({tuple[column], key});
+            });
+        });
+        return sort.finish();
+    };
+
+    if (unique) {
+        auto entries = sortEntries();
+        std::optional<Vari> prev;
+        for (; entries->valid(); entries->next()) {
+            if (prev == entries->tuple()[0])
+                throw std::invalid_argument("Column contains duplicate values.");
+            prev = entries->tuple()[0];
+        }
+    }
+
+    degree_t deg = calculateDegree(types[column], Vec<Vari>{types[0]});
+    pgid_t btree_pg = m_pager.createNewPage<BtreeNodePage<Vec<Vari>>>(
+            deg, cts::PGID_INVALID, true, true
+    ).getPageID();
+    auto btree = std::make_unique<Btree<Vec<Vari>>>(btree_pg, m_pager, deg, false);
+
+    for (auto entries = sortEntries(); entries->valid(); entries->next())
+        btree->insert({entries->tuple()[1]}, entries->tuple()[0]);
+
+    T_PAGE.addIndex(column, unique, btree->getRootPage());
+    pgid_t root = btree->getRootPage();
+    m_indexes.push_back({column, unique, std::move(btree), root});
+}
+
+bool Table::hasIndex(u16 column) const {
+    if (column == 0)
+        return true;
+    for (const auto &index: m_indexes)
+        if (index.column == column) return true;
+    return false;
+}
+
+Vec<Vec<Vari>> Table::readTuplesBy(u16 column, const Vari &value) const {
+    if (column >= T_VIEW.getTypes().size())
+        throw std::invalid_argument("Column is out of range.");
+
+    if (variant_to_type_id(T_VIEW.getTypes()[column]) != variant_to_type_id(value))
+        throw std::runtime_error("Value is incorrect type.");
+
+    Vec<Vec<Vari>> res;
+    if (column == 0) {
+        if (auto tuple = readTuple(value))
+            res.push_back(std::move(*tuple));
+        return res;
+    }
+
+    for (const auto &index: m_indexes) {
+        if (index.column != column)
+            continue;
+        for (const auto &pk: index.btree->searchAll(value))
+            if (auto tuple = readTuple(pk[0]))
+                res.push_back(std::move(*tuple));
+        return res;
+    }
+
+    throw std::invalid_argument("Column is not indexed.");
+}
+
+void Table::checkScan(const Vec<Predicate> &predicates, const Vec<u16> &projection) const {
+    const auto &types = T_VIEW.getTypes();
+    for (const auto &predicate: predicates) {
+        if (predicate.column >= types.size())
+            throw std::invalid_argument("Predicate column is out of range.");
+        if (variant_to_type_id(predicate.value) != variant_to_type_id(types[predicate.column]))
+            throw std::runtime_error("Predicate value is incorrect type.");
+    }
+    for (u16 column: projection)
+        if (column >= types.size())
+            throw std::invalid_argument("Projected column is out of range.");
+}
+
+void Table::scan(const Vec<Predicate> &predicates, const Vec<u16> &projection,
+                 const ScanCallback &callback) const {
+    checkScan(predicates, projection);
+
+    visitStore([&](auto &store) {
+        store.forEach(scanVisitor(predicates, projection, std::cref(callback)));
+    });
+}
+
+std::optional<Vec<Vari>> Table::readTupleAt(const Vari &key, u64 snapshot) const {
+    if (variant_to_type_id(T_VIEW.getTypes()[0]) != variant_to_type_id(key))
+        throw std::runtime_error("Key is incorrect type.");
+
+    {
+        std::shared_lock lock(m_versionsMutex);
+        if (m_versions)
+            if (auto version = m_versions->find(key, snapshot))
+                return *version;
+    }
+    if (auto original = m_transactions.uncommitted(*this, key))
+        return *original;
+    return readChecked(key);
+}
+
+void Table::scanAt(u64 snapshot, const Vec<Predicate> &predicates, const Vec<u16> &projection,
+                   const ScanCallback &callback) const {
+    // keys changed after the snapshot, or by open transactions, are visited with the version it
+    // sees instead of their current tuple, merged into the scan where the store visits keys in order
+    std::map<Vari, VersionStore::Version> changed;
+    {
+        std::shared_lock lock(m_versionsMutex);
+        if (m_versions)
+            changed = m_versions->changedSince(snapshot);
+    }
+    for (auto &[key, before]: m_transactions.uncommitted(*this))
+        changed.try_emplace(key, std::move(before));
+    if (changed.empty()) {
+        scan(predicates, projection, callback);
+        return;
+    }
+    checkScan(predicates, projection);
+
+    auto visit = scanVisitor(predicates, projection, std::cref(callback));
+    auto next = changed.begin();
+    auto visitChangedBefore = [&](const Vari *key) {
+        for (; next != changed.end() && (!key || next->first < *key); ++next)
+            if (next->second)
+                visit(next->first, *next->second);
+    };
+
+    visitStore([&](auto &store) {
+        using Store = std::decay_t<decltype(store)>;
+        store.forEach([&](const Vari &key, const Vec<Vari> &tuple) {
+            if constexpr (!std::is_same_v<Store, HashIndex<Vec<Vari>>>)
+                visitChangedBefore(&key);
+            if (!changed.contains(key))
+                visit(key, tuple);
+        });
+    });
+    visitChangedBefore(nullptr);
+}
+
+void Table::vacuum() const {
+    {
+        std::unique_lock lock(m_versionsMutex);
+        if (!m_versions)
+            return;
+
+        if (auto oldest = m_snapshots.oldest()) {
+            m_versions->vacuum(*oldest);
+            if (m_versions->size() > 0) {
+                syncRootPages();
+                return;
+            }
+        }
+    }
+    dropVersions();
+}
+
+void Table::dropVersions() const {
+    std::unique_lock lock(m_versionsMutex);
+    if (!m_versions)
+        return;
+
+    // the store frees its pages once it goes out of scope, after the TablePage forgot it
+    auto versions = std::move(m_versions);
+    syncRootPages();
+}
+
+void Table::recordChange(const Vari &key, const VersionStore::Version &before,
+                         const VersionStore::Version &after) const {
+    m_transactions.logChange(*this, key, before, after);
+    // a transaction's changes are timestamped when it commits
+    if (!m_transactions.inTransaction())
+        keepVersion(key, m_snapshots.commit(), before);
+}
+
+void Table::keepVersion(const Vari &key, u64 commitTimestamp, const VersionStore::Version &before) const {
+    if (!m_snapshots.active())
+        return;
+
+    std::unique_lock lock(m_versionsMutex);
+    if (!m_versions)
+        m_versions = std::make_unique<VersionStore>(m_pager, T_VIEW.getTypes());
+    m_versions->add(key, commitTimestamp, before);
+    syncRootPages();
+}
+
+void Table::restoreTuple(const Vari &key, const std::optional<Vec<Vari>> &tuple) const {
+    auto current = readTuple(key);
+    if (current == tuple)
+        return;
+
+    if (!tuple)
+        deleteTuple(key);
+    else if (current)
+        updateTuple(*tuple);
+    else
+        insertTuple(*tuple);
+}
+
+void Table::flush() const {
+    visitStore([](auto &store) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(store)>, LsmTree>)
+            store.flush();
+    });
+}
+
+Ptr<TupleCursor> Table::sortedCursor(u16 column) const {
+    if (column >= T_VIEW.getTypes().size())
+        throw std::invalid_argument("Sorted column is out of range.");
+
+    return visitStore([&](auto &store) -> Ptr<TupleCursor> {
+        using Store = std::decay_t<decltype(store)>;
+        if constexpr (std::is_same_v<Store, Btree<Vec<Vari>>>)
+            if (column == 0)
+                return std::make_unique<BtreeCursor>(store.cursor());
+
+        ExternalSort sort(m_spill.getPager(), T_VIEW.getTypes(), {{column}});
+        store.forEach([&](const Vari &, const Vec<Vari> &tuple) {
+            sort.add(tuple);
+        });
+        return sort.finish();
+    });
+}
+
+void Table::scanSorted(const Vec<SortKey> &orderBy, const ScanCallback &callback, size_t memoryBudget) const {
+    ExternalSort sort(m_spill.getPager(), T_VIEW.getTypes(), orderBy, memoryBudget);
+    visitStore([&](auto &store) {
+        store.forEach([&](const Vari &, const Vec<Vari> &tuple) {
+            sort.add(tuple);
+        });
+    });
+
+    for (auto cursor = sort.finish(); cursor->valid(); cursor->next())
+        callback(cursor->tuple());
+}
+
+Vec<Vec<Vari>> Table::query(const Query &query) const {
+    VectorExecutor executor(T_VIEW.getTypes(), query);
+
+    visitStore([&](auto &store) {
+        store.forEach([&](const Vari &, const Vec<Vari> &tuple) {
+            executor.addRow(tuple);
+        });
+    });
+    return executor.finish();
+}
+
+void Table::parallelScan(const Vec<Predicate> &predicates, const Vec<u16> &projection,
+                         const ScanCallback &callback, ThreadPool &pool) const {
+    checkScan(predicates, projection);
+
+    std::mutex callback_mutex;
+    auto emit = [&](const Vec<Vari> &row) {
+        std::lock_guard lock(callback_mutex);
+        callback(row);
+    };
+
+    visitStore([&](auto &store) {
+        using Store = std::decay_t<decltype(store)>;
+        if constexpr (std::is_same_v<Store, Btree<Vec<Vari>>>) {
+            // a few subtrees per thread lets work stealing even out subtrees of different sizes
+            auto partition = store.partition(pool.getNumThreads() * 4);
+            u32 depth = partition.first;
+            pool.submit([&, depth] {
+                store.forEachAbove(depth, scanVisitor(predicates, projection, emit));
+            });
+            for (pgid_t subtree: partition.second)
+                pool.submit([&, subtree] {
+                    store.forEachInSubtree(subtree, scanVisitor(predicates, projection, emit));
+                });
+        } else if constexpr (std::is_same_v<Store, HashIndex<Vec<Vari>>>) {
+            for (pgid_t bucket: store.getBuckets())
+                pool.submit([&, bucket] {
+                    store.forEachInBucket(bucket, scanVisitor(predicates, projection, emit));
+                });
+        } else {
+            // LSM runs are read outside the page cache and merged through a single cursor
+            store.forEach(scanVisitor(predicates, projection, emit));
+        }
+    });
+
+    pool.wait();
+}
+
+void Table::createBloomFilter(double falsePositiveRate, u64 expectedTuples) {
+    if (!(falsePositiveRate > 0 && falsePositiveRate < 1))
+        throw std::invalid_argument("False-positive rate must be between 0 and 1.");
+    if (m_bloom)
+        throw std::invalid_argument("Table already has a bloom filter.");
+
+    // small filters would otherwise be rebuilt on nearly every insert
+    u64 capacity = std::max({expectedTuples, m_numTuples, u64(1024)});
+    m_bloom = std::make_unique<Bloom>(buildBloom(capacity, BloomFilter::bitsPerKeyFor(falsePositiveRate)));
+}
+
+bool Table::hasBloomFilter() const {
+    return m_bloom != nullptr;
+}
+
+Table::Bloom Table::buildBloom(u64 capacity, double bitsPerKey) const {
+    Bloom bloom{BloomFilter(capacity, bitsPerKey), {}, capacity, bitsPerKey};
+    visitStore([&](auto &store) {
+        store.forEach([&](const Vari &key, const Vec<Vari> &) {
+            bloom.filter.add(db_hash(key));
+        });
+    });
+
+    // pages are created back to front so each one can point to the next
+    const auto &words = bloom.filter.getWords();
+    size_t per_page = BloomPage::getMaxWords();
+    bloom.pageIDs.resize((words.size() + per_page - 1) / per_page);
+    pgid_t next = cts::PGID_INVALID;
+    for (size_t i = bloom.pageIDs.size(); i-- > 0;) {
+        Vec<u64> slice(words.begin() + i * per_page, words.begin() + std::min(words.size(), (i + 1) * per_page));
+        next = m_pager.createNewPage<BloomPage>(std::move(slice), next).getPageID();
+        bloom.pageIDs[i] = next;
+    }
+
+    T_PAGE.setBloom({bloom.pageIDs[0], capacity, bitsPerKey});
+    return bloom;
+}
+
+void Table::addToBloom(const Vari &key) const {
+    if (!m_bloom)
+        return;
+
+    if (m_numTuples > m_bloom->capacity) {
+        // a filter holding more keys than it was sized for loses its accuracy, so start over at
+        // double the size. this also clears the bits of deleted keys.
+        for (pgid_t pg: m_bloom->pageIDs)
+            m_pager.freePage(pg);
+        *m_bloom = buildBloom(m_bloom->capacity * 2, m_bloom->bitsPerKey);
+        return;
+    }
+
+    size_t per_page = BloomPage::getMaxWords();
+    m_bloom->filter.add(db_hash(key), [&](size_t idx) {
+        m_pager.getPage<BloomPage>(m_bloom->pageIDs[idx / per_page]).setWord(
+                idx % per_page, m_bloom->filter.getWords()[idx]);
+    });
+}
+
+bool Table::mayContain(const Vari &key) const {
+    return !m_bloom || m_bloom->filter.mayContain(db_hash(key));
+}
+
+string Table::lsmBasePath() const {
+    return string(m_pager.getFileName()) + ".lsm" + std::to_string(m_tablePageID);
+}
+
+void Table::syncRootPages() const {
+    pgid_t root = visitStore([](auto &store) { return store.getRootPage(); });
+    if (root != m_rootPageID) {
+        T_PAGE.setBtreePageID(root);
+        m_rootPageID = root;
+    }
+
+    for (const auto &index: m_indexes)
+        if (index.btree->getRootPage() != index.rootPageID) {
+            index.rootPageID = index.btree->getRootPage();
+            T_PAGE.setIndexBtreePageID(index.column, index.rootPageID);
+        }
+
+    pgid_t versions = m_versions ? m_versions->getRootPage() : cts::PGID_INVALID;
+    if (versions != m_versionsPageID) {
+        T_PAGE.setVersionsPageID(versions);
+        m_versionsPageID = versions;
+    }
+}
+
 } // namespace backend
\ No newline at end of file
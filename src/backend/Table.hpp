@@ -6,40 +6,155 @@
 #define KNDB_TABLE_HPP
 
 #include "Pager.hpp"
+#include "BloomFilter.hpp"
 #include "Btree.hpp"
+#include "ExternalSort.hpp"
+#include "HashIndex.hpp"
+#include "Join.hpp"
+#include "LsmTree.hpp"
+#include "Predicate.hpp"
+#include "SnapshotManager.hpp"
+#include "SpillFile.hpp"
+#include "ThreadPool.hpp"
+#include "TransactionManager.hpp"
+#include "VectorExecutor.hpp"
+#include "VersionStore.hpp"
 #include "kndb_types.hpp"
+#include <functional>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <variant>
 
 namespace backend {
 
+class Table;
+
+/**
+ * @class PreparedInsert
+ * @brief Inserts tuples into one table, with the table's schema resolved once when prepared.
+ *
+ * Tuples are type checked against a plan built from the schema, which compares the variant index
+ * of each value instead of reading the column types from the TablePage on every call. A prepared
+ * insert is invalidated when its table is dropped.
+ */
+class PreparedInsert {
+public:
+    /**
+     * @brief Inserts a tuple, like Table::insertTuple().
+     * @param values The values to insert as a tuple.
+     * @return true if insertion was successful, false if key already exists.
+     * @throws std::runtime_error if tuple has incorrect number of values or incorrect types.
+     */
+    bool execute(const Vec<Vari> &values) const;
+
+private:
+    friend class Table;
+
+    PreparedInsert(const Table &table, Vec<size_t> plan) : m_table(&table), m_plan(std::move(plan)) {}
+
+    const Table *m_table;
+    Vec<size_t> m_plan; // variant index of each column's type
+};
+
+/**
+ * @class PreparedLookup
+ * @brief Reads tuples of one table by primary key, with the key type resolved once when prepared.
+ *
+ * A prepared lookup is invalidated when its table is dropped.
+ */
+class PreparedLookup {
+public:
+    /**
+     * @brief Reads a tuple, like Table::readTuple().
+     * @param key The key to look up.
+     * @return Optional tuple values, or std::nullopt if key not found.
+     * @throws std::runtime_error if key has incorrect type.
+     */
+    std::optional<Vec<Vari>> execute(const Vari &key) const;
+
+private:
+    friend class Table;
+
+    PreparedLookup(const Table &table, size_t keyIndex) : m_table(&table), m_keyIndex(keyIndex) {}
+
+    const Table *m_table;
+    size_t m_keyIndex; // variant index of the key's type
+};
+
 /**
  * @class Table
  * @brief Represents a table in the database.
  *
- * Manages tuple storage and retrieval using a B-tree for indexing.
- * Provides CRUD (Create, Read, Update, Delete) operations on tuples.
+ * Manages tuple storage and retrieval using a B-tree (or, if chosen at creation, a hash index
+ * or an LSM tree) keyed on the first column. Provides CRUD (Create, Read, Update, Delete) operations on tuples.
+ *
+ * Columns other than the primary key can be given secondary indexes, which are B-trees mapping
+ * the column value to the primary key of every tuple holding that value. Secondary indexes are
+ * maintained on every insert, update and delete.
+ *
+ * A table can also be given a bloom filter over its primary keys, which answers lookups, updates
+ * and deletes of keys that are not in the table without searching the storage structure.
+ *
+ * Every table keeps a StatsPage of aggregates (key bounds, column sums and distinct counts), which
+ * is updated along with each insert, update and delete so that getStats() need not read the tuples.
+ *
+ * Every insert, update and delete is reported to the TransactionManager, which locks the row for
+ * the current transaction and logs the change before and after it is made.
  */
 class Table {
 public:
+    /**
+     * Receives the tuples produced by a scan. The tuple is only valid during the call.
+     */
+    using ScanCallback = std::function<void(const Vec<Vari> &)>;
+
+    /**
+     * Aggregates over all of a table's tuples, as returned by getStats().
+     */
+    struct Stats {
+        u64 numTuples;
+        std::optional<Vari> minKey; ///< Smallest primary key, or std::nullopt if the table is empty.
+        std::optional<Vari> maxKey; ///< Largest primary key, or std::nullopt if the table is empty.
+        Vec<double> sums;           ///< Sum of each column as double. 0 for string columns.
+        Vec<u64> distinct;          ///< Number of distinct values of each column. Estimated, except for the key.
+    };
+
     /**
      * @brief Constructs a Table from an existing TablePage.
      * @param name The name of the table.
      * @param pgr Reference to the Pager.
+     * @param snapshots Hands out commit timestamps to the table's changes and tracks open snapshots.
+     * @param transactions Logs the table's changes and locks the rows they touch.
+     * @param spill The file that sorts of the table's tuples spill to.
      * @param tablePageId Page ID of the table's metadata page.
+     * @note Frees the version store a crash left behind, unless the Pager is read-only.
      */
-    Table(string name, Pager &pgr, pgid_t tablePageId);
+    Table(string name, Pager &pgr, SnapshotManager &snapshots, TransactionManager &transactions, SpillFile &spill,
+          pgid_t tablePageId);
 
     /**
      * @brief Constructs a new Table.
      * @param name The name of the table.
      * @param pgr Reference to the Pager.
+     * @param snapshots Hands out commit timestamps to the table's changes and tracks open snapshots.
+     * @param transactions Logs the table's changes and locks the rows they touch.
+     * @param spill The file that sorts of the table's tuples spill to.
      * @param types A list of types that the table tuples will contain.
+     * @param engine The structure used to store the table's tuples.
      */
-    Table(string name, Pager &pgr, const Vec<Vari> &types);
+    Table(string name, Pager &pgr, SnapshotManager &snapshots, TransactionManager &transactions, SpillFile &spill,
+          const Vec<Vari> &types, TableEngine engine = TableEngine::BTREE);
 
     /**
-     * @brief Deletes the table and all associated data, including any Btree Nodes used to store
-     * the data.
+     * @brief Frees the table's version store, if it has one.
+     */
+    ~Table();
+
+    /**
+     * @brief Deletes the table and all associated data: the pages of its tuples, secondary
+     * indexes, bloom filter, statistics, version store and TablePage, or the files of its LSM
+     * tree. The table must not be used after.
      */
     void drop();
 
@@ -47,7 +162,7 @@ public:
      * @brief Retrieves the table name.
      * @return The name of the table.
      */
-    string getName() const;
+    const string &getName() const;
 
     /**
      * @brief Retrieves the number of tuples in the table.
@@ -91,22 +206,383 @@ public:
      */
     bool deleteTuple(const Vari &key) const;
 
+    /**
+     * @brief Inserts a tuple, like insertTuple(), while other threads insert or read tuples with
+     * the concurrent operations.
+     *
+     * The tuple is inserted with Btree::concurrentInsert(), after which the table's count, stats,
+     * log and snapshot versions are updated under a lock. No other operation may run on the table
+     * meanwhile.
+     * @param values The values to insert as a tuple.
+     * @return true if insertion was successful, false if key already exists.
+     * @throws std::runtime_error if the table is not stored in a B-tree, has secondary indexes or a
+     * bloom filter, if a transaction is open, or if the tuple has incorrect number of values or
+     * incorrect types.
+     */
+    bool concurrentInsertTuple(const Vec<Vari> &values) const;
+
+    /**
+     * @brief Reads a tuple, like readTuple(), while other threads insert or read tuples with the
+     * concurrent operations.
+     * @param key The key to look up.
+     * @return Optional tuple values, or std::nullopt if key not found.
+     * @throws std::runtime_error if the table is not stored in a B-tree, or if key has incorrect
+     * type.
+     */
+    std::optional<Vec<Vari>> concurrentReadTuple(const Vari &key) const;
+
+    /**
+     * @brief Retrieves the table's aggregates without reading its tuples.
+     *
+     * The key bounds are recomputed after the smallest or largest key was deleted, which takes
+     * one root-to-leaf path per bound in B-tree tables and a scan in others. Distinct counts are
+     * estimated with HyperLogLog sketches to within a few percent, and values that were deleted
+     * may still be counted.
+     * @return The aggregates.
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief Counts the tuples whose primary key lies in a range.
+     *
+     * B-tree tables answer from the subtree counts in their nodes, reading one root-to-leaf path
+     * per bound. Other tables are scanned.
+     * @param lo The smallest key to count.
+     * @param hi The largest key to count.
+     * @return The number of tuples with lo <= key <= hi.
+     * @throws std::runtime_error if a key has incorrect type.
+     */
+    u64 countRange(const Vari &lo, const Vari &hi) const;
+
+    /**
+     * @brief Counts the tuples whose primary key is smaller than a key.
+     * @param key The key to rank. It does not need to be in the table.
+     * @return The position the key has (or would have) in key order.
+     * @throws std::runtime_error if key has incorrect type.
+     */
+    u64 rank(const Vari &key) const;
+
+    /**
+     * @brief Reads the tuple at a position in primary key order.
+     * @param rank The position, starting from 0.
+     * @return The tuple, or std::nullopt if the table has no more than rank tuples.
+     */
+    std::optional<Vec<Vari>> selectByRank(u64 rank) const;
+
+    /**
+     * @brief Reads consecutive tuples in primary key order, e.g. one page of a paginated result.
+     *
+     * B-tree tables skip straight to the first tuple using their subtree counts. Other tables are
+     * sorted by key and skipped through.
+     * @param rank The position of the first tuple, starting from 0.
+     * @param limit The maximum number of tuples to read.
+     * @return The tuples at positions rank to rank + limit - 1 that exist.
+     */
+    Vec<Vec<Vari>> readTuplesFrom(u64 rank, u64 limit) const;
+
     /**
      * @brief Retrieves the column types of the table.
      * @return A list containing the types of each column.
      */
     Vec<Vari> getTypes() const;
 
+    /**
+     * @brief Prepares an insert for repeated use, resolving the table's schema once.
+     * @return The prepared insert. Valid until the table is dropped.
+     */
+    PreparedInsert prepareInsert() const;
+
+    /**
+     * @brief Prepares a primary key lookup for repeated use, resolving the key type once.
+     * @return The prepared lookup. Valid until the table is dropped.
+     */
+    PreparedLookup prepareLookup() const;
+
+    /**
+     * @brief Builds a secondary index on a column from the tuples currently in the table. The
+     * tuples are sorted by the column first, so the index's B-tree is filled in key order.
+     * @param column The column to index.
+     * @param unique Whether the index should reject tuples with duplicate values in the column.
+     *
+     * @throws std::invalid_argument if the column is the primary key, out of range or already
+     * indexed, or if a unique index is requested on a column that already contains duplicates.
+     */
+    void createIndex(u16 column, bool unique);
+
+    /**
+     * @brief Checks whether a column can be looked up through an index.
+     * @param column The column to check.
+     * @return true if the column is the primary key or has a secondary index.
+     */
+    bool hasIndex(u16 column) const;
+
+    /**
+     * @brief Reads every tuple whose value in a column equals the given value.
+     * @param column The column to look up. Must be the primary key or have a secondary index.
+     * @param value The value to look up.
+     * @return The matching tuples.
+     * @throws std::runtime_error if value has incorrect type.
+     * @throws std::invalid_argument if the column is out of range or not indexed.
+     */
+    Vec<Vec<Vari>> readTuplesBy(u16 column, const Vari &value) const;
+
+    /**
+     * @brief Visits every tuple of the table that satisfies all predicates.
+     * @param predicates Conditions that a tuple must all satisfy to be visited. Each is evaluated
+     * on the tuple in place, so tuples that fail are never copied.
+     * @param projection The columns to pass to the callback, in order. If empty, every column is
+     * passed.
+     * @param callback Invoked once per matching tuple, with only the projected columns. Tuples are
+     * visited in key order, except in hash tables. The callback must not modify the table.
+     *
+     * @throws std::invalid_argument if a predicate or projected column is out of range.
+     * @throws std::runtime_error if a predicate's value has incorrect type.
+     */
+    void scan(const Vec<Predicate> &predicates, const Vec<u16> &projection, const ScanCallback &callback) const;
+
+    /**
+     * @brief Visits every tuple of the table in the order of some of its columns.
+     * @param orderBy The columns to order by, most significant first. Tuples that are equal in
+     * all of them are visited in key order, except in hash tables.
+     * @param callback Invoked once per tuple. The callback must not modify the table.
+     * @param memoryBudget Approximate number of bytes the sort may hold in memory. Tuples beyond
+     * it are sorted in runs on temporary pages, which are merged and freed afterwards.
+     *
+     * @throws std::invalid_argument if an orderBy column is out of range.
+     */
+    void scanSorted(const Vec<SortKey> &orderBy, const ScanCallback &callback,
+                    size_t memoryBudget = ExternalSort::DEFAULT_MEMORY_BUDGET) const;
+
+    /**
+     * @brief Visits every tuple of the table that satisfies all predicates, using several threads.
+     *
+     * B-trees are split into subtrees along the separator keys of their upper levels, and hash
+     * tables into their buckets. Each part is filtered and projected as a separate task on the
+     * pool, whose idle threads steal tasks from busy ones. LSM tables are scanned on the calling
+     * thread.
+     * @param predicates Conditions that a tuple must all satisfy to be visited.
+     * @param projection The columns to pass to the callback, in order. If empty, every column is
+     * passed.
+     * @param callback Invoked once per matching tuple, in no particular order. Calls are made from
+     * the pool's threads but never overlap. The callback must not modify the table.
+     * @param pool The threads to scan with.
+     *
+     * @throws std::invalid_argument if a predicate or projected column is out of range.
+     * @throws std::runtime_error if a predicate's value has incorrect type.
+     */
+    void parallelScan(const Vec<Predicate> &predicates, const Vec<u16> &projection, const ScanCallback &callback,
+                      ThreadPool &pool) const;
+
+    /**
+     * @brief Gets a cursor over the table's tuples in ascending order of a column.
+     *
+     * B-tree tables are streamed straight from their nodes when ordered by their key. Otherwise,
+     * the tuples are sorted with an ExternalSort, which spills them to temporary pages if needed.
+     * @param column The column to order by.
+     * @return The cursor. The table must not be modified while it is in use.
+     *
+     * @throws std::invalid_argument if the column is out of range.
+     */
+    Ptr<TupleCursor> sortedCursor(u16 column) const;
+
+    /**
+     * @brief Reads a tuple as it was when a snapshot was taken.
+     * @param key The key to look up.
+     * @param snapshot The snapshot's timestamp.
+     * @return Optional tuple values, or std::nullopt if the key had no tuple at the time.
+     * @throws std::runtime_error if key has incorrect type.
+     */
+    std::optional<Vec<Vari>> readTupleAt(const Vari &key, u64 snapshot) const;
+
+    /**
+     * @brief Same as scan(), but visits the tuples as they were when a snapshot was taken.
+     * @param snapshot The snapshot's timestamp.
+     * @param predicates Conditions that a tuple must all satisfy.
+     * @param projection The columns to return, in order. If empty, every column is returned.
+     * @param callback Invoked once per matching tuple, in key order (except for hash tables). It
+     * must not modify the table.
+     */
+    void scanAt(u64 snapshot, const Vec<Predicate> &predicates, const Vec<u16> &projection,
+                const ScanCallback &callback) const;
+
+    /**
+     * @brief Removes the versions of tuples that were kept for snapshots but that no open snapshot
+     * sees anymore, freeing their pages.
+     */
+    void vacuum() const;
+
+    /**
+     * @brief Sets the tuple under a key, inserting, updating or deleting it as needed. Used to undo
+     * and redo logged changes.
+     * @param key The key of the tuple.
+     * @param tuple The tuple to store under the key, or std::nullopt to delete it.
+     * @throws std::runtime_error if the key or tuple has incorrect types.
+     */
+    void restoreTuple(const Vari &key, const std::optional<Vec<Vari>> &tuple) const;
+
+    /**
+     * @brief Keeps the tuple a committed change replaced, for the snapshots older than the change.
+     * Called by the TransactionManager when a transaction commits.
+     * @param key The key of the tuple.
+     * @param commitTimestamp The commit timestamp of the change.
+     * @param before The tuple before the change, or std::nullopt if it inserted the key.
+     */
+    void keepVersion(const Vari &key, u64 commitTimestamp, const VersionStore::Version &before) const;
+
+    /**
+     * @brief Writes out the tuples an LSM table still buffers in memory, so that every change made
+     * so far is stored in files. Does nothing for other tables, whose pages are written by the Pager.
+     */
+    void flush() const;
+
+    /**
+     * @brief Evaluates a query over the table with a VectorExecutor, which decodes the tuples into
+     * batches of typed columns and filters and aggregates each batch column by column.
+     * @param query The query to evaluate.
+     * @return The query's result rows. Projected rows are in key order, except in hash tables.
+     *
+     * @throws std::invalid_argument if a column is out of range, if select is combined with
+     * aggregates or groupBy, or if SUM or AVG is applied to a string column.
+     * @throws std::runtime_error if a predicate's value has incorrect type.
+     */
+    Vec<Vec<Vari>> query(const Query &query) const;
+
+    /**
+     * @brief Builds a bloom filter over the primary keys currently in the table. The filter is
+     * maintained on every insert, and rebuilt at double the capacity whenever the table outgrows it.
+     * @param falsePositiveRate The fraction of lookups of missing keys that still search the
+     * storage structure. Lower rates use more memory: about 10 bits per key for 1%.
+     * @param expectedTuples Number of tuples the filter is initially sized for. The table's
+     * current size is used if it is larger.
+     *
+     * @throws std::invalid_argument if the rate is not between 0 and 1 (exclusive), or if the
+     * table already has a bloom filter.
+     */
+    void createBloomFilter(double falsePositiveRate, u64 expectedTuples);
+
+    /**
+     * @return true if the table has a bloom filter over its primary keys.
+     */
+    bool hasBloomFilter() const;
+
     /**
      * Get the Table PageID.
      * @return The ID of the page that stores metadata about the table.
      */
     pgid_t getTablePageID() const;
 
+    /**
+     * @return The structure used to store the table's tuples.
+     */
+    TableEngine getEngine() const;
+
 private:
+    friend class PreparedInsert;
+    friend class PreparedLookup;
+
+    struct SecondaryIndex {
+        u16 column;
+        bool unique;
+        std::unique_ptr<Btree<Vec<Vari>>> btree;
+        mutable pgid_t rootPageID; // the root page recorded in the TablePage
+    };
+
+    struct Bloom {
+        BloomFilter filter;
+        Vec<pgid_t> pageIDs; // BloomPages holding the filter's words, in order
+        u64 capacity;        // as recorded in the TablePage
+        double bitsPerKey;
+    };
+
+    using Store = std::variant<std::unique_ptr<Btree<Vec<Vari>>>, std::unique_ptr<HashIndex<Vec<Vari>>>,
+            std::unique_ptr<LsmTree>>;
+
+    // inserts a tuple whose types were already checked.
+    bool insertChecked(const Vec<Vari> &values) const;
+
+    // reads a tuple by a key whose type was already checked.
+    std::optional<Vec<Vari>> readChecked(const Vari &key) const;
+
+    // logs a change of the tuple under a key and, if made outside of a transaction, keeps the tuple
+    // it replaces (std::nullopt for an insert) if a snapshot may still see it.
+    void recordChange(const Vari &key, const VersionStore::Version &before, const VersionStore::Version &after) const;
+
+    // throws if a scan's predicates or projection don't fit the table's columns.
+    void checkScan(const Vec<Predicate> &predicates, const Vec<u16> &projection) const;
+
+    // returns a callable for forEach() that filters and projects tuples, then passes them to emit.
+    template<typename Emit>
+    static auto scanVisitor(const Vec<Predicate> &predicates, const Vec<u16> &projection, Emit emit) {
+        return [&predicates, &projection, emit = std::move(emit), row = Vec<Vari>()](
+                const Vari &, const Vec<Vari> &tuple) mutable {
+            for (const auto &predicate: predicates)
+                if (!predicate.matches(tuple)) return;
+
+            if (projection.empty()) {
+                emit(tuple);
+                return;
+            }
+
+            row.clear();
+            for (u16 column: projection)
+                row.push_back(tuple[column]);
+            emit(row);
+        };
+    }
+
+    // returns the B-tree of the table for the concurrent operations.
+    Btree<Vec<Vari>> &concurrentStore() const;
+
+    // applies fn to whichever structure stores the table's tuples.
+    template<typename Fn>
+    decltype(auto) visitStore(Fn &&fn) const {
+        return std::visit([&fn](auto &store) -> decltype(auto) { return fn(*store); }, m_store);
+    }
+
+    // builds a bloom filter of every key in the table, writes it to new BloomPages and records it
+    // in the TablePage.
+    Bloom buildBloom(u64 capacity, double bitsPerKey) const;
+
+    // adds a newly inserted key to the bloom filter, if the table has one.
+    void addToBloom(const Vari &key) const;
+
+    // returns false if the key is definitely not in the table.
+    bool mayContain(const Vari &key) const;
+
+    // returns a cursor on the tuple at a position in key order.
+    Ptr<TupleCursor> cursorAtRank(u64 rank) const;
+
+    // prefix of the names of the files of an LSM table.
+    string lsmBasePath() const;
+
+    // writes the root pages of the primary and secondary indexes and of the version store back to
+    // the TablePage if changed. compares them with the copies kept in the table, so the TablePage
+    // is only fetched to write.
+    void syncRootPages() const;
+
+    // frees the version store, after recording in the TablePage that the table has none, so that
+    // it never points at pages that were freed and reused.
+    void dropVersions() const;
+
     Pager &m_pager;
-    std::unique_ptr<Btree<Vec<Vari>>> m_btree;
+    SnapshotManager &m_snapshots;
+    TransactionManager &m_transactions;
+    SpillFile &m_spill;
+    mutable Ptr<VersionStore> m_versions; // created by the first change committed while a snapshot is open
+    // taken shared by snapshot reads of m_versions and exclusively by changes to it
+    mutable std::shared_mutex m_versionsMutex;
+    Store m_store;
+    // serializes the bookkeeping of concurrent inserts
+    mutable std::mutex m_concurrentMutex;
+    Vec<SecondaryIndex> m_indexes;
+    std::unique_ptr<Bloom> m_bloom;
+    // copies of the TablePage's tuple count and root pages, which change far more often than it
+    // is read, so changes don't fetch the TablePage just to look at them
+    mutable u64 m_numTuples = 0;
+    mutable pgid_t m_rootPageID = cts::PGID_INVALID;
+    mutable pgid_t m_versionsPageID = cts::PGID_INVALID;
     pgid_t m_tablePageID;
+    pgid_t m_statsPageID;
     string m_name;
 };
 
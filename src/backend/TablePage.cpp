@@ -38,11 +38,40 @@ TablePage::TablePage(std::span<const byte> bytes, pgid_t pageID) : Page(pageID)
     // deserialize numTuples
     db_deserialize(m_numTuples, bytes, offset);
 
+    // deserialize storage engine
+    db_deserialize(m_engine, bytes, offset);
+
+    // deserialize bloom filter
+    db_deserialize(m_bloom.pageID, bytes, offset);
+    db_deserialize(m_bloom.capacity, bytes, offset);
+    db_deserialize(m_bloom.bitsPerKey, bytes, offset);
+
+    // deserialize stats page id
+    db_deserialize(m_statsPageID, bytes, offset);
+
+    // deserialize version store page id
+    db_deserialize(m_versionsPageID, bytes, offset);
+
+    // deserialize secondary indexes
+    u8 num_indexes;
+    db_deserialize(num_indexes, bytes, offset);
+    m_indexes.resize(num_indexes);
+    for (auto &index: m_indexes) {
+        db_deserialize(index.column, bytes, offset);
+        db_deserialize(index.unique, bytes, offset);
+        db_deserialize(index.btreePageID, bytes, offset);
+    }
+
     ASSUME_S(offset <= cts::PG_SZ, "Offset is out of bounds");
 }
 
 TablePage::TablePage(const Vec<Vari> &types, pgid_t btreePageID, pgid_t pageID)
-        : Page(pageID), m_types(types), m_btreePageID(btreePageID), m_numTuples(0) {
+        : TablePage(types, btreePageID, TableEngine::BTREE, pageID) {
+}
+
+TablePage::TablePage(const Vec<Vari> &types, pgid_t btreePageID, TableEngine engine, pgid_t pageID)
+        : Page(pageID), m_types(types), m_btreePageID(btreePageID), m_numTuples(0), m_engine(engine),
+          m_bloom{cts::PGID_INVALID, 0, 0}, m_statsPageID(cts::PGID_INVALID), m_versionsPageID(cts::PGID_INVALID) {
     ASSUME_S(!types.empty(), "There cannot be 0 types in a TablePage");
     ASSUME_S(types.size() <= (cts::PG_SZ - 100) / db_sizeof<typeid_t>(), "TablePage cannot support that many types");
 }
@@ -55,7 +84,11 @@ void TablePage::setBtreePageID(pgid_t btreePageID) {
     m_btreePageID = btreePageID;
 }
 
-const Vec<Vari> &TablePage::getTypes() {
+TableEngine TablePage::getEngine() const {
+    return m_engine;
+}
+
+const Vec<Vari> &TablePage::getTypes() const {
     return m_types;
 }
 
@@ -73,6 +106,62 @@ void TablePage::removeTuple() {
     m_numTuples--;
 }
 
+const Vec<TablePage::IndexInfo> &TablePage::getIndexes() const {
+    return m_indexes;
+}
+
+void TablePage::addIndex(u16 column, bool unique, pgid_t btreePageID) {
+    ASSUME_S(column < m_types.size(), "Column is out of range");
+    ASSUME_S(m_indexes.size() < cts::U8_INVALID, "Table cannot support that many indexes");
+    ASSUME_S(db_sizeof<pgtypeid_t>() + db_sizeof<u16>() + m_types.size() * db_sizeof<typeid_t>() +
+             db_sizeof<pgid_t>() + db_sizeof<u64>() + db_sizeof<TableEngine>() +
+             db_sizeof<pgid_t>() + db_sizeof<u64>() + db_sizeof<double>() + db_sizeof<pgid_t>() + db_sizeof<pgid_t>() + db_sizeof<u8>() +
+             (m_indexes.size() + 1) * (db_sizeof<u16>() + db_sizeof<bool>() + db_sizeof<pgid_t>()) <= cts::PG_SZ,
+             "There is not enough space in this page to add another index");
+    ASSUME({
+        for (const auto &index: m_indexes)
+            if (index.column == column) return false;
+        return true;
+    }, "Column is already indexed");
+
+    m_indexes.push_back({column, unique, btreePageID});
+}
+
+void TablePage::setIndexBtreePageID(u16 column, pgid_t btreePageID) {
+    for (auto &index: m_indexes) {
+        if (index.column == column) {
+            index.btreePageID = btreePageID;
+            return;
+        }
+    }
+
+    ASSUME_S(false, "Column is not indexed");
+}
+
+const TablePage::BloomInfo &TablePage::getBloom() const {
+    return m_bloom;
+}
+
+void TablePage::setBloom(const BloomInfo &bloom) {
+    m_bloom = bloom;
+}
+
+pgid_t TablePage::getStatsPageID() const {
+    return m_statsPageID;
+}
+
+void TablePage::setStatsPageID(pgid_t statsPageID) {
+    m_statsPageID = statsPageID;
+}
+
+pgid_t TablePage::getVersionsPageID() const {
+    return m_versionsPageID;
+}
+
+void TablePage::setVersionsPageID(pgid_t versionsPageID) {
+    m_versionsPageID = versionsPageID;
+}
+
 void TablePage::toBytes(std::span<byte> buf) {
     ASSUME_S(buf.size() == cts::PG_SZ, "Buffer is incorrectly sized");
     offset_t offset = 0;
@@ -97,6 +186,29 @@ void TablePage::toBytes(std::span<byte> buf) {
     // serialize num tuples
     db_serialize(m_numTuples, buf, offset);
 
+    // serialize storage engine
+    db_serialize(m_engine, buf, offset);
+
+    // serialize bloom filter
+    db_serialize(m_bloom.pageID, buf, offset);
+    db_serialize(m_bloom.capacity, buf, offset);
+    db_serialize(m_bloom.bitsPerKey, buf, offset);
+
+    // serialize stats page id
+    db_serialize(m_statsPageID, buf, offset);
+
+    // serialize version store page id
+    db_serialize(m_versionsPageID, buf, offset);
+
+    // serialize secondary indexes
+    u8 numIndexes = m_indexes.size();
+    db_serialize(numIndexes, buf, offset);
+    for (const auto &index: m_indexes) {
+        db_serialize(index.column, buf, offset);
+        db_serialize(index.unique, buf, offset);
+        db_serialize(index.btreePageID, buf, offset);
+    }
+
     ASSUME_S(offset <= cts::PG_SZ, "Offset is out of bounds");
 }
 
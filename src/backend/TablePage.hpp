@@ -13,10 +13,29 @@ namespace backend {
 /**
  * @class TablePage
  * @brief Representation of an on-disk page that contains metadata for a table such as the types
- * and number of tuples in the table.
+ * and number of tuples in the table, as well as the secondary indexes, bloom filter and statistics
+ * built on it.
  */
 class TablePage : public Page {
 public:
+    /**
+     * Metadata of a secondary index on one of the table's columns.
+     */
+    struct IndexInfo {
+        u16 column;
+        bool unique;
+        pgid_t btreePageID;
+    };
+
+    /**
+     * Metadata of the bloom filter on the table's primary keys.
+     */
+    struct BloomInfo {
+        pgid_t pageID;     ///< First page of the filter's words, or PGID_INVALID if there is none.
+        u64 capacity;      ///< Number of keys the filter is sized for.
+        double bitsPerKey; ///< Number of filter bits per key of capacity.
+    };
+
     /**
      * Loads a TablePage from a byte vector.
      * @param bytes The byte vector containing table data.
@@ -35,17 +54,33 @@ public:
      */
     TablePage(const Vec<Vari> &types, pgid_t btreePageID, pgid_t pageID);
 
+    /**
+     * Creates an empty TablePage for a table stored with a specific engine.
+     * @param types List of types that this table contains.
+     * @param btreePageID The root pageID of the structure that stores this table's data.
+     * @param engine The storage engine used for the table's data.
+     * @param pageID The on-disk page number of this table page.
+     * @note Program terminates if list of types is empty or too long.
+     */
+    TablePage(const Vec<Vari> &types, pgid_t btreePageID, TableEngine engine, pgid_t pageID);
+
     /**
      * Get the types that this table stores.
      * @return A list of all the types.
      */
-    const Vec<Vari> &getTypes();
+    const Vec<Vari> &getTypes() const;
 
     /**
-     * @return The pageID of the root node that contains the data for this table.
+     * @return The pageID of the root node that contains the data for this table. For hash tables,
+     * this is the pageID of the hash directory.
      */
     pgid_t getBtreePageID() const;
 
+    /**
+     * @return The storage engine used for the table's data.
+     */
+    TableEngine getEngine() const;
+
     /**
      * @return The number of tuples of the table that this page represents.
      */
@@ -68,6 +103,61 @@ public:
      */
     void setBtreePageID(pgid_t btreePageID);
 
+    /**
+     * @return The secondary indexes of the table.
+     */
+    const Vec<IndexInfo> &getIndexes() const;
+
+    /**
+     * Records a new secondary index on a column.
+     * @param column The indexed column.
+     * @param unique Whether the index enforces unique values.
+     * @param btreePageID The root node pageID of the index's btree.
+     * @note Program terminates if the column is out of range or already indexed.
+     */
+    void addIndex(u16 column, bool unique, pgid_t btreePageID);
+
+    /**
+     * Changes the page ID of a secondary index's btree root.
+     * @param column The indexed column.
+     * @param btreePageID the new page ID.
+     * @note Program terminates if the column is not indexed.
+     */
+    void setIndexBtreePageID(u16 column, pgid_t btreePageID);
+
+    /**
+     * @return The bloom filter of the table. Its pageID is PGID_INVALID if the table has none.
+     */
+    const BloomInfo &getBloom() const;
+
+    /**
+     * Records the bloom filter of the table, replacing any previous one.
+     * @param bloom The filter's metadata.
+     */
+    void setBloom(const BloomInfo &bloom);
+
+    /**
+     * @return The page ID of the table's StatsPage, or PGID_INVALID if it has none.
+     */
+    pgid_t getStatsPageID() const;
+
+    /**
+     * Changes the page ID of the table's StatsPage.
+     * @param statsPageID the new page ID.
+     */
+    void setStatsPageID(pgid_t statsPageID);
+
+    /**
+     * @return The root node pageID of the table's version store, or PGID_INVALID if it has none.
+     */
+    pgid_t getVersionsPageID() const;
+
+    /**
+     * Changes the page ID of the table's version store root.
+     * @param versionsPageID the new page ID, or PGID_INVALID once the store is freed.
+     */
+    void setVersionsPageID(pgid_t versionsPageID);
+
     /**
      * Serializes the TablePage into a byte buffer.
      * @param buffer The byte buffer to serialize into.
@@ -79,6 +169,11 @@ private:
     Vec<Vari> m_types;
     pgid_t m_btreePageID;
     u64 m_numTuples;
+    TableEngine m_engine;
+    Vec<IndexInfo> m_indexes;
+    BloomInfo m_bloom;
+    pgid_t m_statsPageID;
+    pgid_t m_versionsPageID;
 };
 
 } //namespace backend
@@ -0,0 +1,118 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include "ThreadPool.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+ThreadPool::ThreadPool(size_t numThreads) : m_queued(0), m_pending(0), m_next(0), m_stop(false) {
+    ASSUME_S(numThreads > 0, "Thread pool needs at least one thread");
+
+    for (size_t i = 0; i < numThreads; i++)
+        m_queues.push_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < numThreads; i++)
+        m_threads.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock lock(m_mutex);
+        m_idleCv.wait(lock, [this] { return m_pending == 0; });
+        m_stop = true;
+    }
+    m_workCv.notify_all();
+
+    for (auto &thread: m_threads)
+        thread.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t target;
+    {
+        std::lock_guard lock(m_mutex);
+        target = m_next++ % m_queues.size();
+    }
+
+    {
+        std::lock_guard lock(m_queues[target]->mutex);
+        m_queues[target]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_queued++;
+        m_pending++;
+    }
+    m_workCv.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock lock(m_mutex);
+    m_idleCv.wait(lock, [this] { return m_pending == 0; });
+
+    if (m_error) {
+        auto error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+bool ThreadPool::takeTask(size_t self, std::function<void()> &task) {
+    {
+        auto &own = *m_queues[self];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < m_queues.size(); i++) {
+        auto &victim = *m_queues[(self + i) % m_queues.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::run(size_t self) {
+    while (true) {
+        {
+            std::unique_lock lock(m_mutex);
+            m_workCv.wait(lock, [this] { return m_stop || m_queued > 0; });
+            if (m_queued == 0)
+                return;
+        }
+
+        std::function<void()> task;
+        if (!takeTask(self, task))
+            continue; // another worker got there first
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_queued--;
+        }
+
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard lock(m_mutex);
+            if (!m_error)
+                m_error = std::current_exception();
+        }
+
+        std::lock_guard lock(m_mutex);
+        if (--m_pending == 0)
+            m_idleCv.notify_all();
+    }
+}
+
+} // namespace backend
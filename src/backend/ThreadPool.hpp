@@ -0,0 +1,89 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_THREADPOOL_HPP
+#define KNDB_THREADPOOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads running submitted tasks, with work stealing.
+ *
+ * Every worker owns a queue of tasks. Tasks are handed out to the queues round-robin; a worker
+ * takes tasks from the back of its own queue and, once that is empty, steals from the front of
+ * the other workers' queues. Unevenly sized tasks (such as scanning B-tree subtrees of different
+ * heights) therefore still keep every worker busy.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Starts the worker threads.
+     * @param numThreads Number of worker threads. Must be at least 1.
+     */
+    explicit ThreadPool(size_t numThreads);
+
+    /**
+     * @brief Waits for all submitted tasks to finish, then stops the worker threads.
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Queues a task to run on one of the worker threads.
+     * @param task The task to run.
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Blocks until every submitted task has finished.
+     * @throws The first exception thrown by a task since the last call to wait(), if any.
+     */
+    void wait();
+
+    /**
+     * @return The number of worker threads.
+     */
+    size_t getNumThreads() const { return m_threads.size(); }
+
+    ThreadPool &operator=(ThreadPool &&other) = delete;
+    ThreadPool &operator=(const ThreadPool &other) = delete;
+    ThreadPool(ThreadPool &&other) = delete;
+    ThreadPool(const ThreadPool &other) = delete;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void run(size_t self);
+
+    // takes a task from the worker's own queue, or steals one from another queue
+    bool takeTask(size_t self, std::function<void()> &task);
+
+    Vec<Ptr<Queue>> m_queues;
+    Vec<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_workCv;
+    std::condition_variable m_idleCv;
+    size_t m_queued;  // tasks submitted but not yet taken by a worker
+    size_t m_pending; // tasks submitted but not yet finished
+    size_t m_next;    // queue the next task is handed to
+    bool m_stop;
+    std::exception_ptr m_error;
+};
+
+} // namespace backend
+
+#endif //KNDB_THREADPOOL_HPP
@@ -0,0 +1,221 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include "Tracer.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace backend {
+
+namespace {
+
+constexpr char MAGIC[8] = {'K', 'N', 'D', 'B', 'T', 'R', 'C', '1'};
+
+void putVarint(Vec<byte> &out, u64 val) {
+    while (val >= 0x80) {
+        out.push_back(static_cast<byte>(val | 0x80));
+        val >>= 7;
+    }
+    out.push_back(static_cast<byte>(val));
+}
+
+// reads a varint through 'at', which maps an index to a byte; returns false if it runs past 'end'
+template<typename At>
+bool getVarint(At &&at, size_t &pos, size_t end, u64 &val) {
+    val = 0;
+    for (unsigned shift = 0; shift < 64 && pos < end; shift += 7) {
+        auto b = std::to_integer<u8>(at(pos++));
+        val |= static_cast<u64>(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+u64 zigzag(int64_t val) { return (static_cast<u64>(val) << 1) ^ static_cast<u64>(val >> 63); }
+
+int64_t unzigzag(u64 val) { return static_cast<int64_t>(val >> 1) ^ -static_cast<int64_t>(val & 1); }
+
+constexpr u64 Tracer::Record::*COUNTS[] = {
+        &Tracer::Record::startNs, &Tracer::Record::totalNs, &Tracer::Record::cacheNs, &Tracer::Record::ioNs,
+        &Tracer::Record::codecNs, &Tracer::Record::bytesRead, &Tracer::Record::bytesWritten,
+        &Tracer::Record::bytesSerialized};
+
+} // namespace
+
+thread_local Tracer::Record *Tracer::t_current = nullptr;
+
+Tracer::Scope::Scope(TraceOp op) {
+    // a call made by a traced call is part of it
+    if (t_current || !global().enabled())
+        return;
+    m_active = true;
+    m_record.op = op;
+    m_record.startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - global().m_epoch).count();
+    t_current = &m_record;
+}
+
+Tracer::Scope::~Scope() {
+    if (!m_active)
+        return;
+    t_current = nullptr;
+    auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - global().m_epoch).count();
+    m_record.totalNs = now - m_record.startNs;
+    global().append(m_record);
+}
+
+Tracer &Tracer::global() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::start(size_t capacity) {
+    std::lock_guard lock(m_mutex);
+    m_ring.assign(capacity, byte{0});
+    m_head = 0;
+    m_used = 0;
+    m_dropped = 0;
+    m_epoch = Clock::now();
+    m_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::stop() {
+    m_enabled.store(false, std::memory_order_relaxed);
+}
+
+u64 Tracer::dropped() const {
+    std::lock_guard lock(m_mutex);
+    return m_dropped;
+}
+
+void Tracer::encode(const Record &record, Vec<byte> &out) {
+    out.push_back(static_cast<byte>(record.op));
+    for (auto field: COUNTS)
+        putVarint(out, record.*field);
+    putVarint(out, record.pages.size());
+
+    // page IDs are delta-coded, as a call tends to touch nearby pages, with the access in the low bits
+    pgid_t prev = 0;
+    for (const auto &[pageID, access]: record.pages) {
+        putVarint(out, zigzag(static_cast<int64_t>(pageID) - prev) << 2 | static_cast<u8>(access));
+        prev = pageID;
+    }
+}
+
+bool Tracer::decode(std::span<const byte> bytes, size_t &pos, Record &record) {
+    auto at = [&](size_t i) { return bytes[i]; };
+    u64 len;
+    if (!getVarint(at, pos, bytes.size(), len) || len == 0 || len > bytes.size() - pos)
+        return false;
+    size_t end = pos + len;
+
+    record = {};
+    record.op = static_cast<TraceOp>(bytes[pos++]);
+    for (auto field: COUNTS)
+        if (!getVarint(at, pos, end, record.*field))
+            return false;
+
+    u64 numPages;
+    if (!getVarint(at, pos, end, numPages) || numPages > end - pos)
+        return false;
+    pgid_t prev = 0;
+    for (u64 i = 0; i < numPages; i++) {
+        u64 val;
+        if (!getVarint(at, pos, end, val))
+            return false;
+        prev = static_cast<pgid_t>(prev + unzigzag(val >> 2));
+        record.pages.emplace_back(prev, static_cast<PageAccess>(val & 3));
+    }
+    return pos == end;
+}
+
+void Tracer::append(const Record &record) {
+    Vec<byte> payload;
+    encode(record, payload);
+    Vec<byte> framed;
+    putVarint(framed, payload.size());
+    framed.insert(framed.end(), payload.begin(), payload.end());
+
+    std::lock_guard lock(m_mutex);
+    size_t capacity = m_ring.size();
+    if (framed.size() > capacity) {
+        m_dropped++;
+        return;
+    }
+
+    // overwrite the oldest records until the new one fits
+    auto at = [&](size_t i) { return m_ring[i % capacity]; };
+    while (m_used + framed.size() > capacity) {
+        size_t tail = (m_head + capacity - m_used) % capacity;
+        size_t pos = tail;
+        u64 len;
+        getVarint(at, pos, tail + m_used, len);
+        m_used -= pos - tail + len;
+        m_dropped++;
+    }
+
+    size_t first = std::min(framed.size(), capacity - m_head);
+    std::memcpy(m_ring.data() + m_head, framed.data(), first);
+    std::memcpy(m_ring.data(), framed.data() + first, framed.size() - first);
+    m_head = (m_head + framed.size()) % capacity;
+    m_used += framed.size();
+}
+
+Vec<Tracer::Record> Tracer::records() const {
+    Vec<byte> bytes;
+    {
+        std::lock_guard lock(m_mutex);
+        size_t capacity = m_ring.size();
+        size_t tail = capacity == 0 ? 0 : (m_head + capacity - m_used) % capacity;
+        for (size_t i = 0; i < m_used; i++)
+            bytes.push_back(m_ring[(tail + i) % capacity]);
+    }
+
+    Vec<Record> records;
+    size_t pos = 0;
+    Record record;
+    while (pos < bytes.size() && decode(bytes, pos, record))
+        records.push_back(std::move(record));
+    return records;
+}
+
+void Tracer::save(const string &fileName) const {
+    Vec<byte> out(reinterpret_cast<const byte *>(MAGIC), reinterpret_cast<const byte *>(MAGIC) + sizeof(MAGIC));
+    for (const auto &record: records()) {
+        Vec<byte> payload;
+        encode(record, payload);
+        putVarint(out, payload.size());
+        out.insert(out.end(), payload.begin(), payload.end());
+    }
+
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(out.data()), static_cast<std::streamsize>(out.size()));
+    if (!file)
+        throw std::runtime_error("Failed to write trace file " + fileName);
+}
+
+Vec<Tracer::Record> Tracer::load(const string &fileName) {
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Failed to open trace file " + fileName);
+    Vec<char> chars{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if (chars.size() < sizeof(MAGIC) || std::memcmp(chars.data(), MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error(fileName + " is not a trace file");
+
+    std::span<const byte> bytes(reinterpret_cast<const byte *>(chars.data()), chars.size());
+    Vec<Record> records;
+    size_t pos = sizeof(MAGIC);
+    Record record;
+    while (pos < bytes.size()) {
+        if (!decode(bytes, pos, record))
+            throw std::runtime_error(fileName + " is corrupt");
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+} // namespace backend
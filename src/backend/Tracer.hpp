@@ -0,0 +1,194 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_TRACER_HPP
+#define KNDB_TRACER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <span>
+
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @brief The StorageEngine calls that are traced.
+ */
+enum class TraceOp : u8 {
+    INSERT = 1, UPDATE, REMOVE, GET, RANGE, COMMIT, ABORT, CHECKPOINT
+};
+
+/**
+ * @brief How a traced call used a page of the PageCache.
+ */
+enum class PageAccess : u8 {
+    HIT,    ///< Retrieved while cached.
+    MISS,   ///< Retrieved after reading it from disk.
+    INSERT, ///< Put into the cache without a read, as a new page or a replaced version.
+    WRITE   ///< Written back to disk, on eviction or flush.
+};
+
+/**
+ * @class Tracer
+ * @brief Opt-in tracing of StorageEngine calls: the pages each one touched, and where its time went.
+ *
+ * While started, every StorageEngine call that changes or reads tuples, and every commit, abort and
+ * checkpoint, produces a Record with the sequence of page accesses it made and the time it spent
+ * in each layer. Records are varint-encoded into a fixed-size ring buffer, which overwrites the
+ * oldest records once full. save() writes the buffer to a file, which kndb_tracedump lists or
+ * replays against LRU caches of other sizes.
+ *
+ * The layers report to the Scope open on their own thread, so a call is traced as a whole even if
+ * it calls other traced calls, e.g. an insert that triggers a checkpoint. While stopped, each
+ * hook costs a thread-local load and a branch.
+ */
+class Tracer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 16 << 20;
+
+    /**
+     * @brief One traced StorageEngine call.
+     *
+     * Each layer's time includes the layers below it: cacheNs includes codecNs and the time
+     * spent reading and writing pages, while ioNs also covers writes of the write-ahead log.
+     */
+    struct Record {
+        TraceOp op{};
+        u64 startNs = 0;        ///< When the call started, since the tracer was started.
+        u64 totalNs = 0;        ///< Time spent in the call.
+        u64 cacheNs = 0;        ///< Time spent in the PageCache.
+        u64 ioNs = 0;           ///< Time spent in the IOHandler.
+        u64 codecNs = 0;        ///< Time spent serializing and deserializing pages.
+        u64 bytesRead = 0;      ///< Bytes read from disk.
+        u64 bytesWritten = 0;   ///< Bytes written to disk.
+        u64 bytesSerialized = 0; ///< Bytes of pages serialized or deserialized.
+        Vec<std::pair<pgid_t, PageAccess>> pages; ///< Page accesses, in order.
+    };
+
+    /**
+     * @class Scope
+     * @brief Traces one StorageEngine call, from its construction to its destruction.
+     */
+    class Scope {
+    public:
+        explicit Scope(TraceOp op);
+
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Record m_record;
+        bool m_active = false;
+    };
+
+    /**
+     * @class LayerTimer
+     * @brief Adds the time from its construction to its destruction to one of the traced call's
+     * per-layer times.
+     */
+    class LayerTimer {
+    public:
+        explicit LayerTimer(u64 Record::*field) : m_record(t_current), m_field(field) {
+            if (m_record)
+                m_start = Clock::now();
+        }
+
+        ~LayerTimer() {
+            if (m_record)
+                m_record->*m_field += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        Clock::now() - m_start).count();
+        }
+
+        LayerTimer(const LayerTimer &) = delete;
+        LayerTimer &operator=(const LayerTimer &) = delete;
+
+    private:
+        Record *m_record;
+        u64 Record::*m_field;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    static Tracer &global();
+
+    /**
+     * @brief Clears the buffer and starts tracing. Must not be called while traced calls run.
+     * @param capacity Size of the ring buffer in bytes.
+     */
+    void start(size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Stops tracing. The records stay in the buffer. Calls in progress are still recorded.
+     */
+    void stop();
+
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @return The number of records overwritten, or dropped for being larger than the buffer.
+     */
+    u64 dropped() const;
+
+    /**
+     * @return The records in the buffer, oldest first.
+     */
+    Vec<Record> records() const;
+
+    /**
+     * @brief Writes the records in the buffer to a trace file, replacing it if it exists.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void save(const string &fileName) const;
+
+    /**
+     * @return The records in a trace file written by save(), oldest first.
+     * @throws std::runtime_error if the file cannot be read or is not a trace file.
+     */
+    static Vec<Record> load(const string &fileName);
+
+    /**
+     * @brief Adds a page access to the traced call on this thread, if any.
+     */
+    static void pageAccess(pgid_t pageID, PageAccess access) {
+        if (t_current)
+            t_current->pages.emplace_back(pageID, access);
+    }
+
+    /**
+     * @brief Adds to one of the byte counts of the traced call on this thread, if any.
+     */
+    static void addBytes(u64 Record::*field, u64 bytes) {
+        if (t_current)
+            t_current->*field += bytes;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // appends an encoded record, overwriting the oldest ones as needed
+    void append(const Record &record);
+
+    static void encode(const Record &record, Vec<byte> &out);
+
+    // decodes the record at pos and moves pos past it; returns false if the bytes are malformed
+    static bool decode(std::span<const byte> bytes, size_t &pos, Record &record);
+
+    // the call being traced on this thread, or nullptr
+    static thread_local Record *t_current;
+
+    std::atomic<bool> m_enabled{false};
+    Clock::time_point m_epoch;
+    mutable std::mutex m_mutex;
+    Vec<byte> m_ring;
+    size_t m_head = 0; ///< Where the next record is written.
+    size_t m_used = 0; ///< Bytes of records in the buffer, which end at m_head.
+    u64 m_dropped = 0;
+};
+
+} // namespace backend
+
+#endif //KNDB_TRACER_HPP
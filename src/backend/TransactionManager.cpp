@@ -0,0 +1,141 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <algorithm>
+#include <set>
+
+#include "TransactionManager.hpp"
+#include "Table.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+using Record = WriteAheadLog::Record;
+
+TransactionManager::TransactionManager(string logFileName, SnapshotManager &snapshots, bool readOnly)
+        : m_log(std::move(logFileName), readOnly), m_snapshots(snapshots) {}
+
+u64 TransactionManager::begin() {
+    u64 txn = ++m_lastTxn;
+    m_open.emplace(txn, Transaction());
+    return txn;
+}
+
+void TransactionManager::commit(u64 txn) {
+    ASSUME_S(m_open.contains(txn), "Transaction is not open");
+    m_log.append({Record::Type::COMMIT, txn});
+    m_log.flush();
+
+    // snapshots opened from now on see the changes; older ones still need the replaced tuples
+    u64 commit = m_snapshots.commit();
+    if (m_snapshots.active())
+        for (const auto &[row, before]: m_open.at(txn).originals)
+            row.first->keepVersion(row.second, commit, before);
+    finish(txn);
+}
+
+void TransactionManager::abort(u64 txn) {
+    ASSUME_S(m_open.contains(txn), "Transaction is not open");
+    auto undo = std::move(m_open.at(txn).undo);
+    {
+        Scope scope(*this, txn);
+        m_aborting = true;
+        for (auto it = undo.rbegin(); it != undo.rend(); ++it)
+            it->table->restoreTuple(it->key, it->before);
+        m_aborting = false;
+    }
+    // not flushed: if the abort is lost, recovery rolls the transaction back again
+    m_log.append({Record::Type::ABORT, txn});
+    finish(txn);
+}
+
+void TransactionManager::finish(u64 txn) {
+    for (const auto &row: m_open.at(txn).locks)
+        m_locks.erase(row);
+    m_open.erase(txn);
+}
+
+bool TransactionManager::usesTable(const Table &table) const {
+    return std::any_of(m_locks.begin(), m_locks.end(), [&table](const auto &lock) {
+        return lock.first.first == &table;
+    });
+}
+
+std::optional<TransactionManager::Version> TransactionManager::uncommitted(const Table &table,
+                                                                         const Vari &key) const {
+    RowID row{&table, key};
+    auto lock = m_locks.find(row);
+    if (lock == m_locks.end())
+        return std::nullopt;
+    // a locked row may not have been changed yet
+    const auto &originals = m_open.at(lock->second).originals;
+    if (auto it = originals.find(row); it != originals.end())
+        return it->second;
+    return std::nullopt;
+}
+
+std::map<Vari, TransactionManager::Version> TransactionManager::uncommitted(const Table &table) const {
+    std::map<Vari, Version> tuples;
+    for (const auto &[txn, transaction]: m_open)
+        for (const auto &[row, before]: transaction.originals)
+            if (row.first == &table)
+                tuples.emplace(row.second, before);
+    return tuples;
+}
+
+void TransactionManager::beginChange(const Table &table, const Vari &key) {
+    if (m_recovering)
+        return;
+
+    if (m_open.empty() && m_checkpoint && m_log.size() > CHECKPOINT_THRESHOLD)
+        m_checkpoint();
+
+    RowID row{&table, key};
+    if (auto it = m_locks.find(row); it != m_locks.end()) {
+        if (it->second != m_current)
+            throw std::runtime_error("Row is locked by another transaction.");
+        return;
+    }
+
+    if (m_current != AUTOCOMMIT) {
+        m_locks.emplace(row, m_current);
+        m_open.at(m_current).locks.push_back(std::move(row));
+    }
+}
+
+void TransactionManager::logChange(const Table &table, const Vari &key, const Version &before, const Version &after) {
+    if (m_recovering)
+        return;
+
+    m_log.append({Record::Type::CHANGE, m_current, table.getName(), key, before, after});
+    if (m_current != AUTOCOMMIT && !m_aborting) {
+        auto &transaction = m_open.at(m_current);
+        transaction.undo.push_back({&table, key, before});
+        transaction.originals.try_emplace({&table, key}, before);
+    }
+}
+
+bool TransactionManager::recover(const ApplyFn &apply) {
+    ASSUME_S(m_open.empty(), "Recovery must run before any transaction begins");
+    auto records = m_log.readAll();
+
+    std::set<u64> finished;
+    for (const auto &record: records)
+        if (record.type != Record::Type::CHANGE)
+            finished.insert(record.txn);
+
+    m_recovering = true;
+    for (const auto &record: records)
+        if (record.type == Record::Type::CHANGE)
+            apply(record.table, record.key, record.after);
+
+    for (auto it = records.rbegin(); it != records.rend(); ++it)
+        if (it->type == Record::Type::CHANGE && it->txn != AUTOCOMMIT && !finished.contains(it->txn))
+            apply(it->table, it->key, it->before);
+    m_recovering = false;
+
+    return !records.empty();
+}
+
+} // namespace backend
@@ -0,0 +1,209 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_TRANSACTIONMANAGER_HPP
+#define KNDB_TRANSACTIONMANAGER_HPP
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <unordered_map>
+
+#include "SnapshotManager.hpp"
+#include "WriteAheadLog.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+class Table;
+
+/**
+ * @class TransactionManager
+ * @brief Groups changes to tables into transactions that commit or abort as a whole.
+ *
+ * Tables report every change to it before and after making it. Each change is appended to the
+ * WriteAheadLog with the tuple before and after it, and remembered for undo if made in a
+ * transaction. A commit makes the log durable with one flush, however many changes the transaction
+ * made. An abort restores the tuples in reverse, logging each restoration as another change of the
+ * transaction. Changes made outside of a transaction are logged but only made durable by the next
+ * flush, which happens at the latest before any page is written to disk.
+ *
+ * A transaction holds an exclusive lock on every row it changes until it ends. Locks are not
+ * waited for: changing a row locked by another transaction throws, since transactions are driven
+ * from a single thread and waiting would never end. Reads take no locks and see uncommitted
+ * changes, except snapshot reads: a transaction's changes only get a commit timestamp when it
+ * commits, all the same one, and until then snapshots see the tuples as they were before it.
+ */
+class TransactionManager {
+public:
+    /**
+     * The transaction ID of changes made outside of a transaction.
+     */
+    static constexpr u64 AUTOCOMMIT = 0;
+
+    /**
+     * A tuple before or after a change. std::nullopt if the key had no tuple.
+     */
+    using Version = std::optional<Vec<Vari>>;
+
+    /**
+     * Sets the tuple under a key of the named table during recovery().
+     */
+    using ApplyFn = std::function<void(const string &table, const Vari &key, const Version &tuple)>;
+
+    /**
+     * @brief Makes a transaction the current one for as long as it is in scope, so the changes
+     * tables make in the meantime belong to it.
+     */
+    class Scope {
+    public:
+        Scope(TransactionManager &manager, u64 txn) : m_manager(manager), m_previous(manager.m_current) {
+            manager.m_current = txn;
+        }
+
+        ~Scope() { m_manager.m_current = m_previous; }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        TransactionManager &m_manager;
+        u64 m_previous;
+    };
+
+    /**
+     * @brief Opens the log.
+     * @param logFileName The name of the log file.
+     * @param snapshots Hands out the commit timestamps of transactions.
+     * @param readOnly Whether to open the log read-only, in which case no transaction may be begun.
+     */
+    TransactionManager(string logFileName, SnapshotManager &snapshots, bool readOnly = false);
+
+    /**
+     * @brief Starts a transaction.
+     * @return The transaction's ID.
+     */
+    u64 begin();
+
+    /**
+     * @brief Makes the changes of a transaction durable, gives them a commit timestamp and
+     * releases its locks. The tables keep the tuples the transaction replaced if a snapshot may
+     * still see them.
+     * @param txn An open transaction.
+     */
+    void commit(u64 txn);
+
+    /**
+     * @brief Restores every tuple a transaction changed and releases its locks.
+     * @param txn An open transaction.
+     */
+    void abort(u64 txn);
+
+    /**
+     * @return true if any transaction is open.
+     */
+    bool active() const { return !m_open.empty(); }
+
+    /**
+     * @return true if an open transaction changed a tuple of the table.
+     */
+    bool usesTable(const Table &table) const;
+
+    /**
+     * @return true if changes are currently made in a transaction, including those made by an
+     * abort. Such changes get their commit timestamp when the transaction commits.
+     */
+    bool inTransaction() const { return m_current != AUTOCOMMIT; }
+
+    /**
+     * @return The tuple under a key before the open transaction that changed it, or std::nullopt
+     * if no open transaction changed it.
+     */
+    std::optional<Version> uncommitted(const Table &table, const Vari &key) const;
+
+    /**
+     * @return The tuples before the open transactions that changed them, of every key of the
+     * table that an open transaction changed.
+     */
+    std::map<Vari, Version> uncommitted(const Table &table) const;
+
+    /**
+     * @brief Called by a table before it changes the tuple under a key. Locks the row for the
+     * current transaction, and checkpoints if the log has outgrown its limit while no
+     * transaction is open.
+     * @throws std::runtime_error if another transaction holds the row's lock.
+     */
+    void beginChange(const Table &table, const Vari &key);
+
+    /**
+     * @brief Called by a table after it changed the tuple under a key. Logs the change and keeps
+     * it for undo if made in a transaction.
+     */
+    void logChange(const Table &table, const Vari &key, const Version &before, const Version &after);
+
+    /**
+     * @brief Brings the tables up to date with the log after the database was reopened: redoes
+     * every logged change in order, then undoes in reverse the changes of the transactions that
+     * never finished. Changes made meanwhile are neither logged nor locked.
+     * @param apply Sets the tuple under a key of a table.
+     * @return true if the log had any changes.
+     */
+    bool recover(const ApplyFn &apply);
+
+    /**
+     * @brief Sets what the manager calls to checkpoint once the log has outgrown its limit.
+     * @param checkpoint Makes every logged change durable in the tables, then calls truncateLog().
+     */
+    void setCheckpoint(std::function<void()> checkpoint) { m_checkpoint = std::move(checkpoint); }
+
+    /**
+     * @brief Makes every logged change durable.
+     */
+    void flushLog() { m_log.flush(); }
+
+    /**
+     * @brief Discards the log, once every change in it is durable in the tables.
+     */
+    void truncateLog() { m_log.truncate(); }
+
+    /**
+     * @return The number of bytes logged since the last truncateLog().
+     */
+    u64 logSize() const { return m_log.size(); }
+
+private:
+    // log size past which a change made while no transaction is open checkpoints first
+    static constexpr u64 CHECKPOINT_THRESHOLD = 64 << 20;
+
+    using RowID = std::pair<const Table *, Vari>;
+
+    struct Undo {
+        const Table *table;
+        Vari key;
+        Version before;
+    };
+
+    struct Transaction {
+        Vec<Undo> undo;
+        Vec<RowID> locks;
+        std::map<RowID, Version> originals; // each changed row's tuple before the transaction
+    };
+
+    // releases a finished transaction's locks and forgets it.
+    void finish(u64 txn);
+
+    WriteAheadLog m_log;
+    SnapshotManager &m_snapshots;
+    std::unordered_map<u64, Transaction> m_open;
+    std::map<RowID, u64> m_locks; // the transaction holding each locked row
+    std::function<void()> m_checkpoint;
+    u64 m_lastTxn = AUTOCOMMIT;
+    u64 m_current = AUTOCOMMIT;
+    bool m_aborting = false;   // restorations made by abort() are logged but not kept for undo
+    bool m_recovering = false; // changes made by recover() are neither logged nor locked
+};
+
+} // namespace backend
+
+#endif //KNDB_TRANSACTIONMANAGER_HPP
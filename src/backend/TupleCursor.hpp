@@ -0,0 +1,57 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_TUPLECURSOR_HPP
+#define KNDB_TUPLECURSOR_HPP
+
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class TupleCursor
+ * @brief Iterates a sequence of tuples, one at a time.
+ */
+class TupleCursor {
+public:
+    /**
+     * @return true if the cursor is on a tuple, false once every tuple was visited.
+     */
+    virtual bool valid() const = 0;
+
+    /**
+     * @return The current tuple.
+     */
+    virtual const Vec<Vari> &tuple() const = 0;
+
+    /**
+     * @brief Moves to the next tuple.
+     */
+    virtual void next() = 0;
+
+    virtual ~TupleCursor() = default;
+};
+
+/**
+ * @class VectorCursor
+ * @brief Iterates tuples held in memory.
+ */
+class VectorCursor : public TupleCursor {
+public:
+    explicit VectorCursor(Vec<Vec<Vari>> tuples) : m_tuples(std::move(tuples)), m_idx(0) {}
+
+    bool valid() const override { return m_idx < m_tuples.size(); }
+
+    const Vec<Vari> &tuple() const override { return m_tuples[m_idx]; }
+
+    void next() override { m_idx++; }
+
+private:
+    Vec<Vec<Vari>> m_tuples;
+    size_t m_idx;
+};
+
+} // namespace backend
+
+#endif //KNDB_TUPLECURSOR_HPP
@@ -0,0 +1,373 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "VectorExecutor.hpp"
+#include "assume.hpp"
+#include "utility.hpp"
+
+namespace backend {
+
+namespace {
+
+// type a Vari alternative is stored as in a Column
+template<typename T>
+using stored_t = std::conditional_t<std::is_same_v<T, bool>, u8, T>;
+
+// type a Column alternative holds when converted back to a Vari
+template<typename S>
+using value_t = std::conditional_t<std::is_same_v<S, u8>, bool, S>;
+
+Column makeColumn(const Vari &type) {
+    return std::visit([](const auto &value) -> Column {
+        using T = std::decay_t<decltype(value)>;
+        return Vec<stored_t<T>>{};
+    }, type);
+}
+
+// writes the indices of the rows satisfying cmp into selection, and returns how many there are.
+// selection may already hold the rows to consider, or all rows are considered.
+template<typename S, typename Cmp>
+size_t select(const Vec<S> &column, Cmp cmp, size_t numRows, Vec<u32> &selection, size_t numSelected,
+              bool allSelected) {
+    u32 *out = selection.data();
+    size_t count = 0;
+    if (allSelected) {
+        for (u32 row = 0; row < numRows; row++) {
+            out[count] = row;
+            count += cmp(column[row]);
+        }
+    } else {
+        for (size_t i = 0; i < numSelected; i++) {
+            u32 row = out[i];
+            out[count] = row;
+            count += cmp(column[row]);
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+VectorExecutor::VectorExecutor(const Vec<Vari> &types, Query query)
+        : m_types(types), m_query(std::move(query)), m_numRows(0), m_numSelected(0), m_allSelected(true) {
+    m_aggregating = !m_query.aggregates.empty() || !m_query.groupBy.empty();
+
+    auto use = [&](u16 column, const char *what) {
+        if (column >= m_types.size())
+            throw std::invalid_argument(string(what) + " column is out of range.");
+        if (std::find(m_used.begin(), m_used.end(), column) == m_used.end())
+            m_used.push_back(column);
+    };
+
+    for (const auto &predicate: m_query.where) {
+        use(predicate.column, "Predicate");
+        if (variant_to_type_id(predicate.value) != variant_to_type_id(m_types[predicate.column]))
+            throw std::runtime_error("Predicate value is incorrect type.");
+    }
+
+    if (m_aggregating) {
+        if (!m_query.select.empty())
+            throw std::invalid_argument("Selected columns cannot be combined with aggregates.");
+        for (u16 column: m_query.groupBy)
+            use(column, "Grouped");
+        for (const auto &aggregate: m_query.aggregates) {
+            if (aggregate.op == AggregateOp::COUNT)
+                continue;
+            use(aggregate.column, "Aggregated");
+            bool numeric = !std::holds_alternative<string>(m_types[aggregate.column]);
+            if (!numeric && (aggregate.op == AggregateOp::SUM || aggregate.op == AggregateOp::AVG))
+                throw std::invalid_argument("Cannot sum a string column.");
+        }
+    } else {
+        if (m_query.select.empty())
+            for (u16 column = 0; column < m_types.size(); column++)
+                m_query.select.push_back(column);
+        for (u16 column: m_query.select)
+            use(column, "Selected");
+    }
+
+    m_columns.resize(m_types.size());
+    for (u16 column: m_used) {
+        m_columns[column] = makeColumn(m_types[column]);
+        std::visit([](auto &values) { values.reserve(BATCH_SIZE); }, m_columns[column]);
+    }
+    m_selection.resize(BATCH_SIZE);
+    m_groupOf.resize(BATCH_SIZE);
+    m_hashes.resize(BATCH_SIZE);
+    for (u16 column: m_query.groupBy)
+        m_groupKeys.push_back(makeColumn(m_types[column]));
+
+    if (m_aggregating) {
+        m_sums.resize(m_query.aggregates.size());
+        m_extremes.resize(m_query.aggregates.size());
+        for (size_t i = 0; i < m_query.aggregates.size(); i++) {
+            const auto &aggregate = m_query.aggregates[i];
+            if (aggregate.op == AggregateOp::MIN || aggregate.op == AggregateOp::MAX)
+                m_extremes[i] = makeColumn(m_types[aggregate.column]);
+        }
+
+        // without grouping, every tuple belongs to the single group, which exists even if empty
+        if (m_query.groupBy.empty()) {
+            m_counts.push_back(0);
+            for (auto &sums: m_sums)
+                sums.push_back(0);
+            for (auto &extremes: m_extremes)
+                std::visit([](auto &values) { values.emplace_back(); }, extremes);
+        }
+    }
+}
+
+void VectorExecutor::addRow(const Vec<Vari> &tuple) {
+    for (u16 column: m_used) {
+        std::visit([&](auto &values) {
+            using S = typename std::decay_t<decltype(values)>::value_type;
+            values.push_back(std::get<value_t<S>>(tuple[column]));
+        }, m_columns[column]);
+    }
+
+    if (++m_numRows == BATCH_SIZE)
+        processBatch();
+}
+
+Vec<Vec<Vari>> VectorExecutor::finish() {
+    if (m_numRows > 0)
+        processBatch();
+
+    if (!m_aggregating)
+        return std::move(m_rows);
+
+    Vec<Vec<Vari>> result;
+    result.reserve(m_counts.size());
+    for (u32 group = 0; group < m_counts.size(); group++) {
+        Vec<Vari> row;
+        for (const auto &keys: m_groupKeys) {
+            std::visit([&](const auto &values) {
+                using S = typename std::decay_t<decltype(values)>::value_type;
+                row.emplace_back(static_cast<value_t<S>>(values[group]));
+            }, keys);
+        }
+        for (size_t i = 0; i < m_query.aggregates.size(); i++) {
+            switch (m_query.aggregates[i].op) {
+                case AggregateOp::COUNT:
+                    row.emplace_back(static_cast<int>(m_counts[group]));
+                    break;
+                case AggregateOp::SUM:
+                    row.emplace_back(m_sums[i][group]);
+                    break;
+                case AggregateOp::AVG:
+                    row.emplace_back(m_counts[group] == 0 ? 0.0 : m_sums[i][group] / m_counts[group]);
+                    break;
+                case AggregateOp::MIN:
+                case AggregateOp::MAX:
+                    std::visit([&](const auto &values) {
+                        using S = typename std::decay_t<decltype(values)>::value_type;
+                        row.emplace_back(static_cast<value_t<S>>(values[group]));
+                    }, m_extremes[i]);
+                    break;
+            }
+        }
+        result.push_back(std::move(row));
+    }
+
+    size_t keySize = m_query.groupBy.size();
+    std::sort(result.begin(), result.end(), [keySize](const Vec<Vari> &a, const Vec<Vari> &b) {
+        return std::lexicographical_compare(a.begin(), a.begin() + keySize, b.begin(), b.begin() + keySize);
+    });
+    return result;
+}
+
+void VectorExecutor::processBatch() {
+    m_allSelected = true;
+    m_numSelected = m_numRows;
+    for (const auto &predicate: m_query.where) {
+        filter(predicate);
+        if (m_numSelected == 0)
+            break;
+    }
+
+    auto rowAt = [&](size_t i) -> u32 { return m_allSelected ? static_cast<u32>(i) : m_selection[i]; };
+
+    if (!m_aggregating) {
+        for (size_t i = 0; i < m_numSelected; i++) {
+            u32 row = rowAt(i);
+            Vec<Vari> out;
+            out.reserve(m_query.select.size());
+            for (u16 column: m_query.select) {
+                std::visit([&](const auto &values) {
+                    using S = typename std::decay_t<decltype(values)>::value_type;
+                    out.emplace_back(static_cast<value_t<S>>(values[row]));
+                }, m_columns[column]);
+            }
+            m_rows.push_back(std::move(out));
+        }
+    } else if (m_numSelected > 0) {
+        if (m_allSelected)
+            for (u32 row = 0; row < m_numRows; row++)
+                m_selection[row] = row;
+        m_allSelected = false;
+
+        assignGroups();
+        for (size_t i = 0; i < m_query.aggregates.size(); i++)
+            accumulate(i);
+        // counts are updated last: a count of 0 tells accumulate() the single group has no MIN or MAX yet
+        for (size_t i = 0; i < m_numSelected; i++)
+            m_counts[m_groupOf[i]]++;
+    }
+
+    for (u16 column: m_used)
+        std::visit([](auto &values) { values.clear(); }, m_columns[column]);
+    m_numRows = 0;
+}
+
+void VectorExecutor::filter(const Predicate &predicate) {
+    std::visit([&](const auto &values) {
+        using S = typename std::decay_t<decltype(values)>::value_type;
+        const S value = std::get<value_t<S>>(predicate.value);
+        auto run = [&](auto cmp) {
+            m_numSelected = select(values, cmp, m_numRows, m_selection, m_numSelected, m_allSelected);
+            m_allSelected = false;
+        };
+
+        switch (predicate.op) {
+            case CompareOp::EQ:
+                return run([&](const S &lhs) { return lhs == value; });
+            case CompareOp::NE:
+                return run([&](const S &lhs) { return lhs != value; });
+            case CompareOp::LT:
+                return run([&](const S &lhs) { return lhs < value; });
+            case CompareOp::LE:
+                return run([&](const S &lhs) { return lhs <= value; });
+            case CompareOp::GT:
+                return run([&](const S &lhs) { return lhs > value; });
+            case CompareOp::GE:
+                return run([&](const S &lhs) { return lhs >= value; });
+        }
+        ASSUME_S(false, "Unknown comparison operator");
+    }, m_columns[predicate.column]);
+}
+
+void VectorExecutor::assignGroups() {
+    if (m_query.groupBy.empty()) {
+        std::fill_n(m_groupOf.begin(), m_numSelected, 0);
+        return;
+    }
+
+    // hash the grouped columns of every selected row, one column at a time
+    const u32 *selection = m_selection.data();
+    size_t *hashes = m_hashes.data();
+    std::fill_n(hashes, m_numSelected, 0);
+    for (u16 column: m_query.groupBy) {
+        std::visit([&](const auto &values) {
+            using S = typename std::decay_t<decltype(values)>::value_type;
+            std::hash<S> hasher;
+            for (size_t i = 0; i < m_numSelected; i++)
+                hashes[i] = hashes[i] * 31 + hasher(values[selection[i]]);
+        }, m_columns[column]);
+    }
+
+    for (size_t i = 0; i < m_numSelected; i++) {
+        u32 row = selection[i];
+        auto it = m_groupIndex.find(hashes[i]);
+        u32 group = it == m_groupIndex.end() ? NO_GROUP : it->second;
+        while (group != NO_GROUP && !isInGroup(row, group))
+            group = m_nextGroup[group];
+        m_groupOf[i] = group != NO_GROUP ? group : addGroup(row, hashes[i]);
+    }
+}
+
+bool VectorExecutor::isInGroup(u32 row, u32 group) const {
+    for (size_t k = 0; k < m_query.groupBy.size(); k++) {
+        bool equal = std::visit([&](const auto &values) {
+            using S = typename std::decay_t<decltype(values)>::value_type;
+            return std::get<Vec<S>>(m_groupKeys[k])[group] == values[row];
+        }, m_columns[m_query.groupBy[k]]);
+        if (!equal)
+            return false;
+    }
+    return true;
+}
+
+u32 VectorExecutor::addGroup(u32 row, size_t hash) {
+    u32 group = static_cast<u32>(m_counts.size());
+    auto [it, inserted] = m_groupIndex.try_emplace(hash, group);
+    m_nextGroup.push_back(inserted ? NO_GROUP : it->second);
+    it->second = group;
+
+    for (size_t k = 0; k < m_query.groupBy.size(); k++) {
+        std::visit([&](const auto &values) {
+            using S = typename std::decay_t<decltype(values)>::value_type;
+            std::get<Vec<S>>(m_groupKeys[k]).push_back(values[row]);
+        }, m_columns[m_query.groupBy[k]]);
+    }
+
+    m_counts.push_back(0);
+    for (auto &sums: m_sums)
+        sums.push_back(0);
+    // a new group's MIN and MAX start out as the value of its first row
+    for (size_t a = 0; a < m_query.aggregates.size(); a++) {
+        const auto &aggregate = m_query.aggregates[a];
+        if (aggregate.op != AggregateOp::MIN && aggregate.op != AggregateOp::MAX)
+            continue;
+        std::visit([&](const auto &values) {
+            using S = typename std::decay_t<decltype(values)>::value_type;
+            std::get<Vec<S>>(m_extremes[a]).push_back(values[row]);
+        }, m_columns[aggregate.column]);
+    }
+    return group;
+}
+
+void VectorExecutor::accumulate(size_t aggregateIdx) {
+    const auto &aggregate = m_query.aggregates[aggregateIdx];
+    if (aggregate.op == AggregateOp::COUNT)
+        return;
+
+    const u32 *selection = m_selection.data();
+    const u32 *groupOf = m_groupOf.data();
+    bool grouped = !m_query.groupBy.empty();
+
+    std::visit([&](const auto &values) {
+        using S = typename std::decay_t<decltype(values)>::value_type;
+
+        if (aggregate.op == AggregateOp::SUM || aggregate.op == AggregateOp::AVG) {
+            if constexpr (!std::is_same_v<S, string>) {
+                auto &sums = m_sums[aggregateIdx];
+                if (!grouped) {
+                    double sum = 0;
+                    for (size_t i = 0; i < m_numSelected; i++)
+                        sum += static_cast<double>(values[selection[i]]);
+                    sums[0] += sum;
+                } else {
+                    for (size_t i = 0; i < m_numSelected; i++)
+                        sums[groupOf[i]] += static_cast<double>(values[selection[i]]);
+                }
+            }
+            return;
+        }
+
+        auto &extremes = std::get<Vec<S>>(m_extremes[aggregateIdx]);
+        if (!grouped && m_counts[0] == 0)
+            extremes[0] = values[selection[0]];
+
+        if (aggregate.op == AggregateOp::MIN) {
+            for (size_t i = 0; i < m_numSelected; i++) {
+                const S &value = values[selection[i]];
+                S &extreme = extremes[groupOf[i]];
+                if (value < extreme)
+                    extreme = value;
+            }
+        } else {
+            for (size_t i = 0; i < m_numSelected; i++) {
+                const S &value = values[selection[i]];
+                S &extreme = extremes[groupOf[i]];
+                if (extreme < value)
+                    extreme = value;
+            }
+        }
+    }, m_columns[aggregate.column]);
+}
+
+} // namespace backend
@@ -0,0 +1,139 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_VECTOREXECUTOR_HPP
+#define KNDB_VECTOREXECUTOR_HPP
+
+#include <unordered_map>
+
+#include "Predicate.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * Aggregate function computed by a Query.
+ * - COUNT counts the matching tuples (as int) and ignores the column.
+ * - SUM and AVG add up a numeric column (as double).
+ * - MIN and MAX return a value of the column's type.
+ */
+enum class AggregateOp : u8 {
+    COUNT, SUM, MIN, MAX, AVG
+};
+
+struct Aggregate {
+    AggregateOp op;
+    u16 column;
+};
+
+/**
+ * @struct Query
+ * @brief A single-table query: filter, then either project or group and aggregate.
+ *
+ * Without aggregates or groupBy columns, the query returns the 'select' columns (every column if
+ * empty) of each tuple satisfying all 'where' predicates. Otherwise it returns one row per
+ * distinct combination of groupBy values, in ascending order, holding those values followed by
+ * the aggregates; 'select' must then be empty. Without groupBy columns, there is exactly one row,
+ * even if no tuple matches (COUNT and SUM are then 0, and MIN and MAX the type's default value).
+ */
+struct Query {
+    Vec<Predicate> where;
+    Vec<u16> select;
+    Vec<u16> groupBy;
+    Vec<Aggregate> aggregates;
+};
+
+/**
+ * Values of one column of a batch. The alternatives mirror those of Vari, except that bools are
+ * stored as bytes so that the vector is not bit-packed.
+ */
+using Column = std::variant<Vec<int>, Vec<char>, Vec<u8>, Vec<float>, Vec<double>, Vec<string>>;
+
+/**
+ * @class VectorExecutor
+ * @brief Evaluates a Query one batch of tuples at a time.
+ *
+ * Tuples are decoded into a batch of typed column vectors, holding only the columns the query
+ * uses. Once BATCH_SIZE tuples are buffered, each predicate is evaluated over a whole column in a
+ * tight loop that narrows down a selection vector of matching rows, and aggregates are folded
+ * over the selected rows column by column. Avoiding per-value type dispatch lets the compiler
+ * unroll and vectorize these loops. Grouped rows are assigned to groups through a hash table over
+ * their grouped values, which are kept in typed columns as well.
+ */
+class VectorExecutor {
+public:
+    static constexpr size_t BATCH_SIZE = 1024;
+
+    /**
+     * @brief Prepares to evaluate a query over tuples of the given types.
+     * @param types The types of the tuples' columns.
+     * @param query The query to evaluate.
+     * @throws std::invalid_argument if a column is out of range, if select is combined with
+     * aggregates or groupBy, or if SUM or AVG is applied to a string column.
+     * @throws std::runtime_error if a predicate's value has incorrect type.
+     */
+    VectorExecutor(const Vec<Vari> &types, Query query);
+
+    /**
+     * @brief Adds a tuple to the query's input.
+     * @param tuple The tuple. Must have the types given to the constructor.
+     */
+    void addRow(const Vec<Vari> &tuple);
+
+    /**
+     * @brief Evaluates the remaining input and returns the query's result. The executor must not
+     * be used afterwards.
+     * @return The result rows.
+     */
+    Vec<Vec<Vari>> finish();
+
+private:
+    // evaluates the predicates and folds the selected rows of the current batch into the result
+    void processBatch();
+
+    // narrows the selection down to the rows satisfying a predicate
+    void filter(const Predicate &predicate);
+
+    // maps every selected row to the index of its group, creating groups as needed
+    void assignGroups();
+
+    // checks whether a row of the batch has the grouped values of a group
+    bool isInGroup(u32 row, u32 group) const;
+
+    // creates a group holding a row of the batch, and returns its index
+    u32 addGroup(u32 row, size_t hash);
+
+    void accumulate(size_t aggregateIdx);
+
+    Vec<Vari> m_types;
+    Query m_query;
+    bool m_aggregating;
+    Vec<u16> m_used; // columns decoded into the batch
+
+    // current batch
+    Vec<Column> m_columns; // indexed by table column; unused columns stay empty
+    size_t m_numRows;
+    Vec<u32> m_selection;
+    size_t m_numSelected;
+    bool m_allSelected;
+
+    // projection output
+    Vec<Vec<Vari>> m_rows;
+
+    // aggregation state, indexed by group. Groups are found through the hash of their grouped
+    // values; groups whose hashes collide are chained together.
+    static constexpr u32 NO_GROUP = UINT32_MAX;
+    std::unordered_map<size_t, u32> m_groupIndex; // hash -> most recently added group
+    Vec<u32> m_nextGroup;     // next group with the same hash
+    Vec<Column> m_groupKeys;  // per grouped column
+    Vec<size_t> m_hashes;     // hash of each selected row of the batch
+    Vec<u32> m_groupOf;       // group of each selected row of the batch
+    Vec<u64> m_counts;
+    Vec<Vec<double>> m_sums;  // per aggregate
+    Vec<Column> m_extremes;   // per aggregate, for MIN and MAX
+};
+
+} // namespace backend
+
+#endif //KNDB_VECTOREXECUTOR_HPP
@@ -0,0 +1,110 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <set>
+
+#include "VersionStore.hpp"
+
+#include "BtreeNodePage.hpp"
+#include "utility.hpp"
+
+namespace backend {
+
+// a version is stored as {timestamp high, timestamp low, present, tuple...}, where the tuple holds
+// default values if it was not present
+namespace {
+
+constexpr size_t TUPLE_OFFSET = 3;
+
+u64 timestampOf(const Vec<Vari> &version) {
+    return static_cast<u64>(static_cast<u32>(std::get<int>(version[0]))) << 32 |
+           static_cast<u32>(std::get<int>(version[1]));
+}
+
+VersionStore::Version tupleOf(const Vec<Vari> &version) {
+    if (!std::get<bool>(version[2]))
+        return std::nullopt;
+    return Vec<Vari>(version.begin() + TUPLE_OFFSET, version.end());
+}
+
+} // namespace
+
+VersionStore::VersionStore(Pager &pgr, const Vec<Vari> &types) : VersionStore(pgr, types, cts::PGID_INVALID) {}
+
+VersionStore::VersionStore(Pager &pgr, const Vec<Vari> &types, pgid_t rootPageID) : m_pager(pgr), m_types(types) {
+    Vec<Vari> versionTypes{int(), int(), bool()};
+    versionTypes.insert(versionTypes.end(), types.begin(), types.end());
+
+    degree_t deg = calculateDegree(types[0], versionTypes);
+    if (rootPageID == cts::PGID_INVALID)
+        rootPageID = m_pager.createNewPage<BtreeNodePage<Vec<Vari>>>(
+                deg, cts::PGID_INVALID, true, true
+        ).getPageID();
+    m_versions = std::make_unique<Btree<Vec<Vari>>>(rootPageID, m_pager, deg, false);
+}
+
+VersionStore::~VersionStore() {
+    m_versions->deleteTree();
+}
+
+void VersionStore::add(const Vari &key, u64 commitTimestamp, const Version &before) {
+    Vec<Vari> version{static_cast<int>(commitTimestamp >> 32), static_cast<int>(static_cast<u32>(commitTimestamp)),
+                      before.has_value()};
+    version.insert(version.end(), before ? before->begin() : m_types.begin(), before ? before->end() : m_types.end());
+    m_versions->insert(std::move(version), key);
+    m_order.emplace(commitTimestamp, key);
+    m_size++;
+}
+
+std::optional<VersionStore::Version> VersionStore::find(const Vari &key, u64 snapshot) {
+    // the first change after the snapshot replaced the tuple the snapshot sees
+    std::optional<Version> res;
+    u64 first = 0;
+    for (const auto &version: m_versions->searchAll(key)) {
+        u64 ts = timestampOf(version);
+        if (ts > snapshot && (!res || ts < first)) {
+            res = tupleOf(version);
+            first = ts;
+        }
+    }
+    return res;
+}
+
+std::map<Vari, VersionStore::Version> VersionStore::changedSince(u64 snapshot) {
+    std::map<Vari, std::pair<u64, Version>> first;
+    m_versions->forEach([&](const Vari &key, const Vec<Vari> &version) {
+        u64 ts = timestampOf(version);
+        if (ts <= snapshot)
+            return;
+        auto it = first.find(key);
+        if (it == first.end() || ts < it->second.first)
+            first[key] = {ts, tupleOf(version)};
+    });
+
+    std::map<Vari, Version> res;
+    for (auto &[key, version]: first)
+        res.emplace(key, std::move(version.second));
+    return res;
+}
+
+void VersionStore::vacuum(u64 horizon) {
+    // a key may have several expired versions, which one lookup finds together
+    auto end = m_order.upper_bound(horizon);
+    std::set<Vari> keys;
+    for (auto it = m_order.begin(); it != end; ++it)
+        keys.insert(it->second);
+    m_order.erase(m_order.begin(), end);
+
+    // removing entries merges emptied nodes, which frees their pages
+    for (const auto &key: keys) {
+        for (const auto &version: m_versions->searchAll(key)) {
+            if (timestampOf(version) <= horizon) {
+                m_versions->remove(key, version);
+                m_size--;
+            }
+        }
+    }
+}
+
+} // namespace backend
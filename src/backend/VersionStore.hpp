@@ -0,0 +1,113 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_VERSIONSTORE_HPP
+#define KNDB_VERSIONSTORE_HPP
+
+#include <functional>
+#include <map>
+#include <optional>
+
+#include "Btree.hpp"
+#include "Pager.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class VersionStore
+ * @brief Keeps the versions of a table's tuples that changes replaced, for the snapshots that are
+ * still open.
+ *
+ * Each version is stored under the tuple's key, along with the commit timestamp of the change that
+ * replaced it, in a non-unique Btree. A version is the tuple as it was before the change, or its
+ * absence if the change inserted it. The versions only matter to open snapshots, which never
+ * outlive the StorageEngine, so the store frees its pages to the FreeSpaceMap when destroyed. Its
+ * table still records its root in the TablePage, so that a store left behind by a crash can be
+ * opened and destroyed when the table is opened again.
+ *
+ * The store also remembers, in memory, the keys of its versions in timestamp order, so a vacuum
+ * only visits the versions it removes. find() and changedSince() may be called from several
+ * threads at once, as long as no thread adds or vacuums versions meanwhile.
+ */
+class VersionStore {
+public:
+    /**
+     * The tuple a snapshot sees under a key, as given by the first change after the snapshot.
+     * std::nullopt if the key had no tuple.
+     */
+    using Version = std::optional<Vec<Vari>>;
+
+    /**
+     * @brief Constructs an empty store.
+     * @param pgr Reference to the Pager.
+     * @param types The column types of the table's tuples.
+     */
+    VersionStore(Pager &pgr, const Vec<Vari> &types);
+
+    /**
+     * @brief Opens an existing store, to free its pages.
+     * @param pgr Reference to the Pager.
+     * @param types The column types of the table's tuples.
+     * @param rootPageID The page ID of the store's root node.
+     */
+    VersionStore(Pager &pgr, const Vec<Vari> &types, pgid_t rootPageID);
+
+    /**
+     * @brief Frees every page of the store.
+     */
+    ~VersionStore();
+
+    /**
+     * @brief Keeps the version of a tuple that a change replaced.
+     * @param key The tuple's key.
+     * @param commitTimestamp The commit timestamp of the change.
+     * @param before The tuple before the change, or std::nullopt if the change inserted it.
+     */
+    void add(const Vari &key, u64 commitTimestamp, const Version &before);
+
+    /**
+     * @brief Finds the tuple a snapshot sees under a key, if it changed after the snapshot.
+     * @param key The key to look up.
+     * @param snapshot The snapshot's timestamp.
+     * @return The version the snapshot sees, or std::nullopt if the key did not change after the
+     * snapshot, in which case the table's current tuple is the one it sees.
+     */
+    std::optional<Version> find(const Vari &key, u64 snapshot);
+
+    /**
+     * @brief Collects the tuples a snapshot sees under every key that changed after it.
+     * @param snapshot The snapshot's timestamp.
+     * @return The versions the snapshot sees, by key.
+     */
+    std::map<Vari, Version> changedSince(u64 snapshot);
+
+    /**
+     * @brief Removes the versions replaced by changes up to a timestamp, which no snapshot from
+     * that timestamp on sees. Only the removed versions are visited.
+     * @param horizon The timestamp of the oldest open snapshot.
+     */
+    void vacuum(u64 horizon);
+
+    /**
+     * @return The number of versions kept.
+     */
+    u64 size() const { return m_size; }
+
+    /**
+     * @return The page ID of the store's root node, which changes as the store grows and shrinks.
+     */
+    pgid_t getRootPage() const { return m_versions->getRootPage(); }
+
+private:
+    Pager &m_pager;
+    Vec<Vari> m_types;
+    Ptr<Btree<Vec<Vari>>> m_versions;
+    std::multimap<u64, Vari> m_order; // the key of every version, by commit timestamp
+    u64 m_size = 0;
+};
+
+} // namespace backend
+
+#endif //KNDB_VERSIONSTORE_HPP
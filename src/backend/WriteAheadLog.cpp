@@ -0,0 +1,255 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <cstdio>
+#include <cstring>
+
+#include "WriteAheadLog.hpp"
+#include "utility.hpp"
+#include "assume.hpp"
+
+namespace backend {
+
+//    record:
+//    u32 payloadLength
+//    u32 checksum
+//    u8 type
+//    u64 txn
+//    -- CHANGE only --
+//    str table
+//    val key
+//    tuple before
+//    tuple after
+//
+//    str: u16 length, char chars[length]
+//    val: typeid_t type, then the value's bytes (or a str)
+//    tuple: bool present, then if present: u16 numValues, val values[numValues]
+
+namespace {
+
+constexpr size_t FRAME_SZ = 2 * sizeof(u32);
+
+u32 checksum(const byte *data, size_t len) {
+    // FNV-1a, folded to 32 bits
+    u64 hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= static_cast<u8>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return static_cast<u32>(hash ^ (hash >> 32));
+}
+
+class Encoder {
+public:
+    explicit Encoder(Vec<byte> &out) : m_out(out) {}
+
+    template<typename T>
+    void put(const T &val) {
+        static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+        auto bytes = reinterpret_cast<const byte *>(&val);
+        m_out.insert(m_out.end(), bytes, bytes + sizeof(T));
+    }
+
+    void put(const string &val) {
+        ASSUME_S(val.size() <= cts::U16_INVALID, "String is too long to be logged");
+        put(static_cast<u16>(val.size()));
+        auto bytes = reinterpret_cast<const byte *>(val.data());
+        m_out.insert(m_out.end(), bytes, bytes + val.size());
+    }
+
+    void put(const Vari &val) {
+        put(variant_to_type_id(val));
+        std::visit([this](const auto &arg) { put(arg); }, val);
+    }
+
+    void put(const std::optional<Vec<Vari>> &tuple) {
+        put(tuple.has_value());
+        if (!tuple)
+            return;
+        put(static_cast<u16>(tuple->size()));
+        for (const auto &val: *tuple)
+            put(val);
+    }
+
+private:
+    Vec<byte> &m_out;
+};
+
+// only decodes payloads whose checksum matched, so they were written by an Encoder
+class Decoder {
+public:
+    explicit Decoder(const byte *data) : m_data(data) {}
+
+    template<typename T>
+    void get(T &val) {
+        static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+        memcpy(&val, m_data + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+    }
+
+    void get(string &val) {
+        u16 len;
+        get(len);
+        val.assign(reinterpret_cast<const char *>(m_data + m_offset), len);
+        m_offset += len;
+    }
+
+    void get(Vari &val) {
+        typeid_t type;
+        get(type);
+        val = type_id_to_variant(type);
+        std::visit([this](auto &arg) { get(arg); }, val);
+    }
+
+    void get(std::optional<Vec<Vari>> &tuple) {
+        bool present;
+        get(present);
+        if (!present) {
+            tuple.reset();
+            return;
+        }
+        u16 size;
+        get(size);
+        tuple.emplace(size);
+        for (auto &val: *tuple)
+            get(val);
+    }
+
+private:
+    const byte *m_data;
+    size_t m_offset = 0;
+};
+
+} // namespace
+
+WriteAheadLog::WriteAheadLog(string fileName, bool readOnly) : m_fileName(std::move(fileName)), m_readOnly(readOnly) {
+    // a read-only log that does not exist is empty, and is not created
+    if (!readOnly)
+        m_ioHandler = std::make_unique<IOHandler>(m_fileName);
+    else if (FILE *file = std::fopen(m_fileName.c_str(), "rb")) {
+        std::fclose(file);
+        m_ioHandler = std::make_unique<IOHandler>(m_fileName, IOMode::READ_ONLY);
+    }
+
+    auto bytes = readFile();
+    m_durable = parse(bytes, nullptr);
+    u64 tailStart = m_durable - m_durable % cts::PG_SZ;
+    m_tail.assign(bytes.begin() + static_cast<ptrdiff_t>(tailStart), bytes.begin() + static_cast<ptrdiff_t>(m_durable));
+}
+
+void WriteAheadLog::append(const Record &record) {
+    ASSUME_S(!m_readOnly, "Cannot append to a read-only log");
+    Vec<byte> payload;
+    Encoder enc(payload);
+    enc.put(static_cast<u8>(record.type));
+    enc.put(record.txn);
+    if (record.type == Record::Type::CHANGE) {
+        enc.put(record.table);
+        enc.put(record.key);
+        enc.put(record.before);
+        enc.put(record.after);
+    }
+
+    std::lock_guard lock(m_mutex);
+    Encoder frame(m_buffer);
+    frame.put(static_cast<u32>(payload.size()));
+    frame.put(checksum(payload.data(), payload.size()));
+    m_buffer.insert(m_buffer.end(), payload.begin(), payload.end());
+
+    if (m_buffer.size() >= FLUSH_THRESHOLD)
+        flushLocked();
+}
+
+void WriteAheadLog::flush() {
+    std::lock_guard lock(m_mutex);
+    if (m_readOnly)
+        return;
+    flushLocked();
+}
+
+void WriteAheadLog::flushLocked() {
+    if (m_buffer.empty())
+        return;
+
+    // rewrite the partially filled last block along with the new records, zero padded to a block
+    Vec<byte> data = std::move(m_tail);
+    data.insert(data.end(), m_buffer.begin(), m_buffer.end());
+    data.resize((data.size() + cts::PG_SZ - 1) / cts::PG_SZ * cts::PG_SZ);
+
+    auto first = static_cast<blockid_t>(m_durable / cts::PG_SZ);
+    auto numBlocks = static_cast<blockid_t>(data.size() / cts::PG_SZ);
+    if (first + numBlocks > m_ioHandler->getNumBlocks())
+        m_ioHandler->createMultipleBlocks(static_cast<int>(first + numBlocks - m_ioHandler->getNumBlocks()));
+    m_ioHandler->writeBlocks(data.data(), first, numBlocks);
+
+    m_durable += m_buffer.size();
+    m_buffer.clear();
+    u64 tailStart = (m_durable / cts::PG_SZ - first) * cts::PG_SZ;
+    m_tail.assign(data.begin() + static_cast<ptrdiff_t>(tailStart),
+                  data.begin() + static_cast<ptrdiff_t>(tailStart + m_durable % cts::PG_SZ));
+}
+
+Vec<WriteAheadLog::Record> WriteAheadLog::readAll() const {
+    std::lock_guard lock(m_mutex);
+    Vec<Record> records;
+    parse(readFile(), &records);
+    return records;
+}
+
+void WriteAheadLog::truncate() {
+    ASSUME_S(!m_readOnly, "Cannot truncate a read-only log");
+    std::lock_guard lock(m_mutex);
+    m_ioHandler.reset();
+    std::remove(m_fileName.c_str());
+    m_ioHandler = std::make_unique<IOHandler>(m_fileName);
+    m_durable = 0;
+    m_tail.clear();
+    m_buffer.clear();
+}
+
+u64 WriteAheadLog::size() const {
+    std::lock_guard lock(m_mutex);
+    return m_durable + m_buffer.size();
+}
+
+Vec<byte> WriteAheadLog::readFile() const {
+    if (!m_ioHandler)
+        return {};
+    Vec<byte> bytes(static_cast<size_t>(m_ioHandler->getNumBlocks()) * cts::PG_SZ);
+    if (!bytes.empty())
+        m_ioHandler->readBlocks(bytes.data(), 0, m_ioHandler->getNumBlocks());
+    return bytes;
+}
+
+u64 WriteAheadLog::parse(const Vec<byte> &bytes, Vec<Record> *records) {
+    u64 offset = 0;
+    while (offset + FRAME_SZ <= bytes.size()) {
+        u32 len, sum;
+        memcpy(&len, bytes.data() + offset, sizeof(u32));
+        memcpy(&sum, bytes.data() + offset + sizeof(u32), sizeof(u32));
+        const byte *payload = bytes.data() + offset + FRAME_SZ;
+        if (len == 0 || len > bytes.size() - offset - FRAME_SZ || checksum(payload, len) != sum)
+            break;
+
+        if (records) {
+            Record record{};
+            Decoder dec(payload);
+            u8 type;
+            dec.get(type);
+            record.type = static_cast<Record::Type>(type);
+            dec.get(record.txn);
+            if (record.type == Record::Type::CHANGE) {
+                dec.get(record.table);
+                dec.get(record.key);
+                dec.get(record.before);
+                dec.get(record.after);
+            }
+            records->push_back(std::move(record));
+        }
+        offset += FRAME_SZ + len;
+    }
+    return offset;
+}
+
+} // namespace backend
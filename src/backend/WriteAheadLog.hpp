@@ -0,0 +1,113 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_WRITEAHEADLOG_HPP
+#define KNDB_WRITEAHEADLOG_HPP
+
+#include <mutex>
+#include <optional>
+
+#include "IOHandler.hpp"
+#include "kndb_types.hpp"
+
+namespace backend {
+
+/**
+ * @class WriteAheadLog
+ * @brief An append-only file of the changes made to tables, written before the pages they change.
+ *
+ * Records are buffered in memory by append() and made durable together by flush(), with a single
+ * write and a single sync however many records were buffered. The file is a stream of records
+ * packed across blocks, each framed as:
+ * - u32: length of the payload
+ * - u32: checksum of the payload
+ * - payload: the record, with values stored by type ID and strings by length
+ *
+ * A zero length or a checksum mismatch marks the end of the log, so a record torn by a crash in
+ * the middle of a flush is ignored along with everything after it.
+ *
+ * All member functions may be called from several threads at once.
+ */
+class WriteAheadLog {
+public:
+    /**
+     * @brief A logged event.
+     */
+    struct Record {
+        enum class Type : u8 {
+            CHANGE = 1, ///< A tuple of a table changed from 'before' to 'after'.
+            COMMIT,     ///< A transaction committed.
+            ABORT       ///< A transaction finished rolling back.
+        };
+
+        Type type;
+        u64 txn;                         ///< The transaction, or 0 for a change made outside of one.
+        string table;                    ///< The changed table. CHANGE only.
+        Vari key;                        ///< The changed tuple's key. CHANGE only.
+        std::optional<Vec<Vari>> before; ///< The tuple before the change, std::nullopt if inserted.
+        std::optional<Vec<Vari>> after;  ///< The tuple after the change, std::nullopt if deleted.
+    };
+
+    /**
+     * @brief Opens (or creates) a log, finding the end of its valid records.
+     * @param fileName The name of the log file.
+     * @param readOnly Whether to open the log without changing it, in which case it is not created
+     * if missing, and must not be appended to or truncated.
+     * @throws std::runtime_error if file operations fail.
+     */
+    explicit WriteAheadLog(string fileName, bool readOnly = false);
+
+    /**
+     * @brief Adds a record to the log. It is buffered until the next flush(), which happens
+     * automatically once enough records are buffered.
+     * @param record The record to add.
+     */
+    void append(const Record &record);
+
+    /**
+     * @brief Makes every appended record durable.
+     */
+    void flush();
+
+    /**
+     * @brief Reads back every durable record, in the order they were appended.
+     * @return The records.
+     */
+    Vec<Record> readAll() const;
+
+    /**
+     * @brief Discards every record, durable or not, by recreating the file empty.
+     */
+    void truncate();
+
+    /**
+     * @return The number of bytes appended since the log was last truncated.
+     */
+    u64 size() const;
+
+private:
+    // bytes buffered before append() flushes on its own
+    static constexpr size_t FLUSH_THRESHOLD = 1 << 20;
+
+    // parses the records in a stream of blocks and returns the offset of the end of the log.
+    static u64 parse(const Vec<byte> &bytes, Vec<Record> *records);
+
+    // reads every block of the file.
+    Vec<byte> readFile() const;
+
+    // m_mutex must be held.
+    void flushLocked();
+
+    string m_fileName;
+    bool m_readOnly;
+    Ptr<IOHandler> m_ioHandler; // nullptr if read-only and missing
+    u64 m_durable = 0;    // bytes of records in the file
+    Vec<byte> m_tail;     // the bytes of the last, partially filled block of the file
+    Vec<byte> m_buffer;   // framed records appended since the last flush
+    mutable std::mutex m_mutex;
+};
+
+} // namespace backend
+
+#endif //KNDB_WRITEAHEADLOG_HPP
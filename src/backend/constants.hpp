@@ -25,7 +25,8 @@ constexpr uint8_t SCHEMA_ID = 1;
 // page type id
 namespace pg_type_id {
 enum {
-    SCHEMA_PAGE = 1, FSM_PAGE, TABLE_PAGE, BTREE_NODE_PAGE
+    SCHEMA_PAGE = 1, FSM_PAGE, TABLE_PAGE, BTREE_NODE_PAGE, HASH_DIR_PAGE, HASH_BUCKET_PAGE,
+    LSM_RUN_PAGE, LSM_MANIFEST_PAGE, BLOOM_PAGE, SPILL_PAGE, STATS_PAGE
 };
 }
 
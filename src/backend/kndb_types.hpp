@@ -10,6 +10,7 @@
 #include <array>
 #include <variant>
 #include <memory>
+#include <new>
 
 #include "constants.hpp"
 
@@ -40,6 +41,40 @@ using byte = byte; // use windows byte typedef
 using byte = std::byte;
 #endif // _WIN32
 
+/**
+ * Allocates memory aligned to Align bytes.
+ */
+template<typename T, size_t Align>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Align>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Align> &) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+
+    void deallocate(T *p, size_t) {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Align> &) const { return true; }
+};
+
+/**
+ * Bytes aligned to a page, as buffers of direct I/O must be.
+ */
+using AlignedBytes = std::vector<byte, AlignedAllocator<byte, cts::PG_SZ>>;
+
 using u8 = uint8_t;
 using u16 = uint16_t;
 using u32 = uint32_t;
@@ -55,6 +90,17 @@ using typeid_t = u8;
 using bitmapidx_t = u32;
 using blockid_t = u32;
 
+/**
+ * Storage structure used for the tuples of a table.
+ * - BTREE keeps tuples ordered by primary key.
+ * - HASH answers exact primary key lookups in about one page access, but has no key order.
+ * - LSM buffers writes in memory and writes them out sequentially in sorted runs, for
+ *   write-heavy tables.
+ */
+enum class TableEngine : u8 {
+    BTREE = 1, HASH, LSM
+};
+
 struct RowPos {
     pgid_t pageID;
     cellid_t cellID;
@@ -5,6 +5,9 @@
 #ifndef KNDB_UTILITY_HPP
 #define KNDB_UTILITY_HPP
 
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <span>
 
 #include "kndb_types.hpp"
@@ -147,11 +150,68 @@ inline degree_t calculateDegree(const KeyType &key, const Vec<Vari> &values) {
     for (const auto &value: values) {
         cell_size += db_sizeof(value);
     }
-    const offset_t page_ptr_size = db_sizeof<u32>();
+    // each child takes a page pointer and a subtree count
+    const offset_t page_ptr_size = db_sizeof<u32>() + db_sizeof<u32>();
 
     return (free_space + cell_size) / (2 * (cell_size + page_ptr_size));
 }
 
+/**
+ * @brief Calculates how many cells fit into a hash bucket page.
+ * @param key A key of the type stored in the bucket.
+ * @param values A value of the type stored in the bucket.
+ * @return The max number of cells per bucket page.
+ */
+template<typename KeyType>
+inline u16 calculateBucketCapacity(const KeyType &key, const Vec<Vari> &values) {
+    static constexpr offset_t metadataBuffer = 100;
+    constexpr offset_t free_space = cts::PG_SZ - metadataBuffer;
+
+    offset_t cell_size = 0;
+    cell_size += db_sizeof(key);
+    for (const auto &value: values) {
+        cell_size += db_sizeof(value);
+    }
+
+    return free_space / cell_size;
+}
+
+/**
+ * @brief Hashes a variant into a 64-bit value that is stable across runs and platforms.
+ *
+ * Uses FNV-1a over the value's bytes (or the characters of a string), so hashes can be persisted
+ * in on-disk structures. Floating point values are canonicalized first, so -0.0 hashes like 0.0
+ * and every NaN hashes alike.
+ *
+ * @param val The variant to hash.
+ * @return The hash.
+ */
+inline u64 db_hash(const Vari &val) {
+    static constexpr u64 fnv_offset = 14695981039346656037ULL;
+    static constexpr u64 fnv_prime = 1099511628211ULL;
+
+    auto hash_bytes = [](const void *data, size_t len) {
+        u64 hash = fnv_offset;
+        auto bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < len; i++) {
+            hash ^= bytes[i];
+            hash *= fnv_prime;
+        }
+        return hash;
+    };
+
+    return std::visit([&hash_bytes](auto &&arg) {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_same_v<T, std::string>)
+            return hash_bytes(arg.data(), arg.size());
+        else if constexpr (std::is_floating_point_v<T>) {
+            T canonical = std::isnan(arg) ? std::numeric_limits<T>::quiet_NaN() : arg == 0 ? T(0) : arg;
+            return hash_bytes(&canonical, sizeof(T));
+        } else
+            return hash_bytes(&arg, sizeof(T));
+    }, val);
+}
+
 inline bool sameTypes(const Vec<Vari> &vec1, const Vec<Vari> &vec2) {
     if (vec1.size() != vec2.size()) return false;
     for (int i = 0; i < vec1.size(); i++)
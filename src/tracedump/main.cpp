@@ -0,0 +1,170 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+// kndb_tracedump: lists the records of a trace file written by Tracer::save(), or replays its page
+// accesses against LRU caches of other sizes.
+//
+
+#include <cstdio>
+#include <iostream>
+#include <list>
+#include <map>
+#include <unordered_map>
+
+#include "Tracer.hpp"
+
+using namespace backend;
+
+namespace {
+
+constexpr const char *USAGE = R"(usage: kndb_tracedump FILE [--lru=N[,N...]]
+
+  Lists every traced call in FILE: its operation, start time, time per layer, bytes moved and the
+  pages it accessed (h: hit, m: miss, i: inserted without a read, w: written back), followed by a
+  summary per operation.
+
+  --lru=N[,N...]   instead, replays the page accesses against an LRU cache of each size N (in
+                   pages) and reports each one's hit ratio next to the traced cache's
+)";
+
+const char *opName(TraceOp op) {
+    switch (op) {
+        case TraceOp::INSERT: return "INSERT";
+        case TraceOp::UPDATE: return "UPDATE";
+        case TraceOp::REMOVE: return "REMOVE";
+        case TraceOp::GET: return "GET";
+        case TraceOp::RANGE: return "RANGE";
+        case TraceOp::COMMIT: return "COMMIT";
+        case TraceOp::ABORT: return "ABORT";
+        case TraceOp::CHECKPOINT: return "CHECKPOINT";
+    }
+    return "UNKNOWN";
+}
+
+double us(u64 ns) { return static_cast<double>(ns) / 1000; }
+
+void list(const Vec<Tracer::Record> &records) {
+    constexpr char ACCESS_CODES[] = {'h', 'm', 'i', 'w'};
+    struct Totals {
+        u64 count = 0, totalNs = 0, cacheNs = 0, ioNs = 0, codecNs = 0, pages = 0;
+    };
+    std::map<string, Totals> totals;
+
+    for (const auto &rec: records) {
+        std::printf("%12.3f ms %-10s total=%.1fus cache=%.1fus io=%.1fus codec=%.1fus read=%llu written=%llu "
+                    "serialized=%llu pages=%zu:", static_cast<double>(rec.startNs) / 1e6, opName(rec.op),
+                    us(rec.totalNs), us(rec.cacheNs), us(rec.ioNs), us(rec.codecNs),
+                    static_cast<unsigned long long>(rec.bytesRead), static_cast<unsigned long long>(rec.bytesWritten),
+                    static_cast<unsigned long long>(rec.bytesSerialized), rec.pages.size());
+        for (const auto &[pageID, access]: rec.pages)
+            std::printf(" %u%c", pageID, ACCESS_CODES[static_cast<u8>(access) & 3]);
+        std::printf("\n");
+
+        auto &t = totals[opName(rec.op)];
+        t.count++;
+        t.totalNs += rec.totalNs;
+        t.cacheNs += rec.cacheNs;
+        t.ioNs += rec.ioNs;
+        t.codecNs += rec.codecNs;
+        t.pages += rec.pages.size();
+    }
+
+    std::printf("\n%-10s %10s %12s %12s %12s %12s %10s\n", "op", "count", "avg total", "avg cache", "avg io",
+                "avg codec", "avg pages");
+    for (const auto &[op, t]: totals) {
+        auto n = static_cast<double>(t.count);
+        std::printf("%-10s %10llu %10.1fus %10.1fus %10.1fus %10.1fus %10.1f\n", op.c_str(),
+                    static_cast<unsigned long long>(t.count), us(t.totalNs) / n, us(t.cacheNs) / n, us(t.ioNs) / n,
+                    us(t.codecNs) / n, static_cast<double>(t.pages) / n);
+    }
+}
+
+// replays the accesses against an LRU cache of 'capacity' pages; returns the number of reads it
+// would have made. Inserted pages are cached without a read, and write-backs do not move pages.
+u64 replayLru(const Vec<Tracer::Record> &records, size_t capacity) {
+    std::list<pgid_t> lru;
+    std::unordered_map<pgid_t, std::list<pgid_t>::iterator> cached;
+    u64 misses = 0;
+    for (const auto &rec: records) {
+        for (const auto &[pageID, access]: rec.pages) {
+            if (access == PageAccess::WRITE)
+                continue;
+            if (auto it = cached.find(pageID); it != cached.end()) {
+                lru.splice(lru.begin(), lru, it->second);
+                continue;
+            }
+            if (access != PageAccess::INSERT)
+                misses++;
+            lru.push_front(pageID);
+            cached[pageID] = lru.begin();
+            if (lru.size() > capacity) {
+                cached.erase(lru.back());
+                lru.pop_back();
+            }
+        }
+    }
+    return misses;
+}
+
+void replay(const Vec<Tracer::Record> &records, const Vec<size_t> &capacities) {
+    u64 hits = 0, misses = 0;
+    for (const auto &rec: records)
+        for (const auto &[pageID, access]: rec.pages) {
+            hits += access == PageAccess::HIT;
+            misses += access == PageAccess::MISS;
+        }
+
+    u64 retrievals = hits + misses;
+    auto ratio = [&](u64 m) { return retrievals == 0 ? 0 : 100.0 * static_cast<double>(retrievals - m) /
+                                                           static_cast<double>(retrievals); };
+    std::printf("%-14s %12s %12s %10s\n", "cache", "retrievals", "misses", "hit ratio");
+    std::printf("%-14s %12llu %12llu %9.2f%%\n", "traced", static_cast<unsigned long long>(retrievals),
+                static_cast<unsigned long long>(misses), ratio(misses));
+    for (size_t capacity: capacities) {
+        u64 m = replayLru(records, capacity);
+        std::printf("%-14s %12llu %12llu %9.2f%%\n", ("lru " + std::to_string(capacity)).c_str(),
+                    static_cast<unsigned long long>(retrievals), static_cast<unsigned long long>(m), ratio(m));
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    string fileName;
+    Vec<size_t> capacities;
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--help") {
+                std::cout << USAGE;
+                return 0;
+            }
+            if (arg.starts_with("--lru=")) {
+                size_t pos = 6;
+                while (pos < arg.size()) {
+                    size_t comma = std::min(arg.find(',', pos), arg.size());
+                    capacities.push_back(std::stoull(arg.substr(pos, comma - pos)));
+                    pos = comma + 1;
+                }
+                if (capacities.empty())
+                    throw std::invalid_argument("--lru needs at least one cache size.");
+            } else if (!arg.starts_with("--") && fileName.empty()) {
+                fileName = arg;
+            } else {
+                throw std::invalid_argument("Unexpected argument '" + arg + "'.");
+            }
+        }
+        if (fileName.empty())
+            throw std::invalid_argument("No trace file given.");
+
+        auto records = Tracer::load(fileName);
+        if (capacities.empty())
+            list(records);
+        else
+            replay(records, capacities);
+    } catch (const std::exception &e) {
+        std::cerr << "kndb_tracedump: " << e.what() << "\n\n" << USAGE;
+        return 1;
+    }
+    return 0;
+}
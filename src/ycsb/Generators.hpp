@@ -0,0 +1,125 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#ifndef KNDB_YCSB_GENERATORS_HPP
+#define KNDB_YCSB_GENERATORS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace ycsb {
+
+/**
+ * @class ZipfianGenerator
+ * @brief Draws items 0..n-1 with probability proportional to 1/(rank+1)^theta, item 0 being the
+ * most popular, using the rejection-free method of Gray et al. ("Quickly Generating Billion-Record
+ * Synthetic Databases"), as YCSB does.
+ *
+ * Construction takes O(n) to compute the zeta constant; drawing is O(1). The generator is
+ * immutable, so threads can share it, each with its own random engine.
+ */
+class ZipfianGenerator {
+public:
+    static constexpr double YCSB_THETA = 0.99;
+
+    explicit ZipfianGenerator(uint64_t n, double theta = YCSB_THETA) : m_n(n), m_theta(theta) {
+        double zeta2 = 0;
+        for (uint64_t i = 1; i <= 2; i++)
+            zeta2 += 1 / std::pow(static_cast<double>(i), theta);
+        for (uint64_t i = 1; i <= n; i++)
+            m_zetaN += 1 / std::pow(static_cast<double>(i), theta);
+        m_alpha = 1 / (1 - theta);
+        m_eta = (1 - std::pow(2.0 / static_cast<double>(n), 1 - theta)) / (1 - zeta2 / m_zetaN);
+    }
+
+    template<typename Rng>
+    uint64_t next(Rng &rng) const {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        double uz = u * m_zetaN;
+        if (uz < 1)
+            return 0;
+        if (uz < 1 + std::pow(0.5, m_theta))
+            return 1;
+        auto item = static_cast<uint64_t>(static_cast<double>(m_n) * std::pow(m_eta * u - m_eta + 1, m_alpha));
+        return std::min(item, m_n - 1);
+    }
+
+private:
+    uint64_t m_n;
+    double m_theta;
+    double m_zetaN = 0;
+    double m_alpha;
+    double m_eta;
+};
+
+/**
+ * @brief How the keys of reads, updates and scans are chosen.
+ */
+enum class Distribution {
+    UNIFORM, ///< Every loaded key equally often.
+    ZIPFIAN, ///< A few keys very often, scattered over the key space.
+    LATEST   ///< The most recently inserted keys most often.
+};
+
+/**
+ * @class KeyChooser
+ * @brief Chooses existing keys by a Distribution, and hands out new keys to inserts.
+ *
+ * Keys 0..recordCount-1 are loaded first and inserts continue from there. Popular zipfian keys are
+ * scattered by hashing, as in YCSB's scrambled zipfian generator, so they do not all sit in one
+ * leaf. The latest distribution counts zipfian ranks back from the newest inserted key. Shared by
+ * every thread.
+ */
+class KeyChooser {
+public:
+    KeyChooser(Distribution distribution, uint64_t recordCount)
+            : m_distribution(distribution), m_recordCount(recordCount), m_zipf(recordCount),
+              m_nextInsert(recordCount) {}
+
+    /**
+     * @return A key that was loaded or inserted.
+     */
+    template<typename Rng>
+    uint64_t existing(Rng &rng) const {
+        switch (m_distribution) {
+            case Distribution::UNIFORM:
+                return std::uniform_int_distribution<uint64_t>(0, m_recordCount - 1)(rng);
+            case Distribution::ZIPFIAN:
+                return fnv(m_zipf.next(rng)) % m_recordCount;
+            case Distribution::LATEST: {
+                uint64_t latest = m_nextInsert.load(std::memory_order_relaxed) - 1;
+                return latest - std::min(m_zipf.next(rng), latest);
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * @return A key that was never handed out before.
+     */
+    uint64_t insert() { return m_nextInsert.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    static uint64_t fnv(uint64_t val) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (int i = 0; i < 8; i++) {
+            hash ^= val & 0xff;
+            hash *= 1099511628211ULL;
+            val >>= 8;
+        }
+        return hash;
+    }
+
+    Distribution m_distribution;
+    uint64_t m_recordCount;
+    ZipfianGenerator m_zipf;
+    std::atomic<uint64_t> m_nextInsert;
+};
+
+} // namespace ycsb
+
+#endif //KNDB_YCSB_GENERATORS_HPP
@@ -0,0 +1,396 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+// kndb_ycsb: runs the YCSB core workloads A-F against a StorageEngine and reports throughput and
+// latency percentiles per operation. Run with --help for the options.
+//
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#include "Generators.hpp"
+#include "Metrics.hpp"
+#include "SchemaPage.hpp"
+#include "StorageEngine.hpp"
+#include "Tracer.hpp"
+
+using namespace backend;
+
+namespace ycsb {
+
+namespace {
+
+enum Op { READ, UPDATE, INSERT, SCAN, READ_MODIFY_WRITE, NUM_OPS };
+
+constexpr const char *OP_NAMES[NUM_OPS] = {"READ", "UPDATE", "INSERT", "SCAN", "READ-MODIFY-WRITE"};
+
+struct Options {
+    double proportions[NUM_OPS] = {};
+    Distribution distribution = Distribution::ZIPFIAN;
+    u64 records = 100000;
+    u64 operations = 100000;
+    unsigned threads = 1;
+    unsigned fieldCount = 10;
+    unsigned fieldLength = 100;
+    unsigned maxScan = 100;
+    TableEngine engine = TableEngine::BTREE;
+    string dbFile = "ycsb.db";
+    IOMode ioMode = IOMode::READ_WRITE;
+    size_t cachePages = cts::CACHE_SZ;
+    string metrics = "none";
+    string traceFile;
+};
+
+constexpr const char *USAGE = R"(usage: kndb_ycsb [--option=value ...]
+
+  --workload=a|b|c|d|e|f       core workload to run (default a)
+                                 a: 50% read, 50% update, zipfian
+                                 b: 95% read, 5% update, zipfian
+                                 c: 100% read, zipfian
+                                 d: 95% read, 5% insert, latest
+                                 e: 95% scan, 5% insert, zipfian
+                                 f: 50% read, 50% read-modify-write, zipfian
+  --read=P --update=P --insert=P --scan=P --rmw=P
+                               override the workload's operation proportions
+  --distribution=uniform|zipfian|latest
+                               override the workload's key distribution
+  --records=N                  records loaded before the run (default 100000)
+  --operations=N               operations in the run (default 100000)
+  --threads=N                  client threads (default 1)
+  --fieldcount=N               string fields per record (default 10)
+  --fieldlength=N              characters per field, at most 127 (default 100)
+  --maxscan=N                  longest scan, in records (default 100)
+  --engine=btree|hash|lsm      table engine (default btree)
+  --db=FILE                    database file, replaced if it exists (default ycsb.db)
+  --io=rw|mmap|direct|compressed
+                               how the database file is read and written (default rw)
+  --cache=N                    page cache capacity, in pages (default 100000)
+  --metrics=none|text|json     also print the storage layers' metrics for the run (default none)
+  --trace=FILE                 trace the run's storage engine calls into FILE, for kndb_tracedump
+)";
+
+void setWorkload(Options &opts, char workload) {
+    std::fill(std::begin(opts.proportions), std::end(opts.proportions), 0);
+    opts.distribution = Distribution::ZIPFIAN;
+    switch (workload) {
+        case 'a': opts.proportions[READ] = 0.5; opts.proportions[UPDATE] = 0.5; break;
+        case 'b': opts.proportions[READ] = 0.95; opts.proportions[UPDATE] = 0.05; break;
+        case 'c': opts.proportions[READ] = 1; break;
+        case 'd':
+            opts.proportions[READ] = 0.95;
+            opts.proportions[INSERT] = 0.05;
+            opts.distribution = Distribution::LATEST;
+            break;
+        case 'e': opts.proportions[SCAN] = 0.95; opts.proportions[INSERT] = 0.05; break;
+        case 'f': opts.proportions[READ] = 0.5; opts.proportions[READ_MODIFY_WRITE] = 0.5; break;
+        default: throw std::invalid_argument("Unknown workload.");
+    }
+}
+
+Options parseOptions(int argc, char **argv) {
+    Options opts;
+    setWorkload(opts, 'a');
+
+    // the workload goes first, so that the other options override it
+    std::map<string, string> args;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        auto eq = arg.find('=');
+        if (!arg.starts_with("--") || eq == string::npos)
+            throw std::invalid_argument("Expected --option=value, got '" + arg + "'.");
+        args[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    if (args.contains("workload")) {
+        if (args["workload"].size() != 1)
+            throw std::invalid_argument("Unknown workload.");
+        setWorkload(opts, static_cast<char>(std::tolower(args["workload"][0])));
+        args.erase("workload");
+    }
+
+    const std::map<string, Op> proportionNames{
+            {"read", READ}, {"update", UPDATE}, {"insert", INSERT}, {"scan", SCAN}, {"rmw", READ_MODIFY_WRITE}};
+    for (const auto &[name, value]: args) {
+        if (auto it = proportionNames.find(name); it != proportionNames.end())
+            opts.proportions[it->second] = std::stod(value);
+        else if (name == "distribution")
+            opts.distribution = value == "uniform" ? Distribution::UNIFORM
+                    : value == "latest" ? Distribution::LATEST
+                    : value == "zipfian" ? Distribution::ZIPFIAN
+                    : throw std::invalid_argument("Unknown distribution.");
+        else if (name == "records") opts.records = std::stoull(value);
+        else if (name == "operations") opts.operations = std::stoull(value);
+        else if (name == "threads") opts.threads = std::stoul(value);
+        else if (name == "fieldcount") opts.fieldCount = std::stoul(value);
+        else if (name == "fieldlength") opts.fieldLength = std::stoul(value);
+        else if (name == "maxscan") opts.maxScan = std::stoul(value);
+        else if (name == "engine")
+            opts.engine = value == "btree" ? TableEngine::BTREE
+                    : value == "hash" ? TableEngine::HASH
+                    : value == "lsm" ? TableEngine::LSM
+                    : throw std::invalid_argument("Unknown engine.");
+        else if (name == "db") opts.dbFile = value;
+        else if (name == "io")
+            opts.ioMode = value == "rw" ? IOMode::READ_WRITE
+                    : value == "mmap" ? IOMode::MMAP
+                    : value == "direct" ? IOMode::DIRECT
+                    : value == "compressed" ? IOMode::COMPRESSED
+                    : throw std::invalid_argument("Unknown I/O mode.");
+        else if (name == "cache") opts.cachePages = std::stoull(value);
+        else if (name == "metrics") {
+            if (value != "none" && value != "text" && value != "json")
+                throw std::invalid_argument("Unknown metrics format.");
+            opts.metrics = value;
+        }
+        else if (name == "trace") opts.traceFile = value;
+        else throw std::invalid_argument("Unknown option --" + name + ".");
+    }
+
+    if (opts.records == 0 || opts.records > static_cast<u64>(std::numeric_limits<int>::max()) / 2)
+        throw std::invalid_argument("--records is out of range.");
+    if (opts.threads == 0)
+        throw std::invalid_argument("--threads must be positive.");
+    if (opts.fieldLength > cts::MAX_STR_LEN)
+        throw std::invalid_argument("--fieldlength cannot exceed " + std::to_string(cts::MAX_STR_LEN) + ".");
+    if (opts.maxScan == 0)
+        throw std::invalid_argument("--maxscan must be positive.");
+    if (opts.cachePages == 0)
+        throw std::invalid_argument("--cache must be positive.");
+    return opts;
+}
+
+// The database and the table the workload runs on. The StorageEngine is not thread-safe, so client
+// threads take turns through a mutex.
+class Database {
+public:
+    explicit Database(const Options &opts) : m_fileName(opts.dbFile) {
+        removeFiles();
+        m_ioHandler = std::make_unique<IOHandler>(m_fileName, opts.ioMode);
+        m_pageCache = std::make_unique<PageCache>(*m_ioHandler, opts.cachePages);
+        m_fsm = std::make_unique<FreeSpaceMap>(*m_pageCache);
+        m_pager = std::make_unique<Pager>(*m_fsm, *m_ioHandler, *m_pageCache);
+        m_pager->createNewPage<SchemaPage>();
+        engine = std::make_unique<StorageEngine>(*m_pager, cts::SCHEMA_ID);
+
+        Vec<Vari> types{int()};
+        types.insert(types.end(), opts.fieldCount, string());
+        engine->createTable("usertable", types, opts.engine);
+        table = *engine->openTable("usertable");
+    }
+
+    ~Database() {
+        engine.reset();
+        m_pager.reset();
+        m_fsm.reset();
+        m_pageCache.reset();
+        m_ioHandler.reset();
+        removeFiles();
+    }
+
+    std::unique_ptr<StorageEngine> engine;
+    TableHandle table;
+    std::mutex mutex;
+
+private:
+    // removes the database file and the files stored next to it (log, slot map and LSM runs)
+    void removeFiles() const {
+        auto path = std::filesystem::absolute(m_fileName);
+        string name = path.filename().string();
+        for (const auto &entry: std::filesystem::directory_iterator(path.parent_path())) {
+            string entryName = entry.path().filename().string();
+            if (entryName == name || entryName.starts_with(name + "."))
+                std::filesystem::remove(entry.path());
+        }
+    }
+
+    string m_fileName;
+    std::unique_ptr<IOHandler> m_ioHandler;
+    std::unique_ptr<PageCache> m_pageCache;
+    std::unique_ptr<FreeSpaceMap> m_fsm;
+    std::unique_ptr<Pager> m_pager;
+};
+
+// One client thread: draws operations and keys, and records each operation's latency.
+class Client {
+public:
+    Client(const Options &opts, Database &db, KeyChooser &keys, unsigned seed)
+            : m_opts(opts), m_db(db), m_keys(keys), m_rng(seed) {
+        // a few random values to cycle through, so generating them does not count as latency
+        std::uniform_int_distribution<int> letter('a', 'z');
+        for (auto &value: m_values) {
+            value.resize(opts.fieldLength);
+            for (auto &c: value)
+                c = static_cast<char>(letter(m_rng));
+        }
+    }
+
+    void run(u64 operations) {
+        std::discrete_distribution<int> pickOp(std::begin(m_opts.proportions), std::end(m_opts.proportions));
+        for (u64 i = 0; i < operations; i++) {
+            auto op = static_cast<Op>(pickOp(m_rng));
+            auto start = std::chrono::steady_clock::now();
+            execute(op);
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            histograms[op].record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+    }
+
+    void insert(u64 key) {
+        auto tuple = makeTuple(key);
+        std::lock_guard lock(m_db.mutex);
+        m_db.engine->insertTuple(m_db.table, tuple);
+    }
+
+    Histogram histograms[NUM_OPS];
+
+private:
+    Vec<Vari> makeTuple(u64 key) {
+        Vec<Vari> tuple{static_cast<int>(key)};
+        for (unsigned i = 0; i < m_opts.fieldCount; i++)
+            tuple.emplace_back(m_values[(key + i + m_next++) % m_values.size()]);
+        return tuple;
+    }
+
+    void execute(Op op) {
+        switch (op) {
+            case READ: {
+                Vari key = static_cast<int>(m_keys.existing(m_rng));
+                std::lock_guard lock(m_db.mutex);
+                m_db.engine->getTuple(m_db.table, key);
+                break;
+            }
+            case UPDATE: {
+                auto tuple = makeTuple(m_keys.existing(m_rng));
+                std::lock_guard lock(m_db.mutex);
+                m_db.engine->updateTuple(m_db.table, tuple);
+                break;
+            }
+            case INSERT:
+                insert(m_keys.insert());
+                break;
+            case SCAN: {
+                Vari start = static_cast<int>(m_keys.existing(m_rng));
+                u64 length = std::uniform_int_distribution<u64>(1, m_opts.maxScan)(m_rng);
+                std::lock_guard lock(m_db.mutex);
+                m_db.engine->getTuplesFrom(m_db.table, m_db.engine->getRank(m_db.table, start), length);
+                break;
+            }
+            case READ_MODIFY_WRITE: {
+                u64 key = m_keys.existing(m_rng);
+                auto tuple = makeTuple(key);
+                std::lock_guard lock(m_db.mutex);
+                if (m_db.engine->getTuple(m_db.table, static_cast<int>(key)))
+                    m_db.engine->updateTuple(m_db.table, tuple);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    const Options &m_opts;
+    Database &m_db;
+    KeyChooser &m_keys;
+    std::mt19937_64 m_rng;
+    std::array<string, 16> m_values;
+    u64 m_next = 0;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char *phase, u64 operations, double seconds) {
+    std::printf("[%s] operations: %llu, time: %.3f s, throughput: %.0f ops/s\n", phase,
+                static_cast<unsigned long long>(operations), seconds, static_cast<double>(operations) / seconds);
+}
+
+void report(const char *op, const HistogramSnapshot &histogram) {
+    auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000; };
+    std::printf("[%s] count: %llu, avg: %.1f us, p50: %.1f us, p99: %.1f us, p999: %.1f us, max: %.1f us\n", op,
+                static_cast<unsigned long long>(histogram.count()), histogram.mean() / 1000,
+                us(histogram.percentile(0.5)), us(histogram.percentile(0.99)), us(histogram.percentile(0.999)),
+                us(histogram.max()));
+}
+
+int run(const Options &opts) {
+    Database db(opts);
+    KeyChooser keys(opts.distribution, opts.records);
+
+    // load phase: the records are inserted in a scattered order, as YCSB's hashed insert order does
+    auto start = std::chrono::steady_clock::now();
+    {
+        Client loader(opts, db, keys, 0);
+        Vec<u64> order(opts.records);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937_64(152));
+        for (u64 key: order)
+            loader.insert(key);
+    }
+    report("LOAD", opts.records, secondsSince(start));
+
+    Vec<std::unique_ptr<Client>> clients;
+    for (unsigned i = 0; i < opts.threads; i++)
+        clients.push_back(std::make_unique<Client>(opts, db, keys, i + 1));
+
+    // the metrics and the trace then cover the run phase only
+    MetricsRegistry::global().reset();
+    if (!opts.traceFile.empty())
+        Tracer::global().start();
+    start = std::chrono::steady_clock::now();
+    Vec<std::thread> threads;
+    for (unsigned i = 0; i < opts.threads; i++)
+        threads.emplace_back([&, i] {
+            clients[i]->run(opts.operations / opts.threads + (i < opts.operations % opts.threads));
+        });
+    for (auto &thread: threads)
+        thread.join();
+    report("RUN", opts.operations, secondsSince(start));
+
+    if (!opts.traceFile.empty()) {
+        Tracer::global().stop();
+        Tracer::global().save(opts.traceFile);
+        std::printf("[TRACE] saved to %s, %llu records overwritten\n", opts.traceFile.c_str(),
+                    static_cast<unsigned long long>(Tracer::global().dropped()));
+    }
+
+    for (int op = 0; op < NUM_OPS; op++) {
+        HistogramSnapshot merged;
+        for (const auto &client: clients)
+            merged.merge(client->histograms[op].snapshot());
+        if (merged.count() > 0)
+            report(OP_NAMES[op], merged);
+    }
+
+    if (opts.metrics == "text")
+        std::cout << "\n" << MetricsRegistry::global().snapshot().toText();
+    else if (opts.metrics == "json")
+        std::cout << "\n" << MetricsRegistry::global().snapshot().toJson() << "\n";
+    return 0;
+}
+
+} // namespace
+
+} // namespace ycsb
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--help") {
+            std::cout << ycsb::USAGE;
+            return 0;
+        }
+    }
+
+    try {
+        return ycsb::run(ycsb::parseOptions(argc, argv));
+    } catch (const std::exception &e) {
+        std::cerr << "kndb_ycsb: " << e.what() << "\n\n" << ycsb::USAGE;
+        return 1;
+    }
+}
@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 #include <fstream>
 #include <random>
+#include <thread>
 
 #include "Btree.hpp"
 #include "BtreeNodePage.hpp"
@@ -45,6 +46,23 @@ protected:
         btree = std::make_unique<Btree<Vec<Vari>>>(root_id, *pager, DEGREE);
     }
 
+    // checks the subtree counts and parent pointers below a node, returning the subtree's size
+    u64 checkSubtree(pgid_t pageID, pgid_t parentID) {
+        const auto &node = pager->viewPage<BtreeNodePage<Vec<Vari>>>(pageID);
+        if (!node.root())
+            EXPECT_EQ(node.parent(), parentID);
+        // copied, since the node may be evicted while its children are checked
+        Vec<childid_t> children = node.getChildren();
+        Vec<u32> counts = node.getChildCounts();
+        u64 size = node.cells().size();
+        for (size_t i = 0; i < children.size(); i++) {
+            u64 childSize = checkSubtree(children[i], pageID);
+            EXPECT_EQ(counts[i], childSize);
+            size += childSize;
+        }
+        return size;
+    }
+
     void resetEnv() {
         btree.reset();
         pager.reset();
@@ -96,3 +114,263 @@ TEST_F(BtreeTest, StressTestInsertAndSearchOneHundredThousand) {
         ASSERT_EQ(btree->search(keys[i]), tuples[i]);
     }
 }
+
+TEST_F(BtreeTest, BasicRemoveWorks) {
+    Vec<Vari> tuple = {"kylan", double(3.0), 4};
+    btree->insert(tuple, "kylan");
+    ASSERT_TRUE(btree->remove("kylan"));
+    ASSERT_EQ(btree->search("kylan"), std::nullopt);
+    ASSERT_FALSE(btree->remove("kylan"));
+}
+
+TEST_F(BtreeTest, StressTestRemoveWithSmallDegree) {
+    // a small degree forces borrows, merges and root shrinks
+    static constexpr u16 SMALL_DEGREE = 3;
+    pgid_t small_root = pager->createNewPage<BtreeNodePage<Vec<Vari>>>(
+        SMALL_DEGREE, cts::U32_INVALID, true, true
+    ).getPageID();
+    Btree<Vec<Vari>> small(small_root, *pager, SMALL_DEGREE);
+
+    Vec<int> keys(5000);
+    std::iota(keys.begin(), keys.end(), 1);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(SEED));
+    for (int key : keys)
+        ASSERT_TRUE(small.insert({key, double(key * 1.5)}, key));
+
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(SEED + 1));
+    for (int i = 0; i < keys.size() / 2; i++)
+        ASSERT_TRUE(small.remove(keys[i]));
+
+    for (int i = 0; i < keys.size(); i++) {
+        if (i < keys.size() / 2)
+            ASSERT_EQ(small.search(keys[i]), std::nullopt);
+        else
+            ASSERT_EQ(small.search(keys[i]), (Vec<Vari>{keys[i], double(keys[i] * 1.5)}));
+    }
+
+    for (int i = keys.size() / 2; i < keys.size(); i++)
+        ASSERT_TRUE(small.remove(keys[i]));
+
+    int remaining = 0;
+    small.forEach([&](const Vari &, const Vec<Vari> &) { remaining++; });
+    ASSERT_EQ(remaining, 0);
+}
+
+TEST_F(BtreeTest, ForEachVisitsKeysInOrder) {
+    Vec<int> keys(10000);
+    std::iota(keys.begin(), keys.end(), 1);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(SEED));
+    for (int key : keys)
+        btree->insert({key}, key);
+
+    int expected = 1;
+    btree->forEach([&](const Vari &key, const Vec<Vari> &value) {
+        ASSERT_EQ(key, Vari(expected));
+        ASSERT_EQ(value, Vec<Vari>{expected});
+        expected++;
+    });
+    ASSERT_EQ(expected, 10001);
+}
+
+TEST_F(BtreeTest, NonUniqueTreeStoresDuplicates) {
+    static constexpr u16 SMALL_DEGREE = 3;
+    pgid_t dup_root = pager->createNewPage<BtreeNodePage<Vec<Vari>>>(
+        SMALL_DEGREE, cts::U32_INVALID, true, true
+    ).getPageID();
+    Btree<Vec<Vari>> dup(dup_root, *pager, SMALL_DEGREE, false);
+
+    // 20 distinct keys, 50 entries each, inserted interleaved
+    for (int i = 0; i < 1000; i++)
+        ASSERT_TRUE(dup.insert({i}, i % 20));
+
+    for (int k = 0; k < 20; k++) {
+        auto values = dup.searchAll(k);
+        ASSERT_EQ(values.size(), 50);
+        for (const auto &value : values)
+            ASSERT_EQ(std::get<int>(value[0]) % 20, k);
+    }
+    ASSERT_TRUE(dup.searchAll(20).empty());
+
+    // remove specific entries
+    for (int i = 0; i < 1000; i += 2)
+        ASSERT_TRUE(dup.remove(i % 20, Vec<Vari>{i}));
+    ASSERT_FALSE(dup.remove(0, Vec<Vari>{0}));
+
+    for (int k = 0; k < 20; k++)
+        ASSERT_EQ(dup.searchAll(k).size(), k % 2 == 0 ? 0 : 50);
+}
+
+TEST_F(BtreeTest, CursorVisitsKeysInOrder) {
+    // a small degree gives a deep tree, with pairs in every level
+    static constexpr u16 SMALL_DEGREE = 3;
+    pgid_t small_root = pager->createNewPage<BtreeNodePage<Vec<Vari>>>(
+        SMALL_DEGREE, cts::U32_INVALID, true, true
+    ).getPageID();
+    Btree<Vec<Vari>> small(small_root, *pager, SMALL_DEGREE);
+    ASSERT_FALSE(small.cursor().valid());
+
+    Vec<int> keys(5000);
+    std::iota(keys.begin(), keys.end(), 1);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(SEED));
+    for (int key : keys)
+        small.insert({key, double(key * 1.5)}, key);
+
+    int expected = 1;
+    for (auto cursor = small.cursor(); cursor.valid(); cursor.next()) {
+        ASSERT_EQ(cursor.key(), Vari(expected));
+        ASSERT_EQ(cursor.value(), (Vec<Vari>{expected, double(expected * 1.5)}));
+        expected++;
+    }
+    ASSERT_EQ(expected, 5001);
+}
+
+TEST_F(BtreeTest, SubtreeCountsAnswerRankQueries) {
+    // a small degree exercises the counts through every split, borrow and merge
+    static constexpr u16 SMALL_DEGREE = 3;
+    pgid_t small_root = pager->createNewPage<BtreeNodePage<Vec<Vari>>>(
+        SMALL_DEGREE, cts::U32_INVALID, true, true
+    ).getPageID();
+    Btree<Vec<Vari>> small(small_root, *pager, SMALL_DEGREE);
+
+    // even keys 0..9998
+    Vec<int> keys(5000);
+    for (int i = 0; i < keys.size(); i++)
+        keys[i] = 2 * i;
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(SEED));
+    for (int key : keys)
+        ASSERT_TRUE(small.insert({key}, key));
+    ASSERT_EQ(small.size(), 5000);
+
+    // remove the keys that are multiples of 3
+    for (int key : keys)
+        if (key % 3 == 0)
+            ASSERT_TRUE(small.remove(key));
+
+    Vec<int> remaining;
+    small.forEach([&](const Vari &key, const Vec<Vari> &) { remaining.push_back(std::get<int>(key)); });
+    ASSERT_EQ(small.size(), remaining.size());
+
+    for (int i = 0; i < remaining.size(); i += 7) {
+        ASSERT_EQ(small.rank(remaining[i]), i);
+        ASSERT_EQ(small.rank(remaining[i] + 1), i + 1);
+        ASSERT_EQ(small.selectByRank(i), Vec<Vari>{remaining[i]});
+    }
+    ASSERT_EQ(small.selectByRank(remaining.size()), std::nullopt);
+
+    auto lo = std::lower_bound(remaining.begin(), remaining.end(), 1001);
+    auto hi = std::upper_bound(remaining.begin(), remaining.end(), 7000);
+    ASSERT_EQ(small.countRange(1001, 7000), hi - lo);
+    ASSERT_EQ(small.countRange(7000, 1001), 0);
+    ASSERT_EQ(small.countRange(-5, 20000), remaining.size());
+
+    int expected = 1234;
+    for (auto cursor = small.cursorAt(1234); cursor.valid(); cursor.next())
+        ASSERT_EQ(cursor.key(), Vari(remaining[expected++]));
+    ASSERT_EQ(expected, remaining.size());
+}
+
+TEST_F(BtreeTest, ConcurrentOperationsFromManyThreads) {
+    // a small degree makes inserts split nodes, including the root, while readers descend
+    static constexpr u16 SMALL_DEGREE = 3;
+    static constexpr int NUM_THREADS = 8;
+    static constexpr int KEYS_PER_THREAD = 2000;
+    pgid_t small_root = pager->createNewPage<BtreeNodePage<Vec<Vari>>>(
+        SMALL_DEGREE, cts::U32_INVALID, true, true
+    ).getPageID();
+    Btree<Vec<Vari>> small(small_root, *pager, SMALL_DEGREE);
+
+    // keys below 0 exist before the threads start, and must stay visible throughout
+    for (int key = -1000; key < 0; key++)
+        ASSERT_TRUE(small.insert({key}, key));
+
+    std::atomic<bool> failed = false;
+    Vec<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(SEED + t);
+            for (int i = 0; i < KEYS_PER_THREAD; i++) {
+                int key = i * NUM_THREADS + t;
+                if (!small.concurrentInsert({key}, key) || small.concurrentInsert({0}, key))
+                    failed = true;
+                if (small.concurrentSearch(key) != Vec<Vari>{key})
+                    failed = true;
+
+                int existing = -1 - static_cast<int>(rng() % 1000);
+                if (small.concurrentSearch(existing) != Vec<Vari>{existing})
+                    failed = true;
+                if (t == 0 && !small.concurrentUpdate({existing}, existing))
+                    failed = true;
+                if (small.concurrentSearch(-5000).has_value() || small.concurrentUpdate({0}, -5000))
+                    failed = true;
+            }
+        });
+    }
+    for (auto &thread: threads)
+        thread.join();
+    ASSERT_FALSE(failed);
+
+    // the counts and parent pointers are exact, and the tree works single-threaded again
+    ASSERT_EQ(checkSubtree(small.getRootPage(), cts::PGID_INVALID), 1000 + NUM_THREADS * KEYS_PER_THREAD);
+    ASSERT_EQ(small.size(), 1000 + NUM_THREADS * KEYS_PER_THREAD);
+    int expected = -1000;
+    small.forEach([&](const Vari &key, const Vec<Vari> &value) {
+        ASSERT_EQ(key, Vari(expected));
+        ASSERT_EQ(value, Vec<Vari>{expected});
+        expected++;
+    });
+    ASSERT_EQ(expected, NUM_THREADS * KEYS_PER_THREAD);
+    ASSERT_EQ(small.rank(500), 1500);
+    ASSERT_EQ(small.selectByRank(1500), Vec<Vari>{500});
+    ASSERT_TRUE(small.remove(500));
+    ASSERT_TRUE(small.insert({500}, 500));
+    ASSERT_EQ(small.countRange(-1000, 15999), 17000);
+}
+
+TEST_F(BtreeTest, ConcurrentOperationsWithASmallCache) {
+    // a cache far smaller than the tree, so nodes and free space map pages are evicted and read
+    // back while other threads allocate, insert and search
+    static constexpr u16 SMALL_DEGREE = 4;
+    static constexpr int NUM_THREADS = 4;
+    static constexpr int KEYS_PER_THREAD = 600;
+    resetEnv();
+    std::remove(kTestFile.c_str());
+    ioHandler = std::make_unique<IOHandler>(kTestFile);
+    pageCache = std::make_unique<PageCache>(*ioHandler, 16);
+    fsm = std::make_unique<FreeSpaceMap>(*pageCache);
+    pager = std::make_unique<Pager>(*fsm, *ioHandler, *pageCache);
+    pgid_t small_root = pager->createNewPage<BtreeNodePage<Vec<Vari>>>(
+        SMALL_DEGREE, cts::U32_INVALID, true, true
+    ).getPageID();
+    Btree<Vec<Vari>> small(small_root, *pager, SMALL_DEGREE);
+
+    std::atomic<bool> failed = false;
+    Vec<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(SEED + t);
+            for (int i = 0; i < KEYS_PER_THREAD; i++) {
+                int key = i * NUM_THREADS + t;
+                if (!small.concurrentInsert({key}, key))
+                    failed = true;
+                if (small.concurrentSearch(key) != Vec<Vari>{key})
+                    failed = true;
+                // a key inserted earlier by this thread, whose node may have been evicted since
+                int earlier = static_cast<int>(rng() % (i + 1)) * NUM_THREADS + t;
+                if (small.concurrentSearch(earlier) != Vec<Vari>{earlier})
+                    failed = true;
+            }
+        });
+    }
+    for (auto &thread: threads)
+        thread.join();
+    ASSERT_FALSE(failed);
+
+    ASSERT_EQ(checkSubtree(small.getRootPage(), cts::PGID_INVALID), NUM_THREADS * KEYS_PER_THREAD);
+    ASSERT_EQ(small.size(), NUM_THREADS * KEYS_PER_THREAD);
+    int expected = 0;
+    small.forEach([&](const Vari &key, const Vec<Vari> &value) {
+        ASSERT_EQ(key, Vari(expected));
+        expected++;
+    });
+    ASSERT_EQ(expected, NUM_THREADS * KEYS_PER_THREAD);
+}
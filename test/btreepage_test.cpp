@@ -48,6 +48,8 @@ TEST_F(BtreeNodePageTest, AddingSingleCellWorks) {
     node.cells().push_back({33, {string("Kylan"), 3.1144, 10}});
     node.getChildren().push_back(100);
     node.getChildren().push_back(101);
+    node.getChildCounts().push_back(7);
+    node.getChildCounts().push_back(9);
 
     BtreeNodePage<Vec<Vari>> node2 = roundTrip(node);
     ASSERT_EQ(2, node2.getChildren().size());
@@ -59,6 +61,8 @@ TEST_F(BtreeNodePageTest, AddingSingleCellWorks) {
     ASSERT_EQ(Vari(10), node2.cells()[0].value[2]);
     ASSERT_EQ(100, node2.getChildren()[0]);
     ASSERT_EQ(101, node2.getChildren()[1]);
+    ASSERT_EQ(node2.getChildCounts(), Vec<u32>({7, 9}));
+    ASSERT_EQ(node2.subtreeSize(), 17);
 }
 
 TEST_F(BtreeNodePageTest, AddingMultipleCellsWorks) {
@@ -71,6 +75,7 @@ TEST_F(BtreeNodePageTest, AddingMultipleCellsWorks) {
     Vec<uint32_t> expectedChildren;
 
     node.getChildren().push_back(499);
+    node.getChildCounts().push_back(0);
     expectedChildren.push_back(499);
 
     for (int i = 0; i < node.maxKeys(); i++) {
@@ -81,6 +86,7 @@ TEST_F(BtreeNodePageTest, AddingMultipleCellsWorks) {
         expectedKeys.push_back(cellKey);
         expectedValues.push_back(tuple);
         node.getChildren().push_back(i + 500);
+        node.getChildCounts().push_back(i);
         expectedChildren.push_back(i + 500);
     }
 
@@ -90,6 +96,7 @@ TEST_F(BtreeNodePageTest, AddingMultipleCellsWorks) {
         ASSERT_EQ(node2.cells()[i].key, expectedKeys[i]);
         ASSERT_EQ(node2.cells()[i].value, expectedValues[i]);
         ASSERT_EQ(node2.getChildren()[i], expectedChildren[i]);
+        ASSERT_EQ(node2.getChildCounts()[i + 1], i);
     }
 }
 
@@ -98,6 +105,8 @@ TEST_F(BtreeNodePageTest, RowPtrBtreeNodeWorks) {
     node.cells().push_back({3, {4, 10}});
     node.getChildren().push_back(100);
     node.getChildren().push_back(101);
+    node.getChildCounts().push_back(7);
+    node.getChildCounts().push_back(9);
 
     BtreeNodePage<RowPos> node2 = roundTrip(node);
     ASSERT_EQ(2, node2.getChildren().size());
@@ -108,6 +117,8 @@ TEST_F(BtreeNodePageTest, RowPtrBtreeNodeWorks) {
     ASSERT_EQ(10, node2.cells()[0].value.cellID);
     ASSERT_EQ(100, node2.getChildren()[0]);
     ASSERT_EQ(101, node2.getChildren()[1]);
+    ASSERT_EQ(node2.getChildCounts(), Vec<u32>({7, 9}));
+    ASSERT_EQ(node2.subtreeSize(), 17);
 }
 
 TEST_F(BtreeNodePageTest, InsertingManyRowPtrWorks) {
@@ -115,6 +126,7 @@ TEST_F(BtreeNodePageTest, InsertingManyRowPtrWorks) {
     uint16_t degree = (MX_SZ + 1) / 2;
     BtreeNodePage<RowPos> node(degree, 5, false, false, defaultPageID);
     node.getChildren().push_back(1111);
+    node.getChildCounts().push_back(1);
 
     Vec<BtreeNodePage<RowPos>::cell> expectedCells;
     Vec<uint32_t> expectedChildren = {1111};
@@ -126,6 +138,7 @@ TEST_F(BtreeNodePageTest, InsertingManyRowPtrWorks) {
         node.cells().push_back({i, ptr});
         expectedCells.push_back({i, ptr});
         node.getChildren().push_back(i * 4);
+        node.getChildCounts().push_back(1);
         expectedChildren.push_back(i * 4);
     }
 
@@ -133,6 +146,7 @@ TEST_F(BtreeNodePageTest, InsertingManyRowPtrWorks) {
 
     ASSERT_EQ(node2.cells().size(), expectedCells.size());
     ASSERT_EQ(node2.getChildren(), expectedChildren);
+    ASSERT_EQ(node2.subtreeSize(), 2 * expectedCells.size() + 1);
 
     for (int i = 0; i < expectedCells.size(); i++) {
         ASSERT_EQ(node2.cells()[i].key, expectedCells[i].key);
@@ -0,0 +1,107 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <gtest/gtest.h>
+#include <random>
+
+#include "ExternalSort.hpp"
+
+using namespace backend;
+
+class ExternalSortTest : public testing::Test {
+protected:
+    const std::string kTestFile = "testfile.db";
+
+    std::unique_ptr<IOHandler> ioHandler;
+    std::unique_ptr<PageCache> pageCache;
+    std::unique_ptr<FreeSpaceMap> fsm;
+    std::unique_ptr<Pager> pager;
+
+    void SetUp() override {
+        std::remove(kTestFile.c_str());
+        ioHandler = std::make_unique<IOHandler>(kTestFile);
+        pageCache = std::make_unique<PageCache>(*ioHandler, cts::CACHE_SZ);
+        fsm = std::make_unique<FreeSpaceMap>(*pageCache);
+        pager = std::make_unique<Pager>(*fsm, *ioHandler, *pageCache);
+    }
+
+    void TearDown() override {
+        pager.reset();
+        fsm.reset();
+        pageCache.reset();
+        ioHandler.reset();
+        std::remove(kTestFile.c_str());
+    }
+
+    // (id, group, name) tuples in shuffled order
+    static Vec<Vec<Vari>> shuffledTuples(int n) {
+        Vec<Vec<Vari>> tuples;
+        for (int i = 0; i < n; i++)
+            tuples.push_back({i, i % 10, "name" + std::to_string(i)});
+        std::shuffle(tuples.begin(), tuples.end(), std::mt19937(152));
+        return tuples;
+    }
+
+    static Vec<Vec<Vari>> drain(TupleCursor &cursor) {
+        Vec<Vec<Vari>> out;
+        for (; cursor.valid(); cursor.next())
+            out.push_back(cursor.tuple());
+        return out;
+    }
+};
+
+TEST_F(ExternalSortTest, SortsInMemoryWithinBudget) {
+    auto input = shuffledTuples(1000);
+    ExternalSort sort(*pager, {0, 0, string()}, {{0}});
+    for (const auto &tuple: input)
+        sort.add(tuple);
+    ASSERT_EQ(sort.getNumRuns(), 0);
+
+    auto sorted = drain(*sort.finish());
+    ASSERT_EQ(sorted.size(), 1000);
+    for (int i = 0; i < 1000; i++)
+        ASSERT_EQ(sorted[i][0], Vari(i));
+}
+
+TEST_F(ExternalSortTest, MergesRunsStably) {
+    auto input = shuffledTuples(20000);
+    // sort by group descending; equal groups keep their input order
+    ExternalSort sort(*pager, {0, 0, string()}, {{1, true}}, 64 * 1024);
+    for (const auto &tuple: input)
+        sort.add(tuple);
+    ASSERT_GT(sort.getNumRuns(), 1);
+
+    auto expected = input;
+    std::stable_sort(expected.begin(), expected.end(), [](const Vec<Vari> &a, const Vec<Vari> &b) {
+        return b[1] < a[1];
+    });
+    ASSERT_EQ(drain(*sort.finish()), expected);
+}
+
+TEST_F(ExternalSortTest, MergesInSeveralPassesAndFreesPages) {
+    auto input = shuffledTuples(20000);
+    {
+        // a budget of 4 pages merges 2 runs at a time
+        ExternalSort sort(*pager, {0, 0, string()}, {{1}, {0, true}}, 4 * cts::PG_SZ);
+        for (const auto &tuple: input)
+            sort.add(tuple);
+        ASSERT_GT(sort.getNumRuns(), 8);
+
+        auto sorted = drain(*sort.finish());
+        ASSERT_EQ(sorted.size(), input.size());
+        for (size_t i = 1; i < sorted.size(); i++) {
+            ASSERT_LE(sorted[i - 1][1], sorted[i][1]);
+            if (sorted[i - 1][1] == sorted[i][1])
+                ASSERT_GT(sorted[i - 1][0], sorted[i][0]);
+        }
+    }
+
+    for (pgid_t pageID = 0; pageID < ioHandler->getNumBlocks(); pageID++)
+        if (pageID % FSMPage::getBlocksInPage() != 0)
+            ASSERT_TRUE(pager->isFree(pageID));
+}
+
+TEST_F(ExternalSortTest, RejectsInvalidColumns) {
+    ASSERT_THROW(ExternalSort(*pager, {0, 0}, {{2}}), std::invalid_argument);
+}
@@ -0,0 +1,186 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <gtest/gtest.h>
+#include <random>
+
+#include "HashIndex.hpp"
+#include "HashBucketPage.hpp"
+#include "HashDirectoryPage.hpp"
+#include "utility.hpp"
+
+using namespace backend;
+
+class HashIndexTest : public testing::Test {
+protected:
+    static constexpr int SEED = 152;
+    static constexpr u16 CAPACITY = 20;
+    const std::string kTestFile = "testfile.db";
+    pgid_t dir_id;
+
+    std::unique_ptr<IOHandler> ioHandler;
+    std::unique_ptr<PageCache> pageCache;
+    std::unique_ptr<FreeSpaceMap> fsm;
+    std::unique_ptr<Pager> pager;
+    std::unique_ptr<HashIndex<Vec<Vari>>> index;
+
+    void SetUp() override {
+        std::remove(kTestFile.c_str());
+        initEnv();
+        pgid_t bucket_id = pager->createNewPage<HashBucketPage<Vec<Vari>>>(CAPACITY, 0).getPageID();
+        dir_id = pager->createNewPage<HashDirectoryPage>(bucket_id).getPageID();
+        index = std::make_unique<HashIndex<Vec<Vari>>>(dir_id, *pager, CAPACITY);
+    }
+
+    void TearDown() override {
+        resetEnv();
+        std::remove(kTestFile.c_str());
+    }
+
+    void initEnv() {
+        ioHandler = std::make_unique<IOHandler>(kTestFile);
+        pageCache = std::make_unique<PageCache>(*ioHandler, cts::CACHE_SZ);
+        fsm = std::make_unique<FreeSpaceMap>(*pageCache);
+        pager = std::make_unique<Pager>(*fsm, *ioHandler, *pageCache);
+    }
+
+    void resetEnv() {
+        index.reset();
+        pager.reset();
+        fsm.reset();
+        pageCache.reset();
+        ioHandler.reset();
+    }
+};
+
+TEST(HashDirectoryPageTest, GrowMirrorsSlots) {
+    HashDirectoryPage dir(7, 1);
+    dir.grow();
+    dir.grow();
+    ASSERT_EQ(dir.getGlobalDepth(), 2);
+    ASSERT_EQ(dir.getSlots(), (Vec<pgid_t>{7, 7, 7, 7}));
+
+    dir.getSlots()[3] = 9;
+    Vec<byte> buffer(cts::PG_SZ);
+    dir.toBytes(buffer);
+    HashDirectoryPage serialized(buffer, 1);
+    ASSERT_EQ(serialized.getGlobalDepth(), 2);
+    ASSERT_EQ(serialized.getSlot(7), 9);
+    ASSERT_EQ(serialized.getSlot(4), 7);
+}
+
+TEST(HashDirectoryPageTest, UpperLevelsIndexHigherBits) {
+    HashDirectoryPage dir(2, {10, 11, 12, 13}, 1);
+    ASSERT_EQ(dir.getLevel(), 2);
+    ASSERT_EQ(dir.getDepth(), 2);
+    ASSERT_EQ(dir.getGlobalDepth(), 2 + 2 * HashDirectoryPage::getMaxPageDepth());
+
+    u8 shift = 2 * HashDirectoryPage::getMaxPageDepth();
+    ASSERT_EQ(dir.getSlot(u64(3) << shift), 13);
+    ASSERT_EQ(dir.getSlot((u64(1) << shift) | 0x3FFFF), 11);
+
+    Vec<byte> buffer(cts::PG_SZ);
+    dir.toBytes(buffer);
+    HashDirectoryPage serialized(buffer, 1);
+    ASSERT_EQ(serialized.getLevel(), 2);
+    ASSERT_EQ(serialized.getSlots(), (Vec<pgid_t>{10, 11, 12, 13}));
+}
+
+TEST(HashBucketPageTest, SerializationWorks) {
+    HashBucketPage<Vec<Vari>> bucket(10, 3, 1);
+    bucket.setNextPageID(42);
+    bucket.cells().push_back({string("a"), {string("a"), 1, 2.0}});
+    bucket.cells().push_back({string("b"), {string("b"), 3, 4.0}});
+
+    Vec<byte> buffer(cts::PG_SZ);
+    bucket.toBytes(buffer);
+    HashBucketPage<Vec<Vari>> serialized(buffer, 1);
+    ASSERT_EQ(serialized.capacity(), 10);
+    ASSERT_EQ(serialized.getLocalDepth(), 3);
+    ASSERT_EQ(serialized.getNextPageID(), 42);
+    ASSERT_EQ(serialized.cells().size(), 2);
+    ASSERT_EQ(serialized.cells()[1].key, Vari(string("b")));
+    ASSERT_EQ(serialized.cells()[1].value, (Vec<Vari>{string("b"), 3, 4.0}));
+}
+
+TEST_F(HashIndexTest, BasicInsertAndSearchWorks) {
+    Vec<Vari> tuple = {"kylan", double(3.0), 4};
+    ASSERT_TRUE(index->insert(tuple, "kylan"));
+    ASSERT_FALSE(index->insert(tuple, "kylan"));
+    ASSERT_EQ(index->search("kylan"), tuple);
+    ASSERT_EQ(index->search("other"), std::nullopt);
+}
+
+TEST_F(HashIndexTest, UpdateAndRemoveWork) {
+    ASSERT_TRUE(index->insert({1, 2}, 1));
+    ASSERT_TRUE(index->update({1, 5}, 1));
+    ASSERT_FALSE(index->update({2, 5}, 2));
+    ASSERT_EQ(index->search(1), (Vec<Vari>{1, 5}));
+    ASSERT_TRUE(index->remove(1));
+    ASSERT_FALSE(index->remove(1));
+    ASSERT_EQ(index->search(1), std::nullopt);
+}
+
+TEST_F(HashIndexTest, SignedZerosAreOneKey) {
+    // enough keys to split the directory, so keys whose hashes differ land in different buckets
+    for (int i = 1; i <= 5000; i++)
+        ASSERT_TRUE(index->insert({double(i)}, double(i)));
+
+    ASSERT_TRUE(index->insert({-0.0}, -0.0));
+    ASSERT_FALSE(index->insert({0.0}, 0.0));
+    ASSERT_EQ(index->search(0.0), (Vec<Vari>{-0.0}));
+    ASSERT_TRUE(index->remove(0.0));
+    ASSERT_EQ(index->search(-0.0), std::nullopt);
+}
+
+TEST_F(HashIndexTest, StressTestInsertSearchAndRemove) {
+    Vec<int> keys(50000);
+    std::iota(keys.begin(), keys.end(), 1);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(SEED));
+    for (int key : keys)
+        ASSERT_TRUE(index->insert({key, double(key * 1.5)}, key));
+
+    // 50000 keys over buckets of 20 need more slots than one directory page holds
+    auto &dir = pager->getPage<HashDirectoryPage>(dir_id);
+    ASSERT_GT(dir.getLevel(), 0);
+    ASSERT_GT(dir.getGlobalDepth(), HashDirectoryPage::getMaxPageDepth());
+
+    for (int key : keys)
+        ASSERT_EQ(index->search(key), (Vec<Vari>{key, double(key * 1.5)}));
+
+    for (int i = 0; i < keys.size(); i += 2)
+        ASSERT_TRUE(index->remove(keys[i]));
+
+    for (int i = 0; i < keys.size(); i++)
+        ASSERT_EQ(index->search(keys[i]).has_value(), i % 2 == 1);
+
+    size_t count = 0;
+    index->forEach([&](const Vari &, const Vec<Vari> &) { count++; });
+    ASSERT_EQ(count, keys.size() / 2);
+}
+
+TEST_F(HashIndexTest, ForEachVisitsEveryEntryOnce) {
+    for (int i = 0; i < 5000; i++)
+        index->insert({i}, i);
+
+    Vec<int> seen;
+    index->forEach([&](const Vari &key, const Vec<Vari> &) { seen.push_back(std::get<int>(key)); });
+    std::sort(seen.begin(), seen.end());
+
+    Vec<int> expected(5000);
+    std::iota(expected.begin(), expected.end(), 0);
+    ASSERT_EQ(seen, expected);
+}
+
+TEST_F(HashIndexTest, PersistsAcrossReopen) {
+    for (int i = 0; i < 5000; i++)
+        index->insert({i, std::to_string(i)}, i);
+
+    resetEnv();
+    initEnv();
+    index = std::make_unique<HashIndex<Vec<Vari>>>(dir_id, *pager, CAPACITY);
+
+    for (int i = 0; i < 5000; i++)
+        ASSERT_EQ(index->search(i), (Vec<Vari>{i, std::to_string(i)}));
+}
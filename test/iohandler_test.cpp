@@ -3,9 +3,13 @@
 //
 
 #include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 
 #include "IOHandler.hpp"
+#include "Metrics.hpp"
+#include "PageCodec.hpp"
 
 using namespace backend;
 
@@ -13,15 +17,18 @@ struct IOHandlerTest : testing::Test {
     std::unique_ptr<IOHandler> ioHandler;
 
     const std::string kTestFile = "testfile.db";
+    const std::string kMapFile = "testfile.db.map";
 
     void SetUp() override {
         std::remove(kTestFile.c_str());
+        std::remove(kMapFile.c_str());
         ioHandler = std::make_unique<IOHandler>(kTestFile);
     }
 
     void TearDown() override {
         ioHandler.reset();
         std::remove(kTestFile.c_str());
+        std::remove(kMapFile.c_str());
     }
 };
 
@@ -227,4 +234,244 @@ TEST_F(IOHandlerTest, WriteAndReadToMultipleBlocks) {
         ioHandler->readBlock(buffer, i);
         ASSERT_EQ(memcmp(data, buffer, cts::PG_SZ), 0);
     }
-}
\ No newline at end of file
+}
+
+TEST_F(IOHandlerTest, MappedReadsSeeWritesAndGrowth) {
+    ioHandler = std::make_unique<IOHandler>(kTestFile, IOMode::MMAP);
+    ASSERT_EQ(ioHandler->getMode(), IOMode::MMAP);
+    char data[cts::PG_SZ];
+    char buffer[cts::PG_SZ] = {0};
+    auto fill = [&](int i) {
+        std::memset(data, 0, sizeof(data));
+        std::snprintf(data, sizeof(data), "Block %d", i);
+    };
+
+    // grow past the first mapping, so the file is remapped
+    for (int i = 0; i < 1000; ++i) {
+        ioHandler->createNewBlock();
+        fill(i);
+        ioHandler->writeBlock(data, i);
+    }
+    ioHandler->createMultipleBlocks(24);
+
+    for (int i = 0; i < 1000; ++i) {
+        fill(i);
+        ioHandler->readBlock(buffer, i);
+        ASSERT_EQ(memcmp(data, buffer, cts::PG_SZ), 0);
+        auto view = ioHandler->viewBlock(i);
+        ASSERT_EQ(view.size(), cts::PG_SZ);
+        ASSERT_EQ(memcmp(data, view.data(), cts::PG_SZ), 0);
+    }
+
+    // a view stays valid as the file keeps growing
+    auto view = ioHandler->viewBlock(0);
+    ioHandler->createMultipleBlocks(2000);
+    ASSERT_EQ(memcmp("Block 0", view.data(), 8), 0);
+    ASSERT_THROW(ioHandler->viewBlock(3024), std::runtime_error);
+}
+
+TEST_F(IOHandlerTest, ReadOnlyFileRejectsWrites) {
+    char data[cts::PG_SZ] = "Read-only data";
+    char buffer[cts::PG_SZ] = {0};
+    ioHandler->createMultipleBlocks(2);
+    ioHandler->writeBlock(data, 1);
+    ioHandler.reset();
+
+    ioHandler = std::make_unique<IOHandler>(kTestFile, IOMode::READ_ONLY);
+    ASSERT_TRUE(ioHandler->readOnly());
+    ASSERT_EQ(ioHandler->getNumBlocks(), 2);
+    ioHandler->readBlock(buffer, 1);
+    ASSERT_EQ(memcmp(data, buffer, cts::PG_SZ), 0);
+#ifndef _WIN32
+    ASSERT_EQ(memcmp(data, ioHandler->viewBlock(1).data(), cts::PG_SZ), 0);
+#endif
+    ASSERT_THROW(ioHandler->writeBlock(data, 0), std::runtime_error);
+    ASSERT_THROW(ioHandler->writeBlocks(data, 0, 1), std::runtime_error);
+    ASSERT_THROW(ioHandler->createNewBlock(), std::runtime_error);
+    ASSERT_THROW(ioHandler->createMultipleBlocks(1), std::runtime_error);
+
+    // a missing file is not created
+    ioHandler.reset();
+    std::remove(kTestFile.c_str());
+    ASSERT_THROW(IOHandler(kTestFile, IOMode::READ_ONLY), std::runtime_error);
+    std::ifstream file(kTestFile);
+    ASSERT_FALSE(file.good());
+}
+
+TEST_F(IOHandlerTest, DirectIOReadsAndWritesAnyBuffer) {
+    ioHandler = std::make_unique<IOHandler>(kTestFile, IOMode::DIRECT);
+    ASSERT_EQ(ioHandler->getMode(), IOMode::DIRECT);
+    ioHandler->createMultipleBlocks(4);
+
+    // an aligned buffer is used as is, and an unaligned one is copied through an aligned buffer
+    AlignedBytes aligned(3 * cts::PG_SZ);
+    for (size_t i = 0; i < aligned.size(); i++)
+        aligned[i] = static_cast<byte>(i * 7);
+    ioHandler->writeBlocks(aligned.data(), 1, 3);
+    Vec<byte> unaligned(cts::PG_SZ + 1);
+    for (size_t i = 0; i < unaligned.size(); i++)
+        unaligned[i] = static_cast<byte>(i * 13);
+    ioHandler->writeBlock(unaligned.data() + 1, 0);
+
+    ioHandler.reset();
+    ioHandler = std::make_unique<IOHandler>(kTestFile, IOMode::DIRECT);
+    AlignedBytes readAligned(3 * cts::PG_SZ);
+    ioHandler->readBlocks(readAligned.data(), 1, 3);
+    ASSERT_EQ(readAligned, aligned);
+    Vec<byte> readUnaligned(cts::PG_SZ + 1);
+    ioHandler->readBlock(readUnaligned.data() + 1, 0);
+    ASSERT_EQ(memcmp(readUnaligned.data() + 1, unaligned.data() + 1, cts::PG_SZ), 0);
+    ASSERT_EQ(ioHandler->viewBlock(0).size(), 0);
+}
+
+TEST_F(IOHandlerTest, BatchesAreWrittenAndReadInRuns) {
+    ioHandler->createMultipleBlocks(3000);
+    auto &registry = MetricsRegistry::global();
+    auto &writes = registry.counter("io.writes");
+    auto &reads = registry.counter("io.reads");
+    auto &syncs = registry.counter("io.syncs");
+
+    // blocks 0 to 2047 and 2100 to 2199, listed out of order; the first run is longer than IOV_MAX
+    Vec<blockid_t> blockNos;
+    for (blockid_t i = 0; i < 2048; i++)
+        blockNos.push_back(i * 11 % 2048);
+    for (blockid_t i = 2199; i >= 2100; i--)
+        blockNos.push_back(i);
+    Vec<Vec<byte>> buffers;
+    Vec<std::pair<blockid_t, const void *>> batch;
+    for (blockid_t blockNo: blockNos) {
+        buffers.emplace_back(cts::PG_SZ, static_cast<byte>(blockNo * 7));
+        batch.emplace_back(blockNo, buffers.back().data());
+    }
+
+    registry.reset();
+    ioHandler->writeBlocks(batch);
+    ASSERT_EQ(writes.value(), 2);
+    ASSERT_EQ(syncs.value(), 1);
+
+    Vec<Vec<byte>> readBuffers(blockNos.size(), Vec<byte>(cts::PG_SZ));
+    Vec<std::pair<blockid_t, void *>> readBatch;
+    for (size_t i = 0; i < blockNos.size(); i++)
+        readBatch.emplace_back(blockNos[blockNos.size() - 1 - i], readBuffers[i].data());
+    ioHandler->readBlocks(readBatch);
+    ASSERT_EQ(reads.value(), 2);
+    for (size_t i = 0; i < blockNos.size(); i++)
+        ASSERT_EQ(readBuffers[i], Vec<byte>(cts::PG_SZ, static_cast<byte>(blockNos[blockNos.size() - 1 - i] * 7)));
+
+    // a batch without a flush, and batches that reach out of bounds
+    Vec<std::pair<blockid_t, const void *>> single{{5, buffers[0].data()}};
+    ioHandler->writeBlocks(single, false);
+    ASSERT_EQ(syncs.value(), 1);
+    single[0].first = 3000;
+    ASSERT_THROW(ioHandler->writeBlocks(single), std::runtime_error);
+    Vec<std::pair<blockid_t, void *>> outOfBounds{{0, readBuffers[0].data()}, {3000, readBuffers[1].data()}};
+    ASSERT_THROW(ioHandler->readBlocks(outOfBounds), std::runtime_error);
+}
+
+
+// a page-like block: a few keys, padded strings and zeros after the used part
+static Vec<byte> pageLike(u32 seed) {
+    Vec<byte> block(cts::PG_SZ, byte{0});
+    for (u32 i = 0; i < 12; i++) {
+        u32 key = seed * 100 + i;
+        std::memcpy(block.data() + i * 140, &key, sizeof(key));
+        string name = "student " + std::to_string(key);
+        std::memcpy(block.data() + i * 140 + 8, name.data(), name.size());
+    }
+    return block;
+}
+
+static Vec<byte> randomBlock(u32 seed) {
+    Vec<byte> block(cts::PG_SZ);
+    u64 state = seed * 0x9e3779b97f4a7c15ULL + 1;
+    for (auto &b: block) {
+        state ^= state << 13, state ^= state >> 7, state ^= state << 17;
+        b = static_cast<byte>(state);
+    }
+    return block;
+}
+
+TEST(PageCodecTest, BlocksRoundTripAndMalformedInputIsRejected) {
+    PgArr<byte> compressed;
+    for (const auto &block: {Vec<byte>(cts::PG_SZ, byte{0}), pageLike(1), Vec<byte>(100, byte{'x'}), Vec<byte>()}) {
+        size_t len = PageCodec::compress(block, compressed);
+        ASSERT_GT(len, 0);
+        ASSERT_LT(len, std::max<size_t>(block.size() / 4, 16));
+        Vec<byte> out(block.size());
+        ASSERT_TRUE(PageCodec::decompress({compressed.data(), len}, out));
+        ASSERT_EQ(out, block);
+
+        // the wrong size, or a cut-short input
+        Vec<byte> longer(block.size() + 1);
+        ASSERT_FALSE(PageCodec::decompress({compressed.data(), len}, longer));
+        if (!block.empty())
+            ASSERT_FALSE(PageCodec::decompress({compressed.data(), len / 2}, out));
+    }
+
+    // random bytes do not compress, and do not fit in a buffer of their own size
+    auto random = randomBlock(1);
+    ASSERT_EQ(PageCodec::compress(random, compressed), 0);
+    Vec<byte> larger(2 * cts::PG_SZ), out(cts::PG_SZ);
+    size_t len = PageCodec::compress(random, larger);
+    ASSERT_GT(len, cts::PG_SZ);
+    ASSERT_TRUE(PageCodec::decompress({larger.data(), len}, out));
+    ASSERT_EQ(out, random);
+}
+
+TEST_F(IOHandlerTest, CompressedBlocksAreStoredInSmallerSlots) {
+    // an uncompressed file is not opened as a compressed one
+    ioHandler->createNewBlock();
+    ioHandler.reset();
+    ASSERT_THROW(IOHandler(kTestFile, IOMode::COMPRESSED), std::runtime_error);
+    std::remove(kTestFile.c_str());
+
+    auto &registry = MetricsRegistry::global();
+    auto &bytesWritten = registry.counter("io.bytes_written");
+    auto &incompressible = registry.counter("io.incompressible_blocks");
+    ioHandler = std::make_unique<IOHandler>(kTestFile, IOMode::COMPRESSED);
+    ASSERT_EQ(ioHandler->createMultipleBlocks(200), 0);
+    ASSERT_EQ(ioHandler->createNewBlock(), 200);
+
+    // blocks are created without space, and read as zeros until written
+    Vec<byte> buf(cts::PG_SZ, byte{1});
+    ioHandler->readBlock(buf.data(), 200);
+    ASSERT_EQ(buf, Vec<byte>(cts::PG_SZ, byte{0}));
+
+    registry.reset();
+    Vec<Vec<byte>> blocks;
+    Vec<std::pair<blockid_t, const void *>> batch;
+    for (blockid_t i = 0; i < 200; i++) {
+        blocks.push_back(i % 50 == 0 ? randomBlock(i) : pageLike(i));
+        batch.emplace_back(i, blocks.back().data());
+    }
+    ioHandler->writeBlocks(batch);
+    ASSERT_EQ(incompressible.value(), 4);
+    ASSERT_LT(bytesWritten.value(), 200 * cts::PG_SZ / 4);
+
+    // blocks that no longer fit their slot move, and the space they leave is reused after a sync
+    for (blockid_t i = 1; i < 200; i += 2) {
+        blocks[i] = i % 3 == 0 ? randomBlock(i + 1000) : pageLike(i + 1000);
+        ioHandler->writeBlock(blocks[i].data(), i);
+    }
+    ioHandler->writeBlocks(blocks[1].data(), 1, 1);
+    ioHandler.reset();
+    auto fileSize = std::filesystem::file_size(kTestFile);
+    ASSERT_LT(fileSize, 200 * cts::PG_SZ / 2);
+
+    ioHandler = std::make_unique<IOHandler>(kTestFile, IOMode::COMPRESSED);
+    ASSERT_EQ(ioHandler->getNumBlocks(), 201);
+    for (blockid_t i = 0; i < 200; i++) {
+        ioHandler->readBlock(buf.data(), i);
+        ASSERT_EQ(buf, blocks[i]) << i;
+    }
+    Vec<byte> range(3 * cts::PG_SZ);
+    ioHandler->readBlocks(range.data(), 49, 3);
+    for (blockid_t i = 0; i < 3; i++)
+        ASSERT_EQ(memcmp(range.data() + i * cts::PG_SZ, blocks[49 + i].data(), cts::PG_SZ), 0);
+
+    // rewriting every block in place does not grow the file
+    for (blockid_t i = 0; i < 200; i++)
+        ioHandler->writeBlock(blocks[i].data(), i);
+    ioHandler.reset();
+    ASSERT_EQ(std::filesystem::file_size(kTestFile), fileSize);
+}
@@ -0,0 +1,164 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <gtest/gtest.h>
+
+#include "Join.hpp"
+
+using namespace backend;
+
+class JoinTest : public testing::Test {
+protected:
+    const std::string kTestFile = "testfile.db";
+
+    std::unique_ptr<IOHandler> ioHandler;
+    std::unique_ptr<PageCache> pageCache;
+    std::unique_ptr<FreeSpaceMap> fsm;
+    std::unique_ptr<Pager> pager;
+
+    void SetUp() override {
+        std::remove(kTestFile.c_str());
+        ioHandler = std::make_unique<IOHandler>(kTestFile);
+        pageCache = std::make_unique<PageCache>(*ioHandler, cts::CACHE_SZ);
+        fsm = std::make_unique<FreeSpaceMap>(*pageCache);
+        pager = std::make_unique<Pager>(*fsm, *ioHandler, *pageCache);
+    }
+
+    void TearDown() override {
+        pager.reset();
+        fsm.reset();
+        pageCache.reset();
+        ioHandler.reset();
+        std::remove(kTestFile.c_str());
+    }
+
+    // orders (id, customer, amount) joined with customers (id, name) on the customer id
+    static Vec<Vec<Vari>> orders(int numOrders, int numCustomers) {
+        Vec<Vec<Vari>> tuples;
+        for (int i = 0; i < numOrders; i++)
+            tuples.push_back({i, i % numCustomers, i * 0.5});
+        return tuples;
+    }
+
+    static Vec<Vec<Vari>> customers(int numCustomers) {
+        Vec<Vec<Vari>> tuples;
+        for (int i = 0; i < numCustomers; i++)
+            tuples.push_back({i, "customer" + std::to_string(i)});
+        return tuples;
+    }
+
+    Vec<Vec<Vari>> hashJoin(const Vec<Vec<Vari>> &build, const Vec<Vec<Vari>> &probe, size_t memoryBudget,
+                            bool &spilled) {
+        HashJoin join(*pager, {0, string()}, 0, {0, 0, 0.0}, 1, memoryBudget);
+        Vec<Vec<Vari>> result;
+        JoinCallback collect = [&](const Vec<Vari> &customer, const Vec<Vari> &order) {
+            result.push_back({order[0], customer[1]});
+        };
+
+        for (const auto &tuple: build)
+            join.build(tuple);
+        spilled = join.hasSpilled();
+        for (const auto &tuple: probe)
+            join.probe(tuple, collect);
+        join.finish(collect);
+
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    static Vec<Vec<Vari>> expectedJoin(int numOrders, int numCustomers) {
+        Vec<Vec<Vari>> expected;
+        for (int i = 0; i < numOrders; i++)
+            expected.push_back({i, "customer" + std::to_string(i % numCustomers)});
+        return expected;
+    }
+};
+
+TEST_F(JoinTest, SpillRunReturnsTuplesInOrder) {
+    size_t numPages;
+    {
+        SpillRun run(*pager, {0, string()});
+        for (int i = 0; i < 1000; i++)
+            run.append({i, std::to_string(i)});
+        ASSERT_EQ(run.size(), 1000);
+        numPages = run.getNumPages();
+        ASSERT_GT(numPages, 1);
+
+        int expected = 0;
+        run.forEach([&](const Vec<Vari> &tuple) {
+            ASSERT_EQ(tuple, (Vec<Vari>{expected, std::to_string(expected)}));
+            expected++;
+        });
+        ASSERT_EQ(expected, 1000);
+    }
+
+    // the pages were freed, so a new run reuses them
+    pgid_t numBlocks = ioHandler->getNumBlocks();
+    SpillRun run(*pager, {0, string()});
+    for (int i = 0; i < 1000; i++)
+        run.append({i, std::to_string(i)});
+    ASSERT_EQ(ioHandler->getNumBlocks(), numBlocks);
+}
+
+TEST_F(JoinTest, HashJoinInMemory) {
+    bool spilled;
+    auto result = hashJoin(customers(100), orders(5000, 150), HashJoin::DEFAULT_MEMORY_BUDGET, spilled);
+    ASSERT_FALSE(spilled);
+
+    // orders of customers 100 to 149 have no match
+    Vec<Vec<Vari>> expected;
+    for (auto &row: expectedJoin(5000, 150))
+        if (std::get<int>(row[0]) % 150 < 100)
+            expected.push_back(row);
+    ASSERT_EQ(result, expected);
+}
+
+TEST_F(JoinTest, HashJoinSpillsWhenOverBudget) {
+    bool spilled;
+    auto result = hashJoin(customers(20000), orders(40000, 20000), 64 * 1024, spilled);
+    ASSERT_TRUE(spilled);
+    ASSERT_EQ(result, expectedJoin(40000, 20000));
+}
+
+TEST_F(JoinTest, HashJoinMatchesSignedZerosAfterSpilling) {
+    HashJoin join(*pager, {0.0, string()}, 0, {0, 0.0}, 1, 64 * 1024);
+    for (int i = 1; i <= 5000; i++)
+        join.build({double(i), "customer" + std::to_string(i)});
+    join.build({-0.0, string("zero")});
+    ASSERT_TRUE(join.hasSpilled());
+
+    // -0.0 == 0.0, so both sides must be sent to the same partition
+    Vec<Vec<Vari>> result;
+    JoinCallback collect = [&](const Vec<Vari> &customer, const Vec<Vari> &order) {
+        result.push_back({order[0], customer[1]});
+    };
+    join.probe({7, 0.0}, collect);
+    join.finish(collect);
+    ASSERT_EQ(result, (Vec<Vec<Vari>>{{7, string("zero")}}));
+}
+
+TEST_F(JoinTest, HashJoinOfSkewedKeysTerminates) {
+    // every build tuple shares one join value, so partitioning never shrinks the input
+    Vec<Vec<Vari>> build;
+    for (int i = 0; i < 3000; i++)
+        build.push_back({7, "customer" + std::to_string(i)});
+
+    bool spilled;
+    auto result = hashJoin(build, orders(10, 1000), 16 * 1024, spilled);
+    ASSERT_TRUE(spilled);
+    ASSERT_EQ(result.size(), 3000);
+}
+
+TEST_F(JoinTest, MergeJoinMatchesDuplicatesOnBothSides) {
+    VectorCursor left({{1, 0}, {2, 0}, {2, 1}, {4, 0}, {5, 0}, {5, 1}});
+    VectorCursor right({{0, 'a'}, {2, 'b'}, {2, 'c'}, {3, 'd'}, {5, 'e'}, {6, 'f'}});
+
+    Vec<Vec<Vari>> result;
+    mergeJoin(left, 0, right, 0, [&](const Vec<Vari> &l, const Vec<Vari> &r) {
+        result.push_back({l[0], l[1], r[1]});
+    });
+
+    ASSERT_EQ(result, (Vec<Vec<Vari>>{{2, 0, 'b'}, {2, 0, 'c'}, {2, 1, 'b'}, {2, 1, 'c'},
+                                      {5, 0, 'e'}, {5, 1, 'e'}}));
+}
@@ -0,0 +1,236 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <numeric>
+#include <random>
+
+#include "BloomFilter.hpp"
+#include "LsmTree.hpp"
+#include "SortedRun.hpp"
+#include "utility.hpp"
+
+using namespace backend;
+
+class LsmTreeTest : public testing::Test {
+protected:
+    static constexpr int SEED = 152;
+    const std::string kBasePath = "lsmtest";
+    const Vec<Vari> kTypes = {int(), string()};
+
+    std::unique_ptr<LsmTree> tree;
+
+    void SetUp() override {
+        removeFiles();
+    }
+
+    void TearDown() override {
+        tree.reset();
+        removeFiles();
+    }
+
+    void removeFiles() {
+        for (const auto &entry: std::filesystem::directory_iterator("."))
+            if (entry.path().filename().string().starts_with(kBasePath))
+                std::filesystem::remove(entry.path());
+    }
+
+    void open(LsmTree::Options options) {
+        tree.reset();
+        tree = std::make_unique<LsmTree>(kBasePath, kTypes, options);
+    }
+
+    static LsmTree::Options smallOptions() {
+        LsmTree::Options options;
+        options.memtableEntries = 100;
+        options.level0Runs = 2;
+        options.levelRatio = 2;
+        return options;
+    }
+
+    static Vec<Vari> tuple(int i) {
+        return {i, "v" + std::to_string(i)};
+    }
+};
+
+TEST(BloomFilterTest, HasNoFalseNegatives) {
+    BloomFilter bloom(1000, 10);
+    for (int i = 0; i < 1000; i++)
+        bloom.add(db_hash(Vari(i)));
+
+    for (int i = 0; i < 1000; i++)
+        ASSERT_TRUE(bloom.mayContain(db_hash(Vari(i))));
+}
+
+TEST(BloomFilterTest, FalsePositiveRateIsLow) {
+    BloomFilter bloom(10000, 10);
+    for (int i = 0; i < 10000; i++)
+        bloom.add(db_hash(Vari(i)));
+
+    int false_positives = 0;
+    for (int i = 10000; i < 20000; i++)
+        false_positives += bloom.mayContain(db_hash(Vari(i)));
+
+    // ~1% expected at 10 bits per key
+    ASSERT_LT(false_positives, 300);
+}
+
+TEST(BloomFilterTest, RestoresFromWords) {
+    BloomFilter bloom(100, 10);
+    bloom.add(db_hash(Vari(string("hello"))));
+
+    BloomFilter copy(bloom.getWords(), bloom.getNumHashes());
+    ASSERT_TRUE(copy.mayContain(db_hash(Vari(string("hello")))));
+
+    copy.clear();
+    ASSERT_FALSE(copy.mayContain(db_hash(Vari(string("hello")))));
+}
+
+TEST_F(LsmTreeTest, SortedRunRoundTrips) {
+    const string file = kBasePath + ".0.run";
+    SortedRunWriter writer(file, kTypes, 5000, 10);
+    for (int i = 0; i < 5000; i++) {
+        if (i % 10 == 0)
+            writer.add({i, std::nullopt});
+        else
+            writer.add({i, tuple(i)});
+    }
+    ASSERT_EQ(writer.finish(), 5000);
+
+    SortedRun run(0, file);
+    ASSERT_EQ(run.getNumEntries(), 5000);
+    for (int i = 0; i < 5000; i++) {
+        auto entry = run.get(i, db_hash(Vari(i)));
+        ASSERT_TRUE(entry.has_value());
+        if (i % 10 == 0)
+            ASSERT_FALSE(entry->value.has_value());
+        else
+            ASSERT_EQ(entry->value, tuple(i));
+    }
+    ASSERT_FALSE(run.get(-1, db_hash(Vari(-1))).has_value());
+    ASSERT_FALSE(run.get(5000, db_hash(Vari(5000))).has_value());
+
+    int expected = 0;
+    for (auto cursor = run.cursor(); cursor->valid(); cursor->next())
+        ASSERT_EQ(cursor->entry().key, Vari(expected++));
+    ASSERT_EQ(expected, 5000);
+}
+
+TEST_F(LsmTreeTest, MergeCursorPrefersNewestSource) {
+    MemtableCursor::Memtable newer = {{1, Vec<Vari>{1, string("new")}}, {3, std::nullopt}};
+    MemtableCursor::Memtable older = {{1, Vec<Vari>{1, string("old")}}, {2, tuple(2)}, {3, tuple(3)}};
+
+    Vec<Ptr<LsmCursor>> sources;
+    sources.push_back(std::make_unique<MemtableCursor>(newer));
+    sources.push_back(std::make_unique<MemtableCursor>(older));
+    MergeCursor cursor(std::move(sources));
+
+    ASSERT_TRUE(cursor.valid());
+    ASSERT_EQ(cursor.entry().value, (Vec<Vari>{1, string("new")}));
+    cursor.next();
+    ASSERT_EQ(cursor.entry().value, tuple(2));
+    cursor.next();
+    ASSERT_EQ(cursor.entry().key, Vari(3));
+    ASSERT_FALSE(cursor.entry().value.has_value());
+    cursor.next();
+    ASSERT_FALSE(cursor.valid());
+}
+
+TEST_F(LsmTreeTest, CrudWorksAcrossFlushesAndCompactions) {
+    open(smallOptions());
+
+    Vec<int> keys(3000);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(SEED));
+
+    for (int key: keys)
+        ASSERT_TRUE(tree->insert(tuple(key), key));
+    for (int key: keys)
+        ASSERT_FALSE(tree->insert(tuple(key), key));
+
+    for (int i = 0; i < 3000; i += 2)
+        ASSERT_TRUE(tree->remove(i));
+    for (int i = 1; i < 3000; i += 4)
+        ASSERT_TRUE(tree->update({i, string("updated")}, i));
+    ASSERT_FALSE(tree->remove(0));
+    ASSERT_FALSE(tree->update(tuple(0), 0));
+
+    tree->flush();
+    auto runs = tree->getRunsPerLevel();
+    ASSERT_LT(runs[0], smallOptions().level0Runs);
+    ASSERT_GT(runs.size(), 1);
+
+    for (int i = 0; i < 3000; i++) {
+        if (i % 2 == 0)
+            ASSERT_EQ(tree->search(i), std::nullopt);
+        else if (i % 4 == 1)
+            ASSERT_EQ(tree->search(i), (Vec<Vari>{i, string("updated")}));
+        else
+            ASSERT_EQ(tree->search(i), tuple(i));
+    }
+
+    // deleted keys can be inserted again
+    ASSERT_TRUE(tree->insert(tuple(0), 0));
+    ASSERT_EQ(tree->search(0), tuple(0));
+}
+
+TEST_F(LsmTreeTest, ForEachVisitsLiveKeysInOrder) {
+    open(smallOptions());
+
+    for (int i = 999; i >= 0; i--)
+        ASSERT_TRUE(tree->insert(tuple(i), i));
+    for (int i = 0; i < 1000; i += 3)
+        ASSERT_TRUE(tree->remove(i));
+
+    Vec<int> visited;
+    tree->forEach([&](const Vari &key, const Vec<Vari> &value) {
+        ASSERT_EQ(value, tuple(std::get<int>(key)));
+        visited.push_back(std::get<int>(key));
+    });
+
+    Vec<int> expected;
+    for (int i = 0; i < 1000; i++)
+        if (i % 3 != 0) expected.push_back(i);
+    ASSERT_EQ(visited, expected);
+}
+
+TEST_F(LsmTreeTest, PersistsAcrossReopen) {
+    open(smallOptions());
+    for (int i = 0; i < 2500; i++)
+        ASSERT_TRUE(tree->insert(tuple(i), i));
+    for (int i = 0; i < 2500; i += 5)
+        ASSERT_TRUE(tree->remove(i));
+
+    // destroying the tree writes out the memtable
+    open(smallOptions());
+
+    for (int i = 0; i < 2500; i++) {
+        if (i % 5 == 0)
+            ASSERT_EQ(tree->search(i), std::nullopt);
+        else
+            ASSERT_EQ(tree->search(i), tuple(i));
+    }
+    ASSERT_TRUE(tree->insert(tuple(2500), 2500));
+    ASSERT_EQ(tree->search(2500), tuple(2500));
+}
+
+TEST_F(LsmTreeTest, CompactionRemovesObsoleteRuns) {
+    open(smallOptions());
+    for (int round = 0; round < 10; round++)
+        for (int i = 0; i < 500; i++)
+            tree->insert(tuple(i), i) || tree->update({i, std::to_string(round)}, i);
+    tree->flush();
+
+    size_t live = 0;
+    for (size_t runs: tree->getRunsPerLevel())
+        live += runs;
+
+    size_t files = 0;
+    for (const auto &entry: std::filesystem::directory_iterator("."))
+        if (entry.path().extension() == ".run" && entry.path().filename().string().starts_with(kBasePath))
+            files++;
+    ASSERT_EQ(files, live);
+}
@@ -0,0 +1,135 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "FSMPage.hpp"
+#include "Metrics.hpp"
+#include "PageCache.hpp"
+
+using namespace backend;
+
+TEST(MetricsTest, HistogramPercentilesAreWithinBucketError) {
+    Histogram histogram;
+    for (u64 i = 1; i <= 10000; i++)
+        histogram.record(i);
+
+    auto snap = histogram.snapshot();
+    ASSERT_EQ(snap.count(), 10000);
+    ASSERT_EQ(snap.sum(), 10000 * 10001 / 2);
+    ASSERT_EQ(snap.max(), 10000);
+    ASSERT_DOUBLE_EQ(snap.mean(), 5000.5);
+
+    // a percentile is an upper bound at most 1/16 above the true value
+    for (double q: {0.5, 0.9, 0.99, 0.999}) {
+        auto exact = static_cast<double>(q * 10000);
+        ASSERT_GE(snap.percentile(q), exact);
+        ASSERT_LE(snap.percentile(q), exact * (1 + 1.0 / 16));
+    }
+    ASSERT_EQ(snap.percentile(1), 10000);
+    ASSERT_EQ(Histogram().snapshot().percentile(0.5), 0);
+
+    // merging two halves gives the whole
+    Histogram low, high;
+    for (u64 i = 1; i <= 10000; i++)
+        (i <= 5000 ? low : high).record(i);
+    auto merged = low.snapshot();
+    merged.merge(high.snapshot());
+    ASSERT_EQ(merged.count(), snap.count());
+    ASSERT_EQ(merged.percentile(0.99), snap.percentile(0.99));
+    ASSERT_EQ(merged.max(), snap.max());
+}
+
+TEST(MetricsTest, RecordingFromManyThreadsLosesNothing) {
+    Counter counter;
+    Gauge gauge;
+    Histogram histogram;
+
+    constexpr int numThreads = 4;
+    constexpr u64 perThread = 50000;
+    Vec<std::thread> threads;
+    for (int t = 0; t < numThreads; t++)
+        threads.emplace_back([&, t] {
+            for (u64 i = 0; i < perThread; i++) {
+                counter.add();
+                gauge.add(t % 2 ? 1 : -1);
+                histogram.record(i);
+            }
+        });
+    for (auto &thread: threads)
+        thread.join();
+
+    ASSERT_EQ(counter.value(), numThreads * perThread);
+    ASSERT_EQ(gauge.value(), 0);
+    auto snap = histogram.snapshot();
+    ASSERT_EQ(snap.count(), numThreads * perThread);
+    ASSERT_EQ(snap.sum(), numThreads * (perThread * (perThread - 1) / 2));
+    ASSERT_EQ(snap.max(), perThread - 1);
+}
+
+TEST(MetricsTest, RegistryExportsTextAndJson) {
+    MetricsRegistry registry;
+    auto &counter = registry.counter("test.ops");
+    ASSERT_EQ(&counter, &registry.counter("test.ops"));
+    counter.add(3);
+    registry.gauge("test.level").set(-2);
+    registry.histogram("test.op_ns").record(100);
+
+    auto snap = registry.snapshot();
+    auto text = snap.toText();
+    ASSERT_NE(text.find("test.ops 3\n"), string::npos);
+    ASSERT_NE(text.find("test.level -2\n"), string::npos);
+    ASSERT_NE(text.find("test.op_ns count=1 mean=100.0"), string::npos);
+
+    ASSERT_EQ(snap.toJson(), "{\"counters\":{\"test.ops\":3},\"gauges\":{\"test.level\":-2},\"histograms\":{"
+                             "\"test.op_ns\":{\"count\":1,\"sum\":100,\"mean\":100.0,\"max\":100,"
+                             "\"p50\":100,\"p90\":100,\"p99\":100,\"p999\":100}}}");
+
+    // reset clears the counts, but a gauge keeps its level
+    registry.reset();
+    ASSERT_EQ(counter.value(), 0);
+    ASSERT_EQ(registry.histogram("test.op_ns").snapshot().count(), 0);
+    ASSERT_EQ(registry.gauge("test.level").value(), -2);
+}
+
+TEST(MetricsTest, PageCacheAndIOHandlerAreInstrumented) {
+    const std::string kTestFile = "testfile.db";
+    std::remove(kTestFile.c_str());
+    auto &registry = MetricsRegistry::global();
+    auto &hits = registry.counter("pagecache.hits");
+    auto &misses = registry.counter("pagecache.misses");
+    auto &evictions = registry.counter("pagecache.evictions");
+    auto &reads = registry.counter("io.reads");
+    auto &bytesRead = registry.counter("io.bytes_read");
+    auto &pages = registry.gauge("pagecache.pages");
+    int64_t pagesBefore = pages.value();
+
+    {
+        IOHandler ioHandler(kTestFile);
+        ioHandler.createMultipleBlocks(4);
+        PgArr<byte> buf;
+        for (blockid_t id = 0; id < 4; id++) {
+            FSMPage(id).toBytes(buf);
+            ioHandler.writeBlock(buf.data(), id);
+        }
+
+        registry.reset();
+        PageCache cache(ioHandler, 2);
+        cache.retrievePage<FSMPage>(0);
+        cache.retrievePage<FSMPage>(0);
+        cache.retrievePage<FSMPage>(1);
+        cache.retrievePage<FSMPage>(2);
+        ASSERT_EQ(hits.value(), 1);
+        ASSERT_EQ(misses.value(), 3);
+        ASSERT_EQ(evictions.value(), 1);
+        ASSERT_EQ(pages.value(), pagesBefore + 2);
+        ASSERT_EQ(reads.value(), 3);
+        ASSERT_EQ(bytesRead.value(), 3 * cts::PG_SZ);
+        ASSERT_EQ(registry.histogram("io.read_ns").snapshot().count(), 3);
+    }
+
+    ASSERT_EQ(pages.value(), pagesBefore);
+    std::remove(kTestFile.c_str());
+}
@@ -101,4 +101,136 @@ TEST_F(PageCacheTest, InsertAndRetrieveForManyPages) {
     for (const auto& [pgid, val]: map) {
         ASSERT_EQ(cache->retrievePage<SchemaPage>(pgid).getTables().at("Table"), val);
     }
-}
\ No newline at end of file
+}
+
+TEST_F(PageCacheTest, OnlyDirtyPagesAreWritten) {
+    ioHandler->createMultipleBlocks(10);
+    for (pgid_t id = 0; id < 10; id++) {
+        auto page = std::make_unique<SchemaPage>(id);
+        page->addTable("Page", id);
+        cache->insertPage(std::move(page));
+    }
+
+    auto &registry = MetricsRegistry::global();
+    auto &writes = registry.counter("pagecache.page_writes");
+    registry.reset();
+    cache->flush();
+    ASSERT_EQ(writes.value(), 10);
+
+    // viewing a page does not mark it dirty, but retrieving it for writing does
+    ASSERT_EQ(cache->viewPage<SchemaPage>(3).getTables().at("Page"), 3);
+    cache->flush();
+    ASSERT_EQ(writes.value(), 10);
+    cache->retrievePage<SchemaPage>(4).addTable("Changed", 4);
+    cache->flush();
+    ASSERT_EQ(writes.value(), 11);
+
+    // pages read from disk are clean, so evicting them writes nothing
+    reset();
+    ioHandler = std::make_unique<IOHandler>(kTestFile);
+    cache = std::make_unique<PageCache>(*ioHandler, 2);
+    registry.reset();
+    for (pgid_t id = 0; id < 10; id++)
+        ASSERT_EQ(cache->viewPage<SchemaPage>(id).getTables().at("Page"), id);
+    ASSERT_EQ(cache->viewPage<SchemaPage>(4).getTables().at("Changed"), 4);
+    ASSERT_EQ(writes.value(), 0);
+}
+
+TEST_F(PageCacheTest, PagesHitSinceTheyMovedGetASecondChance) {
+    ioHandler->createMultipleBlocks(4);
+    for (pgid_t id = 0; id < 4; id++)
+        cache->insertPage(std::make_unique<SchemaPage>(id));
+    reset();
+    ioHandler = std::make_unique<IOHandler>(kTestFile);
+    cache = std::make_unique<PageCache>(*ioHandler, 3);
+
+    for (pgid_t id = 0; id < 3; id++)
+        cache->viewPage<SchemaPage>(id);
+    // a hit only sets the page's reference bit, so page 0 stays at the back of the list, but is
+    // moved to the front rather than evicted when page 3 is loaded
+    cache->viewPage<SchemaPage>(0);
+    cache->viewPage<SchemaPage>(3);
+
+    auto &registry = MetricsRegistry::global();
+    auto &misses = registry.counter("pagecache.misses");
+    registry.reset();
+    cache->retrieveSharedPage<SchemaPage>(0);
+    ASSERT_EQ(misses.value(), 0);
+    cache->retrieveSharedPage<SchemaPage>(1);
+    ASSERT_EQ(misses.value(), 1);
+}
+
+TEST_F(PageCacheTest, PrefetchedPagesAreRetrievedWithoutReads) {
+    // each page names its own ID, so a page read from the wrong block would show
+    ioHandler->createMultipleBlocks(100);
+    for (pgid_t id = 0; id < 100; id++) {
+        auto page = std::make_unique<SchemaPage>(id);
+        page->addTable("Page", id);
+        cache->insertPage(std::move(page));
+    }
+    reset();
+    ioHandler = std::make_unique<IOHandler>(kTestFile);
+    cache = std::make_unique<PageCache>(*ioHandler, 4);
+    cache->setReadAhead(0);
+
+    auto &registry = MetricsRegistry::global();
+    auto &reads = registry.counter("io.reads");
+    auto &prefetchHits = registry.counter("pagecache.prefetch_hits");
+    registry.reset();
+
+    // pages 1 to 60 in a shuffled order, and one out of bounds, which is skipped
+    Vec<pgid_t> pageIDs;
+    for (pgid_t i = 1; i <= 60; i++)
+        pageIDs.push_back(i * 7 % 61);
+    pageIDs.push_back(500);
+    cache->prefetch(pageIDs);
+
+    // a page written after it was read ahead is read again
+    auto changed = std::make_unique<SchemaPage>(1);
+    changed->addTable("Page", 1);
+    changed->addTable("Changed", 1);
+    cache->insertPage(std::move(changed));
+    cache->writePage(1);
+
+    for (pgid_t id = 0; id <= 60; id++)
+        ASSERT_EQ(cache->retrieveSharedPage<SchemaPage>(id)->getTables().at("Page"), id);
+    ASSERT_EQ(cache->retrievePage<SchemaPage>(1).getTables().at("Changed"), 1);
+    ASSERT_THROW(cache->retrievePage<SchemaPage>(500), std::runtime_error);
+
+    // one read for pages 1 to 60, then 0 and 1 on their own
+    ASSERT_EQ(prefetchHits.value(), 59);
+    ASSERT_EQ(reads.value(), 3);
+}
+
+TEST_F(PageCacheTest, SequentialMissesAreReadAhead) {
+    const pgid_t numPages = 1000;
+    ioHandler->createMultipleBlocks(numPages);
+    for (pgid_t id = 0; id < numPages; id++) {
+        auto page = std::make_unique<SchemaPage>(id);
+        page->addTable("Page", id);
+        cache->insertPage(std::move(page));
+    }
+    reset();
+    init();
+
+    auto &registry = MetricsRegistry::global();
+    auto &reads = registry.counter("io.reads");
+    auto &prefetched = registry.counter("pagecache.prefetched");
+    registry.reset();
+
+    // a cache much smaller than the scan, so pages are evicted while others are read ahead
+    for (int pass = 0; pass < 2; pass++)
+        for (pgid_t id = 0; id < numPages; id++)
+            ASSERT_EQ(cache->retrievePage<SchemaPage>(id).getTables().at("Page"), id);
+
+    // only the first pages of each pass are read on demand; the rest in windows of up to 64 pages
+    ASSERT_GE(prefetched.value(), 2 * (numPages - PageCache::SEQUENTIAL_TRIGGER - 1));
+    ASSERT_LE(reads.value(), 2 * (numPages / PageCache::DEFAULT_READ_AHEAD + 8));
+
+    // random retrievals are not read ahead
+    registry.reset();
+    for (pgid_t id = 0; id < numPages; id += 37)
+        cache->retrievePage<SchemaPage>(id);
+    ASSERT_EQ(prefetched.value(), 0);
+}
+
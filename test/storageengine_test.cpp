@@ -0,0 +1,1137 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <thread>
+
+#include "StorageEngine.hpp"
+#include "SchemaPage.hpp"
+
+using namespace backend;
+
+class StorageEngineTest : public testing::Test {
+protected:
+    const std::string kTestFile = "testfile.db";
+
+    std::unique_ptr<IOHandler> ioHandler;
+    std::unique_ptr<PageCache> pageCache;
+    std::unique_ptr<FreeSpaceMap> fsm;
+    std::unique_ptr<Pager> pager;
+    std::unique_ptr<StorageEngine> engine;
+
+    void SetUp() override {
+        removeFiles();
+        initEnv();
+        pager->createNewPage<SchemaPage>();
+        engine = std::make_unique<StorageEngine>(*pager, cts::SCHEMA_ID);
+    }
+
+    void TearDown() override {
+        resetEnv();
+        removeFiles();
+    }
+
+    // removes the database file and the files of any LSM tables stored next to it
+    void removeFiles() {
+        for (const auto &entry: std::filesystem::directory_iterator("."))
+            if (entry.path().filename().string().starts_with(kTestFile))
+                std::filesystem::remove(entry.path());
+    }
+
+    void initEnv(IOMode mode = IOMode::READ_WRITE) {
+        ioHandler = std::make_unique<IOHandler>(kTestFile, mode);
+        pageCache = std::make_unique<PageCache>(*ioHandler, cts::CACHE_SZ);
+        fsm = std::make_unique<FreeSpaceMap>(*pageCache);
+        pager = std::make_unique<Pager>(*fsm, *ioHandler, *pageCache);
+    }
+
+    void resetEnv() {
+        engine.reset();
+        pager.reset();
+        fsm.reset();
+        pageCache.reset();
+        ioHandler.reset();
+    }
+
+    void reopen(IOMode mode = IOMode::READ_WRITE) {
+        resetEnv();
+        initEnv(mode);
+        engine = std::make_unique<StorageEngine>(*pager, cts::SCHEMA_ID);
+    }
+};
+
+TEST_F(StorageEngineTest, NameBasedCrudWorks) {
+    engine->createTable("Students", {int(), int(), double()});
+    ASSERT_TRUE(engine->insertTuple("Students", {1, 2, 3.0}));
+    ASSERT_FALSE(engine->insertTuple("Students", {1, 5, 6.0}));
+    ASSERT_EQ(engine->getTuple("Students", 1), (Vec<Vari>{1, 2, 3.0}));
+    ASSERT_TRUE(engine->updateTuple("Students", {1, 7, 8.0}));
+    ASSERT_EQ(engine->getTuple("Students", 1), (Vec<Vari>{1, 7, 8.0}));
+    ASSERT_EQ(engine->getNumTuples("Students"), 1);
+}
+
+TEST_F(StorageEngineTest, UnknownTableReturnsEmpty) {
+    ASSERT_FALSE(engine->insertTuple("Missing", {1}));
+    ASSERT_EQ(engine->getTuple("Missing", 1), std::nullopt);
+    ASSERT_EQ(engine->getNumTuples("Missing"), std::nullopt);
+    ASSERT_EQ(engine->openTable("Missing"), std::nullopt);
+}
+
+TEST_F(StorageEngineTest, DuplicateTableNameThrows) {
+    engine->createTable("Students", {int()});
+    ASSERT_THROW(engine->createTable("Students", {int()}), std::invalid_argument);
+}
+
+TEST_F(StorageEngineTest, HandleBasedCrudWorks) {
+    engine->createTable("Students", {int(), string()});
+    auto students = engine->openTable("Students");
+    ASSERT_TRUE(students.has_value());
+    ASSERT_TRUE(students->valid());
+
+    for (int i = 0; i < 1000; i++)
+        ASSERT_TRUE(engine->insertTuple(*students, {i, std::to_string(i)}));
+
+    ASSERT_EQ(engine->getNumTuples(*students), 1000);
+    ASSERT_EQ(engine->getTableTypes(*students), (Vec<Vari>{int(), string()}));
+    ASSERT_TRUE(engine->updateTuple(*students, {10, string("ten")}));
+    ASSERT_EQ(engine->getTuple(*students, 10), (Vec<Vari>{10, string("ten")}));
+    ASSERT_EQ(engine->getTuple("Students", 10), engine->getTuple(*students, 10));
+}
+
+TEST_F(StorageEngineTest, HandlesAreIndependentPerTable) {
+    engine->createTable("A", {int()});
+    engine->createTable("B", {int()});
+    auto a = *engine->openTable("A");
+    auto b = *engine->openTable("B");
+
+    engine->insertTuple(a, {1});
+    engine->insertTuple(a, {2});
+    engine->insertTuple(b, {3});
+
+    ASSERT_EQ(engine->getNumTuples(a), 2);
+    ASSERT_EQ(engine->getNumTuples(b), 1);
+    ASSERT_EQ(engine->getTuple(b, 1), std::nullopt);
+}
+
+TEST_F(StorageEngineTest, TablesPersistAcrossReopen) {
+    engine->createTable("Students", {int(), double()});
+    for (int i = 0; i < 500; i++)
+        engine->insertTuple("Students", {i, i * 1.5});
+
+    reopen();
+
+    auto students = engine->openTable("Students");
+    ASSERT_TRUE(students.has_value());
+    ASSERT_EQ(engine->getNumTuples(*students), 500);
+    ASSERT_EQ(engine->getTuple(*students, 250), (Vec<Vari>{250, 375.0}));
+}
+
+TEST_F(StorageEngineTest, RemoveTupleWorks) {
+    engine->createTable("Students", {int(), double()});
+    for (int i = 0; i < 2000; i++)
+        engine->insertTuple("Students", {i, i * 1.5});
+    for (int i = 0; i < 2000; i += 2)
+        ASSERT_TRUE(engine->removeTuple("Students", i));
+
+    ASSERT_FALSE(engine->removeTuple("Students", 0));
+    ASSERT_EQ(engine->getNumTuples("Students"), 1000);
+    ASSERT_EQ(engine->getTuple("Students", 2), std::nullopt);
+    ASSERT_EQ(engine->getTuple("Students", 3), (Vec<Vari>{3, 4.5}));
+}
+
+TEST_F(StorageEngineTest, SecondaryIndexLookupWorks) {
+    engine->createTable("Students", {int(), string(), int()});
+    for (int i = 0; i < 300; i++)
+        engine->insertTuple("Students", {i, "name" + std::to_string(i), i % 10});
+
+    // index built from existing tuples, and maintained for new ones
+    engine->createIndex("Students", 2);
+    for (int i = 300; i < 600; i++)
+        engine->insertTuple("Students", {i, "name" + std::to_string(i), i % 10});
+
+    auto res = engine->getTuplesBy("Students", 2, 7);
+    ASSERT_TRUE(res.has_value());
+    ASSERT_EQ(res->size(), 60);
+    for (const auto &tuple : *res)
+        ASSERT_EQ(std::get<int>(tuple[0]) % 10, 7);
+
+    ASSERT_EQ(engine->getTuplesBy("Students", 0, 5)->size(), 1);
+    ASSERT_THROW(engine->getTuplesBy("Students", 1, string("name5")), std::invalid_argument);
+    ASSERT_EQ(engine->getTuplesBy("Missing", 2, 7), std::nullopt);
+}
+
+TEST_F(StorageEngineTest, SecondaryIndexIsMaintainedOnUpdateAndDelete) {
+    engine->createTable("Students", {int(), string()});
+    engine->createIndex("Students", 1);
+    auto students = *engine->openTable("Students");
+
+    for (int i = 0; i < 100; i++)
+        engine->insertTuple(students, {i, string(i % 2 == 0 ? "even" : "odd")});
+
+    ASSERT_TRUE(engine->updateTuple(students, {0, string("zero")}));
+    ASSERT_TRUE(engine->removeTuple(students, 1));
+
+    ASSERT_EQ(engine->getTuplesBy(students, 1, string("even")).size(), 49);
+    ASSERT_EQ(engine->getTuplesBy(students, 1, string("odd")).size(), 49);
+    ASSERT_EQ(engine->getTuplesBy(students, 1, string("zero")),
+              (Vec<Vec<Vari>>{{0, string("zero")}}));
+}
+
+TEST_F(StorageEngineTest, UniqueIndexRejectsDuplicates) {
+    engine->createTable("Users", {int(), string()});
+    engine->insertTuple("Users", {1, string("a")});
+    engine->insertTuple("Users", {2, string("a")});
+    ASSERT_THROW(engine->createIndex("Users", 1, true), std::invalid_argument);
+
+    engine->updateTuple("Users", {2, string("b")});
+    engine->createIndex("Users", 1, true);
+
+    ASSERT_FALSE(engine->insertTuple("Users", {3, string("a")}));
+    ASSERT_FALSE(engine->updateTuple("Users", {2, string("a")}));
+    ASSERT_TRUE(engine->updateTuple("Users", {2, string("b")}));
+    ASSERT_TRUE(engine->insertTuple("Users", {3, string("c")}));
+    ASSERT_EQ(engine->getNumTuples("Users"), 3);
+}
+
+TEST_F(StorageEngineTest, SecondaryIndexPersistsAcrossReopen) {
+    engine->createTable("Students", {int(), int()});
+    engine->createIndex("Students", 1);
+    for (int i = 0; i < 5000; i++)
+        engine->insertTuple("Students", {i, i % 3});
+
+    reopen();
+
+    ASSERT_EQ(engine->getTuplesBy("Students", 1, 2)->size(), 1666);
+    engine->insertTuple("Students", {5000, 2});
+    ASSERT_EQ(engine->getTuplesBy("Students", 1, 2)->size(), 1667);
+}
+
+TEST_F(StorageEngineTest, HashTableCrudWorks) {
+    engine->createTable("Sessions", {string(), int()}, TableEngine::HASH);
+    auto sessions = *engine->openTable("Sessions");
+
+    for (int i = 0; i < 3000; i++)
+        ASSERT_TRUE(engine->insertTuple(sessions, {"s" + std::to_string(i), i}));
+    ASSERT_FALSE(engine->insertTuple(sessions, {string("s1"), 1}));
+
+    ASSERT_TRUE(engine->updateTuple(sessions, {string("s1"), 5000}));
+    ASSERT_TRUE(engine->removeTuple(sessions, string("s2")));
+    ASSERT_EQ(engine->getTuple(sessions, string("s1")), (Vec<Vari>{string("s1"), 5000}));
+    ASSERT_EQ(engine->getTuple(sessions, string("s2")), std::nullopt);
+    ASSERT_EQ(engine->getNumTuples(sessions), 2999);
+
+    engine->createIndex("Sessions", 1);
+    ASSERT_EQ(engine->getTuplesBy(sessions, 1, 5000), (Vec<Vec<Vari>>{{string("s1"), 5000}}));
+
+    reopen();
+
+    ASSERT_EQ(engine->getTuple("Sessions", string("s2999")), (Vec<Vari>{string("s2999"), 2999}));
+    ASSERT_EQ(engine->getTuplesBy("Sessions", 1, 5000)->size(), 1);
+}
+
+TEST_F(StorageEngineTest, LsmTableCrudWorks) {
+    engine->createTable("Events", {int(), string()}, TableEngine::LSM);
+    auto events = *engine->openTable("Events");
+
+    for (int i = 0; i < 20000; i++)
+        ASSERT_TRUE(engine->insertTuple(events, {i, "e" + std::to_string(i)}));
+    ASSERT_FALSE(engine->insertTuple(events, {1, string("e1")}));
+
+    ASSERT_TRUE(engine->updateTuple(events, {1, string("changed")}));
+    ASSERT_TRUE(engine->removeTuple(events, 2));
+    ASSERT_FALSE(engine->removeTuple(events, 2));
+    ASSERT_EQ(engine->getTuple(events, 1), (Vec<Vari>{1, string("changed")}));
+    ASSERT_EQ(engine->getTuple(events, 2), std::nullopt);
+    ASSERT_EQ(engine->getNumTuples(events), 19999);
+
+    engine->createIndex("Events", 1);
+    ASSERT_EQ(engine->getTuplesBy(events, 1, string("changed")), (Vec<Vec<Vari>>{{1, string("changed")}}));
+
+    reopen();
+
+    ASSERT_EQ(engine->getTuple("Events", 19999), (Vec<Vari>{19999, string("e19999")}));
+    ASSERT_EQ(engine->getTuple("Events", 2), std::nullopt);
+    ASSERT_EQ(engine->getTuplesBy("Events", 1, string("changed"))->size(), 1);
+}
+
+TEST_F(StorageEngineTest, BloomFilterKeepsLookupsCorrect) {
+    engine->createTable("Users", {int(), int()});
+    for (int i = 0; i < 500; i++)
+        ASSERT_TRUE(engine->insertTuple("Users", {i * 2, i}));
+
+    engine->createBloomFilter("Users", 0.01);
+    ASSERT_THROW(engine->createBloomFilter("Users", 0.01), std::invalid_argument);
+    ASSERT_THROW(engine->createBloomFilter("Missing", 0.01), std::invalid_argument);
+
+    // grows past the initial capacity, so the filter is rebuilt a few times
+    for (int i = 500; i < 5000; i++)
+        ASSERT_TRUE(engine->insertTuple("Users", {i * 2, i}));
+    ASSERT_FALSE(engine->insertTuple("Users", {0, 0}));
+
+    for (int i = 0; i < 5000; i++) {
+        ASSERT_EQ(engine->getTuple("Users", i * 2), (Vec<Vari>{i * 2, i}));
+        ASSERT_EQ(engine->getTuple("Users", i * 2 + 1), std::nullopt);
+    }
+    ASSERT_FALSE(engine->updateTuple("Users", {1, 1}));
+    ASSERT_FALSE(engine->removeTuple("Users", 1));
+    ASSERT_TRUE(engine->removeTuple("Users", 0));
+    ASSERT_EQ(engine->getTuple("Users", 0), std::nullopt);
+
+    reopen();
+
+    ASSERT_THROW(engine->createBloomFilter("Users", 0.01), std::invalid_argument);
+    ASSERT_TRUE(engine->insertTuple("Users", {10001, 0}));
+    for (int i = 1; i < 5000; i++)
+        ASSERT_EQ(engine->getTuple("Users", i * 2), (Vec<Vari>{i * 2, i}));
+    ASSERT_EQ(engine->getTuple("Users", 10001), (Vec<Vari>{10001, 0}));
+    ASSERT_EQ(engine->getTuple("Users", 3), std::nullopt);
+}
+
+TEST_F(StorageEngineTest, BloomFilterTreatsSignedZerosAsOneKey) {
+    engine->createTable("Points", {double(), int()});
+    ASSERT_TRUE(engine->insertTuple("Points", {-0.0, 1}));
+    engine->createBloomFilter("Points", 0.01);
+
+    // -0.0 == 0.0, so the filter must not reject a lookup of the other
+    ASSERT_EQ(engine->getTuple("Points", 0.0), (Vec<Vari>{-0.0, 1}));
+    ASSERT_FALSE(engine->insertTuple("Points", {0.0, 2}));
+}
+
+TEST_F(StorageEngineTest, BloomFilterRejectsInvalidRate) {
+    engine->createTable("Users", {int(), int()});
+    ASSERT_THROW(engine->createBloomFilter("Users", 0), std::invalid_argument);
+    ASSERT_THROW(engine->createBloomFilter("Users", 1), std::invalid_argument);
+}
+
+TEST_F(StorageEngineTest, ScanFiltersAndProjects) {
+    engine->createTable("Orders", {int(), string(), double()});
+    for (int i = 0; i < 1000; i++)
+        ASSERT_TRUE(engine->insertTuple("Orders", {i, "c" + std::to_string(i % 7), i * 0.5}));
+
+    Vec<Vec<Vari>> rows;
+    ASSERT_TRUE(engine->scan("Orders", {{1, CompareOp::EQ, string("c3")}, {2, CompareOp::LT, 100.0}}, {2, 0},
+                             [&](const Vec<Vari> &row) { rows.push_back(row); }));
+
+    Vec<Vec<Vari>> expected;
+    for (int i = 3; i * 0.5 < 100.0; i += 7)
+        expected.push_back({i * 0.5, i});
+    ASSERT_EQ(rows, expected);
+
+    ASSERT_FALSE(engine->scan("Missing", {}, {}, [](const Vec<Vari> &) {}));
+}
+
+TEST_F(StorageEngineTest, ScanWithoutPredicatesVisitsAllTuplesInKeyOrder) {
+    engine->createTable("Orders", {int(), int()}, TableEngine::LSM);
+    auto orders = *engine->openTable("Orders");
+    for (int i = 999; i >= 0; i--)
+        ASSERT_TRUE(engine->insertTuple(orders, {i, i * 3}));
+
+    int next = 0;
+    engine->scan(orders, {}, {}, [&](const Vec<Vari> &row) {
+        ASSERT_EQ(row, (Vec<Vari>{next, next * 3}));
+        next++;
+    });
+    ASSERT_EQ(next, 1000);
+
+    size_t count = 0;
+    engine->scan(orders, {{0, CompareOp::GE, 900}, {1, CompareOp::NE, 2997}}, {1},
+                 [&](const Vec<Vari> &row) { count++; ASSERT_EQ(row.size(), 1); });
+    ASSERT_EQ(count, 99);
+}
+
+TEST_F(StorageEngineTest, ScanRejectsInvalidColumns) {
+    engine->createTable("Orders", {int(), int()});
+    auto noop = [](const Vec<Vari> &) {};
+    ASSERT_THROW(engine->scan("Orders", {{2, CompareOp::EQ, 1}}, {}, noop), std::invalid_argument);
+    ASSERT_THROW(engine->scan("Orders", {}, {0, 2}, noop), std::invalid_argument);
+    ASSERT_THROW(engine->scan("Orders", {{1, CompareOp::EQ, 1.0}}, {}, noop), std::runtime_error);
+}
+
+TEST_F(StorageEngineTest, ParallelScanMatchesSerialScan) {
+    for (auto table_engine: {TableEngine::BTREE, TableEngine::HASH, TableEngine::LSM}) {
+        string name = "Orders" + std::to_string(static_cast<int>(table_engine));
+        engine->createTable(name, {int(), int(), double()}, table_engine);
+        for (int i = 0; i < 20000; i++)
+            ASSERT_TRUE(engine->insertTuple(name, {i, i % 10, i * 0.5}));
+
+        Vec<Predicate> predicates = {{1, CompareOp::LE, 2}, {0, CompareOp::NE, 2}};
+        Vec<Vec<Vari>> serial, parallel;
+        engine->scan(name, predicates, {2, 0}, [&](const Vec<Vari> &row) { serial.push_back(row); });
+        ASSERT_TRUE(engine->parallelScan(name, predicates, {2, 0},
+                                         [&](const Vec<Vari> &row) { parallel.push_back(row); }, 4));
+
+        ASSERT_EQ(serial.size(), 5999);
+        std::sort(serial.begin(), serial.end());
+        std::sort(parallel.begin(), parallel.end());
+        ASSERT_EQ(serial, parallel);
+    }
+
+    ASSERT_FALSE(engine->parallelScan("Missing", {}, {}, [](const Vec<Vari> &) {}));
+}
+
+TEST_F(StorageEngineTest, ParallelScanOfSmallTableVisitsEveryTuple) {
+    engine->createTable("Orders", {int(), int()});
+    auto orders = *engine->openTable("Orders");
+
+    size_t count = 0;
+    engine->parallelScan(orders, {}, {}, [&](const Vec<Vari> &) { count++; }, 3);
+    ASSERT_EQ(count, 0);
+
+    for (int i = 0; i < 10; i++)
+        ASSERT_TRUE(engine->insertTuple(orders, {i, i}));
+    engine->parallelScan(orders, {}, {}, [&](const Vec<Vari> &) { count++; }, 3);
+    ASSERT_EQ(count, 10);
+}
+
+TEST_F(StorageEngineTest, QueryAggregatesMatchingTuples) {
+    for (auto table_engine: {TableEngine::BTREE, TableEngine::HASH, TableEngine::LSM}) {
+        string name = "Orders" + std::to_string(static_cast<int>(table_engine));
+        engine->createTable(name, {int(), int(), double()}, table_engine);
+        for (int i = 0; i < 5000; i++)
+            ASSERT_TRUE(engine->insertTuple(name, {i, i % 3, i * 0.5}));
+
+        auto rows = engine->query(name, {{{0, CompareOp::LT, 3000}}, {}, {1},
+                                         {{AggregateOp::COUNT, 0}, {AggregateOp::MAX, 0}}});
+        ASSERT_TRUE(rows.has_value());
+        ASSERT_EQ(*rows, (Vec<Vec<Vari>>{{0, 1000, 2997}, {1, 1000, 2998}, {2, 1000, 2999}}));
+
+        auto projected = engine->query(*engine->openTable(name), {{{1, CompareOp::EQ, 2}}, {2}, {}, {}});
+        ASSERT_EQ(projected.size(), 1666);
+    }
+
+    ASSERT_FALSE(engine->query("Missing", {}).has_value());
+    string btree = "Orders" + std::to_string(static_cast<int>(TableEngine::BTREE));
+    ASSERT_THROW(engine->query(btree, {{}, {0}, {}, {{AggregateOp::COUNT, 0}}}), std::invalid_argument);
+}
+
+TEST_F(StorageEngineTest, JoinsMatchAcrossEngines) {
+    engine->createTable("Customers", {int(), string()});
+    for (int i = 0; i < 300; i++)
+        ASSERT_TRUE(engine->insertTuple("Customers", {i, "customer" + std::to_string(i)}));
+
+    Vec<Vec<Vari>> expected;
+    for (int i = 0; i < 3000; i++)
+        if (i % 400 < 300)
+            expected.push_back({i, "customer" + std::to_string(i % 400)});
+
+    for (auto table_engine: {TableEngine::BTREE, TableEngine::HASH, TableEngine::LSM}) {
+        string name = "Orders" + std::to_string(static_cast<int>(table_engine));
+        engine->createTable(name, {int(), int()}, table_engine);
+        for (int i = 0; i < 3000; i++)
+            ASSERT_TRUE(engine->insertTuple(name, {i, i % 400}));
+
+        Vec<Vec<Vari>> hashed, merged, spilled;
+        auto collect = [](Vec<Vec<Vari>> &out) {
+            return [&out](const Vec<Vari> &order, const Vec<Vari> &customer) {
+                ASSERT_EQ(order[1], customer[0]);
+                out.push_back({order[0], customer[1]});
+            };
+        };
+        ASSERT_TRUE(engine->hashJoin(name, 1, "Customers", 0, collect(hashed)));
+        ASSERT_TRUE(engine->mergeJoin(name, 1, "Customers", 0, collect(merged)));
+        engine->hashJoin(*engine->openTable(name), 1, *engine->openTable("Customers"), 0, collect(spilled), 4096);
+
+        ASSERT_TRUE(std::is_sorted(merged.begin(), merged.end(), [](const auto &a, const auto &b) {
+            return std::get<int>(a[0]) % 400 < std::get<int>(b[0]) % 400;
+        }));
+        for (auto *result: {&hashed, &merged, &spilled}) {
+            std::sort(result->begin(), result->end());
+            ASSERT_EQ(*result, expected);
+        }
+    }
+}
+
+TEST_F(StorageEngineTest, MergeJoinOnKeysStreamsBothTables) {
+    engine->createTable("A", {int(), double()});
+    engine->createTable("B", {int(), char()});
+    for (int i = 0; i < 2000; i++) {
+        engine->insertTuple("A", {i * 2, i * 1.0});
+        engine->insertTuple("B", {i * 3, 'x'});
+    }
+
+    Vec<int> keys;
+    ASSERT_TRUE(engine->mergeJoin("A", 0, "B", 0, [&](const Vec<Vari> &a, const Vec<Vari> &b) {
+        ASSERT_EQ(a[0], b[0]);
+        keys.push_back(std::get<int>(a[0]));
+    }));
+
+    Vec<int> expected;
+    for (int key = 0; key < 4000; key += 6)
+        expected.push_back(key);
+    ASSERT_EQ(keys, expected);
+}
+
+TEST_F(StorageEngineTest, JoinRejectsInvalidColumns) {
+    engine->createTable("A", {int(), double()});
+    engine->createTable("B", {int(), int()});
+    auto noop = [](const Vec<Vari> &, const Vec<Vari> &) {};
+    ASSERT_FALSE(engine->hashJoin("A", 0, "Missing", 0, noop));
+    ASSERT_FALSE(engine->mergeJoin("Missing", 0, "B", 0, noop));
+    ASSERT_THROW(engine->hashJoin("A", 2, "B", 0, noop), std::invalid_argument);
+    ASSERT_THROW(engine->mergeJoin("A", 1, "B", 1, noop), std::runtime_error);
+}
+
+TEST_F(StorageEngineTest, ScanSortedOrdersByAnyColumn) {
+    for (auto table_engine: {TableEngine::BTREE, TableEngine::HASH, TableEngine::LSM}) {
+        string name = "Orders" + std::to_string(static_cast<int>(table_engine));
+        engine->createTable(name, {int(), int(), double()}, table_engine);
+        for (int i = 0; i < 5000; i++)
+            ASSERT_TRUE(engine->insertTuple(name, {i, i % 7, (i * 37 % 5000) * 0.5}));
+
+        // small budget, so the sort spills
+        Vec<Vec<Vari>> rows;
+        ASSERT_TRUE(engine->scanSorted(name, {{1}, {2, true}},
+                                       [&](const Vec<Vari> &row) { rows.push_back(row); }, 16 * 1024));
+        ASSERT_EQ(rows.size(), 5000);
+        ASSERT_TRUE(std::is_sorted(rows.begin(), rows.end(), [](const Vec<Vari> &a, const Vec<Vari> &b) {
+            return a[1] != b[1] ? a[1] < b[1] : b[2] < a[2];
+        }));
+    }
+
+    ASSERT_FALSE(engine->scanSorted("Missing", {{0}}, [](const Vec<Vari> &) {}));
+    string btree = "Orders" + std::to_string(static_cast<int>(TableEngine::BTREE));
+    ASSERT_THROW(engine->scanSorted(btree, {{3}}, [](const Vec<Vari> &) {}), std::invalid_argument);
+}
+
+TEST_F(StorageEngineTest, RankQueriesPaginateInKeyOrder) {
+    for (auto table_engine: {TableEngine::BTREE, TableEngine::HASH, TableEngine::LSM}) {
+        string name = "Pages" + std::to_string(static_cast<int>(table_engine));
+        engine->createTable(name, {int(), double()}, table_engine);
+        for (int i = 0; i < 3000; i++)
+            ASSERT_TRUE(engine->insertTuple(name, {(i * 7919) % 3000 * 2, i * 0.5}));
+        for (int i = 0; i < 300; i++)
+            ASSERT_TRUE(engine->removeTuple(name, i * 20));
+
+        // keys are the even numbers below 6000 that aren't multiples of 20
+        ASSERT_EQ(engine->countRange(name, 0, 5998), 2700);
+        ASSERT_EQ(engine->countRange(name, 100, 199), 45);
+        ASSERT_EQ(engine->getRank(name, 42), 18);
+        ASSERT_EQ((*engine->getTupleAtRank(name, 18))[0], Vari(42));
+        ASSERT_EQ(engine->getTupleAtRank(name, 2700), std::nullopt);
+
+        auto page = engine->getTuplesFrom(name, 2690, 50);
+        ASSERT_TRUE(page.has_value());
+        ASSERT_EQ(page->size(), 10);
+        ASSERT_EQ(page->front()[0], Vari(5978));
+        ASSERT_EQ(page->back()[0], Vari(5998));
+    }
+
+    ASSERT_EQ(engine->countRange("Missing", 0, 1), std::nullopt);
+    string btree = "Pages" + std::to_string(static_cast<int>(TableEngine::BTREE));
+    ASSERT_THROW(engine->getRank(btree, 1.0), std::runtime_error);
+}
+
+TEST_F(StorageEngineTest, TableStatsTrackEveryChange) {
+    for (auto table_engine: {TableEngine::BTREE, TableEngine::HASH, TableEngine::LSM}) {
+        string name = "Stats" + std::to_string(static_cast<int>(table_engine));
+        engine->createTable(name, {int(), int(), double(), string()}, table_engine);
+
+        auto empty = engine->getTableStats(name);
+        ASSERT_EQ(empty->numTuples, 0);
+        ASSERT_EQ(empty->minKey, std::nullopt);
+
+        // keys 0..9999, 500 distinct values in column 1
+        for (int i = 0; i < 10000; i++)
+            ASSERT_TRUE(engine->insertTuple(name, {i, i % 500, 0.5, "s" + std::to_string(i % 3)}));
+        for (int i = 0; i < 100; i++)
+            ASSERT_TRUE(engine->updateTuple(name, {i, i % 500, 1.5, string("s0")}));
+        // deleting both ends of the key range
+        ASSERT_TRUE(engine->removeTuple(name, 0));
+        ASSERT_TRUE(engine->removeTuple(name, 9999));
+
+        auto stats = engine->getTableStats(name);
+        ASSERT_EQ(stats->numTuples, 9998);
+        ASSERT_EQ(stats->minKey, Vari(1));
+        ASSERT_EQ(stats->maxKey, Vari(9998));
+        ASSERT_DOUBLE_EQ(stats->sums[0], 9999.0 * 10000 / 2 - 9999);
+        ASSERT_DOUBLE_EQ(stats->sums[1], 20.0 * 499 * 500 / 2 - 499);
+        ASSERT_DOUBLE_EQ(stats->sums[2], 9998 * 0.5 + 99);
+        ASSERT_EQ(stats->sums[3], 0);
+        ASSERT_EQ(stats->distinct[0], 9998);
+        ASSERT_NEAR(stats->distinct[1], 500, 50);
+        ASSERT_NEAR(stats->distinct[2], 2, 1);
+        ASSERT_NEAR(stats->distinct[3], 3, 1);
+    }
+
+    reopen();
+    auto stats = engine->getTableStats("Stats" + std::to_string(static_cast<int>(TableEngine::BTREE)));
+    ASSERT_EQ(stats->minKey, Vari(1));
+    ASSERT_EQ(stats->maxKey, Vari(9998));
+    ASSERT_EQ(engine->getTableStats("Missing"), std::nullopt);
+}
+
+TEST_F(StorageEngineTest, TableStatsSumsDoNotLoseSmallValues) {
+    engine->createTable("Sums", {int(), int(), double()});
+    ASSERT_TRUE(engine->insertTuple("Sums", {0, std::numeric_limits<int>::max(), 1e16}));
+    for (int i = 1; i <= 1000; i++)
+        ASSERT_TRUE(engine->insertTuple("Sums", {i, std::numeric_limits<int>::max(), 1.0}));
+
+    // each 1.0 is below half the spacing of doubles around 1e16, so a plain sum would drop it
+    ASSERT_TRUE(engine->removeTuple("Sums", 0));
+    auto stats = engine->getTableStats("Sums");
+    ASSERT_EQ(stats->sums[1], 1000.0 * std::numeric_limits<int>::max());
+    ASSERT_EQ(stats->sums[2], 1000.0);
+
+    reopen();
+    ASSERT_EQ(engine->getTableStats("Sums")->sums[2], 1000.0);
+}
+
+TEST_F(StorageEngineTest, SortsSpillToATemporaryFile) {
+    // a spill file left behind by a crash
+    std::ofstream(kTestFile + ".tmp") << "stale";
+    reopen();
+    ASSERT_FALSE(std::filesystem::exists(kTestFile + ".tmp"));
+
+    engine->createTable("Orders", {int(), int()});
+    for (int i = 0; i < 20000; i++)
+        ASSERT_TRUE(engine->insertTuple("Orders", {i, -i}));
+    engine->checkpoint();
+    auto blocks = ioHandler->getNumBlocks();
+
+    int expected = 19999;
+    ASSERT_TRUE(engine->scanSorted("Orders", {{1}}, [&](const Vec<Vari> &tuple) {
+        ASSERT_EQ(tuple[0], Vari(expected--));
+    }, 4 * cts::PG_SZ));
+    ASSERT_EQ(expected, -1);
+
+    // the runs never touched the database file
+    ASSERT_TRUE(std::filesystem::exists(kTestFile + ".tmp"));
+    ASSERT_EQ(ioHandler->getNumBlocks(), blocks);
+    engine.reset();
+    ASSERT_FALSE(std::filesystem::exists(kTestFile + ".tmp"));
+}
+
+TEST_F(StorageEngineTest, PreparedInsertAndLookupMatchUnprepared) {
+    for (auto table_engine: {TableEngine::BTREE, TableEngine::HASH, TableEngine::LSM}) {
+        string name = "Prepared" + std::to_string(static_cast<int>(table_engine));
+        engine->createTable(name, {int(), string(), double()}, table_engine);
+        auto table = *engine->openTable(name);
+        auto insert = engine->prepareInsert(table);
+        auto lookup = engine->prepareLookup(table);
+
+        for (int i = 0; i < 2000; i++)
+            ASSERT_TRUE(insert.execute({i, "v" + std::to_string(i), i * 0.5}));
+        ASSERT_FALSE(insert.execute({7, string("dup"), 0.0}));
+
+        for (int i = 0; i < 2000; i++) {
+            auto tuple = lookup.execute(i);
+            ASSERT_EQ(tuple, engine->getTuple(table, i));
+            ASSERT_EQ(tuple, Vec<Vari>({i, "v" + std::to_string(i), i * 0.5}));
+        }
+        ASSERT_EQ(lookup.execute(5000), std::nullopt);
+        ASSERT_EQ(engine->getTableStats(table).numTuples, 2000);
+
+        ASSERT_THROW(insert.execute({1, string("short")}), std::runtime_error);
+        ASSERT_THROW(insert.execute({1, 2, 3.0}), std::runtime_error);
+        ASSERT_THROW(lookup.execute(string("key")), std::runtime_error);
+    }
+}
+
+TEST_F(StorageEngineTest, PreparedInsertsKeepTheTablePageUpToDate) {
+    engine->createTable("Prepared", {int(), int()});
+    engine->createIndex("Prepared", 1);
+    engine->createBloomFilter("Prepared", 0.01);
+    auto table = *engine->openTable("Prepared");
+
+    // the root pages and the bloom filter's capacity change many times along the way
+    auto insert = engine->prepareInsert(table);
+    for (int i = 0; i < 5000; i++)
+        ASSERT_TRUE(insert.execute({i, i % 100}));
+    ASSERT_TRUE(engine->removeTuple(table, 0));
+    ASSERT_EQ(engine->getTableStats(table).numTuples, 4999);
+
+    reopen();
+    table = *engine->openTable("Prepared");
+    ASSERT_EQ(engine->getTableStats(table).numTuples, 4999);
+    for (int i = 1; i < 5000; i++)
+        ASSERT_EQ(engine->getTuple(table, i), Vec<Vari>({i, i % 100}));
+    ASSERT_EQ(engine->getTuplesBy("Prepared", 1, 7)->size(), 50);
+    ASSERT_TRUE(engine->prepareInsert(table).execute({5000, 0}));
+    ASSERT_EQ(engine->getTableStats(table).numTuples, 5000);
+}
+
+TEST_F(StorageEngineTest, SnapshotsSeeTuplesAsTheyWere) {
+    for (auto table_engine: {TableEngine::BTREE, TableEngine::HASH, TableEngine::LSM}) {
+        string name = "Snap" + std::to_string(static_cast<int>(table_engine));
+        engine->createTable(name, {int(), int()}, table_engine);
+        auto table = *engine->openTable(name);
+        for (int i = 0; i < 1000; i++)
+            ASSERT_TRUE(engine->insertTuple(table, {i, i}));
+
+        // the first snapshot sees 0..999, the second also sees the even keys doubled
+        auto first = engine->beginSnapshot();
+        for (int i = 0; i < 1000; i += 2)
+            ASSERT_TRUE(engine->updateTuple(table, {i, i * 2}));
+        auto second = engine->beginSnapshot();
+        for (int i = 0; i < 1000; i += 3)
+            ASSERT_TRUE(engine->removeTuple(table, i));
+        for (int i = 1000; i < 1500; i++)
+            ASSERT_TRUE(engine->insertTuple(table, {i, i}));
+        ASSERT_TRUE(engine->updateTuple(table, {4, -1}));
+
+        auto snapshotRows = [&](const Snapshot &snapshot) {
+            Vec<Vec<Vari>> rows;
+            engine->scan(snapshot, table, {}, {}, [&](const Vec<Vari> &row) { rows.push_back(row); });
+            if (table_engine == TableEngine::HASH)
+                std::sort(rows.begin(), rows.end());
+            return rows;
+        };
+
+        auto firstRows = snapshotRows(first);
+        ASSERT_EQ(firstRows.size(), 1000);
+        for (int i = 0; i < 1000; i++)
+            ASSERT_EQ(firstRows[i], Vec<Vari>({i, i}));
+        auto secondRows = snapshotRows(second);
+        ASSERT_EQ(secondRows.size(), 1000);
+        for (int i = 0; i < 1000; i++)
+            ASSERT_EQ(secondRows[i], Vec<Vari>({i, i % 2 == 0 ? i * 2 : i}));
+
+        ASSERT_EQ(engine->getTuple(first, table, 4), Vec<Vari>({4, 4}));
+        ASSERT_EQ(engine->getTuple(second, table, 4), Vec<Vari>({4, 8}));
+        ASSERT_EQ(engine->getTuple(table, 4), Vec<Vari>({4, -1}));
+        ASSERT_EQ(engine->getTuple(second, table, 3), Vec<Vari>({3, 3}));
+        ASSERT_EQ(engine->getTuple(table, 3), std::nullopt);
+        ASSERT_EQ(engine->getTuple(second, table, 1200), std::nullopt);
+
+        // predicates and projections apply to the versions the snapshot sees
+        Vec<Vec<Vari>> small;
+        engine->scan(second, table, {{1, CompareOp::LT, 7}}, {1}, [&](const Vec<Vari> &row) {
+            small.push_back(row);
+        });
+        std::sort(small.begin(), small.end());
+        ASSERT_EQ(small, Vec<Vec<Vari>>({{0}, {1}, {3}, {4}, {5}}));
+
+        // closing the first snapshot keeps what the second one sees
+        first.close();
+        ASSERT_FALSE(first.valid());
+        ASSERT_EQ(snapshotRows(second), secondRows);
+        second.close();
+
+        // with no snapshot open, changes keep no versions
+        auto third = engine->beginSnapshot();
+        ASSERT_EQ(engine->getTuple(third, table, 4), Vec<Vari>({4, -1}));
+        ASSERT_EQ(snapshotRows(third).size(), 1000 - 334 + 500);
+    }
+}
+
+TEST_F(StorageEngineTest, SnapshotVersionsCanBeReadFromSeveralThreads) {
+    engine->createTable("Snap", {int(), int()});
+    auto table = *engine->openTable("Snap");
+    for (int i = 0; i < 2000; i++)
+        ASSERT_TRUE(engine->insertTuple(table, {i, i}));
+
+    auto snapshot = engine->beginSnapshot();
+    for (int i = 0; i < 2000; i++)
+        ASSERT_TRUE(engine->updateTuple(table, {i, -i}));
+
+    // every key changed after the snapshot, so every read is answered by the version store
+    std::atomic<int> mismatches = 0;
+    Vec<std::thread> readers;
+    for (int t = 0; t < 4; t++)
+        readers.emplace_back([&, t] {
+            for (int i = t; i < 2000; i += 4)
+                if (engine->getTuple(snapshot, table, i) != Vec<Vari>({i, i}))
+                    mismatches++;
+        });
+    for (auto &reader: readers)
+        reader.join();
+    ASSERT_EQ(mismatches, 0);
+}
+
+TEST_F(StorageEngineTest, SnapshotsDoNotSeeOpenTransactions) {
+    engine->createTable("Snap", {int(), int()});
+    auto table = *engine->openTable("Snap");
+    for (int i = 0; i < 100; i++)
+        ASSERT_TRUE(engine->insertTuple(table, {i, i}));
+
+    auto snapshotRows = [&](const Snapshot &snapshot) {
+        Vec<Vec<Vari>> rows;
+        engine->scan(snapshot, table, {}, {}, [&](const Vec<Vari> &row) { rows.push_back(row); });
+        return rows;
+    };
+    Vec<Vec<Vari>> original;
+    for (int i = 0; i < 100; i++)
+        original.push_back({i, i});
+
+    // a snapshot taken while a transaction is open sees neither its changes nor its abort
+    auto txn = engine->begin();
+    for (int i = 0; i < 100; i += 2)
+        ASSERT_TRUE(engine->updateTuple(txn, table, {i, -i}));
+    ASSERT_TRUE(engine->insertTuple(txn, table, {100, 100}));
+    ASSERT_TRUE(engine->removeTuple(txn, table, 1));
+    auto during = engine->beginSnapshot();
+    ASSERT_EQ(engine->getTuple(during, table, 2), Vec<Vari>({2, 2}));
+    ASSERT_EQ(engine->getTuple(during, table, 1), Vec<Vari>({1, 1}));
+    ASSERT_EQ(engine->getTuple(during, table, 100), std::nullopt);
+    ASSERT_EQ(snapshotRows(during), original);
+    engine->abort(txn);
+    ASSERT_EQ(snapshotRows(during), original);
+
+    // a committed transaction is seen by the snapshots opened after it only
+    txn = engine->begin();
+    for (int i = 0; i < 100; i += 2)
+        ASSERT_TRUE(engine->updateTuple(txn, table, {i, -i}));
+    ASSERT_TRUE(engine->insertTuple(txn, table, {100, 100}));
+    engine->commit(txn);
+    auto after = engine->beginSnapshot();
+    ASSERT_EQ(snapshotRows(during), original);
+    ASSERT_EQ(engine->getTuple(during, table, 2), Vec<Vari>({2, 2}));
+    ASSERT_EQ(engine->getTuple(after, table, 2), Vec<Vari>({2, -2}));
+    ASSERT_EQ(engine->getTuple(after, table, 100), Vec<Vari>({100, 100}));
+    ASSERT_EQ(snapshotRows(after).size(), 101);
+    during.close();
+    after.close();
+}
+
+TEST_F(StorageEngineTest, TransactionsCommitOrAbortAcrossTables) {
+    engine->createTable("Accounts", {int(), int()});
+    engine->createTable("Transfers", {int(), int(), int()}, TableEngine::HASH);
+    auto accounts = *engine->openTable("Accounts");
+    auto transfers = *engine->openTable("Transfers");
+    for (int i = 0; i < 100; i++)
+        ASSERT_TRUE(engine->insertTuple(accounts, {i, 1000}));
+
+    // an aborted transaction leaves every table as it was, including splits it caused
+    auto txn = engine->begin();
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(engine->updateTuple(txn, accounts, {i, 0}));
+        ASSERT_TRUE(engine->insertTuple(txn, transfers, {i, i, 1000}));
+    }
+    for (int i = 100; i < 1000; i++)
+        ASSERT_TRUE(engine->insertTuple(txn, accounts, {i, i}));
+    ASSERT_TRUE(engine->removeTuple(txn, accounts, 5));
+    ASSERT_EQ(engine->getTuple(accounts, 7), Vec<Vari>({7, 0}));
+    engine->abort(txn);
+    ASSERT_FALSE(txn.valid());
+
+    ASSERT_EQ(engine->getNumTuples(accounts), 100);
+    ASSERT_EQ(engine->getNumTuples(transfers), 0);
+    for (int i = 0; i < 100; i++)
+        ASSERT_EQ(engine->getTuple(accounts, i), Vec<Vari>({i, 1000}));
+
+    // a committed one keeps its changes, also across a reopen
+    txn = engine->begin();
+    ASSERT_TRUE(engine->updateTuple(txn, accounts, {1, 900}));
+    ASSERT_TRUE(engine->updateTuple(txn, accounts, {2, 1100}));
+    ASSERT_TRUE(engine->insertTuple(txn, transfers, {1, 2, 100}));
+    ASSERT_FALSE(engine->insertTuple(txn, transfers, {1, 2, 100}));
+    engine->commit(txn);
+
+    // a transaction that goes out of scope is aborted
+    {
+        auto dropped = engine->begin();
+        ASSERT_TRUE(engine->removeTuple(dropped, accounts, 1));
+    }
+
+    reopen();
+    accounts = *engine->openTable("Accounts");
+    transfers = *engine->openTable("Transfers");
+    ASSERT_EQ(engine->getTuple(accounts, 1), Vec<Vari>({1, 900}));
+    ASSERT_EQ(engine->getTuple(accounts, 2), Vec<Vari>({2, 1100}));
+    ASSERT_EQ(engine->getTuple(transfers, 1), Vec<Vari>({1, 2, 100}));
+    ASSERT_EQ(engine->getNumTuples(transfers), 1);
+}
+
+TEST_F(StorageEngineTest, TransactionsLockTheRowsTheyChange) {
+    engine->createTable("Items", {int(), int()});
+    auto items = *engine->openTable("Items");
+    for (int i = 0; i < 10; i++)
+        ASSERT_TRUE(engine->insertTuple(items, {i, i}));
+
+    auto first = engine->begin();
+    auto second = engine->begin();
+    ASSERT_TRUE(engine->updateTuple(first, items, {1, 10}));
+    ASSERT_TRUE(engine->insertTuple(first, items, {20, 20}));
+
+    // the rows first changed are locked, both for other transactions and outside of them
+    ASSERT_THROW(engine->updateTuple(second, items, {1, 11}), std::runtime_error);
+    ASSERT_THROW(engine->removeTuple(second, items, 20), std::runtime_error);
+    ASSERT_THROW(engine->updateTuple(items, {1, 12}), std::runtime_error);
+    ASSERT_THROW(engine->dropTable("Items"), std::runtime_error);
+    ASSERT_THROW(engine->createTable("Other", {int()}), std::runtime_error);
+    ASSERT_EQ(engine->getTableTypes("Other"), std::nullopt);
+    ASSERT_TRUE(engine->updateTuple(second, items, {2, 22}));
+    ASSERT_TRUE(engine->updateTuple(items, {3, 33}));
+
+    // reads see uncommitted changes
+    ASSERT_EQ(engine->getTuple(items, 1), Vec<Vari>({1, 10}));
+
+    engine->commit(first);
+    ASSERT_TRUE(engine->updateTuple(second, items, {1, 11}));
+    engine->abort(second);
+
+    ASSERT_EQ(engine->getTuple(items, 1), Vec<Vari>({1, 10}));
+    ASSERT_EQ(engine->getTuple(items, 2), Vec<Vari>({2, 2}));
+    ASSERT_EQ(engine->getTuple(items, 3), Vec<Vari>({3, 33}));
+    ASSERT_EQ(engine->getTuple(items, 20), Vec<Vari>({20, 20}));
+}
+
+TEST_F(StorageEngineTest, RecoveryRedoesCommittedAndUndoesUnfinishedChanges) {
+    const Vec<string> files{kTestFile, kTestFile + ".wal"};
+    for (auto table_engine: {TableEngine::BTREE, TableEngine::HASH}) {
+        resetEnv();
+        removeFiles();
+        initEnv();
+        pager->createNewPage<SchemaPage>();
+        engine = std::make_unique<StorageEngine>(*pager, cts::SCHEMA_ID);
+        engine->createTable("Orders", {int(), int()}, table_engine);
+        auto orders = *engine->openTable("Orders");
+        for (int i = 0; i < 100; i++)
+            ASSERT_TRUE(engine->insertTuple(orders, {i, i}));
+
+        auto committed = engine->begin();
+        for (int i = 100; i < 200; i++)
+            ASSERT_TRUE(engine->insertTuple(committed, orders, {i, i}));
+        engine->commit(committed);
+
+        // the unfinished transaction's changes reach the database file, which flushes the log first
+        auto unfinished = engine->begin();
+        ASSERT_TRUE(engine->updateTuple(unfinished, orders, {0, -1}));
+        ASSERT_TRUE(engine->removeTuple(unfinished, orders, 1));
+        ASSERT_TRUE(engine->insertTuple(unfinished, orders, {500, 500}));
+        pager->flush();
+
+        // the last transaction's changes only reach the log
+        auto last = engine->begin();
+        ASSERT_TRUE(engine->updateTuple(last, orders, {50, 5000}));
+        ASSERT_TRUE(engine->insertTuple(last, orders, {600, 600}));
+        engine->commit(last);
+
+        // crash: keep the files as they are now
+        for (const auto &file: files)
+            std::filesystem::copy_file(file, file + ".crash", std::filesystem::copy_options::overwrite_existing);
+        engine->abort(unfinished);
+        resetEnv();
+        for (const auto &file: files)
+            std::filesystem::rename(file + ".crash", file);
+
+        reopen();
+        orders = *engine->openTable("Orders");
+        ASSERT_EQ(engine->getNumTuples(orders), 201);
+        for (int i = 0; i < 200; i++)
+            ASSERT_EQ(engine->getTuple(orders, i), Vec<Vari>({i, i == 50 ? 5000 : i}));
+        ASSERT_EQ(engine->getTuple(orders, 500), std::nullopt);
+        ASSERT_EQ(engine->getTuple(orders, 600), Vec<Vari>({600, 600}));
+
+        // recovery checkpoints, so the log starts over
+        ASSERT_EQ(std::filesystem::file_size(kTestFile + ".wal"), 0);
+    }
+}
+
+TEST_F(StorageEngineTest, CrashWithOpenSnapshotDoesNotLeakVersionPages) {
+    engine->createTable("Orders", {int(), int()});
+    auto orders = *engine->openTable("Orders");
+    for (int i = 0; i < 2000; i++)
+        ASSERT_TRUE(engine->insertTuple(orders, {i, 0}));
+    engine->checkpoint();
+
+    auto usedPages = [&] {
+        u64 used = 0;
+        for (pgid_t pg = 0; pg < ioHandler->getNumBlocks(); pg++)
+            used += !pager->isFree(pg);
+        return used;
+    };
+
+    // every update keeps a version, and the versions' pages reach the database file
+    auto updateAll = [&](int value) {
+        auto snapshot = engine->beginSnapshot();
+        for (int i = 0; i < 2000; i++)
+            EXPECT_TRUE(engine->updateTuple(orders, {i, value}));
+        pager->flush();
+        return snapshot;
+    };
+    auto snapshot = updateAll(1);
+    auto used = usedPages();
+
+    // crash while the snapshot is open
+    const Vec<string> files{kTestFile, kTestFile + ".wal"};
+    for (const auto &file: files)
+        std::filesystem::copy_file(file, file + ".crash", std::filesystem::copy_options::overwrite_existing);
+    snapshot.close();
+    resetEnv();
+    for (const auto &file: files)
+        std::filesystem::rename(file + ".crash", file);
+
+    // the version store left behind was freed, so the same versions fit in its pages again
+    reopen();
+    orders = *engine->openTable("Orders");
+    ASSERT_EQ(engine->getTuple(orders, 7), Vec<Vari>({7, 1}));
+    snapshot = updateAll(2);
+    ASSERT_EQ(engine->getTuple(snapshot, orders, 7), Vec<Vari>({7, 1}));
+    ASSERT_EQ(usedPages(), used);
+    snapshot.close();
+}
+
+TEST_F(StorageEngineTest, ReadOnlyDatabaseReadsButRejectsChanges) {
+    engine->createTable("Students", {int(), string()});
+    engine->createIndex("Students", 1, false);
+    for (int i = 0; i < 2000; i++)
+        ASSERT_TRUE(engine->insertTuple("Students", {i, "name" + std::to_string(i % 10)}));
+    resetEnv();
+    std::filesystem::remove(kTestFile + ".wal");
+    auto size = std::filesystem::file_size(kTestFile);
+
+    initEnv(IOMode::READ_ONLY);
+    engine = std::make_unique<StorageEngine>(*pager, cts::SCHEMA_ID);
+    auto students = *engine->openTable("Students");
+    ASSERT_EQ(engine->getNumTuples(students), 2000);
+    for (int i = 0; i < 2000; i += 7)
+        ASSERT_EQ(engine->getTuple(students, i), (Vec<Vari>{i, "name" + std::to_string(i % 10)}));
+    ASSERT_EQ(engine->getTuplesBy(students, 1, string("name3")).size(), 200);
+
+    ASSERT_THROW(engine->insertTuple(students, {5000, string("x")}), std::runtime_error);
+    ASSERT_THROW(engine->updateTuple("Students", {1, string("x")}), std::runtime_error);
+    ASSERT_THROW(engine->removeTuple(students, 1), std::runtime_error);
+    ASSERT_THROW(engine->createTable("Teachers", {int()}), std::runtime_error);
+    ASSERT_THROW(engine->begin(), std::runtime_error);
+    ASSERT_EQ(engine->getTuple(students, 1), (Vec<Vari>{1, string("name1")}));
+    engine->checkpoint();
+
+    // neither the database file nor its log was touched
+    resetEnv();
+    ASSERT_EQ(std::filesystem::file_size(kTestFile), size);
+    ASSERT_FALSE(std::filesystem::exists(kTestFile + ".wal"));
+
+    // a log that needs recovery can only be replayed read-write
+    initEnv();
+    engine = std::make_unique<StorageEngine>(*pager, cts::SCHEMA_ID);
+    auto txn = engine->begin();
+    ASSERT_TRUE(engine->insertTuple(txn, *engine->openTable("Students"), {5000, string("x")}));
+    engine->commit(txn);
+    std::filesystem::copy_file(kTestFile + ".wal", kTestFile + ".wal.crash");
+    resetEnv();
+    std::filesystem::rename(kTestFile + ".wal.crash", kTestFile + ".wal");
+    initEnv(IOMode::READ_ONLY);
+    ASSERT_THROW(StorageEngine(*pager, cts::SCHEMA_ID), std::runtime_error);
+}
+
+TEST_F(StorageEngineTest, CompressedDatabaseIsSmallerAndSurvivesReopen) {
+    resetEnv();
+    removeFiles();
+    initEnv(IOMode::COMPRESSED);
+    pager->createNewPage<SchemaPage>();
+    engine = std::make_unique<StorageEngine>(*pager, cts::SCHEMA_ID);
+
+    engine->createTable("Students", {int(), string()});
+    engine->createIndex("Students", 1, false);
+    for (int i = 0; i < 3000; i++)
+        ASSERT_TRUE(engine->insertTuple("Students", {i, "name" + std::to_string(i % 10)}));
+    for (int i = 0; i < 3000; i += 3)
+        ASSERT_TRUE(engine->removeTuple("Students", i));
+    engine->checkpoint();
+    // the blocks' slots take much less than the blocks themselves
+    ASSERT_LT(std::filesystem::file_size(kTestFile), ioHandler->getNumBlocks() * cts::PG_SZ / 3);
+
+    reopen(IOMode::COMPRESSED);
+    auto students = *engine->openTable("Students");
+    ASSERT_EQ(engine->getNumTuples(students), 2000);
+    for (int i = 0; i < 3000; i++)
+        ASSERT_EQ(engine->getTuple(students, i).has_value(), i % 3 != 0);
+    ASSERT_EQ(engine->getTuplesBy(students, 1, string("name4")).size(), 200);
+    ASSERT_TRUE(engine->updateTuple("Students", {1, string("renamed")}));
+
+    reopen(IOMode::COMPRESSED);
+    ASSERT_EQ(engine->getTuple(*engine->openTable("Students"), 1), (Vec<Vari>{1, string("renamed")}));
+}
+
+TEST_F(StorageEngineTest, DropTableReclaimsPagesAndFiles) {
+    auto usedPages = [&] {
+        u64 used = 0;
+        for (pgid_t pg = 0; pg < ioHandler->getNumBlocks(); pg++)
+            used += !pager->isFree(pg);
+        return used;
+    };
+    auto lsmFiles = [&] {
+        u64 files = 0;
+        for (const auto &entry: std::filesystem::directory_iterator("."))
+            files += entry.path().filename().string().starts_with(kTestFile + ".lsm");
+        return files;
+    };
+
+    for (auto table_engine: {TableEngine::BTREE, TableEngine::HASH, TableEngine::LSM}) {
+        engine->checkpoint();
+        auto used = usedPages();
+
+        engine->createTable("Orders", {int(), int()}, table_engine);
+        auto orders = *engine->openTable("Orders");
+        for (int i = 0; i < 3000; i++)
+            ASSERT_TRUE(engine->insertTuple(orders, {i, i % 7}));
+        engine->createIndex("Orders", 1);
+        engine->createBloomFilter("Orders");
+
+        // the snapshot keeps a version of every update, which the drop must free too
+        auto snapshot = engine->beginSnapshot();
+        for (int i = 0; i < 1000; i++)
+            ASSERT_TRUE(engine->updateTuple(orders, {i, -i}));
+        if (table_engine == TableEngine::LSM) {
+            engine->checkpoint();
+            ASSERT_GT(lsmFiles(), 0);
+        }
+        ASSERT_GT(usedPages(), used);
+
+        engine->dropTable("Orders");
+        ASSERT_EQ(usedPages(), used);
+        ASSERT_EQ(lsmFiles(), 0);
+        ASSERT_EQ(engine->openTable("Orders"), std::nullopt);
+    }
+}
+
+TEST_F(StorageEngineTest, HandlesToDroppedTablesThrow) {
+    engine->createTable("Orders", {int(), int()});
+    auto dropped = *engine->openTable("Orders");
+    ASSERT_TRUE(engine->insertTuple(dropped, {1, 1}));
+
+    engine->dropTable("Orders");
+    ASSERT_THROW(engine->getTuple(dropped, 1), std::invalid_argument);
+    ASSERT_THROW(engine->insertTuple(dropped, {2, 2}), std::invalid_argument);
+
+    // the new table may reuse the dropped one's pages, but not its handles
+    engine->createTable("Orders", {int(), int()});
+    ASSERT_THROW(engine->getNumTuples(dropped), std::invalid_argument);
+    auto orders = *engine->openTable("Orders");
+    ASSERT_EQ(engine->getNumTuples(orders), 0);
+    ASSERT_TRUE(engine->insertTuple(orders, {1, 1}));
+
+    ASSERT_THROW(engine->getNumTuples(TableHandle()), std::invalid_argument);
+}
+
+TEST_F(StorageEngineTest, ConcurrentInsertsFromSeveralThreads) {
+    engine->createTable("Orders", {int(), int()});
+    auto orders = *engine->openTable("Orders");
+
+    std::atomic<int> failures = 0;
+    Vec<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([&, t] {
+            for (int i = t; i < 4000; i += 4) {
+                if (!engine->concurrentInsertTuple(orders, {i, 2 * i}))
+                    failures++;
+                if (engine->concurrentGetTuple(orders, i) != Vec<Vari>({i, 2 * i}))
+                    failures++;
+            }
+        });
+    for (auto &thread: threads)
+        thread.join();
+    ASSERT_EQ(failures, 0);
+    ASSERT_FALSE(engine->concurrentInsertTuple(orders, {0, 0}));
+
+    auto stats = engine->getTableStats(orders);
+    ASSERT_EQ(stats.numTuples, 4000);
+    ASSERT_EQ(stats.sums[1], 3999.0 * 4000);
+    ASSERT_EQ(engine->countRange(orders, 1000, 1999), 1000);
+
+    reopen();
+    orders = *engine->openTable("Orders");
+    ASSERT_EQ(engine->getNumTuples(orders), 4000);
+    for (int i = 0; i < 4000; i++)
+        ASSERT_EQ(engine->getTuple(orders, i), Vec<Vari>({i, 2 * i}));
+
+    engine->createTable("Sessions", {int(), int()}, TableEngine::HASH);
+    ASSERT_THROW(engine->concurrentInsertTuple(*engine->openTable("Sessions"), {1, 1}), std::runtime_error);
+    engine->createIndex("Orders", 1);
+    ASSERT_THROW(engine->concurrentInsertTuple(orders, {4000, 1}), std::runtime_error);
+}
@@ -164,3 +164,39 @@ TEST_F(TablePageTest, SingleTypeTable) {
     ASSERT_EQ(singleTypeTable.getTypes().size(), 1);
     ASSERT_EQ(singleTypeTable.getTypes(), singleType);
 }
+
+TEST_F(TablePageTest, IndexesAreSerialized) {
+    table->addIndex(1, false, 10);
+    table->addIndex(3, true, 11);
+    table->setIndexBtreePageID(1, 12);
+
+    Vec<byte> buffer(cts::PG_SZ);
+    table->toBytes(buffer);
+
+    TablePage serialized(buffer, 1);
+    ASSERT_EQ(serialized.getIndexes().size(), 2);
+    ASSERT_EQ(serialized.getIndexes()[0].column, 1);
+    ASSERT_FALSE(serialized.getIndexes()[0].unique);
+    ASSERT_EQ(serialized.getIndexes()[0].btreePageID, 12);
+    ASSERT_EQ(serialized.getIndexes()[1].column, 3);
+    ASSERT_TRUE(serialized.getIndexes()[1].unique);
+    ASSERT_EQ(serialized.getIndexes()[1].btreePageID, 11);
+}
+
+TEST_F(TablePageTest, IndexingSameColumnTwiceCausesDeath) {
+    table->addIndex(1, false, 10);
+    ASSERT_DEATH(table->addIndex(1, true, 11), "");
+}
+
+TEST_F(TablePageTest, BloomIsSerialized) {
+    ASSERT_EQ(table->getBloom().pageID, cts::PGID_INVALID);
+    table->setBloom({20, 4096, 9.5});
+
+    Vec<byte> buffer(cts::PG_SZ);
+    table->toBytes(buffer);
+
+    TablePage serialized(buffer, 1);
+    ASSERT_EQ(serialized.getBloom().pageID, 20);
+    ASSERT_EQ(serialized.getBloom().capacity, 4096);
+    ASSERT_EQ(serialized.getBloom().bitsPerKey, 9.5);
+}
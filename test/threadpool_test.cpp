@@ -0,0 +1,49 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <gtest/gtest.h>
+#include <atomic>
+
+#include "ThreadPool.hpp"
+
+using namespace backend;
+
+TEST(ThreadPoolTest, RunsEveryTask) {
+    ThreadPool pool(4);
+    std::atomic<int> sum = 0;
+    for (int i = 1; i <= 1000; i++)
+        pool.submit([&sum, i] { sum += i; });
+    pool.wait();
+    ASSERT_EQ(sum, 500500);
+
+    // the pool can be reused after waiting
+    pool.submit([&sum] { sum = 0; });
+    pool.wait();
+    ASSERT_EQ(sum, 0);
+}
+
+TEST(ThreadPoolTest, IdleThreadsStealFromBusyOnes) {
+    ThreadPool pool(4);
+    std::atomic<bool> release = false;
+    std::atomic<int> done = 0;
+
+    // the first queue gets a task that blocks until every other task has run, so the tasks
+    // queued behind it can only finish by being stolen
+    pool.submit([&] { while (!release) std::this_thread::yield(); });
+    for (int i = 0; i < 99; i++)
+        pool.submit([&] { if (++done == 99) release = true; });
+    pool.wait();
+    ASSERT_EQ(done, 99);
+}
+
+TEST(ThreadPoolTest, WaitRethrowsTaskExceptions) {
+    ThreadPool pool(2);
+    pool.submit([] { throw std::runtime_error("task failed"); });
+    pool.submit([] {});
+    ASSERT_THROW(pool.wait(), std::runtime_error);
+
+    // the error is only reported once
+    pool.submit([] {});
+    ASSERT_NO_THROW(pool.wait());
+}
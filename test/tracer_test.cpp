@@ -0,0 +1,157 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <gtest/gtest.h>
+#include <filesystem>
+
+#include "SchemaPage.hpp"
+#include "StorageEngine.hpp"
+#include "Tracer.hpp"
+
+using namespace backend;
+
+struct TracerTest : testing::Test {
+    const std::string kTestFile = "testfile.db";
+    const std::string kTraceFile = "testfile.trace";
+
+    void SetUp() override {
+        removeFiles();
+    }
+
+    void TearDown() override {
+        Tracer::global().stop();
+        removeFiles();
+    }
+
+    void removeFiles() {
+        for (const auto &entry: std::filesystem::directory_iterator("."))
+            if (entry.path().filename().string().starts_with("testfile."))
+                std::filesystem::remove(entry.path());
+    }
+
+    static void expectEqual(const Tracer::Record &a, const Tracer::Record &b) {
+        EXPECT_EQ(a.op, b.op);
+        EXPECT_EQ(a.startNs, b.startNs);
+        EXPECT_EQ(a.totalNs, b.totalNs);
+        EXPECT_EQ(a.cacheNs, b.cacheNs);
+        EXPECT_EQ(a.ioNs, b.ioNs);
+        EXPECT_EQ(a.codecNs, b.codecNs);
+        EXPECT_EQ(a.bytesRead, b.bytesRead);
+        EXPECT_EQ(a.bytesWritten, b.bytesWritten);
+        EXPECT_EQ(a.bytesSerialized, b.bytesSerialized);
+        EXPECT_EQ(a.pages, b.pages);
+    }
+};
+
+TEST_F(TracerTest, RingBufferKeepsTheNewestRecords) {
+    auto &tracer = Tracer::global();
+
+    // nothing is recorded while stopped
+    tracer.start(512);
+    tracer.stop();
+    {
+        Tracer::Scope scope(TraceOp::GET);
+        Tracer::pageAccess(1, PageAccess::HIT);
+    }
+    ASSERT_TRUE(tracer.records().empty());
+
+    tracer.start(512);
+    for (pgid_t i = 0; i < 100; i++) {
+        Tracer::Scope scope(TraceOp::INSERT);
+        // a nested call is part of the outer one
+        Tracer::Scope nested(TraceOp::CHECKPOINT);
+        Tracer::pageAccess(i, PageAccess::HIT);
+        Tracer::pageAccess(i + 1000, PageAccess::MISS);
+        Tracer::pageAccess(i > 0 ? i - 1 : 0, PageAccess::WRITE);
+        Tracer::addBytes(&Tracer::Record::bytesRead, i);
+    }
+
+    auto records = tracer.records();
+    ASSERT_FALSE(records.empty());
+    ASSERT_EQ(records.size() + tracer.dropped(), 100);
+    for (size_t r = 0; r < records.size(); r++) {
+        auto i = static_cast<pgid_t>(100 - records.size() + r);
+        ASSERT_EQ(records[r].op, TraceOp::INSERT);
+        ASSERT_EQ(records[r].bytesRead, i);
+        ASSERT_EQ(records[r].pages, (Vec<std::pair<pgid_t, PageAccess>>{
+                {i, PageAccess::HIT}, {i + 1000, PageAccess::MISS}, {i > 0 ? i - 1 : 0, PageAccess::WRITE}}));
+        if (r > 0)
+            ASSERT_GE(records[r].startNs, records[r - 1].startNs);
+    }
+
+    // a record larger than the buffer is dropped
+    u64 dropped = tracer.dropped();
+    {
+        Tracer::Scope scope(TraceOp::RANGE);
+        for (pgid_t i = 0; i < 1000; i++)
+            Tracer::pageAccess(i * 7919, PageAccess::HIT);
+    }
+    ASSERT_EQ(tracer.dropped(), dropped + 1);
+    ASSERT_EQ(tracer.records().size(), records.size());
+}
+
+TEST_F(TracerTest, EngineCallsRecordTheirPagesAndLayers) {
+    {
+        IOHandler ioHandler(kTestFile);
+        // a cache smaller than the table, so that lookups miss
+        PageCache pageCache(ioHandler, 64);
+        // so that every miss reads its page itself
+        pageCache.setReadAhead(0);
+        FreeSpaceMap fsm(pageCache);
+        Pager pager(fsm, ioHandler, pageCache);
+        pager.createNewPage<SchemaPage>();
+        StorageEngine engine(pager, cts::SCHEMA_ID);
+        engine.createTable("Students", {int(), string()});
+        auto students = *engine.openTable("Students");
+
+        auto &tracer = Tracer::global();
+        tracer.start();
+        for (int i = 0; i < 3000; i++)
+            ASSERT_TRUE(engine.insertTuple(students, {i, string(100, 'x')}));
+        for (int i = 0; i < 3000; i += 50)
+            ASSERT_TRUE(engine.getTuple(students, i).has_value());
+        engine.checkpoint();
+        tracer.stop();
+        tracer.save(kTraceFile);
+    }
+
+    auto records = Tracer::global().records();
+    ASSERT_EQ(records.size(), 3061);
+    ASSERT_EQ(Tracer::global().dropped(), 0);
+
+    u64 inserts = 0, misses = 0;
+    for (const auto &rec: records) {
+        ASSERT_FALSE(rec.pages.empty());
+        ASSERT_LE(rec.cacheNs, rec.totalNs);
+        ASSERT_LE(rec.codecNs, rec.cacheNs);
+        for (const auto &[pageID, access]: rec.pages) {
+            inserts += access == PageAccess::INSERT;
+            misses += access == PageAccess::MISS;
+        }
+        if (rec.op == TraceOp::GET) {
+            // every miss read one page from disk
+            u64 reads = 0;
+            for (const auto &[pageID, access]: rec.pages)
+                reads += access == PageAccess::MISS;
+            ASSERT_EQ(rec.bytesRead, reads * cts::PG_SZ);
+        }
+    }
+    ASSERT_GT(inserts, 0);
+    ASSERT_GT(misses, 0);
+
+    const auto &checkpoint = records.back();
+    ASSERT_EQ(checkpoint.op, TraceOp::CHECKPOINT);
+    ASSERT_GT(checkpoint.bytesWritten, 0);
+    ASSERT_GT(checkpoint.bytesSerialized, 0);
+    ASSERT_TRUE(std::ranges::any_of(checkpoint.pages, [](auto &p) { return p.second == PageAccess::WRITE; }));
+
+    auto loaded = Tracer::load(kTraceFile);
+    ASSERT_EQ(loaded.size(), records.size());
+    for (size_t i = 0; i < loaded.size(); i++)
+        expectEqual(loaded[i], records[i]);
+
+    // a trace file that was cut short is rejected
+    std::filesystem::resize_file(kTraceFile, std::filesystem::file_size(kTraceFile) - 1);
+    ASSERT_THROW(Tracer::load(kTraceFile), std::runtime_error);
+}
@@ -0,0 +1,102 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <gtest/gtest.h>
+
+#include "VectorExecutor.hpp"
+
+using namespace backend;
+
+namespace {
+
+// key, category (key % 7), amount (key * 0.5), name, flag (key is even)
+const Vec<Vari> kTypes = {0, 0, 0.0, string(), false};
+
+Vec<Vec<Vari>> run(const Query &query, int numRows) {
+    VectorExecutor executor(kTypes, query);
+    for (int key = 0; key < numRows; key++)
+        executor.addRow({key, key % 7, key * 0.5, "name" + std::to_string(key), key % 2 == 0});
+    return executor.finish();
+}
+
+} // namespace
+
+TEST(VectorExecutorTest, FiltersAndProjectsAcrossBatches) {
+    int numRows = VectorExecutor::BATCH_SIZE * 3 + 17;
+    auto rows = run({{{1, CompareOp::EQ, 3}, {0, CompareOp::GE, 100}}, {3, 0}, {}, {}}, numRows);
+
+    int expected = 0;
+    for (int key = 0; key < numRows; key++) {
+        if (key % 7 != 3 || key < 100)
+            continue;
+        ASSERT_LT(expected, rows.size());
+        ASSERT_EQ(rows[expected], (Vec<Vari>{"name" + std::to_string(key), key}));
+        expected++;
+    }
+    ASSERT_EQ(rows.size(), expected);
+}
+
+TEST(VectorExecutorTest, EmptyProjectionReturnsEveryColumn) {
+    auto rows = run({{{4, CompareOp::EQ, true}, {0, CompareOp::LT, 6}}, {}, {}, {}}, 100);
+    ASSERT_EQ(rows.size(), 3);
+    ASSERT_EQ(rows[1], (Vec<Vari>{2, 2, 1.0, string("name2"), true}));
+}
+
+TEST(VectorExecutorTest, AggregatesWithoutGrouping) {
+    int numRows = 5000;
+    auto rows = run({{{0, CompareOp::LT, 4000}}, {}, {}, {
+            {AggregateOp::COUNT, 0}, {AggregateOp::SUM, 0}, {AggregateOp::MIN, 2},
+            {AggregateOp::MAX, 3}, {AggregateOp::AVG, 2}}}, numRows);
+
+    ASSERT_EQ(rows.size(), 1);
+    ASSERT_EQ(rows[0][0], Vari(4000));
+    ASSERT_EQ(rows[0][1], Vari(3999.0 * 4000 / 2));
+    ASSERT_EQ(rows[0][2], Vari(0.0));
+    ASSERT_EQ(rows[0][3], Vari(string("name999")));
+    ASSERT_EQ(rows[0][4], Vari(3999 * 0.5 / 2));
+}
+
+TEST(VectorExecutorTest, AggregatesOfNoTuplesStillReturnARow) {
+    auto rows = run({{{0, CompareOp::GT, 1000}}, {}, {}, {{AggregateOp::COUNT, 0}, {AggregateOp::SUM, 2}}}, 100);
+    ASSERT_EQ(rows, (Vec<Vec<Vari>>{{0, 0.0}}));
+}
+
+TEST(VectorExecutorTest, GroupsAreReturnedInOrder) {
+    int numRows = 3000;
+    auto rows = run({{{0, CompareOp::NE, 0}}, {}, {4, 1}, {
+            {AggregateOp::COUNT, 0}, {AggregateOp::MIN, 0}, {AggregateOp::MAX, 0}, {AggregateOp::SUM, 2}}},
+                    numRows);
+
+    struct Expected { int count = 0, min = INT32_MAX, max = INT32_MIN; double sum = 0; };
+    std::map<std::pair<bool, int>, Expected> expected;
+    for (int key = 1; key < numRows; key++) {
+        auto &group = expected[{key % 2 == 0, key % 7}];
+        group.count++;
+        group.min = std::min(group.min, key);
+        group.max = std::max(group.max, key);
+        group.sum += key * 0.5;
+    }
+
+    ASSERT_EQ(rows.size(), expected.size());
+    size_t i = 0;
+    for (const auto &[key, group]: expected) {
+        ASSERT_EQ(rows[i], (Vec<Vari>{key.first, key.second, group.count, group.min, group.max, group.sum}));
+        i++;
+    }
+}
+
+TEST(VectorExecutorTest, GroupingWithoutAggregatesReturnsDistinctValues) {
+    auto rows = run({{}, {}, {1}, {}}, 100);
+    ASSERT_EQ(rows, (Vec<Vec<Vari>>{{0}, {1}, {2}, {3}, {4}, {5}, {6}}));
+}
+
+TEST(VectorExecutorTest, RejectsInvalidQueries) {
+    ASSERT_THROW(VectorExecutor(kTypes, {{{5, CompareOp::EQ, 0}}, {}, {}, {}}), std::invalid_argument);
+    ASSERT_THROW(VectorExecutor(kTypes, {{{0, CompareOp::EQ, 0.0}}, {}, {}, {}}), std::runtime_error);
+    ASSERT_THROW(VectorExecutor(kTypes, {{}, {5}, {}, {}}), std::invalid_argument);
+    ASSERT_THROW(VectorExecutor(kTypes, {{}, {0}, {1}, {}}), std::invalid_argument);
+    ASSERT_THROW(VectorExecutor(kTypes, {{}, {}, {7}, {}}), std::invalid_argument);
+    ASSERT_THROW(VectorExecutor(kTypes, {{}, {}, {}, {{AggregateOp::SUM, 3}}}), std::invalid_argument);
+    ASSERT_THROW(VectorExecutor(kTypes, {{}, {}, {}, {{AggregateOp::MAX, 9}}}), std::invalid_argument);
+}
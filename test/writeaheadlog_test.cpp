@@ -0,0 +1,107 @@
+//
+// Created by Kylan Chen on 10/18/26.
+//
+
+#include <gtest/gtest.h>
+
+#include "WriteAheadLog.hpp"
+
+using namespace backend;
+
+using Record = WriteAheadLog::Record;
+
+struct WriteAheadLogTest : testing::Test {
+    const std::string kTestFile = "testfile.wal";
+
+    void SetUp() override {
+        std::remove(kTestFile.c_str());
+    }
+
+    void TearDown() override {
+        std::remove(kTestFile.c_str());
+    }
+
+    static Record change(u64 txn, int key) {
+        return {Record::Type::CHANGE, txn, "table " + std::to_string(key % 3), key,
+                key % 2 ? std::nullopt : std::optional<Vec<Vari>>({key, 'c', true, 1.5f, 2.5, string(key % 50, 'x')}),
+                Vec<Vari>({key, 'd', false, -1.5f, -2.5, string("after")})};
+    }
+
+    static void expectEqual(const Record &a, const Record &b) {
+        EXPECT_EQ(a.type, b.type);
+        EXPECT_EQ(a.txn, b.txn);
+        EXPECT_EQ(a.table, b.table);
+        EXPECT_EQ(a.key, b.key);
+        EXPECT_EQ(a.before, b.before);
+        EXPECT_EQ(a.after, b.after);
+    }
+};
+
+TEST_F(WriteAheadLogTest, FlushedRecordsSurviveReopen) {
+    Vec<Record> records;
+    {
+        WriteAheadLog log(kTestFile);
+        // enough records to span several blocks, flushed in uneven batches
+        for (int i = 0; i < 500; i++) {
+            records.push_back(change(i / 10, i));
+            log.append(records.back());
+            if (i % 10 == 9) {
+                records.push_back({Record::Type::COMMIT, static_cast<u64>(i / 10)});
+                log.append(records.back());
+            }
+            if (i % 37 == 0)
+                log.flush();
+        }
+        log.flush();
+
+        // records appended after the last flush are lost
+        log.append(change(99, 1000));
+    }
+
+    WriteAheadLog log(kTestFile);
+    auto read = log.readAll();
+    ASSERT_EQ(read.size(), records.size());
+    for (size_t i = 0; i < read.size(); i++)
+        expectEqual(read[i], records[i]);
+
+    // appending continues after the last record
+    records.push_back({Record::Type::ABORT, 7});
+    log.append(records.back());
+    log.flush();
+    read = log.readAll();
+    ASSERT_EQ(read.size(), records.size());
+    expectEqual(read.back(), records.back());
+}
+
+TEST_F(WriteAheadLogTest, CorruptRecordEndsTheLog) {
+    {
+        WriteAheadLog log(kTestFile);
+        for (int i = 0; i < 3; i++)
+            log.append(change(1, i));
+        log.flush();
+    }
+
+    // flip a byte in the payload of the last record, as a torn write would
+    u64 size;
+    {
+        WriteAheadLog log(kTestFile);
+        size = log.size();
+    }
+    {
+        IOHandler io(kTestFile);
+        PgArr<byte> block;
+        io.readBlock(block.data(), 0);
+        block[size - 1] ^= byte{0xff};
+        io.writeBlock(block.data(), 0);
+    }
+
+    WriteAheadLog log(kTestFile);
+    auto read = log.readAll();
+    ASSERT_EQ(read.size(), 2);
+    expectEqual(read[1], change(1, 1));
+    ASSERT_LT(log.size(), size);
+
+    log.truncate();
+    ASSERT_EQ(log.size(), 0);
+    ASSERT_TRUE(log.readAll().empty());
+}